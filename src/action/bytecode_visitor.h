@@ -6,11 +6,11 @@
 
 #include "common/defines.h"
 #include "common/enums.h"
+#include "common/mem_pool.h"
 #include "common/operators.h"
 #include "common/type.h"
 #include "runtime/module.h"
 #include "utils/wasm.h"
-#include <stack>
 #include <vector>
 
 #ifdef ZEN_ENABLE_CHECKED_ARITHMETIC
@@ -26,6 +26,7 @@ using common::getErrorWithExtraMessage;
 using common::getWASMBlockTypeFromOpcode;
 using common::isWASMTypeFloat;
 using common::isWASMTypeInteger;
+using common::MiscOpcode;
 using common::Opcode;
 using common::UnaryOperator;
 using common::WASMType;
@@ -35,26 +36,34 @@ using utils::readFixedNumber;
 using utils::readSafeLEBNumber;
 using utils::skipCurrentBlock;
 
-template <typename Operand> class WASMEvalStack {
+template <typename Operand, typename Allocator = std::allocator<Operand>>
+class WASMEvalStack {
 public:
-  void push(Operand Op) { StackImpl.push(Op); }
+  typedef Allocator allocator_type;
+
+  explicit WASMEvalStack(const Allocator &Alloc = Allocator())
+      : StackImpl(Alloc) {
+    StackImpl.reserve(16);
+  }
+
+  void push(Operand Op) { StackImpl.push_back(Op); }
 
   Operand pop() {
     ZEN_ASSERT(!StackImpl.empty());
-    Operand Top = StackImpl.top();
-    StackImpl.pop();
+    Operand Top = StackImpl.back();
+    StackImpl.pop_back();
     return Top;
   }
 
   Operand getTop() const {
     ZEN_ASSERT(!StackImpl.empty());
-    return StackImpl.top();
+    return StackImpl.back();
   }
 
   uint32_t getSize() const { return StackImpl.size(); }
 
 private:
-  std::stack<Operand> StackImpl;
+  std::vector<Operand, Allocator> StackImpl;
 };
 
 // ============================================================================
@@ -71,12 +80,17 @@ template <typename IRBuilder> class WASMByteCodeVisitor {
   typedef typename IRBuilder::BlockInfo CtrlBlockInfo;
   typedef typename IRBuilder::CompilerContext CompilerContext;
   typedef typename IRBuilder::Operand Operand; // operand to build ir
-  typedef WASMEvalStack<Operand> EvalStack;    // byte code evaluation stack
+  // per function pool of the compiler, reset between functions
+  typedef decltype(CompilerContext::MemPool) MemPoolType;
+  typedef common::MemPoolAllocator<Operand, MemPoolType> EvalStackAllocator;
+  typedef WASMEvalStack<Operand, EvalStackAllocator>
+      EvalStack; // byte code evaluation stack
 
 public:
   WASMByteCodeVisitor(IRBuilder &Builder, CompilerContext *Ctx)
-      : Builder(Builder), Ctx(Ctx), CurMod(&Ctx->getWasmMod()),
-        CurFunc(&Ctx->getWasmFuncCode()) {
+      : Builder(Builder),
+        Stack(EvalStackAllocator(Ctx->MemPool)), Ctx(Ctx),
+        CurMod(&Ctx->getWasmMod()), CurFunc(&Ctx->getWasmFuncCode()) {
     ZEN_ASSERT(Ctx);
   }
 
@@ -114,6 +128,7 @@ private:
     float F32;
     double F64;
 
+    countBlock(Ip);
     while (Ip < IpEnd) {
       auto &CurBlock = Builder.getCurrentBlockInfo();
       uint8_t Opcode = *Ip++;
@@ -137,22 +152,28 @@ private:
       case Opcode::LOOP: {
         WASMType BlockType = getWASMBlockTypeFromOpcode(*Ip++);
         handleLoop(BlockType);
+        countBlock(Ip);
         break;
       }
 
       case Opcode::IF: {
         WASMType BlockType = getWASMBlockTypeFromOpcode(*Ip++);
         handleIf(BlockType);
+        countBlock(Ip);
         break;
       }
 
       case Opcode::ELSE:
         handleElse();
         CurBlock.setReachable(true);
+        countBlock(Ip);
         break;
 
       case Opcode::END:
         handleEnd();
+        if (Ip < IpEnd) {
+          countBlock(Ip);
+        }
         break;
 
       case Opcode::BR:
@@ -165,6 +186,7 @@ private:
       case Opcode::BR_IF:
         Ip = readSafeLEBNumber(Ip, U32);
         handleBranchIf(U32);
+        countBlock(Ip);
         break;
 
       case Opcode::BR_TABLE:
@@ -324,6 +346,10 @@ private:
         handleMemoryGrow();
         break;
 
+      case Opcode::MISC_PREFIX:
+        Ip = handleMiscOpcode(Ip);
+        break;
+
       case Opcode::I32_CONST:
         Ip = readSafeLEBNumber(Ip, I32);
         handleConst<WASMType::I32>(I32);
@@ -1000,6 +1026,50 @@ private:
     push(Result);
   }
 
+  const uint8_t *handleMiscOpcode(const uint8_t *Ip) {
+    uint32_t MiscOp;
+    uint32_t DataIdx;
+    Ip = readSafeLEBNumber(Ip, MiscOp);
+    switch (MiscOp) {
+    case MiscOpcode::MEMORY_INIT: {
+      Ip = readSafeLEBNumber(Ip, DataIdx);
+      // Skip the memory index(0)
+      ++Ip;
+      Operand Size = pop();
+      Operand SrcOffset = pop();
+      Operand DestOffset = pop();
+      Builder.handleMemoryInit(DataIdx, DestOffset, SrcOffset, Size);
+      break;
+    }
+    case MiscOpcode::DATA_DROP:
+      Ip = readSafeLEBNumber(Ip, DataIdx);
+      Builder.handleDataDrop(DataIdx);
+      break;
+    case MiscOpcode::MEMORY_COPY: {
+      // Skip the memory indexes(0, 0)
+      Ip += 2;
+      Operand Size = pop();
+      Operand SrcOffset = pop();
+      Operand DestOffset = pop();
+      Builder.handleMemoryCopy(DestOffset, SrcOffset, Size);
+      break;
+    }
+    case MiscOpcode::MEMORY_FILL: {
+      // Skip the memory index(0)
+      ++Ip;
+      Operand Size = pop();
+      Operand Value = pop();
+      Operand DestOffset = pop();
+      Builder.handleMemoryFill(DestOffset, Value, Size);
+      break;
+    }
+    default:
+      throw getErrorWithExtraMessage(ErrorCode::UnsupportedOpcode,
+                                     std::to_string(MiscOp));
+    }
+    return Ip;
+  }
+
   // ==================== Numeric Instruction Handlers ====================
 
   template <WASMType Ty> void handleConst(typename WASMTypeAttr<Ty>::Type Val) {
@@ -1211,6 +1281,15 @@ private:
 
   // ==================== Platform Feature Methods ====================
 
+  // count the basic block starting at Ip with the same leaders as the
+  // interpreter, see BaseInterpreterImpl::interpret
+  void countBlock(const uint8_t *Ip) {
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+    uint64_t *Counters = CurMod->getBlockCounters();
+    Builder.handleBlockCount(Counters + (Ip - CurMod->getWASMBytecode()));
+#endif // ZEN_ENABLE_BLOCK_COUNTERS
+  }
+
   void handleGasCall() {
     auto Delta = pop();
     ZEN_ASSERT(Delta.getType() == WASMType::I64);
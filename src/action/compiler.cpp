@@ -38,4 +38,37 @@ void performJITCompile(runtime::Module &Mod) {
   }
 }
 
+StreamingJITCompiler::StreamingJITCompiler(runtime::Module &Mod) : Mod(Mod) {}
+
+StreamingJITCompiler::~StreamingJITCompiler() = default;
+
+void StreamingJITCompiler::compileFunction(uint32_t FuncIdx) {
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+  const auto &Config = Mod.getRuntime()->getConfig();
+  if (Config.Mode != common::RunMode::MultipassMode ||
+      Config.EnableMultipassLazy || Config.DisableMultipassMultithread) {
+    return;
+  }
+  if (!EagerCompiler) {
+    EagerCompiler = std::make_unique<COMPILER::EagerJITCompiler>(&Mod);
+    EagerCompiler->startStreaming();
+  }
+  EagerCompiler->dispatchStreamingTask(FuncIdx -
+                                       Mod.getNumImportFunctions());
+#endif
+}
+
+void StreamingJITCompiler::finish() {
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+  if (EagerCompiler) {
+    EagerCompiler->finishStreaming();
+    EagerCompiler.reset();
+    return;
+  }
+#endif
+  if (Mod.getNumInternalFunctions() > 0) {
+    performJITCompile(Mod);
+  }
+}
+
 } // namespace zen::action
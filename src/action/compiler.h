@@ -6,10 +6,44 @@
 
 #include "runtime/module.h"
 
+#include <memory>
+
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+namespace COMPILER {
+class EagerJITCompiler;
+} // namespace COMPILER
+#endif
+
 namespace zen::action {
 
 void performJITCompile(runtime::Module &Mod);
 
+/// Compiles a module loaded by runtime::ModuleStream. In multipass eager
+/// multithread mode every function is compiled in background as soon as its
+/// body has been loaded, the other modes compile the whole module in finish
+/// like performJITCompile.
+class StreamingJITCompiler {
+public:
+  explicit StreamingJITCompiler(runtime::Module &Mod);
+
+  ~StreamingJITCompiler();
+
+  NONCOPYABLE(StreamingJITCompiler);
+
+  /// Called once the body of the function has been loaded, the layout of the
+  /// module must be computed before the first call
+  void compileFunction(uint32_t FuncIdx);
+
+  /// Called once the whole module has been loaded
+  void finish();
+
+private:
+  runtime::Module &Mod;
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+  std::unique_ptr<COMPILER::EagerJITCompiler> EagerCompiler;
+#endif
+};
+
 } // namespace zen::action
 
 #endif // ZEN_ACTION_COMPILER_H
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "action/function_loader.h"
+#include "runtime/runtime.h"
 #include "utils/others.h"
 #include "utils/wasm.h"
 
@@ -187,15 +188,15 @@ void FunctionLoader::checkTargetBlockStack(uint32_t NumTypes,
                                            const WASMType *Types,
                                            uint32_t AvailStackSize) {
   /* Check stack top values match target block type */
-  std::vector<WASMType> FuncValueTypes(ValueTypes);
+  size_t NumValues = ValueTypes.size();
   for (int32_t I = static_cast<int32_t>(NumTypes) - 1; I >= 0; --I) {
     WASMType RetType = Types[I];
     uint32_t TypeSize = getWASMTypeSize(RetType);
     if (TypeSize > AvailStackSize) {
       throw getError(ErrorCode::TypeMismatchExpectDataStackEmpty);
     }
-    WASMType Type = FuncValueTypes.back();
-    FuncValueTypes.pop_back();
+    ZEN_ASSERT(NumValues > 0);
+    WASMType Type = ValueTypes[--NumValues];
     if (Type != RetType) {
       throw getErrorWithExtraMessage(ErrorCode::TypeMismatch,
                                      getTypeErrorMsg(Type, RetType));
@@ -214,11 +215,16 @@ void FunctionLoader::checkBlockStack() {
   checkTopTypes(Block, NumReturnTypes, ReturnTypes, false);
 }
 
-const FunctionLoader::ControlBlock &FunctionLoader::checkBranch() {
+uint32_t FunctionLoader::readLabel() {
   uint32_t Depth = readU32();
   if (ControlBlocks.size() <= Depth) {
     throw getError(ErrorCode::UnknownLabel);
   }
+  return Depth;
+}
+
+const FunctionLoader::ControlBlock &FunctionLoader::checkBranch() {
+  uint32_t Depth = readLabel();
 
   const auto &TargetBlock = ControlBlocks[ControlBlocks.size() - Depth - 1];
   const ControlBlockType &BlockType = TargetBlock.BlockType;
@@ -263,13 +269,107 @@ WASMType FunctionLoader::readLocal() {
   return FuncCodeEntry.LocalTypes[LocalIdx - NumParams];
 }
 
+uint32_t FunctionLoader::readGlobal() {
+  uint32_t GlobalIdx = readU32();
+  if (!Mod.isValidGlobal(GlobalIdx)) {
+    throw getError(ErrorCode::UnknownGlobal);
+  }
+  if (GlobalIdx < Mod.getNumImportGlobals()) {
+    throw getError(ErrorCode::UnsupportedImport);
+  }
+  return GlobalIdx;
+}
+
+uint32_t FunctionLoader::readCallee() {
+  uint32_t CalleeIdx = readU32();
+  if (!Mod.isValidFunc(CalleeIdx)) {
+    throw getErrorWithExtraMessage(ErrorCode::UnknownFunction,
+                                   '#' + std::to_string(CalleeIdx));
+  }
+  return CalleeIdx;
+}
+
+uint32_t FunctionLoader::readCallIndirectType() {
+  uint32_t TypeIdx = readU32();
+  if (!Mod.isValidType(TypeIdx)) {
+    throw getError(ErrorCode::UnknownTypeIdx);
+  }
+  uint8_t TableIdx = to_underlying(readByte());
+  if (TableIdx != 0) {
+    throw getError(ErrorCode::ZeroFlagExpected);
+  }
+  if (!Mod.isValidTable(TableIdx)) {
+    throw getError(ErrorCode::UnknownTable);
+  }
+  return TypeIdx;
+}
+
+void FunctionLoader::readMemArg(uint8_t Opcode) {
+  if (!hasMemory()) {
+    throw getError(ErrorCode::UnknownMemory);
+  }
+  uint32_t Align = readU32();
+  [[maybe_unused]] uint32_t Offset = readU32();
+  if (!checkMemoryAlign(Opcode, Align)) {
+    throw getError(ErrorCode::AlignMustLargerThanNatural);
+  }
+}
+
+void FunctionLoader::readMemIdx() {
+  if (!hasMemory()) {
+    throw getError(ErrorCode::UnknownMemory);
+  }
+  if (to_underlying(readByte()) != 0x00) {
+    throw getError(ErrorCode::ZeroFlagExpected);
+  }
+}
+
+void FunctionLoader::readDataIdx() {
+  // Data segments are loaded after code, so rely on the data count
+  if (!Mod.hasDataCount()) {
+    throw getError(ErrorCode::DataCountSectionRequired);
+  }
+  uint32_t DataIdx = readU32();
+  if (DataIdx >= Mod.getDataCount()) {
+    throw getError(ErrorCode::UnknownDataSegment);
+  }
+}
+
+#ifdef ZEN_ENABLE_DWASM
+void FunctionLoader::checkDWasmLimits(uint8_t Opcode, uint32_t &NumOpcodes) {
+  size_t CurBlockDepth = ControlBlocks.size();
+  // check children blocks number
+  if (Opcode >= BLOCK && Opcode <= IF) {
+    ZEN_ASSERT(CurBlockDepth >= 2); // 1 for function body, 1 for the block
+    ControlBlock &PreBlock = ControlBlocks[CurBlockDepth - 2];
+    if (++PreBlock.NumChildBlocks > PresetMaxNumSameLevelBlocks) {
+      throw getError(ErrorCode::DWasmBlockTooLarge);
+    }
+  }
+  // check block nested depth
+  if (CurBlockDepth > 1 + PresetMaxBlockDepth) {
+    throw getError(ErrorCode::DWasmBlockNestedTooDeep);
+  }
+  // check func body children number
+  if (++NumOpcodes > PresetMaxNumOpcodesOfFunction) {
+    throw getError(ErrorCode::DWasmFuncBodyTooLarge);
+  }
+}
+#endif
+
 void FunctionLoader::load() {
   pushBlock(LABEL_FUNCTION, ControlBlockType(&FuncTypeEntry), Ptr);
+  // only the interpreter dispatches on drop_64/select_64, the JIT modes keep
+  // the code untouched so that file-backed modules stay read-only mapped
+  bool Rewrite64BitOps =
+      Mod.getRuntime()->getConfig().Mode == RunMode::InterpMode;
 #ifdef ZEN_ENABLE_DWASM
   uint32_t NumOpcodes = 0;
 #endif
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
-  std::vector<bool> CalleeIdxBitset(Mod.NumImportFunctions, true);
+  std::vector<bool, ArenaMemPoolAllocator<bool>> CalleeIdxBitset(
+      Mod.NumImportFunctions, true,
+      ArenaMemPoolAllocator<bool>(ValueTypes.get_allocator()));
   CalleeIdxBitset.resize(Mod.getNumTotalFunctions(), false);
   std::vector<uint32_t> CalleeIdxSeq;
 #endif
@@ -394,28 +494,13 @@ void FunctionLoader::load() {
       break;
     }
     case GET_GLOBAL: {
-      uint32_t GlobalIdx = readU32();
-      if (!Mod.isValidGlobal(GlobalIdx)) {
-        throw getError(ErrorCode::UnknownGlobal);
-      }
-      if (GlobalIdx < Mod.getNumImportGlobals()) {
-        throw getError(ErrorCode::UnsupportedImport);
-      }
-      WASMType GlobalType = Mod.getGlobalType(GlobalIdx);
+      WASMType GlobalType = Mod.getGlobalType(readGlobal());
       pushValueType(GlobalType);
       FuncCodeEntry.Stats |= Module::SF_global;
       break;
     }
     case SET_GLOBAL: {
-      uint32_t GlobalIdx = readU32();
-      if (!Mod.isValidGlobal(GlobalIdx)) {
-        throw getError(ErrorCode::UnknownGlobal);
-      }
-      int32_t InternalGlobalIdx =
-          int32_t(GlobalIdx) - Mod.getNumImportGlobals();
-      if (InternalGlobalIdx < 0) {
-        throw getError(ErrorCode::UnsupportedImport);
-      }
+      uint32_t InternalGlobalIdx = readGlobal() - Mod.getNumImportGlobals();
       const auto &Global = Mod.getInternalGlobal(InternalGlobalIdx);
       if (!Global.Mutable) {
         throw getError(ErrorCode::GlobalIsImmutable);
@@ -425,15 +510,7 @@ void FunctionLoader::load() {
       break;
     }
     case MEMORY_SIZE: {
-      if (!hasMemory()) {
-        throw getError(ErrorCode::UnknownMemory);
-      }
-
-      uint8_t MemIdx = to_underlying(readByte());
-      if (MemIdx != 0x00) {
-        throw getError(ErrorCode::ZeroFlagExpected);
-      }
-
+      readMemIdx();
       pushValueType(WASMType::I32);
 
       FuncCodeEntry.Stats |= Module::SF_memory;
@@ -441,15 +518,7 @@ void FunctionLoader::load() {
       break;
     }
     case MEMORY_GROW: {
-      if (!hasMemory()) {
-        throw getError(ErrorCode::UnknownMemory);
-      }
-
-      uint8_t MemIdx = to_underlying(readByte());
-      if (MemIdx != 0x00) {
-        throw getError(ErrorCode::ZeroFlagExpected);
-      }
-
+      readMemIdx();
       popAndPushValueType(1, WASMType::I32, WASMType::I32);
 
       FuncCodeEntry.Stats |= Module::SF_memory;
@@ -691,15 +760,7 @@ void FunctionLoader::load() {
     case I64_STORE8:
     case I64_STORE16:
     case I64_STORE32: {
-      if (!hasMemory()) {
-        throw getError(ErrorCode::UnknownMemory);
-      }
-
-      uint32_t Align = readU32();
-      [[maybe_unused]] uint32_t Offset = readU32();
-      if (!checkMemoryAlign(Opcode, Align)) {
-        throw getError(ErrorCode::AlignMustLargerThanNatural);
-      }
+      readMemArg(Opcode);
 
       switch (Opcode) {
       case I32_LOAD:
@@ -751,7 +812,8 @@ void FunctionLoader::load() {
     }
     case DROP: {
       WASMType Type = popValueType(WASMType::ANY);
-      if (Type == WASMType::I64 || Type == WASMType::F64) {
+      if (Rewrite64BitOps &&
+          (Type == WASMType::I64 || Type == WASMType::F64)) {
         Byte *OpcodePtr = const_cast<Byte *>(Ptr - 1);
         *OpcodePtr = Byte(DROP_64);
       }
@@ -768,7 +830,8 @@ void FunctionLoader::load() {
       }
 
       WASMType Type = Type1 != WASMType::ANY ? Type1 : Type2;
-      if (Type == WASMType::I64 || Type == WASMType::F64) {
+      if (Rewrite64BitOps &&
+          (Type == WASMType::I64 || Type == WASMType::F64)) {
         Byte *OpcodePtr = const_cast<Byte *>(Ptr - 1);
         *OpcodePtr = Byte(SELECT_64);
       }
@@ -786,11 +849,7 @@ void FunctionLoader::load() {
       break;
     }
     case CALL: {
-      uint32_t CalleeIdx = readU32();
-      if (!Mod.isValidFunc(CalleeIdx)) {
-        throw getErrorWithExtraMessage(ErrorCode::UnknownFunction,
-                                       '#' + std::to_string(CalleeIdx));
-      }
+      uint32_t CalleeIdx = readCallee();
       const TypeEntry *CalleeFuncType = Mod.getFunctionType(CalleeIdx);
       int32_t NumParams = static_cast<int32_t>(CalleeFuncType->NumParams);
       for (int32_t I = NumParams; I > 0; --I) {
@@ -800,6 +859,9 @@ void FunctionLoader::load() {
       for (uint32_t I = 0; I < CalleeFuncType->NumReturns; ++I) {
         pushValueType(CalleeFuncType->ReturnTypes[I]);
       }
+      if (CalleeIdx == Mod.getGasFuncIdx()) {
+        FuncCodeEntry.Stats |= Module::SF_gas;
+      }
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
       if (!CalleeIdxBitset[CalleeIdx]) {
         CalleeIdxBitset[CalleeIdx] = true;
@@ -809,18 +871,7 @@ void FunctionLoader::load() {
       break;
     }
     case CALL_INDIRECT: {
-      uint32_t TypeIdx = readU32();
-      if (!Mod.isValidType(TypeIdx)) {
-        throw getError(ErrorCode::UnknownTypeIdx);
-      }
-
-      uint8_t TableIdx = to_underlying(readByte());
-      if (TableIdx != 0) {
-        throw getError(ErrorCode::ZeroFlagExpected);
-      }
-      if (!Mod.isValidTable(TableIdx)) {
-        throw getError(ErrorCode::UnknownTable);
-      }
+      uint32_t TypeIdx = readCallIndirectType();
 
       popValueType(WASMType::I32);
 
@@ -836,40 +887,67 @@ void FunctionLoader::load() {
         pushValueType(CalleeFuncType->ReturnTypes[I]);
       }
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
-      const auto &LikelyCalleeIdxs = Mod.TypedFuncRefs[TypeIdx];
-      for (uint32_t CalleeIdx : LikelyCalleeIdxs) {
-        if (!CalleeIdxBitset[CalleeIdx]) {
-          CalleeIdxBitset[CalleeIdx] = true;
-          CalleeIdxSeq.push_back(CalleeIdx);
+      // Only look up, function bodies may be validated in parallel
+      auto It = Mod.TypedFuncRefs.find(TypeIdx);
+      if (It != Mod.TypedFuncRefs.end()) {
+        for (uint32_t CalleeIdx : It->second) {
+          if (!CalleeIdxBitset[CalleeIdx]) {
+            CalleeIdxBitset[CalleeIdx] = true;
+            CalleeIdxSeq.push_back(CalleeIdx);
+          }
         }
       }
 #endif
       FuncCodeEntry.Stats |= Module::SF_table;
       break;
     }
+    case MISC_PREFIX: {
+      uint32_t MiscOpcode = readU32();
+      switch (MiscOpcode) {
+      case MEMORY_INIT: {
+        readDataIdx();
+        readMemIdx();
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        FuncCodeEntry.Stats |= Module::SF_memory;
+        break;
+      }
+      case DATA_DROP:
+        readDataIdx();
+        break;
+      case MEMORY_COPY: {
+        readMemIdx(); // dst
+        readMemIdx(); // src
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        FuncCodeEntry.Stats |= Module::SF_memory;
+        break;
+      }
+      case MEMORY_FILL: {
+        readMemIdx();
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        popValueType(WASMType::I32);
+        FuncCodeEntry.Stats |= Module::SF_memory;
+        break;
+      }
+      default:
+        throw getErrorWithExtraMessage(
+            ErrorCode::UnsupportedOpcode,
+            getOpcodeHexString(Opcode) + " " +
+                std::to_string(MiscOpcode));
+      }
+      break;
+    }
     default:
       throw getErrorWithExtraMessage(ErrorCode::UnsupportedOpcode,
                                      getOpcodeHexString(Opcode));
     }
 
 #ifdef ZEN_ENABLE_DWASM
-    size_t CurBlockDepth = ControlBlocks.size();
-    // check children blocks number
-    if (Opcode >= BLOCK && Opcode <= IF) {
-      ZEN_ASSERT(CurBlockDepth >= 2); // 1 for function body, 1 for the block
-      ControlBlock &PreBlock = ControlBlocks[CurBlockDepth - 2];
-      if (++PreBlock.NumChildBlocks > PresetMaxNumSameLevelBlocks) {
-        throw getError(ErrorCode::DWasmBlockTooLarge);
-      }
-    }
-    // check block nested depth
-    if (CurBlockDepth > 1 + PresetMaxBlockDepth) {
-      throw getError(ErrorCode::DWasmBlockNestedTooDeep);
-    }
-    // check func body children number
-    if (++NumOpcodes > PresetMaxNumOpcodesOfFunction) {
-      throw getError(ErrorCode::DWasmFuncBodyTooLarge);
-    }
+    checkDWasmLimits(Opcode, NumOpcodes);
 #endif
   }
 
@@ -886,11 +964,174 @@ void FunctionLoader::load() {
   }
 
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
-  Mod.CallSeqMap[FuncIdx] = std::move(CalleeIdxSeq);
+  // The entry is inserted by ModuleLoader::loadCodeSection
+  Mod.CallSeqMap.at(FuncIdx) = std::move(CalleeIdxSeq);
 #endif
 
   FuncCodeEntry.MaxStackSize = MaxStackSize;
   FuncCodeEntry.MaxBlockDepth = MaxBlockDepth;
 }
 
+void FunctionLoader::scan() {
+  pushBlock(LABEL_FUNCTION, ControlBlockType(&FuncTypeEntry), Ptr);
+#ifdef ZEN_ENABLE_DWASM
+  uint32_t NumOpcodes = 0;
+#endif
+  while (Ptr < End) {
+    uint8_t Opcode = to_underlying(readByte());
+    switch (Opcode) {
+    case UNREACHABLE:
+    case NOP:
+    case RETURN:
+    case DROP:
+    case SELECT:
+      break;
+    case BLOCK:
+    case LOOP:
+    case IF: {
+      ControlBlockType BlockType = readBlockType();
+      auto BlockLabelTy = static_cast<LabelType>(LABEL_BLOCK + Opcode - BLOCK);
+      pushBlock(BlockLabelTy, BlockType, Ptr);
+      break;
+    }
+    case ELSE: {
+      ControlBlock &Block = ControlBlocks.back();
+      if (Block.LabelType != LABEL_IF) {
+        throw getError(ErrorCode::ElseMismatchIf);
+      }
+      Block.ElsePtr = Ptr - 1;
+      break;
+    }
+    case END:
+      if (ControlBlocks.back().LabelType == LABEL_FUNCTION) {
+        popBlock();
+        if (Ptr < End) {
+          throw getError(ErrorCode::OpcodesRemainAfterEndOfFunction);
+        }
+      } else {
+        popBlock();
+      }
+      break;
+    case BR:
+    case BR_IF:
+      readLabel();
+      break;
+    case BR_TABLE: {
+      uint32_t NumTargets = readU32();
+      for (uint32_t I = 0; I <= NumTargets; ++I) {
+        readLabel();
+      }
+      break;
+    }
+    case GET_LOCAL:
+    case SET_LOCAL:
+    case TEE_LOCAL:
+      readLocal();
+      break;
+    case GET_GLOBAL:
+      readGlobal();
+      break;
+    case SET_GLOBAL: {
+      uint32_t InternalGlobalIdx = readGlobal() - Mod.getNumImportGlobals();
+      if (!Mod.getInternalGlobal(InternalGlobalIdx).Mutable) {
+        throw getError(ErrorCode::GlobalIsImmutable);
+      }
+      break;
+    }
+    case I32_LOAD:
+    case I64_LOAD:
+    case F32_LOAD:
+    case F64_LOAD:
+    case I32_LOAD8_S:
+    case I32_LOAD8_U:
+    case I32_LOAD16_S:
+    case I32_LOAD16_U:
+    case I64_LOAD8_S:
+    case I64_LOAD8_U:
+    case I64_LOAD16_S:
+    case I64_LOAD16_U:
+    case I64_LOAD32_S:
+    case I64_LOAD32_U:
+    case I32_STORE:
+    case I64_STORE:
+    case F32_STORE:
+    case F64_STORE:
+    case I32_STORE8:
+    case I32_STORE16:
+    case I64_STORE8:
+    case I64_STORE16:
+    case I64_STORE32:
+      readMemArg(Opcode);
+      break;
+    case MEMORY_SIZE:
+    case MEMORY_GROW:
+      readMemIdx();
+      break;
+    case I32_CONST:
+      readI32();
+      break;
+    case I64_CONST:
+      readI64();
+      break;
+    case F32_CONST:
+      readF32();
+      break;
+    case F64_CONST:
+      readF64();
+      break;
+    case CALL:
+      readCallee();
+      break;
+    case CALL_INDIRECT:
+      readCallIndirectType();
+      break;
+    case MISC_PREFIX: {
+      uint32_t MiscOpcode = readU32();
+      switch (MiscOpcode) {
+      case MEMORY_INIT:
+        readDataIdx();
+        readMemIdx();
+        break;
+      case DATA_DROP:
+        readDataIdx();
+        break;
+      case MEMORY_COPY:
+        readMemIdx(); // dst
+        readMemIdx(); // src
+        break;
+      case MEMORY_FILL:
+        readMemIdx();
+        break;
+      default:
+        throw getErrorWithExtraMessage(
+            ErrorCode::UnsupportedOpcode,
+            getOpcodeHexString(Opcode) + " " +
+                std::to_string(MiscOpcode));
+      }
+      break;
+    }
+    default:
+      // The numeric operators from i32.eqz to i64.extend32_s have no
+      // immediates, see FunctionLoader::load for the individual opcodes
+      if (Opcode < I32_EQZ || Opcode > I64_EXTEND32_S) {
+        throw getErrorWithExtraMessage(ErrorCode::UnsupportedOpcode,
+                                       getOpcodeHexString(Opcode));
+      }
+      break;
+    }
+
+#ifdef ZEN_ENABLE_DWASM
+    checkDWasmLimits(Opcode, NumOpcodes);
+#endif
+  }
+
+  if (ControlBlocks.size() > 0) {
+    throw getError(ErrorCode::BlockStackNotEmptyAtEndOfFunction);
+  }
+
+  if (Ptr != End) {
+    throw getError(ErrorCode::UnexpectedEnd);
+  }
+}
+
 } // namespace zen::action
@@ -5,6 +5,7 @@
 #define ZEN_ACTION_FUNCTION_LOADER_H
 
 #include "action/loader_common.h"
+#include "common/mem_pool.h"
 
 namespace zen::action {
 
@@ -53,14 +54,24 @@ class FunctionLoader final : public LoaderCommon {
   };
 
 public:
+  /// \param Arena backs the scratch stacks of the loader, the caller may
+  /// reset it once the loader is destroyed
   explicit FunctionLoader(runtime::Module &M, const Byte *PtrStart,
                           const Byte *PtrEnd, uint32_t FuncIdx,
-                          const runtime::TypeEntry &TE, runtime::CodeEntry &CE)
+                          const runtime::TypeEntry &TE, runtime::CodeEntry &CE,
+                          common::ArenaMemPool &Arena)
       : LoaderCommon(M, PtrStart, PtrEnd), FuncIdx(FuncIdx), FuncTypeEntry(TE),
-        FuncCodeEntry(CE) {}
+        FuncCodeEntry(CE),
+        ControlBlocks(common::ArenaMemPoolAllocator<ControlBlock>(Arena)),
+        ValueTypes(common::ArenaMemPoolAllocator<WASMType>(Arena)) {}
 
   void load();
 
+  // Only checks the encoding of the body (opcodes, immediates, indices and
+  // block nesting) without tracking the operand types. Lazy validation runs
+  // it at load time and defers the full load() to the first call
+  void scan();
+
 private:
   static bool checkMemoryAlign(uint8_t Opcode, uint32_t Align);
 
@@ -118,8 +129,26 @@ private:
 
   const ControlBlock &checkBranch();
 
+  uint32_t readLabel();
+
   WASMType readLocal();
 
+  uint32_t readGlobal();
+
+  uint32_t readCallee();
+
+  uint32_t readCallIndirectType();
+
+  void readMemArg(uint8_t Opcode);
+
+  void readMemIdx();
+
+  void readDataIdx();
+
+#ifdef ZEN_ENABLE_DWASM
+  void checkDWasmLimits(uint8_t Opcode, uint32_t &NumOpcodes);
+#endif
+
   uint32_t FuncIdx;
   const runtime::TypeEntry &FuncTypeEntry;
   runtime::CodeEntry &FuncCodeEntry;
@@ -127,8 +156,9 @@ private:
   uint32_t StackSize = 0;
   uint32_t MaxStackSize = 0;
   uint32_t MaxBlockDepth = 0;
-  std::vector<ControlBlock> ControlBlocks;
-  std::vector<WASMType> ValueTypes;
+  std::vector<ControlBlock, common::ArenaMemPoolAllocator<ControlBlock>>
+      ControlBlocks;
+  std::vector<WASMType, common::ArenaMemPoolAllocator<WASMType>> ValueTypes;
 };
 
 } // namespace zen::action
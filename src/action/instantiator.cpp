@@ -87,6 +87,7 @@ void Instantiator::instantiateFunctions(Instance &Inst) {
   Inst.NumTotalFunctions = Mod.getNumTotalFunctions();
 
   uint32_t NumImportFunctions = Mod.getNumImportFunctions();
+  bool LazyValidation = Mod.getRuntime()->getConfig().EnableLazyValidation;
   if (NumImportFunctions > 0) {
     std::memset(Inst.Functions, 0,
                 sizeof(FunctionInstance) * NumImportFunctions);
@@ -123,8 +124,15 @@ void Instantiator::instantiateFunctions(Instance &Inst) {
       FuncInst.NumLocalCells = Code.NumLocalCells;
       FuncInst.LocalTypes = Code.LocalTypes;
       FuncInst.LocalOffsets = Code.LocalOffsets;
-      FuncInst.MaxStackSize = Code.MaxStackSize;
-      FuncInst.MaxBlockDepth = Code.MaxBlockDepth;
+      // Zero until validated with RuntimeConfig::EnableLazyValidation, the
+      // interpreter then fills them on the first call of every instance
+      if (!LazyValidation) {
+        FuncInst.MaxStackSize = Code.MaxStackSize;
+        FuncInst.MaxBlockDepth = Code.MaxBlockDepth;
+      } else {
+        FuncInst.MaxStackSize = 0;
+        FuncInst.MaxBlockDepth = 0;
+      }
       FuncInst.CodePtr = Code.CodePtr;
 #ifdef ZEN_ENABLE_JIT
       FuncInst.JITCodePtr = Code.JITCodePtr;
@@ -133,7 +141,6 @@ void Instantiator::instantiateFunctions(Instance &Inst) {
     }
 
 #ifdef ZEN_ENABLE_JIT
-    Inst.FuncTypeIdxs[I] = TypeIdx;
     Inst.JITFuncPtrs[I] = reinterpret_cast<uintptr_t>(FuncInst.JITCodePtr);
 #endif
   }
@@ -145,7 +152,7 @@ void Instantiator::instantiateTables(Instance &Inst) {
   const Module &Mod = *Inst.Mod;
   Inst.NumTotalTables = Mod.getNumTotalTables();
 
-  uint32_t *TableElemStart = reinterpret_cast<uint32_t *>(
+  TableElement *TableElemStart = reinterpret_cast<TableElement *>(
       (uintptr_t)Inst.Tables + Inst.Mod->Layout.TableInstancesSize);
 
   for (uint32_t I = 0; I < Inst.NumTotalTables; ++I) {
@@ -160,8 +167,10 @@ void Instantiator::instantiateTables(Instance &Inst) {
       TableInst.MaxSize = Table.MaxSize;
     }
 
-    std::memset(TableElemStart, -1, TableInst.CurSize * sizeof(uint32_t));
     TableInst.Elements = TableElemStart;
+    for (uint32_t J = 0; J < TableInst.CurSize; ++J) {
+      Inst.setTableElement(TableInst, J, -1u);
+    }
   }
 
   for (uint32_t I = 0; I < Mod.NumElementSegments; ++I) {
@@ -186,8 +195,9 @@ void Instantiator::instantiateTables(Instance &Inst) {
 #endif
     }
 
-    std::memcpy(TableInst.Elements + Offset, Element.FuncIdxs,
-                NumFuncIdxs * sizeof(uint32_t));
+    for (uint32_t J = 0; J < NumFuncIdxs; ++J) {
+      Inst.setTableElement(TableInst, Offset + J, Element.FuncIdxs[J]);
+    }
   }
 }
 
@@ -203,12 +213,20 @@ static void checkAndUpdateMemPages(uint32_t VmMaxMemPages, uint32_t CurMemPages,
 }
 
 void Instantiator::initMemoryByDataSegments(Instance &Inst) {
+  const Module *Mod = Inst.Mod;
+  Inst.DroppedDataSegs.resize(Mod->NumDataSegments);
+  for (uint32_t I = 0; I < Mod->NumDataSegments; ++I) {
+    Inst.DroppedDataSegs[I] = !Mod->DataTable[I].Passive;
+  }
+
   if (Inst.DataSegsInited) {
     return;
   }
-  const Module *Mod = Inst.Mod;
   for (uint32_t I = 0; I < Mod->NumDataSegments; ++I) {
     const auto &DataSeg = Mod->DataTable[I];
+    if (DataSeg.Passive) {
+      continue;
+    }
     uint32_t MemIdx = DataSeg.MemIdx;
     // should checked if MemIndex is valid in loader
     MemoryInstance &MemInst = Inst.Memories[MemIdx];
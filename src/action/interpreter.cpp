@@ -6,6 +6,7 @@
 #include "common/errors.h"
 #include "entrypoint/entrypoint.h"
 #include "runtime/instance.h"
+#include "runtime/runtime.h"
 #include "utils/logging.h"
 #include "utils/wasm.h"
 #include <bitset>
@@ -22,6 +23,14 @@ using namespace runtime;
 // local_ptr <-----> frame <-----> control stack <----> value stack
 InterpFrame *InterpreterExecContext::allocFrame(FunctionInstance *FuncInst,
                                                 uint32_t *LocalPtr) {
+  // Not validated yet with RuntimeConfig::EnableLazyValidation
+  if (ZEN_UNLIKELY(FuncInst->MaxBlockDepth == 0) &&
+      FuncInst->Kind == FunctionKind::ByteCode) {
+    uint32_t FuncIdx = FuncInst - ModInst->getFunctionInst(0);
+    const CodeEntry &Code = ModInst->getModule()->validateFunction(FuncIdx);
+    FuncInst->MaxStackSize = Code.MaxStackSize;
+    FuncInst->MaxBlockDepth = Code.MaxBlockDepth;
+  }
   InterpStack *Stack = getInterpStack();
   uint32_t LocalSize = FuncInst->NumLocalCells << 2;
   uint32_t ControlSize = FuncInst->MaxBlockDepth * sizeof(BlockInfo);
@@ -568,6 +577,28 @@ private:
       case MEMORY_GROW:
         Ptr = skipLEBNumber<uint32_t>(Ptr, End);
         break;
+      case MISC_PREFIX: {
+        uint32_t MiscOpcode;
+        Ptr = readSafeLEBNumber(Ptr, MiscOpcode);
+        switch (MiscOpcode) {
+        case MEMORY_INIT:
+          Ptr = skipLEBNumber<uint32_t>(Ptr, End);
+          Ptr++;
+          break;
+        case DATA_DROP:
+          Ptr = skipLEBNumber<uint32_t>(Ptr, End);
+          break;
+        case MEMORY_COPY:
+          Ptr += 2;
+          break;
+        case MEMORY_FILL:
+          Ptr++;
+          break;
+        default:
+          ZEN_ASSERT_TODO();
+        }
+        break;
+      }
       case RETURN:
         break;
       case CALL: {
@@ -1147,6 +1178,30 @@ void BaseInterpreterImpl::interpret() {
   const uint8_t *EndAddr = nullptr;
   uint8_t Opcode;
 
+  // polled before calls and on branches back to a loop header
+  const bool CheckInterrupt =
+      ModInst->getRuntime()->getConfig().EnableInterruption;
+#define CHECK_INTERRUPT()                                                      \
+  if (CheckInterrupt && ModInst->isInterruptRequested()) {                     \
+    throw getError(ErrorCode::Interrupted);                                    \
+  }
+#define CHECK_INTERRUPT_ON_LOOP()                                              \
+  if ((ControlStackPtr - 1)->LabelType == LABEL_LOOP) {                        \
+    CHECK_INTERRUPT()                                                          \
+    COUNT_BLOCK();                                                             \
+  }
+
+  // count the basic block starting at Ip, leaders are the function entry and
+  // the instructions following loop, if, else, end and br_if, the same ones
+  // instrumented by WASMByteCodeVisitor for JIT
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  uint64_t *BlockCounters = Mod->getBlockCounters();
+  const uint8_t *Bytecode = Mod->getWASMBytecode();
+#define COUNT_BLOCK() ++BlockCounters[Ip - Bytecode]
+#else
+#define COUNT_BLOCK()
+#endif // ZEN_ENABLE_BLOCK_COUNTERS
+
   Frame->blockPush(ControlStackPtr, IpEnd - 1, ValStackPtr,
                    FuncInst->NumReturnCells, LABEL_FUNCTION);
 
@@ -1157,6 +1212,7 @@ void BaseInterpreterImpl::interpret() {
                  FuncInst); // the last arg is useless
     return;
   }
+  COUNT_BLOCK();
 
   while (Ip < IpEnd) {
     SWITCH(Ip) {
@@ -1181,11 +1237,13 @@ void BaseInterpreterImpl::interpret() {
       CASE(LOOP) : {
         uint32_t CellNum = getWASMTypeCellNumFromOpcode(*Ip++);
         Frame->blockPush(ControlStackPtr, Ip, ValStackPtr, CellNum, LABEL_LOOP);
+        COUNT_BLOCK();
         BREAK;
       }
       CASE(BR) : {
         Ip = readSafeLEBNumber(Ip, Depth);
         Frame->blockPop(ControlStackPtr, ValStackPtr, Ip, Depth);
+        CHECK_INTERRUPT_ON_LOOP();
         BREAK;
       }
       CASE(BR_IF) : {
@@ -1193,6 +1251,9 @@ void BaseInterpreterImpl::interpret() {
         Cond = Frame->valuePop<int32_t>(ValStackPtr);
         if (Cond) {
           Frame->blockPop(ControlStackPtr, ValStackPtr, Ip, Depth);
+          CHECK_INTERRUPT_ON_LOOP();
+        } else {
+          COUNT_BLOCK();
         }
         BREAK;
       }
@@ -1206,6 +1267,7 @@ void BaseInterpreterImpl::interpret() {
         }
         Ip = readSafeLEBNumber(Ip, Depth);
         Frame->blockPop(ControlStackPtr, ValStackPtr, Ip, Depth);
+        CHECK_INTERRUPT_ON_LOOP();
         BREAK;
       }
       CASE(DROP) : {
@@ -1233,6 +1295,7 @@ void BaseInterpreterImpl::interpret() {
             Ip = ElseAddr + 1;
           }
         }
+        COUNT_BLOCK();
         BREAK;
       }
       CASE(ELSE) : {
@@ -1395,6 +1458,54 @@ void BaseInterpreterImpl::interpret() {
         Frame->valuePush(ValStackPtr, Memory->CurPages);
         BREAK;
       }
+      CASE(MISC_PREFIX) : {
+        uint32_t MiscOpcode;
+        Ip = readSafeLEBNumber(Ip, MiscOpcode);
+        switch (MiscOpcode) {
+        case MEMORY_INIT: {
+          uint32_t DataIdx;
+          Ip = readSafeLEBNumber(Ip, DataIdx);
+          Ip++;
+          uint32_t Size = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t SrcOffset = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t DestOffset = Frame->valuePop<uint32_t>(ValStackPtr);
+          if (!ModInst->initLinearMemory(DataIdx, DestOffset, SrcOffset,
+                                         Size)) {
+            throw getError(ErrorCode::OutOfBoundsMemory);
+          }
+          break;
+        }
+        case DATA_DROP: {
+          uint32_t DataIdx;
+          Ip = readSafeLEBNumber(Ip, DataIdx);
+          ModInst->dropDataSegment(DataIdx);
+          break;
+        }
+        case MEMORY_COPY: {
+          Ip += 2;
+          uint32_t Size = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t SrcOffset = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t DestOffset = Frame->valuePop<uint32_t>(ValStackPtr);
+          if (!ModInst->copyLinearMemory(DestOffset, SrcOffset, Size)) {
+            throw getError(ErrorCode::OutOfBoundsMemory);
+          }
+          break;
+        }
+        case MEMORY_FILL: {
+          Ip++;
+          uint32_t Size = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t Value = Frame->valuePop<uint32_t>(ValStackPtr);
+          uint32_t DestOffset = Frame->valuePop<uint32_t>(ValStackPtr);
+          if (!ModInst->fillLinearMemory(DestOffset, uint8_t(Value), Size)) {
+            throw getError(ErrorCode::OutOfBoundsMemory);
+          }
+          break;
+        }
+        default:
+          ZEN_ASSERT_TODO();
+        }
+        BREAK;
+      }
       CASE(F32_STORE) : CASE(I32_STORE) : {
         storeOp<uint32_t, uint32_t>(*Memory, Ip, IpEnd, Frame, ValStackPtr,
                                     LinearMemSize);
@@ -2032,9 +2143,13 @@ void BaseInterpreterImpl::interpret() {
 #undef HANDLE_CHECKED_ARITHMETIC_CALL_POSTHOOK
 #endif // ZEN_ENABLE_CHECKED_ARITHMETIC
 
+        CHECK_INTERRUPT();
         FunctionInstance *FuncInstCallee = ModInst->getFunctionInst(FuncIdx);
         callFuncInst(FuncInstCallee, Context, Ip, IpEnd, Frame, ValStackPtr,
                      ControlStackPtr, LocalPtr, FuncInst);
+        if (FuncInstCallee->Kind == FunctionKind::ByteCode) {
+          COUNT_BLOCK();
+        }
         BREAK;
       }
       CASE(CALL_INDIRECT) : {
@@ -2051,26 +2166,32 @@ void BaseInterpreterImpl::interpret() {
             (uint32_t)IndirectFuncIdx >= Table->CurSize) {
           throw getError(ErrorCode::UndefinedElement);
         }
-        FuncIdx = Table->Elements[IndirectFuncIdx];
+        const TableElement &Elem = Table->Elements[IndirectFuncIdx];
+        FuncIdx = Elem.FuncIdx;
 #ifdef ZEN_ENABLE_DEBUG_INTERP
         ZEN_LOG_DEBUG("fidx: %d", FuncIdx);
 #endif
-        if (FuncIdx == (uint32_t)-1) {
-          throw getError(ErrorCode::UninitializedElement);
+        // uninitialized elements never match any type
+        if (Elem.TypeIdx != ExpectedFuncType->SmallestTypeIdx) {
+          if (FuncIdx == (uint32_t)-1) {
+            throw getError(ErrorCode::UninitializedElement);
+          }
+          throw getError(ErrorCode::IndirectCallTypeMismatch);
         }
         auto *FuncInstCallee = ModInst->getFunctionInst(FuncIdx);
         ZEN_ASSERT(FuncInstCallee);
-        auto *ActualFuncType = FuncInstCallee->FuncType;
-        if (!TypeEntry::isEqual(ActualFuncType, ExpectedFuncType)) {
-          throw getError(ErrorCode::IndirectCallTypeMismatch);
-        }
+        CHECK_INTERRUPT();
         callFuncInst(FuncInstCallee, Context, Ip, IpEnd, Frame, ValStackPtr,
                      ControlStackPtr, LocalPtr, FuncInst);
+        if (FuncInstCallee->Kind == FunctionKind::ByteCode) {
+          COUNT_BLOCK();
+        }
         BREAK;
       }
       CASE(END) : {
         if (ControlStackPtr > Frame->CtrlBasePtr + 1) {
           Frame->blockPop(ControlStackPtr);
+          COUNT_BLOCK();
         } else {
           // return
           Context.freeFrame(FuncInst, Frame);
@@ -2099,6 +2220,9 @@ void BaseInterpreterImpl::interpret() {
     }
     // TODO: write back ValueStackPtr, Ip, CtrlStackPtr to Frame
   }
+#undef COUNT_BLOCK
+#undef CHECK_INTERRUPT_ON_LOOP
+#undef CHECK_INTERRUPT
 }
 
 void BaseInterpreter::interpret() {
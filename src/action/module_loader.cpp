@@ -3,10 +3,15 @@
 
 #include "action/module_loader.h"
 #include "action/function_loader.h"
+#include "common/thread_pool.h"
+#include "runtime/runtime.h"
 #include "runtime/symbol_wrapper.h"
 #include "utils/unicode.h"
 #include "utils/wasm.h"
 
+#include <atomic>
+#include <mutex>
+
 #ifdef ZEN_ENABLE_CHECKED_ARITHMETIC
 #include "action/hook.h"
 #endif
@@ -40,24 +45,73 @@ void HostModuleLoader::load() {
 }
 
 void ModuleLoader::load() {
-  if (!Start) {
-    throw getError(ErrorCode::UnexpectedEnd);
-  }
+  loadAvailable(ModuleSize);
+  finishLoad();
+}
+
+void ModuleLoader::loadAvailable(size_t NumAvailBytes) {
+  ZEN_ASSERT(NumAvailBytes <= ModuleSize);
+
+  if (!HeaderLoaded) {
+    if (!Start) {
+      throw getError(ErrorCode::UnexpectedEnd);
+    }
 
-  // Set `End` if the module size is valid, otherwise throw error
-  if (addOverflow(Start, ModuleSize, End)) {
-    throw getError(ErrorCode::ModuleSizeTooLarge);
+    // Set `End` if the module size is valid, otherwise throw error
+    if (addOverflow(Start, ModuleSize, End)) {
+      throw getError(ErrorCode::ModuleSizeTooLarge);
+    }
   }
 
-  loadModuleHeader();
+  Avail = Start + NumAvailBytes;
+  Complete = NumAvailBytes == ModuleSize;
+
+  if (!HeaderLoaded) {
+    if (!isAvailable(Ptr, 2 * sizeof(uint32_t))) {
+      return;
+    }
+    loadModuleHeader();
+    HeaderLoaded = true;
+  }
 
   loadModuleBody();
+}
+
+void ModuleLoader::finishLoad() {
+  ZEN_ASSERT(Complete && Ptr == End);
+
+  // Check function number consistency
+  if (Mod.NumInternalFunctions != Mod.NumCodeSegments) {
+    throw getError(ErrorCode::FuncCodeInconsistent);
+  }
+
+  // Check data segment number consistency when the data section is absent
+  if (Mod.hasDataCount() && Mod.NumDataSegments != Mod.DataCount) {
+    throw getError(ErrorCode::DataSegAndDataCountInconsistent);
+  }
 
 #ifdef ZEN_ENABLE_SPEC_TEST
   patchForSpecTest();
 #endif
 }
 
+bool ModuleLoader::isLEBAvailable(const Byte *P) const {
+  if (Complete) {
+    return true;
+  }
+  // Longer numbers are rejected by `readLEB`
+  constexpr size_t MaxLEBBytes = 5;
+  for (size_t I = 0; I < MaxLEBBytes; ++I) {
+    if (!isAvailable(P, I + 1)) {
+      return false;
+    }
+    if ((to_underlying(P[I]) & 0x80) == 0) {
+      break;
+    }
+  }
+  return true;
+}
+
 WASMSymbol ModuleLoader::readName() {
   uint32_t NameLen = readU32();
   Bytes NameBytes = readBytes(NameLen);
@@ -295,20 +349,32 @@ void ModuleLoader::loadModuleHeader() {
 }
 
 void ModuleLoader::loadModuleBody() {
-  SectionOrder LastSecOrder = SectionOrder::SEC_ORDER_CUSTOM;
   while (Ptr < End) {
+    if (CodeSecEnd) {
+      if (!loadFunctionBodies()) {
+        return;
+      }
+      continue;
+    }
+
+    // Leave the section to the next call if it is not entirely available,
+    // except the code section whose function bodies are loaded one by one
+    const Byte *SecStart = Ptr;
+    if (!isLEBAvailable(Ptr + 1)) {
+      return;
+    }
     const auto [SecType, SecSize] = loadSectionHeader();
 
     if (SecType > SectionType::SEC_LAST) {
       throw getError(ErrorCode::InvalidSectionId);
     }
     // Ensure the order of sections
+    SectionOrder SecOrder = LastSecOrder;
     if (SecType != SectionType::SEC_CUSTOM) {
-      SectionOrder SecOrder = getSectionOrder(SecType);
+      SecOrder = getSectionOrder(SecType);
       if (SecOrder <= LastSecOrder) {
         throw getError(ErrorCode::JunkAfterLastSection);
       }
-      LastSecOrder = SecOrder;
     }
     if (HasNameSection && SecType != SectionType::SEC_CUSTOM) {
       throw getError(ErrorCode::InvalidNameSectionPosition);
@@ -322,6 +388,13 @@ void ModuleLoader::loadModuleBody() {
       throw getError(ErrorCode::UnexpectedEnd);
     }
 
+    if (SecType == SectionType::SEC_CODE ? !isLEBAvailable(Ptr)
+                                         : !isAvailable(Ptr, SecSize)) {
+      Ptr = SecStart;
+      return;
+    }
+    LastSecOrder = SecOrder;
+
     // Swap `SecEnd` and `End` and restore after loading current section
     std::swap(SecEnd, End);
     switch (SecType) {
@@ -359,7 +432,9 @@ void ModuleLoader::loadModuleBody() {
       loadDataCountSection();
       break;
     case SectionType::SEC_CODE:
+      // The function bodies are loaded by `loadFunctionBodies`
       loadCodeSection();
+      CodeSecEnd = End;
       break;
     case SectionType::SEC_DATA:
       loadDataSection();
@@ -369,16 +444,11 @@ void ModuleLoader::loadModuleBody() {
     }
     std::swap(SecEnd, End);
 
-    if (Ptr != SecEnd) {
+    if (!CodeSecEnd && Ptr != SecEnd) {
       throw getError(ErrorCode::SectionSizeMismath);
     }
   }
 
-  // Check function number consistency
-  if (Mod.NumInternalFunctions != Mod.NumCodeSegments) {
-    throw getError(ErrorCode::FuncCodeInconsistent);
-  }
-
   ZEN_ASSERT(Ptr == End);
 }
 
@@ -851,129 +921,250 @@ void ModuleLoader::loadCodeSection() {
     throw getError(ErrorCode::FuncCodeInconsistent);
   }
 
-  // Calculate the distance between callsite and callee in AArch64 singlepass
-  uint32_t CodeOffset = 0;
+  Mod.initCodeTable(NumCodes);
+  NextFuncIdx = Mod.getNumImportFunctions();
+  CodeOffset = 0;
 
-  CodeEntry *Entry = Mod.initCodeTable(NumCodes);
-  uint32_t NumImportFunctions = Mod.getNumImportFunctions();
-  uint32_t NumTotalFunctions = NumImportFunctions + NumCodes;
-  for (uint32_t I = NumImportFunctions; I < NumTotalFunctions; ++I) {
-    uint32_t CodeSize = readU32();
-    if (CodeSize > PresetMaxFunctionSize) {
-      throw getError(ErrorCode::FunctionSizeTooLarge);
-    }
+  // The function bodies are handed one by one to the callback, so they are
+  // validated in place in that case
+  ValidateInParallel = !FunctionLoadedCallback && NumCodes > 1 &&
+                       Mod.getRuntime()->getConfig().NumLoaderThreads > 1;
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+  // Insert all the entries up front, so that function loaders running in
+  // parallel only assign their own
+  Mod.CallSeqMap.reserve(NumCodes);
+  for (uint32_t I = 0; I < NumCodes; ++I) {
+    Mod.CallSeqMap.try_emplace(NextFuncIdx + I);
+  }
+#endif
+}
 
-    // Include `vec(locals) expr`
-    const Byte *CodePtrStart = Ptr;
-    uint32_t NumLocals = 0;
-    uint32_t NumLocalCells = 0;
-    uint32_t NumLocalVectors = readU32();
-    const Byte *PrevPtr = Ptr;
-
-    // First pass to get the total number and cells of locals
-    for (uint32_t J = 0; J < NumLocalVectors; ++J) {
-      // Number of same type locals
-      uint32_t NumSameLocals = readU32();
-      if (addOverflow(NumLocals, NumSameLocals, NumLocals)) {
-        throw getError(ErrorCode::TooManyLocals);
+bool ModuleLoader::loadFunctionBodies() {
+  ZEN_ASSERT(CodeSecEnd);
+  // Swap `CodeSecEnd` and `End` and restore after loading the bodies
+  std::swap(CodeSecEnd, End);
+  uint32_t NumTotalFunctions = Mod.getNumTotalFunctions();
+  bool Loaded = true;
+  try {
+    while (NextFuncIdx < NumTotalFunctions) {
+      const Byte *BodyStart = Ptr;
+      if (!isLEBAvailable(Ptr)) {
+        Loaded = false;
+        break;
       }
-
-      WASMType Type = readValType();
-      uint32_t NumCells = getWASMTypeCellNum(Type);
-
-      uint32_t NumSameLocalCells;
-      if (mulOverflow(NumSameLocals, NumCells, NumSameLocalCells) ||
-          addOverflow(NumLocalCells, NumSameLocalCells, NumLocalCells)) {
-        throw getError(ErrorCode::TooManyLocals);
+      uint32_t CodeSize = readU32();
+      if (CodeSize > PresetMaxFunctionSize) {
+        throw getError(ErrorCode::FunctionSizeTooLarge);
       }
+      if (!isAvailable(Ptr, CodeSize)) {
+        Ptr = BodyStart;
+        Loaded = false;
+        break;
+      }
+      loadFunctionBody(NextFuncIdx, CodeSize);
+      if (FunctionLoadedCallback) {
+        FunctionLoadedCallback(NextFuncIdx);
+      }
+      ++NextFuncIdx;
     }
+  } catch (const Error &) {
+    // An invalid body before the failing function wins, as in serial loading
+    validateFunctions();
+    throw;
+  }
+  std::swap(CodeSecEnd, End);
+
+  if (!Loaded) {
+    return false;
+  }
+  validateFunctions();
+  if (Ptr != CodeSecEnd) {
+    throw getError(ErrorCode::SectionSizeMismath);
+  }
+  CodeSecEnd = nullptr;
+  return true;
+}
 
-    if (NumLocals > PresetMaxFunctionLocals ||
-        NumLocalCells > PresetMaxFunctionLocalCells) {
+void ModuleLoader::loadFunctionBody(uint32_t FuncIdx, uint32_t CodeSize) {
+  CodeEntry *Entry = Mod.getCodeEntry(FuncIdx);
+  ZEN_ASSERT(Entry);
+
+  // Include `vec(locals) expr`
+  const Byte *CodePtrStart = Ptr;
+  uint32_t NumLocals = 0;
+  uint32_t NumLocalCells = 0;
+  uint32_t NumLocalVectors = readU32();
+  const Byte *PrevPtr = Ptr;
+
+  // First pass to get the total number and cells of locals
+  for (uint32_t J = 0; J < NumLocalVectors; ++J) {
+    // Number of same type locals
+    uint32_t NumSameLocals = readU32();
+    if (addOverflow(NumLocals, NumSameLocals, NumLocals)) {
       throw getError(ErrorCode::TooManyLocals);
     }
 
-    WASMType *LocalTypes = Mod.initLocalTypes(NumLocals);
-    WASMType *LocalTypesPtr = LocalTypes;
-    Ptr = PrevPtr;
+    WASMType Type = readValType();
+    uint32_t NumCells = getWASMTypeCellNum(Type);
 
-    // Second pass to set the local types
-    for (uint32_t J = 0; J < NumLocalVectors; ++J) {
-      uint32_t NumSameLocals = readU32();
-      WASMType Type = readValType();
-      std::memset(LocalTypesPtr, to_underlying(Type), NumSameLocals);
-      if (addOverflow(LocalTypesPtr, NumSameLocals, LocalTypesPtr)) {
-        throw getError(ErrorCode::TooManyLocals);
-      }
+    uint32_t NumSameLocalCells;
+    if (mulOverflow(NumSameLocals, NumCells, NumSameLocalCells) ||
+        addOverflow(NumLocalCells, NumSameLocalCells, NumLocalCells)) {
+      throw getError(ErrorCode::TooManyLocals);
     }
+  }
+
+  if (NumLocals > PresetMaxFunctionLocals ||
+      NumLocalCells > PresetMaxFunctionLocalCells) {
+    throw getError(ErrorCode::TooManyLocals);
+  }
+
+  WASMType *LocalTypes = Mod.initLocalTypes(NumLocals);
+  WASMType *LocalTypesPtr = LocalTypes;
+  Ptr = PrevPtr;
 
-    TypeEntry *FuncType = Mod.getFunctionType(I);
-    ZEN_ASSERT(FuncType);
-    uint32_t NumParamsAndLocals;
-    if (addOverflow(static_cast<uint32_t>(FuncType->NumParams), NumLocals,
-                    NumParamsAndLocals)) {
+  // Second pass to set the local types
+  for (uint32_t J = 0; J < NumLocalVectors; ++J) {
+    uint32_t NumSameLocals = readU32();
+    WASMType Type = readValType();
+    std::memset(LocalTypesPtr, to_underlying(Type), NumSameLocals);
+    if (addOverflow(LocalTypesPtr, NumSameLocals, LocalTypesPtr)) {
       throw getError(ErrorCode::TooManyLocals);
     }
-    size_t TotalLocalSize = NumParamsAndLocals * sizeof(uint32_t);
-    if (TotalLocalSize > 0) {
-      Entry->LocalOffsets = Mod.initLocalOffsets(TotalLocalSize);
-
-      const WASMType *ParamTypes = FuncType->getParamTypes();
-      uint32_t LocalOffset = 0;
-
-      // Set the offsets of parameters
-      for (uint32_t J = 0; J < FuncType->NumParams; ++J) {
-        Entry->LocalOffsets[J] = LocalOffset;
-        uint32_t ParamSize = getWASMTypeCellNum(ParamTypes[J]);
-        if (addOverflow(LocalOffset, ParamSize, LocalOffset)) {
-          throw getError(ErrorCode::TooManyParams);
-        }
+  }
+
+  TypeEntry *FuncType = Mod.getFunctionType(FuncIdx);
+  ZEN_ASSERT(FuncType);
+  uint32_t NumParamsAndLocals;
+  if (addOverflow(static_cast<uint32_t>(FuncType->NumParams), NumLocals,
+                  NumParamsAndLocals)) {
+    throw getError(ErrorCode::TooManyLocals);
+  }
+  size_t TotalLocalSize = NumParamsAndLocals * sizeof(uint32_t);
+  if (TotalLocalSize > 0) {
+    Entry->LocalOffsets = Mod.initLocalOffsets(TotalLocalSize);
+
+    const WASMType *ParamTypes = FuncType->getParamTypes();
+    uint32_t LocalOffset = 0;
+
+    // Set the offsets of parameters
+    for (uint32_t J = 0; J < FuncType->NumParams; ++J) {
+      Entry->LocalOffsets[J] = LocalOffset;
+      uint32_t ParamSize = getWASMTypeCellNum(ParamTypes[J]);
+      if (addOverflow(LocalOffset, ParamSize, LocalOffset)) {
+        throw getError(ErrorCode::TooManyParams);
       }
+    }
 
-      // Set the offsets of local variables
-      for (uint32_t J = 0; J < NumLocals; ++J) {
-        Entry->LocalOffsets[FuncType->NumParams + J] = LocalOffset;
-        uint32_t LocalSize = getWASMTypeCellNum(LocalTypes[J]);
-        if (addOverflow(LocalOffset, LocalSize, LocalOffset)) {
-          throw getError(ErrorCode::TooManyLocals);
-        }
+    // Set the offsets of local variables
+    for (uint32_t J = 0; J < NumLocals; ++J) {
+      Entry->LocalOffsets[FuncType->NumParams + J] = LocalOffset;
+      uint32_t LocalSize = getWASMTypeCellNum(LocalTypes[J]);
+      if (addOverflow(LocalOffset, LocalSize, LocalOffset)) {
+        throw getError(ErrorCode::TooManyLocals);
       }
+    }
 
 #if defined(ZEN_ENABLE_DWASM) && defined(ZEN_ENABLE_JIT)
-      Entry->JITStackCost = (LocalOffset << 2) + 64;
+    Entry->JITStackCost = (LocalOffset << 2) + 64;
 #endif
-    } else {
+  } else {
 #if defined(ZEN_ENABLE_DWASM) && defined(ZEN_ENABLE_JIT)
-      Entry->JITStackCost = 64;
+    Entry->JITStackCost = 64;
 #endif
-    }
+  }
 
-    // ActualCodeSize < CodeSize < PresetMaxFunctionSize < UINT32_MAX
-    uint32_t ActualCodeSize = CodePtrStart + CodeSize - Ptr;
+  // ActualCodeSize < CodeSize < PresetMaxFunctionSize < UINT32_MAX
+  uint32_t ActualCodeSize = CodePtrStart + CodeSize - Ptr;
 
-    Entry->NumLocals = static_cast<uint16_t>(NumLocals);
-    Entry->NumLocalCells = static_cast<uint16_t>(NumLocalCells);
-    Entry->LocalTypes = LocalTypes;
-    Entry->CodePtr = reinterpret_cast<const uint8_t *>(Ptr);
-    Entry->CodeSize = ActualCodeSize;
-    Entry->CodeOffset = CodeOffset;
-    Entry->Stats = Module::SF_none;
+  Entry->NumLocals = static_cast<uint16_t>(NumLocals);
+  Entry->NumLocalCells = static_cast<uint16_t>(NumLocalCells);
+  Entry->LocalTypes = LocalTypes;
+  Entry->CodePtr = reinterpret_cast<const uint8_t *>(Ptr);
+  Entry->CodeSize = ActualCodeSize;
+  Entry->CodeOffset = CodeOffset;
+  Entry->Stats = Module::SF_none;
 
-    const Byte *CodePtrEnd;
-    if (addOverflow(Ptr, ActualCodeSize, CodePtrEnd) || CodePtrEnd > End) {
-      throw getError(ErrorCode::UnexpectedEnd);
-    }
+  const Byte *CodePtrEnd;
+  if (addOverflow(Ptr, ActualCodeSize, CodePtrEnd) || CodePtrEnd > End) {
+    throw getError(ErrorCode::UnexpectedEnd);
+  }
 
-    FunctionLoader FuncLoader(Mod, Ptr, CodePtrEnd, I, *FuncType, *Entry);
+  if (Mod.getRuntime()->getConfig().EnableLazyValidation) {
+    // Malformed bodies are still rejected here, only the type checking is left
+    // to the first call by Module::validateFunction
+    LoaderArena.reset();
+    FunctionLoader FuncLoader(Mod, Ptr, CodePtrEnd, FuncIdx, *FuncType,
+                              *Entry, LoaderArena);
+    FuncLoader.scan();
+  } else if (ValidateInParallel) {
+    PendingFunctions.push_back({FuncIdx, Ptr, CodePtrEnd});
+  } else {
+    LoaderArena.reset();
+    FunctionLoader FuncLoader(Mod, Ptr, CodePtrEnd, FuncIdx, *FuncType,
+                              *Entry, LoaderArena);
     FuncLoader.load();
+  }
+
+  Ptr = CodePtrEnd;
+  if (addOverflow(CodeOffset, ActualCodeSize, CodeOffset) ||
+      CodeOffset > PresetMaxTotalFunctionSize) {
+    throw getError(ErrorCode::CodeSectionTooLarge);
+  }
+}
+
+void ModuleLoader::validateFunctions() {
+  if (PendingFunctions.empty()) {
+    return;
+  }
 
-    Ptr = CodePtrEnd;
-    if (addOverflow(CodeOffset, ActualCodeSize, CodeOffset) ||
-        CodeOffset > PresetMaxTotalFunctionSize) {
-      throw getError(ErrorCode::CodeSectionTooLarge);
+  size_t NumPendings = PendingFunctions.size();
+  // Index of the first invalid function in `PendingFunctions`
+  std::atomic<size_t> FailedPos = NumPendings;
+  std::mutex ErrorMutex;
+  Error FirstError = ErrorCode::NoError;
+  std::atomic<size_t> NextPos = 0;
+
+  auto ValidateTask = [&](void *) {
+    common::ArenaMemPool Arena;
+    while (true) {
+      size_t Pos = NextPos++;
+      // Functions after an invalid one never get reported
+      if (Pos >= NumPendings || Pos > FailedPos) {
+        return;
+      }
+      const PendingFunction &Func = PendingFunctions[Pos];
+      Arena.reset();
+      try {
+        FunctionLoader FuncLoader(Mod, Func.Start, Func.End, Func.FuncIdx,
+                                  *Mod.getFunctionType(Func.FuncIdx),
+                                  *Mod.getCodeEntry(Func.FuncIdx), Arena);
+        FuncLoader.load();
+      } catch (const Error &Err) {
+        std::scoped_lock Lock(ErrorMutex);
+        if (Pos < FailedPos) {
+          FailedPos = Pos;
+          FirstError = Err;
+        }
+      }
     }
+  };
 
-    ++Entry;
+  uint32_t NumThreads = Mod.getRuntime()->getConfig().NumLoaderThreads;
+  NumThreads = std::min<size_t>(NumThreads, NumPendings);
+  {
+    common::ThreadPool<void> Pool(NumThreads);
+    for (uint32_t I = 0; I < NumThreads; ++I) {
+      Pool.pushTask(ValidateTask);
+    }
+    // Let the idle threads exit instead of spinning until all tasks are done
+    Pool.setNoNewTask();
+    Pool.waitForTasks();
+  }
+  PendingFunctions.clear();
+
+  if (FailedPos < NumPendings) {
+    throw FirstError;
   }
 }
 
@@ -991,12 +1182,24 @@ void ModuleLoader::loadDataSection() {
   uint32_t TotalDataSize = 0;
   DataEntry *Entry = Mod.initDataTable(NumDataSegments);
   for (uint32_t I = 0; I < NumDataSegments; ++I) {
-    uint32_t MemIdx = readU32();
-    if (!Mod.isValidMem(MemIdx)) {
-      throw getError(ErrorCode::UnknownMemory);
+    // 0: active on memory 0, 1: passive, 2: active with memory index
+    uint32_t Kind = readU32();
+    if (Kind > 2) {
+      throw getError(ErrorCode::InvalidDataSegmentKind);
     }
 
-    const auto [ExprKind, Expr] = readConstExpr(WASMType::I32);
+    uint32_t MemIdx = 0;
+    uint8_t ExprKind = 0;
+    InitExpr Expr{};
+    if (Kind != 1) {
+      if (Kind == 2) {
+        MemIdx = readU32();
+      }
+      if (!Mod.isValidMem(MemIdx)) {
+        throw getError(ErrorCode::UnknownMemory);
+      }
+      std::tie(ExprKind, Expr) = readConstExpr(WASMType::I32);
+    }
 
     uint32_t DataSegmentSize = readU32();
     if (DataSegmentSize > PresetMaxDataSegmentSize ||
@@ -1013,6 +1216,7 @@ void ModuleLoader::loadDataSection() {
     Entry->Size = DataSegmentSize;
     Entry->Offset = DataPtrOffset;
     Entry->InitExprKind = ExprKind;
+    Entry->Passive = Kind == 1;
     Entry->InitExprVal = Expr;
 
     ++Entry;
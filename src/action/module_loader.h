@@ -5,6 +5,9 @@
 #define ZEN_ACTION_MODULE_LOADER_H
 
 #include "action/loader_common.h"
+#include "common/mem_pool.h"
+
+#include <functional>
 
 namespace zen::action {
 
@@ -41,6 +44,19 @@ public:
 
   void load();
 
+  /// Load the sections and function bodies entirely within the first
+  /// `NumAvailBytes` bytes of a module received in chunks, see
+  /// runtime::ModuleStream. May be called again as more bytes arrive, the
+  /// module is loaded once called with the whole size and then finishLoad.
+  void loadAvailable(size_t NumAvailBytes);
+
+  void finishLoad();
+
+  /// Called with the index of each function once its body has been loaded
+  void setFunctionLoadedCallback(std::function<void(uint32_t)> Callback) {
+    FunctionLoadedCallback = std::move(Callback);
+  }
+
 private:
   ModuleLoader(runtime::Module &M, const Byte *PtrStart, const Byte *PtrEnd)
       : LoaderCommon(M, PtrStart, PtrEnd) {}
@@ -56,6 +72,14 @@ private:
   const void *resolveImportFunction(WASMSymbol ModuleName, WASMSymbol FieldName,
                                     const runtime::TypeEntry &ExpectedFuncType);
 
+  // Whether `Size` bytes from `P` are available, always true once the whole
+  // module is, so that truncated modules report the same errors
+  bool isAvailable(const Byte *P, size_t Size) const {
+    return Complete || (P <= Avail && Size <= size_t(Avail - P));
+  }
+
+  bool isLEBAvailable(const Byte *P) const;
+
   std::pair<SectionType, uint32_t> loadSectionHeader() {
     SectionType SecType = static_cast<SectionType>(readByte());
     uint32_t SecSize = readU32();
@@ -76,6 +100,9 @@ private:
   void loadElementSection();
   void loadDataCountSection();
   void loadCodeSection();
+  bool loadFunctionBodies();
+  void loadFunctionBody(uint32_t FuncIdx, uint32_t CodeSize);
+  void validateFunctions();
   void loadDataSection();
 
   void loadNameSection();
@@ -86,6 +113,31 @@ private:
 
   bool HasNameSection = false;
   size_t ModuleSize = 0;
+
+  // State kept between the calls to loadAvailable
+  const Byte *Avail = nullptr;
+  bool Complete = false;
+  bool HeaderLoaded = false;
+  common::SectionOrder LastSecOrder = common::SectionOrder::SEC_ORDER_CUSTOM;
+  // Non-null while loading the function bodies of the code section
+  const Byte *CodeSecEnd = nullptr;
+  uint32_t NextFuncIdx = 0;
+  // Calculate the distance between callsite and callee in AArch64 singlepass
+  uint32_t CodeOffset = 0;
+  std::function<void(uint32_t)> FunctionLoadedCallback;
+
+  // Function bodies whose validation is deferred to validateFunctions, which
+  // runs them on RuntimeConfig::NumLoaderThreads threads
+  struct PendingFunction {
+    uint32_t FuncIdx;
+    const Byte *Start;
+    const Byte *End;
+  };
+  bool ValidateInParallel = false;
+  std::vector<PendingFunction> PendingFunctions;
+  // Scratch memory of the function bodies loaded on the loading thread, reset
+  // between functions
+  common::ArenaMemPool LoaderArena;
 }; // class ModuleLoader
 
 } // namespace zen::action
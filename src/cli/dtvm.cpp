@@ -7,6 +7,11 @@
 #include "utils/statistics.h"
 #include "zetaengine.h"
 #include <CLI/CLI.hpp>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unistd.h>
 
 #ifdef ZEN_ENABLE_BUILTIN_WASI
@@ -25,6 +30,14 @@
 #include <gperftools/profiler.h>
 #endif
 
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+#include "runtime/profiler.h"
+#endif
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+#include "runtime/block_profile.h"
+#endif
+
 using namespace zen::common;
 using namespace zen::runtime;
 using namespace zen::utils;
@@ -41,6 +54,43 @@ int exitMain(int ExitCode, Runtime *RT = nullptr) {
   return ExitCode;
 }
 
+// Interrupts the instance when the timeout expires, unless cancelled before
+class InterruptTimer {
+public:
+  InterruptTimer(Instance &Inst, uint32_t TimeoutMs) {
+    if (TimeoutMs == 0) {
+      return;
+    }
+    Thread = std::thread([this, &Inst, TimeoutMs] {
+      std::unique_lock<std::mutex> Lock(Mtx);
+      if (!CV.wait_for(Lock, std::chrono::milliseconds(TimeoutMs),
+                       [this] { return Cancelled; })) {
+        Inst.interrupt();
+      }
+    });
+  }
+
+  ~InterruptTimer() { cancel(); }
+
+  void cancel() {
+    if (!Thread.joinable()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> Lock(Mtx);
+      Cancelled = true;
+    }
+    CV.notify_one();
+    Thread.join();
+  }
+
+private:
+  std::thread Thread;
+  std::mutex Mtx;
+  std::condition_variable CV;
+  bool Cancelled = false;
+};
+
 // when evmabi test enabled, we need fuzz test by cli, so we need all output
 // fixed
 #ifdef ZEN_ENABLE_EVMABI_TEST
@@ -72,6 +122,10 @@ int main(int argc, char *argv[]) {
   std::vector<std::string> Envs;
   std::vector<std::string> Dirs;
   uint64_t GasLimit = UINT64_MAX;
+  uint32_t TimeoutMs = 0;
+  std::string ProfileFilename;
+  uint32_t ProfileIntervalUs = 1000;
+  std::string BlockProfileFilename;
   LoggerLevel LogLevel = LoggerLevel::Info;
   uint32_t NumExtraCompilations = 0;
   uint32_t NumExtraExecutions = 0;
@@ -100,16 +154,49 @@ int main(int argc, char *argv[]) {
     CLIParser->add_option("--env", Envs, "Environment variables");
     CLIParser->add_option("--dir", Dirs, "Work directories");
     CLIParser->add_option("--gas-limit", GasLimit, "Gas limit");
+    CLIParser->add_option("--timeout", TimeoutMs,
+                          "Interrupt the entry function after the given "
+                          "milliseconds(0 for no timeout)");
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+    CLIParser->add_option("--profile", ProfileFilename,
+                          "Sample the execution and write folded stacks for "
+                          "flamegraph.pl to the file");
+    CLIParser->add_option("--profile-interval", ProfileIntervalUs,
+                          "Sampling interval in microseconds of cpu time");
+#endif
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+    CLIParser->add_option("--block-profile", BlockProfileFilename,
+                          "Write the basic block and opcode execution counts "
+                          "of the module to the file");
+#endif
     CLIParser->add_option("--log-level", LogLevel, "Log level")
         ->transform(CLI::CheckedTransformer(LogMap, CLI::ignore_case));
+    CLIParser->add_option("--num-loader-threads", Config.NumLoaderThreads,
+                          "Number of threads validating function bodies "
+                          "while loading(0 or 1 for the loading thread only)");
+    CLIParser->add_flag("--enable-lazy-validation",
+                        Config.EnableLazyValidation,
+                        "Validate function bodies on their first call instead "
+                        "of while loading(interpreter only)");
     CLIParser->add_option("--num-extra-compilations", NumExtraCompilations,
                           "The number of extra compilations");
     CLIParser->add_option("--num-extra-executions", NumExtraExecutions,
                           "The number of extra executions");
     CLIParser->add_flag("--enable-statistics", Config.EnableStatistics,
                         "Enable statistics");
+    CLIParser->add_flag("--enable-hardware-counters",
+                        Config.EnableHardwareCounters,
+                        "Count cpu cycles, instructions and misses per "
+                        "statistics phase(needs --enable-statistics)");
     CLIParser->add_flag("--disable-wasm-memory-map",
                         Config.DisableWasmMemoryMap, "Disable wasm memory map");
+    CLIParser->add_flag("--enable-huge-pages", Config.EnableHugePages,
+                        "Back wasm memory and JIT code with transparent huge "
+                        "pages");
+    CLIParser->add_flag("--enable-numa-local-memory",
+                        Config.EnableNumaLocalMemory,
+                        "Allocate wasm memory and JIT code on the NUMA node of "
+                        "the executing thread");
     CLIParser->add_flag("--benchmark", EnableBenchmark, "Enable benchmark");
     // If you want to trace the cpu instructions of wasm func,
     // you can qemu-x86_64 -cpu qemu64,+ssse3,+sse4.1,+sse4.2,+x2apic
@@ -151,6 +238,10 @@ int main(int argc, char *argv[]) {
 
   /// ================ Create ZetaEngine runtime ================
 
+  if (TimeoutMs > 0) {
+    Config.EnableInterruption = true;
+  }
+
   std::unique_ptr<Runtime> RT = Runtime::newRuntime(Config);
   if (!RT) {
     ZEN_LOG_ERROR("failed to create runtime");
@@ -235,6 +326,18 @@ int main(int argc, char *argv[]) {
 
   /// ================ Call function ================
 
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  std::unique_ptr<SamplingProfiler> Profiler;
+  if (!ProfileFilename.empty()) {
+    Profiler = SamplingProfiler::start(*RT, ProfileIntervalUs);
+    if (!Profiler) {
+      ZEN_LOG_ERROR("failed to start sampling profiler");
+      return exitMain(EXIT_FAILURE, RT.get());
+    }
+  }
+#endif
+
+  InterruptTimer Timer(*Inst, TimeoutMs);
   std::vector<TypedValue> Results;
   if (!FuncName.empty()) {
     /// Call the specified function
@@ -259,6 +362,7 @@ int main(int argc, char *argv[]) {
       return exitMain(EXIT_FAILURE, RT.get());
     }
   }
+  Timer.cancel();
 
   /// ========== Extra compilations and executions for benchmarking ==========
 
@@ -293,6 +397,41 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  /// ================ Write profile ================
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  if (Profiler) {
+    FILE *ProfileFile = std::fopen(ProfileFilename.c_str(), "w");
+    bool Written = ProfileFile && Profiler->writeFoldedStacks(ProfileFile);
+    if (ProfileFile) {
+      std::fclose(ProfileFile);
+    }
+    if (!Written) {
+      ZEN_LOG_ERROR("failed to write profile to %s", ProfileFilename.c_str());
+      return exitMain(EXIT_FAILURE, RT.get());
+    }
+    ZEN_LOG_INFO("%" PRIu64 " samples written to %s(%" PRIu64 " dropped)",
+                 Profiler->getNumSamples(), ProfileFilename.c_str(),
+                 Profiler->getNumDroppedSamples());
+    Profiler.reset();
+  }
+#endif
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  if (!BlockProfileFilename.empty()) {
+    FILE *ProfileFile = std::fopen(BlockProfileFilename.c_str(), "w");
+    bool Written = ProfileFile && writeBlockProfile(*Mod, ProfileFile);
+    if (ProfileFile) {
+      std::fclose(ProfileFile);
+    }
+    if (!Written) {
+      ZEN_LOG_ERROR("failed to write block profile to %s",
+                    BlockProfileFilename.c_str());
+      return exitMain(EXIT_FAILURE, RT.get());
+    }
+  }
+#endif
+
 #ifdef ZEN_ENABLE_BUILTIN_WASI
   int ExitCode = Inst->getExitCode();
 #else
@@ -46,6 +46,12 @@ enum Opcode {
 #undef DEFINE_WASM_OPCODE
 }; // Opcode
 
+enum MiscOpcode : uint32_t {
+#define DEFINE_WASM_MISC_OPCODE(NAME, OPCODE, TEXT) NAME = OPCODE,
+#include "common/wasm_defs/opcode_misc.def"
+#undef DEFINE_WASM_MISC_OPCODE
+}; // MiscOpcode
+
 enum LabelType {
   LABEL_BLOCK,
   LABEL_LOOP,
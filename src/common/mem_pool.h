@@ -7,6 +7,8 @@
 #include "common/defines.h"
 #include "common/errors.h"
 #include "platform/map.h"
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
 #include <vector>
 
@@ -220,6 +222,17 @@ public:
 
   NONCOPYABLE(MemPool);
 
+  // Must be called before any allocation, the policies only take effect on
+  // pages faulted in later
+  void applyMemoryPolicy(bool HugePages, bool NumaLocal) {
+    if (HugePages) {
+      platform::adviseHugePages(MemStart, MaxCodeSize);
+    }
+    if (NumaLocal) {
+      platform::bindLocalNumaNode(MemStart, MaxCodeSize);
+    }
+  }
+
   void *allocate(size_t Size, size_t Align = DefaultAlign) {
     if (!Size) {
       return nullptr;
@@ -294,6 +307,11 @@ private:
 
 using CodeMemPool = MemPool<CODE_POOL>;
 
+/// Bump allocator for data that lives as long as one compilation unit, such
+/// as the evaluation and control stacks of a function. deallocate is a no-op
+/// and reset rewinds the pool in O(1), keeping its blocks for the next unit,
+/// so compiling a module only hits the system allocator until the largest
+/// function has been seen. The blocks are freed with the pool.
 template <> class MemPool<ALLOC_ONLY_POOL> {
 private:
   struct Block {
@@ -301,18 +319,94 @@ private:
     Block *Next;
     uint8_t *Avail;
     uint8_t *Ceil;
-  };
 
-#if 0 // unused yet
-    Block *BLK;
-    uint32_t BlockSize;
-    uint32_t Level;
-#endif
+    uint8_t *getStart() { return reinterpret_cast<uint8_t *>(this + 1); }
+  };
 
 public:
-  MemPool(uint32_t BlockSize) {}
+  MemPool(size_t BlockSize = DefaultBlockSize) : BlockSize(BlockSize) {}
+
+  ~MemPool() {
+    while (First) {
+      Block *Next = First->Next;
+      std::free(First);
+      First = Next;
+    }
+  }
+
+  NONCOPYABLE(MemPool);
+
+  void *allocate(size_t Size, size_t Align = alignof(std::max_align_t)) {
+    if (!Size) {
+      return nullptr;
+    }
+    if (Cur) {
+      uintptr_t Ptr = ZEN_ALIGN(reinterpret_cast<uintptr_t>(Cur->Avail), Align);
+      if (Ptr <= reinterpret_cast<uintptr_t>(Cur->Ceil) &&
+          Size <= reinterpret_cast<uintptr_t>(Cur->Ceil) - Ptr) {
+        Cur->Avail = reinterpret_cast<uint8_t *>(Ptr + Size);
+        return reinterpret_cast<void *>(Ptr);
+      }
+    }
+    switchBlock(Size + Align);
+    return allocate(Size, Align);
+  }
+
+  void deallocate([[maybe_unused]] void *Ptr,
+                  [[maybe_unused]] size_t Size = 0) {}
+
+  /// Release everything allocated so far at once
+  void reset() {
+    Cur = First;
+    if (Cur) {
+      Cur->Avail = Cur->getStart();
+    }
+  }
+
+  template <typename T, typename... Arguments>
+  T *newObject(Arguments &&...Args) {
+    void *Ptr = allocate(sizeof(T), alignof(T));
+    return new (Ptr) T(std::forward<Arguments>(Args)...);
+  }
+
+  static constexpr size_t DefaultBlockSize = 16 * 1024;
+
+private:
+  // Move to the next retained block if it has room for Size bytes, otherwise
+  // insert a new one after the current block
+  void switchBlock(size_t Size) {
+    Block *Next = Cur ? Cur->Next : First;
+    if (!Next || static_cast<size_t>(Next->Ceil - Next->getStart()) < Size) {
+      size_t Capacity = std::max(BlockSize, Size);
+      Block *NewBlock =
+          static_cast<Block *>(std::malloc(sizeof(Block) + Capacity));
+      if (!NewBlock) {
+        ZEN_ABORT();
+      }
+      NewBlock->Prev = Cur;
+      NewBlock->Next = Next;
+      NewBlock->Ceil = NewBlock->getStart() + Capacity;
+      if (Next) {
+        Next->Prev = NewBlock;
+      }
+      if (Cur) {
+        Cur->Next = NewBlock;
+      } else {
+        First = NewBlock;
+      }
+      Next = NewBlock;
+    }
+    Next->Avail = Next->getStart();
+    Cur = Next;
+  }
+
+  Block *First = nullptr;
+  Block *Cur = nullptr;
+  size_t BlockSize;
 };
 
+using ArenaMemPool = MemPool<ALLOC_ONLY_POOL>;
+
 template <typename MemPoolType> class Destroyer {
 public:
   Destroyer(MemPoolType &MPool) : MPool(MPool) {}
@@ -403,6 +497,9 @@ inline bool operator!=(const MemPoolAllocator<T, MemPoolType> &LHS,
 template <typename T>
 using SysMemPoolAllocator = MemPoolAllocator<T, SysMemPool>;
 
+template <typename T>
+using ArenaMemPoolAllocator = MemPoolAllocator<T, ArenaMemPool>;
+
 } // namespace zen::common
 
 #endif // ZEN_COMMON_MEM_POOL_H
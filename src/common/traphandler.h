@@ -77,8 +77,27 @@ public:
 
   CallThreadState *parent() const { return Parent; }
 
+  // used to move the states of a suspended call between threads, see
+  // runtime::ResumableCall
+  static void setCurrent(CallThreadState *State) {
+    currentThreadStateOrUpdate(State, State == nullptr);
+  }
+
+  void setParent(CallThreadState *NewParent) { Parent = NewParent; }
+
   jmp_buf *jmpbuf() { return JmpBuf; }
 
+  runtime::Instance *instance() const { return Inst; }
+
+  // rebind to the instance of the next call when one state serves a batch of
+  // calls, dropping the trap state of the previous call
+  void setInstance(runtime::Instance *NewInst) {
+    Inst = NewInst;
+    setTrapFrameAddr(nullptr, nullptr, nullptr, 0);
+    CurGasRegisterValue = 0;
+    Traces.clear();
+  }
+
   void setHandler(SigActionHandlerType Handler) { restartHandler(); }
 
   void stopHandler() { Handling = false; }
@@ -354,21 +354,7 @@ void WasmJITCompiler::compileWasmToMC(WasmFrontendContext &Ctx, MModule &Mod,
   Ctx.getMCLowering().runOnCgFunction(CgFunc);
 }
 
-void EagerJITCompiler::compile() {
-  auto Timer = Stats.startRecord(zen::utils::StatisticPhase::JITCompilation);
-
-  WasmFrontendContext MainContext(*WasmMod);
-  auto &MainMemPool = MainContext.ThreadMemPool;
-
-  MModule Mod(MainContext);
-  buildAllMIRFuncTypes(MainContext, Mod, *WasmMod);
-  MainContext.CodeMPool = &WasmMod->getJITCodeMemPool();
-
-  const uint32_t NumImportFunctions = WasmMod->getNumImportFunctions();
-  ZEN_ASSERT(NumInternalFunctions > 0);
-
 #ifdef ZEN_ENABLE_LINUX_PERF
-  utils::JitDumpWriter JitDumpWriter;
 #define JIT_DUMP_WRITE_FUNC(FuncIdx, FuncAddr, FuncSize)                       \
   JitDumpWriter.writeFunc(WasmMod->getWasmFuncDebugName(FuncIdx),              \
                           reinterpret_cast<uint64_t>(FuncAddr), FuncSize)
@@ -377,7 +363,6 @@ void EagerJITCompiler::compile() {
 #endif
 
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
-  auto &SortedJITFuncPtrs = WasmMod->getSortedJITFuncPtrs();
 #define INSERT_JITED_FUNC_PTR(JITCodePtr, FuncIdx)                             \
   SortedJITFuncPtrs.emplace_back(JITCodePtr, FuncIdx)
 #define SORT_JITED_FUNC_PTRS                                                   \
@@ -389,51 +374,31 @@ void EagerJITCompiler::compile() {
 #define SORT_JITED_FUNC_PTRS
 #endif // ZEN_ENABLE_DUMP_CALL_STACK
 
-  auto &CodeMPool = WasmMod->getJITCodeMemPool();
-  uint8_t *JITCode = const_cast<uint8_t *>(CodeMPool.getMemStart());
-  if (Config.DisableMultipassMultithread) {
-    for (uint32_t I = 0; I < NumInternalFunctions; ++I) {
-      compileWasmToMC(MainContext, Mod, I, Config.DisableMultipassGreedyRA);
-    }
-    emitObjectBuffer(&MainContext);
-    ZEN_ASSERT(MainContext.ExternRelocs.empty());
-    for (const auto &[FuncIdx, FuncOffset] : MainContext.FuncOffsetMap) {
-      uint32_t RealFuncIdx = NumImportFunctions + FuncIdx;
-      CodeEntry *CE = WasmMod->getCodeEntry(RealFuncIdx);
-      ZEN_ASSERT(CE);
-      CE->JITCodePtr = MainContext.CodePtr + FuncOffset;
-      JIT_DUMP_WRITE_FUNC(RealFuncIdx, CE->JITCodePtr,
-                          MainContext.FuncSizeMap[FuncIdx]);
-      INSERT_JITED_FUNC_PTR((void *)(CE->JITCodePtr), RealFuncIdx);
-    }
-  } else {
-    common::ThreadPool<WasmFrontendContext> ThreadPool(
-        std::min(Config.NumMultipassThreads, NumInternalFunctions));
-    uint32_t NumThreads = ThreadPool.getThreadCount();
-    ZEN_LOG_DEBUG("using %u threads for multipass JIT compilation", NumThreads);
-
-    CompileVector<WasmFrontendContext> AuxContexts(NumThreads - 1, MainContext,
-                                                   MainMemPool);
-    // Some threads may not have compiled functions, so when all compilation
-    // tasks are completed, in the context of these threads:
-    // - Inited == false
-    // - CodePtr == nullptr
-    // - CodeSize == 0
-    // - CodeOffset == 0
-    // - FuncOffsetMap.empty() == true
-    // - ExternRelocs.empty() == true
-    CompileVector<WasmFrontendContext *> Contexts(MainMemPool);
-
-    ThreadPool.setThreadContext(0, &MainContext, emitObjectBuffer);
-    Contexts.push_back(&MainContext);
-    for (uint32_t I = 0; I < NumThreads - 1; ++I) {
-      ThreadPool.setThreadContext(I + 1, &AuxContexts[I], emitObjectBuffer);
-      Contexts.push_back(&AuxContexts[I]);
-    }
+EagerJITCompiler::EagerJITCompiler(Module *WasmMod)
+    : WasmJITCompiler(WasmMod) {}
+
+EagerJITCompiler::~EagerJITCompiler() {
+  // Abandoned streaming compilation
+  if (ThreadPool) {
+    ThreadPool->interrupt();
+  }
+  if (MainContext) {
+    MainContext->ThreadMemPool.deleteObject(Mod);
+    delete MainContext;
+  }
+}
+
+void EagerJITCompiler::compile() {
+  ZEN_ASSERT(NumInternalFunctions > 0);
+
+  if (!Config.DisableMultipassMultithread) {
+    startStreaming();
 
     // Sort functions by code size in descending order in order to compile
     // larger functions first
-    CompileVector<std::pair<uint32_t, uint32_t>> FuncIdxAndSizes(MainMemPool);
+    const uint32_t NumImportFunctions = WasmMod->getNumImportFunctions();
+    CompileVector<std::pair<uint32_t, uint32_t>> FuncIdxAndSizes(
+        MainContext->ThreadMemPool);
     FuncIdxAndSizes.reserve(NumInternalFunctions);
     for (uint32_t I = 0; I < NumInternalFunctions; ++I) {
       CodeEntry *CE = WasmMod->getCodeEntry(NumImportFunctions + I);
@@ -446,47 +411,134 @@ void EagerJITCompiler::compile() {
               });
 
     for (const auto &[FuncIdx, FuncSize] : FuncIdxAndSizes) {
-      ThreadPool.pushTask([&, FuncIdx = FuncIdx](WasmFrontendContext *Ctx) {
-        compileWasmToMC(*Ctx, Mod, FuncIdx, Config.DisableMultipassGreedyRA);
-      });
+      dispatchStreamingTask(FuncIdx);
     }
 
-    ThreadPool.setNoNewTask();
-    // Must call the `waitForTasks` method explicitly, because `Contexts` will
-    // be destructed before `ThreadPool`
-    ThreadPool.waitForTasks();
-
-    CompileUnorderedMap<uint32_t, WasmFrontendContext *> FuncIdxToCtxIdMap(
-        MainMemPool);
-    FuncIdxToCtxIdMap.reserve(NumInternalFunctions);
-    for (WasmFrontendContext *Ctx : Contexts) {
-      for (const auto &[FuncIdx, FuncSymOffset] : Ctx->FuncOffsetMap) {
-        FuncIdxToCtxIdMap[FuncIdx] = Ctx;
-        uint32_t RealFuncIdx = NumImportFunctions + FuncIdx;
-        CodeEntry *CE = WasmMod->getCodeEntry(RealFuncIdx);
-        ZEN_ASSERT(CE);
-        CE->JITCodePtr = Ctx->CodePtr + FuncSymOffset;
-        JIT_DUMP_WRITE_FUNC(RealFuncIdx, CE->JITCodePtr,
-                            Ctx->FuncSizeMap[FuncIdx]);
-        INSERT_JITED_FUNC_PTR((void *)(CE->JITCodePtr), RealFuncIdx);
-      }
+    finishStreaming();
+    return;
+  }
+
+  auto Timer = Stats.startRecord(zen::utils::StatisticPhase::JITCompilation);
+
+  WasmFrontendContext Context(*WasmMod);
+  MModule MMod(Context);
+  buildAllMIRFuncTypes(Context, MMod, *WasmMod);
+  Context.CodeMPool = &WasmMod->getJITCodeMemPool();
+
+  for (uint32_t I = 0; I < NumInternalFunctions; ++I) {
+    compileWasmToMC(Context, MMod, I, Config.DisableMultipassGreedyRA);
+  }
+  emitObjectBuffer(&Context);
+  ZEN_ASSERT(Context.ExternRelocs.empty());
+
+  CompileVector<WasmFrontendContext *> Contexts(Context.ThreadMemPool);
+  Contexts.push_back(&Context);
+  linkFunctions(Contexts);
+
+  Stats.stopRecord(Timer);
+}
+
+void EagerJITCompiler::startStreaming() {
+  ZEN_ASSERT(!Config.DisableMultipassMultithread);
+  ZEN_ASSERT(NumInternalFunctions > 0);
+  ZEN_ASSERT(!MainContext);
+
+  StreamingTimer =
+      Stats.startRecord(zen::utils::StatisticPhase::JITCompilation);
+
+  MainContext = new WasmFrontendContext(*WasmMod);
+  MainContext->CodeMPool = &WasmMod->getJITCodeMemPool();
+  Mod = MainContext->ThreadMemPool.newObject<MModule>(*MainContext);
+  buildAllMIRFuncTypes(*MainContext, *Mod, *WasmMod);
+
+  ThreadPool = std::make_unique<common::ThreadPool<WasmFrontendContext>>(
+      std::min(Config.NumMultipassThreads, NumInternalFunctions));
+  uint32_t NumThreads = ThreadPool->getThreadCount();
+  ZEN_LOG_DEBUG("using %u threads for multipass JIT compilation", NumThreads);
+
+  // Some threads may not have compiled functions, so when all compilation
+  // tasks are completed, in the context of these threads:
+  // - Inited == false
+  // - CodePtr == nullptr
+  // - CodeSize == 0
+  // - CodeOffset == 0
+  // - FuncOffsetMap.empty() == true
+  // - ExternRelocs.empty() == true
+  AuxContexts =
+      std::vector<WasmFrontendContext>(NumThreads - 1, *MainContext);
+  ThreadPool->setThreadContext(0, MainContext, emitObjectBuffer);
+  for (uint32_t I = 0; I < NumThreads - 1; ++I) {
+    ThreadPool->setThreadContext(I + 1, &AuxContexts[I], emitObjectBuffer);
+  }
+}
+
+void EagerJITCompiler::dispatchStreamingTask(uint32_t FuncIdx) {
+  ZEN_ASSERT(ThreadPool);
+  ThreadPool->pushTask([this, FuncIdx](WasmFrontendContext *Ctx) {
+    compileWasmToMC(*Ctx, *Mod, FuncIdx, Config.DisableMultipassGreedyRA);
+  });
+}
+
+void EagerJITCompiler::finishStreaming() {
+  ZEN_ASSERT(ThreadPool);
+  ThreadPool->setNoNewTask();
+  // Must wait for the tail tasks explicitly before reading the contexts
+  ThreadPool->waitForTasks();
+  ThreadPool.reset();
+
+  CompileVector<WasmFrontendContext *> Contexts(MainContext->ThreadMemPool);
+  Contexts.push_back(MainContext);
+  for (WasmFrontendContext &Ctx : AuxContexts) {
+    Contexts.push_back(&Ctx);
+  }
+  linkFunctions(Contexts);
+
+  Stats.stopRecord(StreamingTimer);
+}
+
+void EagerJITCompiler::linkFunctions(
+    const CompileVector<WasmFrontendContext *> &Contexts) {
+#ifdef ZEN_ENABLE_LINUX_PERF
+  utils::JitDumpWriter JitDumpWriter;
+#endif
+#ifdef ZEN_ENABLE_DUMP_CALL_STACK
+  auto &SortedJITFuncPtrs = WasmMod->getSortedJITFuncPtrs();
+#endif
+
+  const uint32_t NumImportFunctions = WasmMod->getNumImportFunctions();
+  auto &CodeMPool = WasmMod->getJITCodeMemPool();
+  uint8_t *JITCode = const_cast<uint8_t *>(CodeMPool.getMemStart());
+
+  CompileUnorderedMap<uint32_t, WasmFrontendContext *> FuncIdxToCtxIdMap(
+      Contexts.front()->ThreadMemPool);
+  FuncIdxToCtxIdMap.reserve(NumInternalFunctions);
+  for (WasmFrontendContext *Ctx : Contexts) {
+    for (const auto &[FuncIdx, FuncSymOffset] : Ctx->FuncOffsetMap) {
+      FuncIdxToCtxIdMap[FuncIdx] = Ctx;
+      uint32_t RealFuncIdx = NumImportFunctions + FuncIdx;
+      CodeEntry *CE = WasmMod->getCodeEntry(RealFuncIdx);
+      ZEN_ASSERT(CE);
+      CE->JITCodePtr = Ctx->CodePtr + FuncSymOffset;
+      JIT_DUMP_WRITE_FUNC(RealFuncIdx, CE->JITCodePtr,
+                          Ctx->FuncSizeMap[FuncIdx]);
+      INSERT_JITED_FUNC_PTR((void *)(CE->JITCodePtr), RealFuncIdx);
     }
-    for (WasmFrontendContext *Ctx : Contexts) {
-      for (const auto &Reloc : Ctx->ExternRelocs) {
-        auto It = FuncIdxToCtxIdMap.find(Reloc.CalleeFuncIdx);
-        if (It == FuncIdxToCtxIdMap.end()) {
-          throw getError(ErrorCode::ObjectFileResolvingFailed);
-        }
-        WasmFrontendContext *CalleeCtx = It->second;
-        uint64_t RelOffset = Ctx->CodeOffset + Reloc.Offset;
-        uint64_t FuncSymValue = CalleeCtx->CodeOffset +
-                                CalleeCtx->FuncOffsetMap[Reloc.CalleeFuncIdx];
-        uint64_t RelValue = FuncSymValue + Reloc.Addend - RelOffset;
-        JITCode[RelOffset] = RelValue & 0xff;
-        JITCode[RelOffset + 1] = (RelValue >> 8) & 0xff;
-        JITCode[RelOffset + 2] = (RelValue >> 16) & 0xff;
-        JITCode[RelOffset + 3] = (RelValue >> 24) & 0xff;
+  }
+  for (WasmFrontendContext *Ctx : Contexts) {
+    for (const auto &Reloc : Ctx->ExternRelocs) {
+      auto It = FuncIdxToCtxIdMap.find(Reloc.CalleeFuncIdx);
+      if (It == FuncIdxToCtxIdMap.end()) {
+        throw getError(ErrorCode::ObjectFileResolvingFailed);
       }
+      WasmFrontendContext *CalleeCtx = It->second;
+      uint64_t RelOffset = Ctx->CodeOffset + Reloc.Offset;
+      uint64_t FuncSymValue = CalleeCtx->CodeOffset +
+                              CalleeCtx->FuncOffsetMap[Reloc.CalleeFuncIdx];
+      uint64_t RelValue = FuncSymValue + Reloc.Addend - RelOffset;
+      JITCode[RelOffset] = RelValue & 0xff;
+      JITCode[RelOffset + 1] = (RelValue >> 8) & 0xff;
+      JITCode[RelOffset + 2] = (RelValue >> 16) & 0xff;
+      JITCode[RelOffset + 3] = (RelValue >> 24) & 0xff;
     }
   }
   size_t CodeSize = CodeMPool.getMemEnd() - JITCode;
@@ -496,8 +548,6 @@ void EagerJITCompiler::compile() {
   WasmMod->setJITCodeAndSize(JITCode, CodeSize);
 
   SORT_JITED_FUNC_PTRS;
-
-  Stats.stopRecord(Timer);
 }
 
 LazyJITCompiler::LazyJITCompiler(Module *WasmMod)
@@ -661,7 +711,8 @@ void LazyJITCompiler::compileFunctionInBackgroud(WasmFrontendContext &Ctx,
                                                  uint32_t FuncIdx) {
   ZEN_LOG_DEBUG("compile function %d in background", FuncIdx);
   CompileStatuses[FuncIdx] = CompileStatus::InProgress;
-  auto Timer = Stats.startRecord(utils::StatisticPhase::JITLazyBgCompilation);
+  auto Timer =
+      Stats.startRecord(utils::StatisticPhase::JITLazyBgCompilation, FuncIdx);
   uint8_t *JITFuncCodePtr =
       compileFunction(Ctx, FuncIdx, Config.DisableMultipassGreedyRA);
   uint8_t *FuncStubCodePtr = StubBuilder.getFuncStubCodePtr(FuncIdx);
@@ -674,7 +725,8 @@ void LazyJITCompiler::compileFunctionInBackgroud(WasmFrontendContext &Ctx,
 uint8_t *LazyJITCompiler::compileFunctionOnRequest(uint8_t *FuncStubCodePtr) {
   uint32_t FuncIdx = StubBuilder.getFuncIdxByStubCodePtr(FuncStubCodePtr);
   if (!ThreadPool) { // Single thread lazy mode
-    auto Timer = Stats.startRecord(utils::StatisticPhase::JITLazyFgCompilation);
+    auto Timer =
+        Stats.startRecord(utils::StatisticPhase::JITLazyFgCompilation, FuncIdx);
     uint8_t *JITFuncCodePtr =
         compileFunction(*MainContext, FuncIdx, Config.DisableMultipassGreedyRA);
     JITStubBuilder::updateStubJmpTargetPtr(FuncStubCodePtr, JITFuncCodePtr);
@@ -685,7 +737,8 @@ uint8_t *LazyJITCompiler::compileFunctionOnRequest(uint8_t *FuncStubCodePtr) {
     return GreedyRACodePtrs[FuncIdx];
   }
   ZEN_LOG_DEBUG("compile function %d on request", FuncIdx);
-  auto Timer = Stats.startRecord(utils::StatisticPhase::JITLazyFgCompilation);
+  auto Timer =
+      Stats.startRecord(utils::StatisticPhase::JITLazyFgCompilation, FuncIdx);
   // Compile the function with fastRA for faster compilation
   uint8_t *JITFuncCodePtr = compileFunction(*MainContext, FuncIdx, true);
   Stats.stopRecord(Timer);
@@ -45,11 +45,30 @@ protected:
 
 class EagerJITCompiler final : public WasmJITCompiler {
 public:
-  EagerJITCompiler(runtime::Module *WasmMod) : WasmJITCompiler(WasmMod) {}
+  EagerJITCompiler(runtime::Module *WasmMod);
 
-  ~EagerJITCompiler() override = default;
+  ~EagerJITCompiler() override;
 
   void compile();
+
+  /// Multithread compilation of a module loaded by runtime::ModuleStream:
+  /// every function is compiled in the thread pool as soon as its body has
+  /// been loaded, and the functions are linked once all are dispatched
+  void startStreaming();
+
+  void dispatchStreamingTask(uint32_t FuncIdx);
+
+  void finishStreaming();
+
+private:
+  void linkFunctions(const CompileVector<WasmFrontendContext *> &Contexts);
+
+  // These five fields are only used in multithread compilation
+  WasmFrontendContext *MainContext = nullptr;
+  MModule *Mod = nullptr;
+  std::vector<WasmFrontendContext> AuxContexts;
+  std::unique_ptr<common::ThreadPool<WasmFrontendContext>> ThreadPool;
+  uint32_t StreamingTimer = 0;
 };
 
 class LazyJITCompiler final : public WasmJITCompiler {
@@ -4,6 +4,7 @@
 #include "action/bytecode_visitor.h"
 #include "compiler/mir/module.h"
 #include "compiler/mir/pointer.h"
+#include "runtime/runtime.h"
 #include <unordered_map>
 #include <unordered_set>
 
@@ -11,12 +12,35 @@ namespace COMPILER {
 
 WasmFrontendContext::WasmFrontendContext(runtime::Module &WasmMod)
     : UseSoftMemCheck(WasmMod.checkUseSoftLinearMemoryCheck()),
-      WasmMod(WasmMod) {}
+      UseInterruptCheck(
+          WasmMod.getRuntime()->getConfig().EnableInterruption),
+      WasmMod(WasmMod) {
+  collectIndirectCallTargets();
+}
 
 WasmFrontendContext::WasmFrontendContext(const WasmFrontendContext &OtherCtx)
     : CompileContext(OtherCtx),
       UseSoftMemCheck(OtherCtx.WasmMod.checkUseSoftLinearMemoryCheck()),
-      WasmMod(OtherCtx.WasmMod) {}
+      UseInterruptCheck(OtherCtx.UseInterruptCheck),
+      WasmMod(OtherCtx.WasmMod),
+      IndirectCallTargets(OtherCtx.IndirectCallTargets) {}
+
+void WasmFrontendContext::collectIndirectCallTargets() {
+  const uint32_t NumImportFunctions = WasmMod.getNumImportFunctions();
+  for (uint32_t I = 0; I < WasmMod.getNumElementSegments(); ++I) {
+    const runtime::ElemEntry &Elem = WasmMod.getElemEntry(I);
+    for (uint32_t J = 0; J < Elem.NumFuncIdxs; ++J) {
+      uint32_t FuncIdx = Elem.FuncIdxs[J];
+      uint32_t TypeIdx = WasmMod.getFunctionType(FuncIdx)->SmallestTypeIdx;
+      // imported functions are not called directly
+      uint32_t Target = FuncIdx < NumImportFunctions ? -1u : FuncIdx;
+      auto [It, Inserted] = IndirectCallTargets.emplace(TypeIdx, Target);
+      if (!Inserted && It->second != FuncIdx) {
+        It->second = -1;
+      }
+    }
+  }
+}
 
 MType *WasmFrontendContext::getMIRTypeFromWASMType(WASMType Type) {
   switch (Type) {
@@ -176,6 +200,8 @@ void FunctionMirBuilder::loadWASMInstanceAttr() {
   addUniqueSuccessor(CallStackExhaustedBB);
 #endif
 
+  checkInterrupt();
+
   using StatsFlags = Module::StatsFlags;
   const uint32_t Stats = Ctx.getWasmFuncCode().Stats;
   if (Stats == StatsFlags::SF_none) {
@@ -210,6 +236,19 @@ void FunctionMirBuilder::loadWASMInstanceAttr() {
                                             MemorySizeIdx);
     }
   }
+
+  // Keep the gas left in a variable if the gas function is called
+  if (Stats & StatsFlags::SF_gas) {
+    /**
+     *  $_gas_left_idx = load (
+     *    base = instance,
+     *    offset = GasOffset
+     *  )
+     */
+    Variable *GasLeftVar = CurFunc->createVariable(&Ctx.I64Type);
+    GasLeftIdx = GasLeftVar->getVarIdx();
+    updateGasLeft();
+  }
 }
 
 void FunctionMirBuilder::finalizeFunctionBase() {
@@ -281,10 +320,11 @@ void FunctionMirBuilder::finalizeFunctionBase() {
 
 #if defined(ZEN_ENABLE_CPU_EXCEPTION) && !defined(ZEN_ENABLE_DWASM)
   // When check call exception after call_indirect or call hostapi, just
-  // throw, no need set args again
+  // unwind, no need set args again. The error has been recorded either way,
+  // so the soft exceptions unwind without the cpu trap as well
   auto ThrowException = [&] {
     MInstruction *ThrowExceptionAddr = createIntConstInstruction(
-        &Ctx.I64Type, uintptr_t(Instance::throwInstanceExceptionOnJIT));
+        &Ctx.I64Type, uintptr_t(Instance::unwindHostExceptionOnJIT));
 
     CompileVector<MInstruction *> ThrowExceptionArgs{
         {InstanceAddr},
@@ -389,6 +429,8 @@ void FunctionMirBuilder::handleLoop(WASMType Type, uint32_t StackSize) {
 
   enterBlock(CtrlBlockKind::LOOP, Type, StackSize, LoopBlock, EndBlock);
   setInsertBlock(LoopBlock);
+  // every back edge goes through the loop header
+  checkInterrupt();
 }
 
 void FunctionMirBuilder::handleIf(Operand CondOp, WASMType Type,
@@ -554,6 +596,29 @@ FunctionMirBuilder::Operand FunctionMirBuilder::handleCallIndirect(
     uint32_t TypeIdx, Operand IndirectFuncIdxOp, uint32_t TblIdx,
     const ArgumentInfo &ArgInfo, const std::vector<Operand> &Args) {
 
+  // the only candidate in the tables, called directly when the element holds
+  // it and through the generic path below otherwise
+  const uint32_t Target = Ctx.getIndirectCallTarget(TypeIdx);
+  const bool Speculative = Target != -1u;
+  const std::vector<Operand> *CallArgs = &Args;
+  std::vector<Operand> SharedArgs;
+  if (Speculative) {
+    // both calls read the arguments, keep them in variables
+    SharedArgs.reserve(Args.size());
+    for (const Operand &Arg : Args) {
+      if (!Arg.getInstr()) {
+        SharedArgs.push_back(Arg);
+        continue;
+      }
+      Variable *ArgVar =
+          CurFunc->createVariable(Ctx.getMIRTypeFromWASMType(Arg.getType()));
+      createInstruction<DassignInstruction>(true, &Ctx.VoidType, Arg.getInstr(),
+                                            ArgVar->getVarIdx());
+      SharedArgs.emplace_back(ArgVar, Arg.getType());
+    }
+    CallArgs = &SharedArgs;
+  }
+
   MInstruction *IndirectFuncIdx = extractOperand(IndirectFuncIdxOp);
   MInstruction *ResuableIndirectFuncIdx =
       makeReusableValue(IndirectFuncIdx, &Ctx.I32Type);
@@ -575,25 +640,92 @@ FunctionMirBuilder::Operand FunctionMirBuilder::handleCallIndirect(
   addUniqueSuccessor(UndefinedElementBB);
 
   /**
-   *  $func_idx = load (
+   *  $elem_offset = shl (uext $indirect_func_idx), 4
+   *  $actual_type_idx = load (
    *    base = instance,
-   *    scale = 4,
-   *    index = $indirect_func_idx,
-   *    offset = TableElemBaseOffset
+   *    index = $elem_offset,
+   *    offset = TableElemBaseOffset + offsetof(TableElement, TypeIdx)
    *  )
+   *
+   *  The elements are too large for a scaled index, and keep the type of
+   *  their function so that one entry is loaded for the checks and the call.
+   */
+
+  ZEN_STATIC_ASSERT(sizeof(runtime::TableElement) == 16);
+  MInstruction *ExtendedIndirectFuncIdx =
+      createInstruction<ConversionInstruction>(false, OP_uext, &Ctx.I64Type,
+                                               ResuableIndirectFuncIdx);
+  MInstruction *ElemOffset = createInstruction<BinaryInstruction>(
+      false, OP_shl, &Ctx.I64Type, ExtendedIndirectFuncIdx,
+      createIntConstInstruction(&Ctx.I64Type, 4));
+  MInstruction *ReusableElemOffset =
+      makeReusableValue(ElemOffset, &Ctx.I64Type);
+  const uint64_t ElemBaseOffset =
+      Ctx.getWasmMod().getLayout().TableElemBaseOffset;
+
+  /**
+   *  br_if cmp ieq ($actual_func_idx, $target), @direct_call, @indirect_call
+   *  @direct_call:
+   *    $result = call $target (args)
+   *    br @call_end
+   *  @indirect_call:
+   *    ...checks below
+   *    $result = icall $func_addr (args)
+   *    br @call_end
+   *  @call_end:
+   *
+   *  An element holding the target has its type, so the direct call needs no
+   *  checks.
    */
 
-  MInstruction *FuncIdx = getInstanceElement(
-      &Ctx.I32Type, sizeof(uint32_t), ResuableIndirectFuncIdx,
-      Ctx.getWasmMod().getLayout().TableElemBaseOffset);
-  MInstruction *ReusableFuncIdx = makeReusableValue(FuncIdx, &Ctx.I32Type);
+  WASMType ResultType = ArgInfo.getReturnType();
+  MType *ResultMType = Ctx.getMIRTypeFromWASMType(ResultType);
+  Variable *ResultVar = nullptr;
+  MBasicBlock *CallEndBB = nullptr;
+  if (Speculative) {
+    if (ResultType != WASMType::VOID) {
+      ResultVar = CurFunc->createVariable(ResultMType);
+    }
+    MInstruction *ActualFuncIdx = getInstanceElement(
+        &Ctx.I32Type, 1, ReusableElemOffset,
+        ElemBaseOffset + offsetof(runtime::TableElement, FuncIdx));
+    MInstruction *IsTarget = createInstruction<CmpInstruction>(
+        false, CmpInstruction::ICMP_EQ, &Ctx.I8Type, ActualFuncIdx,
+        createIntConstInstruction(&Ctx.I32Type, Target));
+    MBasicBlock *DirectCallBB = createBasicBlock();
+    MBasicBlock *IndirectCallBB = createBasicBlock();
+    CallEndBB = createBasicBlock();
+    createInstruction<BrIfInstruction>(true, Ctx, IsTarget, DirectCallBB,
+                                       IndirectCallBB);
+    addSuccessor(DirectCallBB);
+    addSuccessor(IndirectCallBB);
+
+    setInsertBlock(DirectCallBB);
+    Operand DirectResult =
+        handleCall(Target, 0, false, false, ArgInfo, *CallArgs);
+    if (ResultVar) {
+      createInstruction<DassignInstruction>(true, &Ctx.VoidType,
+                                            extractOperand(DirectResult),
+                                            ResultVar->getVarIdx());
+    }
+    createInstruction<BrInstruction>(true, Ctx, CallEndBB);
+    addSuccessor(CallEndBB);
+
+    setInsertBlock(IndirectCallBB);
+  }
+
+  MInstruction *ActualTypeIdx = getInstanceElement(
+      &Ctx.I32Type, 1, ReusableElemOffset,
+      ElemBaseOffset + offsetof(runtime::TableElement, TypeIdx));
+  MInstruction *ReusableActualTypeIdx =
+      makeReusableValue(ActualTypeIdx, &Ctx.I32Type);
 
   /**
-   *  br_if cmp ieq ($func_idx, -1), @uninitialized_element
+   *  br_if cmp ieq ($actual_type_idx, -1), @uninitialized_element
    */
 
   MInstruction *IsUninitialized = createInstruction<CmpInstruction>(
-      false, CmpInstruction::ICMP_EQ, &Ctx.I8Type, ReusableFuncIdx,
+      false, CmpInstruction::ICMP_EQ, &Ctx.I8Type, ReusableActualTypeIdx,
       createIntConstInstruction(&Ctx.I32Type, -1));
 
   MBasicBlock *UninitializedElementBB =
@@ -603,21 +735,11 @@ FunctionMirBuilder::Operand FunctionMirBuilder::handleCallIndirect(
   addUniqueSuccessor(UninitializedElementBB);
 
   /**
-   *  $actual_type_idx = load (
-   *    base = instance,
-   *    scale = 4,
-   *    index = $func_idx,
-   *    offset = FuncTypeIndexesBaseOffset
-   *  )
    *  br_if cmp ine ($actual_type_idx, type_idx), @indirect_call_type_mismatch
    */
 
-  MInstruction *ActualTypeIdx = getInstanceElement(
-      &Ctx.I32Type, sizeof(uint32_t), ReusableFuncIdx,
-      Ctx.getWasmMod().getLayout().FuncTypeIndexesBaseOffset);
-
   MInstruction *IsTypeMismatch = createInstruction<CmpInstruction>(
-      false, CmpInstruction::ICMP_NE, &Ctx.I8Type, ActualTypeIdx,
+      false, CmpInstruction::ICMP_NE, &Ctx.I8Type, ReusableActualTypeIdx,
       createIntConstInstruction(&Ctx.I32Type, TypeIdx));
 
   MBasicBlock *IndirectCallTypeMismatchBB =
@@ -629,16 +751,35 @@ FunctionMirBuilder::Operand FunctionMirBuilder::handleCallIndirect(
   /**
    *  $func_addr = load (
    *    base = instance,
-   *    scale = 8,
-   *    index = $func_idx,
-   *    offset = FuncPtrsBaseOffset
+   *    index = $elem_offset,
+   *    offset = TableElemBaseOffset + offsetof(TableElement, JITCodePtr)
    *  )
    */
 
-  MInstruction *FuncAddr =
-      getInstanceElement(&Ctx.I64Type, sizeof(uintptr_t), ReusableFuncIdx,
-                         Ctx.getWasmMod().getLayout().FuncPtrsBaseOffset);
-  return handleCallBase<ICallInstruction>(FuncAddr, ArgInfo, Args, true);
+  MInstruction *FuncAddr = getInstanceElement(
+      &Ctx.I64Type, 1, ReusableElemOffset,
+      ElemBaseOffset + offsetof(runtime::TableElement, JITCodePtr));
+  Operand Result =
+      handleCallBase<ICallInstruction>(FuncAddr, ArgInfo, *CallArgs, true);
+  if (!Speculative) {
+    return Result;
+  }
+
+  if (ResultVar) {
+    createInstruction<DassignInstruction>(true, &Ctx.VoidType,
+                                          extractOperand(Result),
+                                          ResultVar->getVarIdx());
+  }
+  createInstruction<BrInstruction>(true, Ctx, CallEndBB);
+  addSuccessor(CallEndBB);
+
+  setInsertBlock(CallEndBB);
+  if (!ResultVar) {
+    return Operand();
+  }
+  MInstruction *ResultVal = createInstruction<DreadInstruction>(
+      false, ResultMType, ResultVar->getVarIdx());
+  return Operand(ResultVal, ResultType);
 }
 
 void FunctionMirBuilder::checkCallException(bool IsImportOrIndirect) {
@@ -755,6 +896,90 @@ FunctionMirBuilder::Operand FunctionMirBuilder::handleMemoryGrow(Operand Opnd) {
   return Operand(PrevNumPages, WASMType::I32);
 }
 
+void FunctionMirBuilder::handleMemoryCopy(Operand DestOffset, Operand SrcOffset,
+                                          Operand Size) {
+  CompileVector<MInstruction *> MemoryCopyArgs{
+      {
+          InstanceAddr,
+          extractOperand(DestOffset),
+          extractOperand(SrcOffset),
+          extractOperand(Size),
+      },
+      Ctx.MemPool,
+  };
+  callMemoryKernel(uintptr_t(Instance::copyInstanceMemoryOnJIT),
+                   MemoryCopyArgs);
+}
+
+void FunctionMirBuilder::handleMemoryFill(Operand DestOffset, Operand Value,
+                                          Operand Size) {
+  CompileVector<MInstruction *> MemoryFillArgs{
+      {
+          InstanceAddr,
+          extractOperand(DestOffset),
+          extractOperand(Value),
+          extractOperand(Size),
+      },
+      Ctx.MemPool,
+  };
+  callMemoryKernel(uintptr_t(Instance::fillInstanceMemoryOnJIT),
+                   MemoryFillArgs);
+}
+
+void FunctionMirBuilder::handleMemoryInit(uint32_t DataIdx, Operand DestOffset,
+                                          Operand SrcOffset, Operand Size) {
+  CompileVector<MInstruction *> MemoryInitArgs{
+      {
+          InstanceAddr,
+          createIntConstInstruction(&Ctx.I32Type, DataIdx),
+          extractOperand(DestOffset),
+          extractOperand(SrcOffset),
+          extractOperand(Size),
+      },
+      Ctx.MemPool,
+  };
+  callMemoryKernel(uintptr_t(Instance::initInstanceMemoryOnJIT),
+                   MemoryInitArgs);
+}
+
+void FunctionMirBuilder::handleDataDrop(uint32_t DataIdx) {
+  CompileVector<MInstruction *> DataDropArgs{
+      {
+          InstanceAddr,
+          createIntConstInstruction(&Ctx.I32Type, DataIdx),
+      },
+      Ctx.MemPool,
+  };
+  MInstruction *DataDropAddr = createIntConstInstruction(
+      &Ctx.I64Type, uint64_t(Instance::dropInstanceDataSegmentOnJIT));
+  createInstruction<ICallInstruction>(true, &Ctx.VoidType, DataDropAddr,
+                                      DataDropArgs);
+}
+
+void FunctionMirBuilder::callMemoryKernel(
+    uintptr_t KernelAddr, const CompileVector<MInstruction *> &Args) {
+  MInstruction *KernelAddrInst =
+      createIntConstInstruction(&Ctx.I64Type, uint64_t(KernelAddr));
+  MInstruction *Result = createInstruction<ICallInstruction>(
+      false, &Ctx.I32Type, KernelAddrInst, Args);
+
+  // Keep the call where it is, before the branch reading its result
+  Variable *ResultVar = CurFunc->createVariable(&Ctx.I32Type);
+  createInstruction<DassignInstruction>(true, &(Ctx.VoidType), Result,
+                                        ResultVar->getVarIdx());
+
+  MInstruction *ResultVal = createInstruction<DreadInstruction>(
+      false, &Ctx.I32Type, ResultVar->getVarIdx());
+  MInstruction *IsOutOfBounds = createInstruction<CmpInstruction>(
+      false, CmpInstruction::ICMP_NE, &Ctx.I8Type, ResultVal,
+      createIntConstInstruction(&Ctx.I32Type, 0));
+  MBasicBlock *OutOfBoundsMemoryBB =
+      getOrCreateExceptionSetBB(ErrorCode::OutOfBoundsMemory);
+  createInstruction<BrIfInstruction>(true, Ctx, IsOutOfBounds,
+                                     OutOfBoundsMemoryBB);
+  addUniqueSuccessor(OutOfBoundsMemoryBB);
+}
+
 std::tuple<MInstruction *, MInstruction *, int32_t>
 FunctionMirBuilder::getMemoryLocation(MInstruction *Base, uint32_t Offset,
                                       MType *Type) {
@@ -850,12 +1075,26 @@ void FunctionMirBuilder::updateMemoryBaseAndSize() {
 
 // ==================== Platform Feature Methods ====================
 
+void FunctionMirBuilder::updateGasLeft() {
+  if (GasLeftIdx != VariableIdx(-1)) {
+    MInstruction *GasLeft = getInstanceElement(
+        &Ctx.I64Type, Ctx.getWasmMod().getLayout().GasOffset);
+    createInstruction<DassignInstruction>(true, &Ctx.VoidType, GasLeft,
+                                          GasLeftIdx);
+  }
+}
+
 void FunctionMirBuilder::handleGasCall(Operand Delta) {
-  // if instance.gas_left < 0 error; instance.gas_left -= delta;
+  // if gas_left < delta error; gas_left -= delta; instance.gas_left = gas_left
+  //
+  // gas_left is only read from the instance at the function entry and after
+  // calls, but always written back, so traps and callees see the exact value
+  ZEN_ASSERT(GasLeftIdx != VariableIdx(-1));
   const auto &Layout = Ctx.getWasmMod().getLayout();
   MBasicBlock *GasExceedBB =
       getOrCreateExceptionSetBB(ErrorCode::GasLimitExceeded);
-  MInstruction *GasLeft = getInstanceElement(&Ctx.I64Type, Layout.GasOffset);
+  MInstruction *GasLeft =
+      createInstruction<DreadInstruction>(false, &Ctx.I64Type, GasLeftIdx);
   MInstruction *DeltaValue = extractOperand(Delta);
   MInstruction *ReusableDeltaValue =
       makeReusableValue(DeltaValue, &Ctx.I64Type);
@@ -867,9 +1106,48 @@ void FunctionMirBuilder::handleGasCall(Operand Delta) {
   addUniqueSuccessor(GasExceedBB);
 
   MInstruction *NewGasLeft = createInstruction<BinaryInstruction>(
-      false, OP_sub, &Ctx.I64Type, GasLeft, DeltaValue);
-  setInstanceElement(&Ctx.I64Type, NewGasLeft, Layout.GasOffset);
+      false, OP_sub, &Ctx.I64Type, GasLeft, ReusableDeltaValue);
+  createInstruction<DassignInstruction>(true, &Ctx.VoidType, NewGasLeft,
+                                        GasLeftIdx);
+  setInstanceElement(
+      &Ctx.I64Type,
+      createInstruction<DreadInstruction>(false, &Ctx.I64Type, GasLeftIdx),
+      Layout.GasOffset);
+}
+
+void FunctionMirBuilder::checkInterrupt() {
+  // if instance.interrupt_flag != 0 error
+  if (!Ctx.UseInterruptCheck) {
+    return;
+  }
+  const auto &Layout = Ctx.getWasmMod().getLayout();
+  MBasicBlock *InterruptedBB =
+      getOrCreateExceptionSetBB(ErrorCode::Interrupted);
+  MInstruction *Flag =
+      getInstanceElement(&Ctx.I32Type, Layout.InterruptFlagOffset);
+  createInstruction<BrIfInstruction>(true, Ctx, Flag, InterruptedBB);
+  addUniqueSuccessor(InterruptedBB);
+}
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+void FunctionMirBuilder::handleBlockCount(uint64_t *Counter) {
+  // *counter += 1, the counters are owned by the module and never move
+  MPointerType *CounterPtrType = MPointerType::create(Ctx, Ctx.I64Type);
+  auto GetCounterPtr = [&]() {
+    MInstruction *CounterAddr =
+        createIntConstInstruction(&Ctx.I64Type, uintptr_t(Counter));
+    return createInstruction<ConversionInstruction>(false, OP_inttoptr,
+                                                    CounterPtrType, CounterAddr);
+  };
+  MInstruction *Count = createInstruction<LoadInstruction>(
+      false, &Ctx.I64Type, GetCounterPtr(), 1, nullptr, 0);
+  MInstruction *One = createIntConstInstruction(&Ctx.I64Type, 1);
+  MInstruction *NewCount = createInstruction<BinaryInstruction>(
+      false, OP_add, &Ctx.I64Type, Count, One);
+  createInstruction<StoreInstruction>(true, &Ctx.VoidType, NewCount,
+                                      GetCounterPtr(), 0);
 }
+#endif // ZEN_ENABLE_BLOCK_COUNTERS
 
 // ==================== MIR Opcode Methods ====================
 
@@ -10,6 +10,7 @@
 #include "compiler/mir/instructions.h"
 #include "compiler/mir/opcode.h"
 #include "compiler/mir/pointer.h"
+#include <unordered_map>
 
 namespace COMPILER {
 
@@ -50,10 +51,25 @@ public:
 
   const runtime::CodeEntry &getWasmFuncCode() const { return *WasmFuncCode; }
 
+  /// The only internal function put into tables by the element segments with
+  /// the type \p TypeIdx(smallest type index), which call_indirect of the type
+  /// speculatively calls directly, or -1 if there are none or several.
+  uint32_t getIndirectCallTarget(uint32_t TypeIdx) const {
+    auto It = IndirectCallTargets.find(TypeIdx);
+    return It == IndirectCallTargets.end() ? -1u : It->second;
+  }
+
   const bool UseSoftMemCheck;
+  // poll Instance::interrupt at function entries and loop headers
+  const bool UseInterruptCheck;
 
 private:
+  void collectIndirectCallTargets();
+
   runtime::Module &WasmMod;
+  // smallest type index -> the only function of the type in element segments,
+  // -1 for several functions or an imported one
+  std::unordered_map<uint32_t, uint32_t> IndirectCallTargets;
   uint32_t CurFuncIdx = -1; // exclude imported functions
   runtime::TypeEntry *WasmFuncType = nullptr;
   runtime::CodeEntry *WasmFuncCode = nullptr;
@@ -259,6 +275,15 @@ public:
 
   Operand handleMemoryGrow(Operand Opnd);
 
+  void handleMemoryCopy(Operand DestOffset, Operand SrcOffset, Operand Size);
+
+  void handleMemoryFill(Operand DestOffset, Operand Value, Operand Size);
+
+  void handleMemoryInit(uint32_t DataIdx, Operand DestOffset, Operand SrcOffset,
+                        Operand Size);
+
+  void handleDataDrop(uint32_t DataIdx);
+
   // ==================== Numeric Instruction Handlers ====================
 
   template <WASMType Ty>
@@ -509,6 +534,12 @@ public:
 
   void handleGasCall(Operand Delta);
 
+  void checkInterrupt();
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  void handleBlockCount(uint64_t *Counter);
+#endif
+
   template <bool Sign, WASMType Type, BinaryOperator Opr>
   Operand handleCheckedArithmetic(Operand LHSOp, Operand RHSOp) {
     Opcode Opc;
@@ -659,6 +690,7 @@ private:
 
     checkCallException(IsImportOrIndirect);
     updateMemoryBaseAndSize();
+    updateGasLeft();
 
     if (IsStmt) {
       return Operand();
@@ -690,6 +722,14 @@ private:
   // Update memory base and size after growing memory or calling a function
   void updateMemoryBaseAndSize();
 
+  // Call a bulk memory kernel of Instance and trap with OutOfBoundsMemory if it
+  // returns non-zero
+  void callMemoryKernel(uintptr_t KernelAddr,
+                        const CompileVector<MInstruction *> &Args);
+
+  // Reload the gas left after calling a function
+  void updateGasLeft();
+
   template <WASMType Type, CompareOperator Opeator>
   CmpInstruction *handleCompareImpl(Operand LHSOp,
                                     [[maybe_unused]] Operand RHSOp,
@@ -823,6 +863,7 @@ private:
 
   VariableIdx MemoryBaseIdx = (VariableIdx)-1;
   VariableIdx MemorySizeIdx = (VariableIdx)-1;
+  VariableIdx GasLeftIdx = (VariableIdx)-1;
 };
 
 } // namespace COMPILER
@@ -14,9 +14,6 @@ namespace zen::entrypoint {
 using namespace common;
 using namespace runtime;
 
-constexpr const uint32_t MaxIntRegs = 6;
-constexpr const uint32_t MaxFloatRegs = 8;
-
 void callNativeGeneral(Instance *Instance, GenericFunctionPointer FuncPtr,
                        const std::vector<TypedValue> &Args,
                        std::vector<TypedValue> &Results, SysMemPool *MPool,
@@ -93,15 +90,29 @@ void callNativeGeneral(Instance *Instance, GenericFunctionPointer FuncPtr,
     }
   }
 
+  callNativeArgv(Instance, FuncPtr, ArgvNative, NumStackArgs,
+                 Results.empty() ? nullptr : &Results[0],
+                 SkipInstanceProcessing);
+
+  if (ArgcNative > sizeof(ArgvBuf) / sizeof(uint64_t)) {
+    MPool->deallocate(ArgvNative);
+  }
+}
+
+void callNativeArgv(Instance *Instance, GenericFunctionPointer FuncPtr,
+                    uint64_t *ArgvNative, uint32_t NumStackArgs,
+                    TypedValue *Result, bool SkipInstanceProcessing) {
   if (Instance) {
     Instance->getRuntime()->startCPUTracing();
+  } else {
+    SkipInstanceProcessing = true;
   }
 
-  if (Results.empty()) {
+  if (!Result) {
     callNative_Void(FuncPtr, ArgvNative, NumStackArgs, SkipInstanceProcessing);
   } else {
-    UntypedValue &Value = Results[0].Value;
-    switch (Results[0].Type) {
+    UntypedValue &Value = Result->Value;
+    switch (Result->Type) {
     case WASMType::I32:
       Value.I32 = callNative_Int32(FuncPtr, ArgvNative, NumStackArgs,
                                    SkipInstanceProcessing);
@@ -126,10 +137,6 @@ void callNativeGeneral(Instance *Instance, GenericFunctionPointer FuncPtr,
   if (Instance) {
     Instance->getRuntime()->endCPUTracing();
   }
-
-  if (ArgcNative > sizeof(ArgvBuf) / sizeof(uint64_t)) {
-    MPool->deallocate(ArgvNative);
-  }
 }
 
 } // namespace zen::entrypoint
@@ -51,6 +51,12 @@ class Instance;
 
 namespace entrypoint {
 
+// Layout of the native argv read by callNative: MaxFloatRegs 16-byte float
+// registers, MaxIntRegs integer registers(the first one holds the instance)
+// and then the stack arguments
+constexpr const uint32_t MaxIntRegs = 6;
+constexpr const uint32_t MaxFloatRegs = 8;
+
 void callNativeGeneral(runtime::Instance *Instance,
                        GenericFunctionPointer FuncPtr,
                        const std::vector<common::TypedValue> &Args,
@@ -58,6 +64,14 @@ void callNativeGeneral(runtime::Instance *Instance,
                        common::SysMemPool *MPool,
                        bool SkipInstProcessing = false);
 
+/// Call FuncPtr with an argv already laid out for callNative
+/// \param Result receives the return value with its type preset, null if the
+/// function returns nothing
+void callNativeArgv(runtime::Instance *Instance, GenericFunctionPointer FuncPtr,
+                    uint64_t *ArgvNative, uint32_t NumStackArgs,
+                    common::TypedValue *Result,
+                    bool SkipInstProcessing = false);
+
 } // namespace entrypoint
 } // namespace zen
 
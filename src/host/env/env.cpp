@@ -2,6 +2,8 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "runtime/instance.h"
+#include "runtime/state_journal.h"
+#include "utils/crypto.h"
 // Note: must place env.h after instance.h to get correct EXPORT_MODULE_NAME
 #include "host/env/env.h"
 
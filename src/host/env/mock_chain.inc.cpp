@@ -17,6 +17,13 @@ static int32_t MyAbort(zen::runtime::Instance *Inst, int32_t Exception,
   return 0;
 }
 
+// Trap the hostapi call on an app address out of the instance memory
+static void trapOutOfBounds(zen::runtime::Instance *Inst, const char *What) {
+  using namespace zen::common;
+  Inst->setExceptionByHostapi(
+      getErrorWithExtraMessage(ErrorCode::OutOfBoundsMemory, What));
+}
+
 static int32_t memcpy(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t) {
   MOCK_CHAIN_DUMMY_IMPLEMENTATION
   return 0;
@@ -94,23 +101,113 @@ static int32_t memcmp(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t) {
   return 0;
 }
 
-static int32_t SetStorage(zen::runtime::Instance *Inst, int32_t, int32_t,
-                          int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
-  return 0;
+// Storage hostapis are backed by the instance's state journal when the
+// embedder attached one, so nested calls can checkpoint and revert them.
+// Layouts: (key, key_len, value, value_len) and the DC* variants take the
+// contract(id, id_len) first, its keys are prefixed by [id_len(u32)][id].
+// Invalid addresses trap the call.
+
+static bool getStorageKey(zen::runtime::Instance *Inst, int32_t IdOffset,
+                          int32_t IdLen, int32_t KeyOffset, int32_t KeyLen,
+                          std::string &Key) {
+  if (!Inst->hasMemory() ||
+      (IdLen != 0 && !Inst->validatedAppAddr(IdOffset, IdLen)) ||
+      (KeyLen != 0 && !Inst->validatedAppAddr(KeyOffset, KeyLen))) {
+    trapOutOfBounds(Inst, "storage key");
+    return false;
+  }
+  Key.clear();
+  if (IdLen != 0) {
+    uint32_t Len = IdLen;
+    Key.append(reinterpret_cast<const char *>(&Len), sizeof(Len));
+    Key.append(static_cast<const char *>(Inst->getNativeMemoryAddr(IdOffset)),
+               Len);
+  }
+  if (KeyLen != 0) {
+    Key.append(static_cast<const char *>(Inst->getNativeMemoryAddr(KeyOffset)),
+               (uint32_t)KeyLen);
+  }
+  return true;
 }
 
-static int32_t GetStorageSize(zen::runtime::Instance *Inst, int32_t, int32_t,
-                              int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+static const uint8_t *storageKeyData(const std::string &Key) {
+  return reinterpret_cast<const uint8_t *>(Key.data());
+}
+
+static int32_t setStorageImpl(zen::runtime::Instance *Inst, int32_t IdOffset,
+                              int32_t IdLen, int32_t KeyOffset, int32_t KeyLen,
+                              int32_t ValueOffset, int32_t ValueLen) {
+  zen::runtime::StateJournal *Journal = Inst->getStateJournal();
+  std::string Key;
+  if (!Journal ||
+      !getStorageKey(Inst, IdOffset, IdLen, KeyOffset, KeyLen, Key)) {
+    return 0;
+  }
+  const uint8_t *Value = nullptr;
+  if (ValueLen != 0) {
+    if (!Inst->validatedAppAddr(ValueOffset, ValueLen)) {
+      trapOutOfBounds(Inst, "storage value");
+      return 0;
+    }
+    Value =
+        static_cast<const uint8_t *>(Inst->getNativeMemoryAddr(ValueOffset));
+  }
+  Journal->set(storageKeyData(Key), Key.size(), Value, ValueLen);
   return 0;
 }
 
-static int32_t DeleteStorage(zen::runtime::Instance *Inst, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+// Write the size of the value(0 if absent) to SizeOffset as u32
+static int32_t getStorageSizeImpl(zen::runtime::Instance *Inst,
+                                  int32_t IdOffset, int32_t IdLen,
+                                  int32_t KeyOffset, int32_t KeyLen,
+                                  int32_t SizeOffset) {
+  zen::runtime::StateJournal *Journal = Inst->getStateJournal();
+  std::string Key;
+  if (!Journal ||
+      !getStorageKey(Inst, IdOffset, IdLen, KeyOffset, KeyLen, Key)) {
+    return 0;
+  }
+  if (!Inst->validatedAppAddr(SizeOffset, sizeof(uint32_t))) {
+    trapOutOfBounds(Inst, "storage value size");
+    return 0;
+  }
+  const uint8_t *Value = nullptr;
+  uint32_t ValueLen = 0;
+  Journal->get(storageKeyData(Key), Key.size(), Value, ValueLen);
+  std::memcpy(Inst->getNativeMemoryAddr(SizeOffset), &ValueLen,
+              sizeof(ValueLen));
+  return 0;
+}
+
+static int32_t deleteStorageImpl(zen::runtime::Instance *Inst,
+                                 int32_t IdOffset, int32_t IdLen,
+                                 int32_t KeyOffset, int32_t KeyLen) {
+  zen::runtime::StateJournal *Journal = Inst->getStateJournal();
+  std::string Key;
+  if (!Journal ||
+      !getStorageKey(Inst, IdOffset, IdLen, KeyOffset, KeyLen, Key)) {
+    return 0;
+  }
+  Journal->remove(storageKeyData(Key), Key.size());
   return 0;
 }
 
+static int32_t SetStorage(zen::runtime::Instance *Inst, int32_t KeyOffset,
+                          int32_t KeyLen, int32_t ValueOffset,
+                          int32_t ValueLen) {
+  return setStorageImpl(Inst, 0, 0, KeyOffset, KeyLen, ValueOffset, ValueLen);
+}
+
+static int32_t GetStorageSize(zen::runtime::Instance *Inst, int32_t KeyOffset,
+                              int32_t KeyLen, int32_t SizeOffset) {
+  return getStorageSizeImpl(Inst, 0, 0, KeyOffset, KeyLen, SizeOffset);
+}
+
+static int32_t DeleteStorage(zen::runtime::Instance *Inst, int32_t KeyOffset,
+                             int32_t KeyLen) {
+  return deleteStorageImpl(Inst, 0, 0, KeyOffset, KeyLen);
+}
+
 static int32_t strcmp(zen::runtime::Instance *Inst, int32_t, int32_t) {
   MOCK_CHAIN_DUMMY_IMPLEMENTATION
   return 0;
@@ -153,10 +250,29 @@ static int64_t GetBlockTimeStamp(zen::runtime::Instance *Inst) {
   return 0;
 }
 
-static int32_t GetStorage(zen::runtime::Instance *Inst, int32_t, int32_t,
-                          int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
-  return 0;
+// Copy at most ValueLen bytes of the value, return the number of bytes copied
+static int32_t GetStorage(zen::runtime::Instance *Inst, int32_t KeyOffset,
+                          int32_t KeyLen, int32_t ValueOffset,
+                          int32_t ValueLen) {
+  zen::runtime::StateJournal *Journal = Inst->getStateJournal();
+  std::string Key;
+  if (!Journal || !getStorageKey(Inst, 0, 0, KeyOffset, KeyLen, Key)) {
+    return 0;
+  }
+  if (ValueLen != 0 && !Inst->validatedAppAddr(ValueOffset, ValueLen)) {
+    trapOutOfBounds(Inst, "storage value");
+    return 0;
+  }
+  const uint8_t *Value = nullptr;
+  uint32_t Size = 0;
+  if (!Journal->get(storageKeyData(Key), Key.size(), Value, Size)) {
+    return 0;
+  }
+  Size = std::min(Size, (uint32_t)ValueLen);
+  if (Size != 0) {
+    std::memcpy(Inst->getNativeMemoryAddr(ValueOffset), Value, Size);
+  }
+  return Size;
 }
 
 static int32_t GetCode(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t,
@@ -544,22 +660,24 @@ static int32_t __call_evm__(zen::runtime::Instance *Inst, int32_t, int32_t,
   return 0;
 }
 
-static int32_t DCGetStorageSize(zen::runtime::Instance *Inst, int32_t, int32_t,
-                                int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
-  return 0;
+static int32_t DCGetStorageSize(zen::runtime::Instance *Inst, int32_t IdOffset,
+                                int32_t IdLen, int32_t KeyOffset,
+                                int32_t KeyLen, int32_t SizeOffset) {
+  return getStorageSizeImpl(Inst, IdOffset, IdLen, KeyOffset, KeyLen,
+                            SizeOffset);
 }
 
-static int32_t DCSetStorage(zen::runtime::Instance *Inst, int32_t, int32_t,
-                            int32_t, int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
-  return 0;
+static int32_t DCSetStorage(zen::runtime::Instance *Inst, int32_t IdOffset,
+                            int32_t IdLen, int32_t KeyOffset, int32_t KeyLen,
+                            int32_t ValueOffset, int32_t ValueLen) {
+  return setStorageImpl(Inst, IdOffset, IdLen, KeyOffset, KeyLen, ValueOffset,
+                        ValueLen);
 }
 
-static int32_t DCDeleteStorage(zen::runtime::Instance *Inst, int32_t, int32_t,
-                               int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
-  return 0;
+static int32_t DCDeleteStorage(zen::runtime::Instance *Inst, int32_t IdOffset,
+                               int32_t IdLen, int32_t KeyOffset,
+                               int32_t KeyLen) {
+  return deleteStorageImpl(Inst, IdOffset, IdLen, KeyOffset, KeyLen);
 }
 
 static int32_t GrayscaleDeployContract(zen::runtime::Instance *Inst, int32_t,
@@ -736,16 +854,39 @@ static int64_t get_tx_nonce(zen::runtime::Instance *Inst) {
   MOCK_CHAIN_DUMMY_IMPLEMENTATION
   return 0;
 }
-static void sha256(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+// Hash InputLen bytes at InputOffset into the 32 bytes at ResultOffset,
+// invalid addresses trap the call
+static void hashImpl(zen::runtime::Instance *Inst,
+                     void (*HashFn)(const uint8_t *, size_t, uint8_t[32]),
+                     int32_t InputOffset, int32_t InputLen,
+                     int32_t ResultOffset) {
+  if (!Inst->hasMemory() ||
+      (InputLen != 0 && !Inst->validatedAppAddr(InputOffset, InputLen)) ||
+      !Inst->validatedAppAddr(ResultOffset, 32)) {
+    trapOutOfBounds(Inst, "hash input or result");
+    return;
+  }
+  const uint8_t *Input =
+      InputLen != 0
+          ? static_cast<const uint8_t *>(Inst->getNativeMemoryAddr(InputOffset))
+          : nullptr;
+  HashFn(Input, (uint32_t)InputLen,
+         static_cast<uint8_t *>(Inst->getNativeMemoryAddr(ResultOffset)));
 }
 
-static void sm3(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+static void sha256(zen::runtime::Instance *Inst, int32_t InputOffset,
+                   int32_t InputLen, int32_t ResultOffset) {
+  hashImpl(Inst, zen::utils::sha256, InputOffset, InputLen, ResultOffset);
 }
 
-static void keccak256(zen::runtime::Instance *Inst, int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+static void sm3(zen::runtime::Instance *Inst, int32_t InputOffset,
+                int32_t InputLen, int32_t ResultOffset) {
+  hashImpl(Inst, zen::utils::sm3, InputOffset, InputLen, ResultOffset);
+}
+
+static void keccak256(zen::runtime::Instance *Inst, int32_t InputOffset,
+                      int32_t InputLen, int32_t ResultOffset) {
+  hashImpl(Inst, zen::utils::keccak256, InputOffset, InputLen, ResultOffset);
 }
 
 static int32_t verify_mycrypto_signature(zen::runtime::Instance *Inst, int32_t,
@@ -755,9 +896,33 @@ static int32_t verify_mycrypto_signature(zen::runtime::Instance *Inst, int32_t,
   return 0;
 }
 
-static int32_t eth_secp256k1_recovery(zen::runtime::Instance *Inst, int32_t,
-                                      int32_t, int32_t, int32_t, int32_t) {
-  MOCK_CHAIN_DUMMY_IMPLEMENTATION
+// Recover the 64-byte public key(x || y) from the 32-byte hash and the
+// 65-byte signature r || s || v, v is the recovery id optionally offset by 27.
+// Return 0 on success and -1 if the signature is invalid, invalid addresses
+// trap the call.
+static int32_t eth_secp256k1_recovery(zen::runtime::Instance *Inst,
+                                      int32_t HashOffset, int32_t HashLen,
+                                      int32_t SigOffset, int32_t SigLen,
+                                      int32_t ResultOffset) {
+  if (HashLen != 32 || SigLen != 65) {
+    return -1;
+  }
+  if (!Inst->hasMemory() || !Inst->validatedAppAddr(HashOffset, HashLen) ||
+      !Inst->validatedAppAddr(SigOffset, SigLen) ||
+      !Inst->validatedAppAddr(ResultOffset, 64)) {
+    trapOutOfBounds(Inst, "secp256k1 recovery argument");
+    return -1;
+  }
+  const uint8_t *Hash =
+      static_cast<const uint8_t *>(Inst->getNativeMemoryAddr(HashOffset));
+  const uint8_t *Sig =
+      static_cast<const uint8_t *>(Inst->getNativeMemoryAddr(SigOffset));
+  uint8_t RecId = Sig[64] >= 27 ? Sig[64] - 27 : Sig[64];
+  uint8_t PubKey[64];
+  if (!zen::utils::secp256k1Recover(Hash, Sig, Sig + 32, RecId, PubKey)) {
+    return -1;
+  }
+  std::memcpy(Inst->getNativeMemoryAddr(ResultOffset), PubKey, sizeof(PubKey));
   return 0;
 }
 
@@ -0,0 +1,181 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "host/evmabimock/evm_storage.h"
+#include "common/defines.h"
+#include <algorithm>
+#include <cstring>
+
+namespace zen::host {
+
+// ==================== Bytes32Table ====================
+
+Bytes32Table::Bytes32Table(size_t InitCapacity) {
+  size_t Capacity = 16;
+  while (Capacity < InitCapacity) {
+    Capacity <<= 1;
+  }
+  Slots.resize(Capacity);
+  Used.assign(Capacity, 0);
+  Mask = Capacity - 1;
+}
+
+size_t Bytes32Table::hash(const Bytes32 &Key) {
+  // Keys are either keccak outputs or small big-endian slot numbers, so all
+  // words must be mixed
+  uint64_t Words[4];
+  std::memcpy(Words, Key.data(), sizeof(Words));
+  uint64_t H = Words[0] ^ (Words[1] * 0x9e3779b97f4a7c15ULL) ^
+               (Words[2] * 0xc2b2ae3d27d4eb4fULL) ^
+               (Words[3] * 0x165667b19e3779f9ULL);
+  H ^= H >> 32;
+  H *= 0xd6e8feb86659fd93ULL;
+  H ^= H >> 32;
+  return static_cast<size_t>(H);
+}
+
+size_t Bytes32Table::probe(const Bytes32 &Key) const {
+  size_t I = hash(Key) & Mask;
+  while (Used[I] && Slots[I].Key != Key) {
+    I = (I + 1) & Mask;
+  }
+  return I;
+}
+
+const Bytes32 *Bytes32Table::find(const Bytes32 &Key) const {
+  size_t I = probe(Key);
+  return Used[I] ? &Slots[I].Value : nullptr;
+}
+
+Bytes32 &Bytes32Table::findOrInsert(const Bytes32 &Key, bool &Inserted) {
+  // keep the load factor under 3/4
+  if ((NumEntries + 1) * 4 > Slots.size() * 3) {
+    grow();
+  }
+  size_t I = probe(Key);
+  Inserted = !Used[I];
+  if (Inserted) {
+    Used[I] = 1;
+    Slots[I].Key = Key;
+    Slots[I].Value.fill(0);
+    ++NumEntries;
+  }
+  return Slots[I].Value;
+}
+
+bool Bytes32Table::erase(const Bytes32 &Key) {
+  size_t I = probe(Key);
+  if (!Used[I]) {
+    return false;
+  }
+  Used[I] = 0;
+  --NumEntries;
+  // Backward shift deletion, no tombstones needed
+  size_t J = I;
+  while (true) {
+    J = (J + 1) & Mask;
+    if (!Used[J]) {
+      break;
+    }
+    size_t Home = hash(Slots[J].Key) & Mask;
+    bool InPlace = I <= J ? (I < Home && Home <= J) : (I < Home || Home <= J);
+    if (!InPlace) {
+      Slots[I] = Slots[J];
+      Used[I] = 1;
+      Used[J] = 0;
+      I = J;
+    }
+  }
+  return true;
+}
+
+void Bytes32Table::clear() {
+  if (NumEntries == 0) {
+    return;
+  }
+  std::fill(Used.begin(), Used.end(), 0);
+  NumEntries = 0;
+}
+
+void Bytes32Table::grow() {
+  std::vector<EVMStorageSlot> OldSlots;
+  std::vector<uint8_t> OldUsed;
+  OldSlots.swap(Slots);
+  OldUsed.swap(Used);
+  Slots.resize(OldSlots.size() * 2);
+  Used.assign(OldUsed.size() * 2, 0);
+  Mask = Slots.size() - 1;
+  for (size_t I = 0; I < OldSlots.size(); ++I) {
+    if (OldUsed[I]) {
+      size_t J = probe(OldSlots[I].Key);
+      Slots[J] = OldSlots[I];
+      Used[J] = 1;
+    }
+  }
+}
+
+// ==================== InMemoryEVMStorage ====================
+
+bool InMemoryEVMStorage::load(const Bytes32 &Key, Bytes32 &Value) {
+  const Bytes32 *Found = Table.find(Key);
+  if (!Found) {
+    return false;
+  }
+  Value = *Found;
+  return true;
+}
+
+void InMemoryEVMStorage::commit(const EVMStorageSlot *Slots,
+                                size_t NumSlots) {
+  for (size_t I = 0; I < NumSlots; ++I) {
+    bool Inserted;
+    Table.findOrInsert(Slots[I].Key, Inserted) = Slots[I].Value;
+  }
+}
+
+// ==================== JournaledEVMStorage ====================
+
+bool JournaledEVMStorage::BackendAdapter::load(const uint8_t *Key,
+                                               uint32_t KeyLen,
+                                               std::string &Value) {
+  ZEN_ASSERT(KeyLen == sizeof(Bytes32));
+  Bytes32 K;
+  Bytes32 V;
+  std::memcpy(K.data(), Key, KeyLen);
+  if (!Backend.load(K, V)) {
+    return false;
+  }
+  Value.assign(reinterpret_cast<const char *>(V.data()), V.size());
+  return true;
+}
+
+void JournaledEVMStorage::BackendAdapter::commit(
+    const runtime::StateWrite *Writes, size_t NumWrites) {
+  Batch.resize(NumWrites);
+  for (size_t I = 0; I < NumWrites; ++I) {
+    const runtime::StateWrite &W = Writes[I];
+    // Slots are only ever stored, never deleted
+    ZEN_ASSERT(W.Value && W.KeyLen == sizeof(Bytes32) &&
+               W.ValueLen == sizeof(Bytes32));
+    std::memcpy(Batch[I].Key.data(), W.Key, sizeof(Bytes32));
+    std::memcpy(Batch[I].Value.data(), W.Value, sizeof(Bytes32));
+  }
+  Backend.commit(Batch.data(), Batch.size());
+}
+
+void JournaledEVMStorage::load(const Bytes32 &Key, Bytes32 &Value) {
+  const uint8_t *Data;
+  uint32_t Size;
+  if (!Journal.get(Key.data(), Key.size(), Data, Size)) {
+    Value.fill(0);
+    return;
+  }
+  ZEN_ASSERT(Size == Value.size());
+  std::memcpy(Value.data(), Data, Size);
+}
+
+void JournaledEVMStorage::store(const Bytes32 &Key, const Bytes32 &Value) {
+  Journal.set(Key.data(), Key.size(), Value.data(), Value.size());
+}
+
+} // namespace zen::host
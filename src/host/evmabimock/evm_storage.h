@@ -0,0 +1,141 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_HOST_EVMABIMOCK_EVM_STORAGE_H
+#define ZEN_HOST_EVMABIMOCK_EVM_STORAGE_H
+
+#include "runtime/state_journal.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace zen::host {
+
+using Bytes32 = std::array<uint8_t, 32>;
+
+struct EVMStorageSlot {
+  Bytes32 Key;
+  Bytes32 Value;
+};
+
+/// Pluggable persistent storage behind the EVM ABI storage host functions
+class EVMStorageBackend {
+public:
+  virtual ~EVMStorageBackend() = default;
+
+  /// \return false if the key has never been written(the value is zero)
+  virtual bool load(const Bytes32 &Key, Bytes32 &Value) = 0;
+
+  /// Batched commit hook, called once per committed message with all the
+  /// slots written by it
+  virtual void commit(const EVMStorageSlot *Slots, size_t NumSlots) = 0;
+};
+
+/// Open-addressing(linear probing) table of fixed-size 32-byte keys and
+/// values. Keys and values are stored inline so a lookup touches a single
+/// cache line in the common case and never allocates.
+class Bytes32Table {
+public:
+  explicit Bytes32Table(size_t InitCapacity = 64);
+
+  const Bytes32 *find(const Bytes32 &Key) const;
+
+  /// \return the value of the key, zero-initialized if newly inserted
+  Bytes32 &findOrInsert(const Bytes32 &Key, bool &Inserted);
+
+  bool erase(const Bytes32 &Key);
+
+  void clear();
+
+  size_t size() const { return NumEntries; }
+
+  size_t capacity() const { return Slots.size(); }
+
+  /// The slot probing for the key starts from
+  size_t getHomeSlot(const Bytes32 &Key) const { return hash(Key) & Mask; }
+
+  template <typename Func> void forEach(Func &&F) const {
+    for (size_t I = 0; I < Slots.size(); ++I) {
+      if (Used[I]) {
+        F(Slots[I]);
+      }
+    }
+  }
+
+private:
+  static size_t hash(const Bytes32 &Key);
+
+  /// \return the index of the key or of the first empty slot after it
+  size_t probe(const Bytes32 &Key) const;
+
+  void grow();
+
+  std::vector<EVMStorageSlot> Slots;
+  std::vector<uint8_t> Used;
+  size_t Mask = 0;
+  size_t NumEntries = 0;
+};
+
+/// Default in-process backend
+class InMemoryEVMStorage : public EVMStorageBackend {
+public:
+  bool load(const Bytes32 &Key, Bytes32 &Value) override;
+
+  void commit(const EVMStorageSlot *Slots, size_t NumSlots) override;
+
+  const Bytes32Table &getTable() const { return Table; }
+
+private:
+  Bytes32Table Table;
+};
+
+/// Journaled write overlay in front of a backend, a runtime::StateJournal of
+/// 32-byte keys and values. Writes stay in the journal until commit,
+/// checkpoints nest and revert costs O(writes since the checkpoint).
+class JournaledEVMStorage {
+public:
+  explicit JournaledEVMStorage(EVMStorageBackend &Backend)
+      : Adapter(Backend), Journal(Adapter) {}
+
+  void load(const Bytes32 &Key, Bytes32 &Value);
+
+  void store(const Bytes32 &Key, const Bytes32 &Value);
+
+  /// \return the id of the new checkpoint, see StateJournal::checkpoint
+  uint32_t checkpoint() { return Journal.checkpoint(); }
+
+  /// Undo the writes since checkpoint Id and close it with the nested ones
+  void revert(uint32_t Id) { Journal.revert(Id); }
+
+  /// Undo all the writes since the last commit
+  void discard() { Journal.discard(); }
+
+  /// Flush the writes to the backend in one batch
+  void commit() { Journal.commit(); }
+
+  size_t getNumDirtySlots() const { return Journal.getNumDirtyKeys(); }
+
+private:
+  /// Presents an EVMStorageBackend as the backend of the state journal
+  class BackendAdapter : public runtime::StateBackend {
+  public:
+    explicit BackendAdapter(EVMStorageBackend &Backend) : Backend(Backend) {}
+
+    bool load(const uint8_t *Key, uint32_t KeyLen,
+              std::string &Value) override;
+
+    void commit(const runtime::StateWrite *Writes, size_t NumWrites) override;
+
+  private:
+    EVMStorageBackend &Backend;
+    std::vector<EVMStorageSlot> Batch;
+  };
+
+  BackendAdapter Adapter;
+  runtime::StateJournal Journal;
+};
+
+} // namespace zen::host
+
+#endif // ZEN_HOST_EVMABIMOCK_EVM_STORAGE_H
@@ -6,6 +6,7 @@
 // EXPORT_MODULE_NAME
 #include "common/errors.h"
 #include "host/evmabimock/evmabimock.h"
+#include "utils/crypto.h"
 #include "utils/others.h"
 #include <iomanip>
 #include <string>
@@ -30,9 +31,18 @@ static const char *EVM_ABI_CONTEXT_NOT_FOUND = "not found EVMAbi context";
 
 // begin EVMAbiMockContext
 
+EVMAbiMockContext::EVMAbiMockContext(
+    std::unique_ptr<EVMStorageBackend> Backend)
+    : StorageBackend(std::move(Backend)),
+      CurMsgContractStorage(*StorageBackend) {}
+
 std::shared_ptr<EVMAbiMockContext>
-EVMAbiMockContext::create(std::vector<uint8_t> &WasmCode) {
-  auto Ctx = std::make_shared<EVMAbiMockContext>();
+EVMAbiMockContext::create(std::vector<uint8_t> &WasmCode,
+                          std::unique_ptr<EVMStorageBackend> Backend) {
+  if (!Backend) {
+    Backend = std::make_unique<InMemoryEVMStorage>();
+  }
+  auto Ctx = std::make_shared<EVMAbiMockContext>(std::move(Backend));
   // prefix is big-endian 4bytes of wasm Length
 
   uint32_t CodeLength = WasmCode.size();
@@ -55,28 +65,6 @@ const std::vector<uint8_t> &EVMAbiMockContext::getCurContractCode() {
   return CurMsgContractCode;
 }
 
-void EVMAbiMockContext::setCurContractStore(const std::string &Key,
-                                            const std::vector<uint8_t> &Value) {
-  auto It = CurMsgContractStores.find(Key);
-  if (It != CurMsgContractStores.end()) {
-    It->second = Value;
-  } else {
-    CurMsgContractStores.insert(std::make_pair(Key, Value));
-  }
-}
-
-const std::vector<uint8_t> &
-EVMAbiMockContext::getCurContractStore(const std::string &Key) {
-  // bytes32 zero hex
-  static const std::vector<uint8_t> ZERO_BYTES32(32, 0x0);
-  auto It = CurMsgContractStores.find(Key);
-  if (It != CurMsgContractStores.end()) {
-    return It->second;
-  } else {
-    return ZERO_BYTES32;
-  }
-}
-
 // end EVMAbiMockContext
 
 static EVMAbiMockContext *getEVMAbiMockContext(Instance *instance) {
@@ -201,7 +189,6 @@ static int64_t getBlockTimestamp(Instance *instance) { return 1234567890L; }
 
 static void storageStore(Instance *instance, int32_t KeyBytesOffset,
                          int32_t ValueBytesOffset) {
-  printf("storageStore hostapi called\n");
   auto EvmAbiMockCtx = getEVMAbiMockContext(instance);
   if (!EvmAbiMockCtx) {
     instance->setExceptionByHostapi(getErrorWithExtraMessage(
@@ -218,22 +205,20 @@ static void storageStore(Instance *instance, int32_t KeyBytesOffset,
         getErrorWithExtraMessage(ErrorCode::EnvAbort, OUT_OF_BOUND_ERROR));
     return;
   }
-  const uint8_t *native_key_bytes32 =
-      (const uint8_t *)ADDR_APP_TO_NATIVE(KeyBytesOffset);
-  const uint8_t *native_value_bytes32 =
-      (const uint8_t *)ADDR_APP_TO_NATIVE(ValueBytesOffset);
-  std::vector<uint8_t> native_value_bytes32_vec(native_value_bytes32,
-                                                native_value_bytes32 + 32);
-  printf("storageStore key: %s, value: %s\n",
-         zen::utils::toHex(native_key_bytes32, 32).c_str(),
-         zen::utils::toHex(native_value_bytes32, 32).c_str());
-  EvmAbiMockCtx->setCurContractStore(zen::utils::toHex(native_key_bytes32, 32),
-                                     native_value_bytes32_vec);
+  Bytes32 Key;
+  Bytes32 Value;
+  std::memcpy(Key.data(), ADDR_APP_TO_NATIVE(KeyBytesOffset), 32);
+  std::memcpy(Value.data(), ADDR_APP_TO_NATIVE(ValueBytesOffset), 32);
+  if (EvmAbiMockCtx->isTraceStorage()) {
+    printf("storageStore key: %s, value: %s\n",
+           zen::utils::toHex(Key.data(), 32).c_str(),
+           zen::utils::toHex(Value.data(), 32).c_str());
+  }
+  EvmAbiMockCtx->getCurContractStorage().store(Key, Value);
 }
 
 static void storageLoad(Instance *instance, int32_t KeyBytesOffset,
                         int32_t ResultOffset) {
-  printf("storageLoad hostapi called\n");
   auto EvmAbiMockCtx = getEVMAbiMockContext(instance);
   if (!EvmAbiMockCtx) {
     instance->setExceptionByHostapi(getErrorWithExtraMessage(
@@ -251,13 +236,18 @@ static void storageLoad(Instance *instance, int32_t KeyBytesOffset,
         getErrorWithExtraMessage(ErrorCode::EnvAbort, OUT_OF_BOUND_ERROR));
     return;
   }
-  const uint8_t *native_key_bytes32 =
-      (const uint8_t *)ADDR_APP_TO_NATIVE(KeyBytesOffset);
-  const auto &native_value_bytes32 = EvmAbiMockCtx->getCurContractStore(
-      zen::utils::toHex(native_key_bytes32, 32));
+  Bytes32 Key;
+  Bytes32 Value;
+  std::memcpy(Key.data(), ADDR_APP_TO_NATIVE(KeyBytesOffset), 32);
+  EvmAbiMockCtx->getCurContractStorage().load(Key, Value);
+  if (EvmAbiMockCtx->isTraceStorage()) {
+    printf("storageLoad key: %s, value: %s\n",
+           zen::utils::toHex(Key.data(), 32).c_str(),
+           zen::utils::toHex(Value.data(), 32).c_str());
+  }
 
   uint8_t *NativeResult = (uint8_t *)ADDR_APP_TO_NATIVE(ResultOffset);
-  memcpy(NativeResult, native_value_bytes32.data(), 32);
+  memcpy(NativeResult, Value.data(), 32);
 }
 
 static void emitLogEvent(Instance *instance, int32_t DataOffset, int32_t Length,
@@ -326,6 +316,21 @@ static void emitLogEvent(Instance *instance, int32_t DataOffset, int32_t Length,
   }
 }
 
+// finish commits the storage writes of the current message in one batch,
+// revert and invalid drop them
+static void endCurMessage(Instance *instance, bool Success) {
+  auto EvmAbiMockCtx = getEVMAbiMockContext(instance);
+  if (!EvmAbiMockCtx) {
+    return;
+  }
+  auto &Storage = EvmAbiMockCtx->getCurContractStorage();
+  if (Success) {
+    Storage.commit();
+  } else {
+    Storage.discard();
+  }
+}
+
 static void finish(Instance *instance, int32_t DataOffset, int32_t Length) {
   if (!VALIDATE_APP_ADDR(DataOffset, Length)) {
     instance->setExceptionByHostapi(
@@ -339,6 +344,7 @@ static void finish(Instance *instance, int32_t DataOffset, int32_t Length) {
   }
   if (Length == 0) {
     printf("evm finish with: \n");
+    endCurMessage(instance, true);
     instance->setError(ErrorCode::InstanceExit);
     return;
   }
@@ -349,11 +355,13 @@ static void finish(Instance *instance, int32_t DataOffset, int32_t Length) {
   memcpy((uint8_t *)finish_msg.data(), native_data, Length);
   printf("evm finish with: %s\n",
          zen::utils::toHex(finish_msg.data(), finish_msg.size()).c_str());
+  endCurMessage(instance, true);
   instance->setError(ErrorCode::InstanceExit);
 }
 
 static void invalid(Instance *instance) {
   printf("evm invalid error\n");
+  endCurMessage(instance, false);
   instance->setExceptionByHostapi(
       getErrorWithExtraMessage(ErrorCode::EnvAbort, ""));
 }
@@ -376,6 +384,7 @@ static void revert(Instance *instance, int32_t DataOffset, int32_t Length) {
   memcpy((uint8_t *)revert_msg.data(), native_data, Length);
   printf("evm revert with: %s\n",
          zen::utils::toHex(revert_msg.data(), revert_msg.size()).c_str());
+  endCurMessage(instance, false);
   instance->setExceptionByHostapi(
       getErrorWithExtraMessage(ErrorCode::EnvAbort, "revert"));
 }
@@ -544,28 +553,33 @@ static void selfDestruct(Instance *instance, int32_t _AddrOffset) {
       getErrorWithExtraMessage(ErrorCode::EnvAbort, "selfdestruct"));
 }
 
-static void sha256(Instance *instance, int32_t input_offset,
-                   int32_t input_Length, int32_t ResultOffset) {
-  static uint8_t MOCK_SHA256_RESULT[32] = {0x12};
-  if (!VALIDATE_APP_ADDR(ResultOffset, 32)) {
+static void hashImpl(Instance *instance,
+                     void (*HashFn)(const uint8_t *, size_t, uint8_t[32]),
+                     int32_t InputOffset, int32_t InputLength,
+                     int32_t ResultOffset) {
+  if ((InputLength != 0 && !VALIDATE_APP_ADDR(InputOffset, InputLength)) ||
+      !VALIDATE_APP_ADDR(ResultOffset, 32)) {
     instance->setExceptionByHostapi(
         getErrorWithExtraMessage(ErrorCode::EnvAbort, OUT_OF_BOUND_ERROR));
     return;
   }
+  const uint8_t *NativeInput =
+      InputLength != 0 ? (const uint8_t *)ADDR_APP_TO_NATIVE(InputOffset)
+                       : nullptr;
   uint8_t *NativeResult = (uint8_t *)ADDR_APP_TO_NATIVE(ResultOffset);
-  memcpy(NativeResult, MOCK_SHA256_RESULT, 32);
+  HashFn(NativeInput, (uint32_t)InputLength, NativeResult);
 }
 
-static void keccak256(Instance *instance, int32_t _InputOffset,
-                      int32_t _InputLength, int32_t ResultOffset) {
-  static uint8_t MOCK_SHA256_RESULT[32] = {0x23};
-  if (!VALIDATE_APP_ADDR(ResultOffset, 32)) {
-    instance->setExceptionByHostapi(
-        getErrorWithExtraMessage(ErrorCode::EnvAbort, OUT_OF_BOUND_ERROR));
-    return;
-  }
-  uint8_t *NativeResult = (uint8_t *)ADDR_APP_TO_NATIVE(ResultOffset);
-  memcpy(NativeResult, MOCK_SHA256_RESULT, 32);
+static void sha256(Instance *instance, int32_t InputOffset,
+                   int32_t InputLength, int32_t ResultOffset) {
+  hashImpl(instance, zen::utils::sha256, InputOffset, InputLength,
+           ResultOffset);
+}
+
+static void keccak256(Instance *instance, int32_t InputOffset,
+                      int32_t InputLength, int32_t ResultOffset) {
+  hashImpl(instance, zen::utils::keccak256, InputOffset, InputLength,
+           ResultOffset);
 }
 
 static void addmod(Instance *instance, int32_t _AOffset, int32_t _BOffset,
@@ -4,9 +4,9 @@
 #ifndef ZEN_HOST_EVMABIMOCK_EVMABIMOCK_H
 #define ZEN_HOST_EVMABIMOCK_EVMABIMOCK_H
 
+#include "host/evmabimock/evm_storage.h"
 #include "wni/helper.h"
 #include <memory>
-#include <unordered_map>
 #include <vector>
 
 namespace zen::host {
@@ -16,16 +16,27 @@ namespace zen::host {
 class EVMAbiMockContext {
 private:
   std::vector<uint8_t> CurMsgContractCode;
-  // key(byte32) hex => value(byte32) hex without 0x prefix
-  std::unordered_map<std::string, std::vector<uint8_t>> CurMsgContractStores;
+  std::unique_ptr<EVMStorageBackend> StorageBackend;
+  // writes of the current message, committed to StorageBackend on finish and
+  // dropped on revert
+  JournaledEVMStorage CurMsgContractStorage;
+  // print every storage access, only for debugging
+  bool TraceStorage = false;
 
 public:
+  explicit EVMAbiMockContext(std::unique_ptr<EVMStorageBackend> Backend);
+
+  /// \param Backend the persistent storage, use InMemoryEVMStorage if null
   static std::shared_ptr<EVMAbiMockContext>
-  create(std::vector<uint8_t> &WasmCode);
-  void setCurContractStore(const std::string &Key,
-                           const std::vector<uint8_t> &Value);
-  const std::vector<uint8_t> &getCurContractStore(const std::string &Key);
+  create(std::vector<uint8_t> &WasmCode,
+         std::unique_ptr<EVMStorageBackend> Backend = nullptr);
+  JournaledEVMStorage &getCurContractStorage() {
+    return CurMsgContractStorage;
+  }
+  EVMStorageBackend &getStorageBackend() { return *StorageBackend; }
   const std::vector<uint8_t> &getCurContractCode();
+  void setTraceStorage(bool Enabled) { TraceStorage = Enabled; }
+  bool isTraceStorage() const { return TraceStorage; }
 };
 
 #undef EXPORT_MODULE_NAME
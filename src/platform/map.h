@@ -20,12 +20,27 @@ void munmap(void *Addr, size_t Len);
 
 void mprotect(void *Addr, size_t Len, int Prot);
 
+// Hint the kernel to back the range with transparent huge pages, failure is
+// not fatal because huge pages are only a performance hint
+void adviseHugePages(void *Addr, size_t Len);
+
+// Prefer the NUMA node of the calling thread when the pages of the range are
+// faulted in, failure is not fatal(e.g. single-node host)
+void bindLocalNumaNode(void *Addr, size_t Len);
+
+// Let the kernel reclaim the pages of the range, their content is undefined
+// afterwards but the range stays mapped with the same protection. Failure is
+// not fatal because the pages are only kept resident
+void discardPages(void *Addr, size_t Len);
+
 struct FileMapInfo {
   void *Addr;
   size_t Length;
 };
 
-bool mapFile(FileMapInfo *Info, const char *Filename);
+// Map the whole file privately, read-only unless `Writable`, in which case
+// the written pages are copied on write and never reach the file
+bool mapFile(FileMapInfo *Info, const char *Filename, bool Writable = false);
 
 void unmapFile(const FileMapInfo *Info);
 
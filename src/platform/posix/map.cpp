@@ -6,6 +6,9 @@
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#ifdef ZEN_BUILD_PLATFORM_LINUX
+#include <sys/syscall.h>
+#endif
 
 namespace zen::platform {
 
@@ -40,8 +43,52 @@ void mprotect(void *Addr, size_t Len, int Prot) {
   }
 }
 
-bool mapFile(FileMapInfo *Info, const char *Filename) {
-  int Fd = ::open(Filename, O_RDWR);
+void adviseHugePages(void *Addr, size_t Len) {
+#if defined(ZEN_BUILD_PLATFORM_LINUX) && defined(MADV_HUGEPAGE)
+  if (::madvise(Addr, Len, MADV_HUGEPAGE) != 0) {
+    ZEN_LOG_DEBUG("failed to madvise(%p, %zu, MADV_HUGEPAGE) due to '%s'",
+                  Addr, Len, std::strerror(errno));
+  }
+#endif
+}
+
+void discardPages(void *Addr, size_t Len) {
+#if defined(MADV_FREE)
+  // reclaimed only under memory pressure, otherwise reused without a fault
+  int Advice = MADV_FREE;
+#else
+  int Advice = MADV_DONTNEED;
+#endif
+  if (::madvise(Addr, Len, Advice) != 0) {
+    ZEN_LOG_DEBUG("failed to madvise(%p, %zu, %d) due to '%s'", Addr, Len,
+                  Advice, std::strerror(errno));
+  }
+}
+
+void bindLocalNumaNode(void *Addr, size_t Len) {
+#if defined(ZEN_BUILD_PLATFORM_LINUX) && defined(SYS_getcpu) &&                \
+    defined(SYS_mbind)
+  // Use raw syscalls to avoid the dependency on libnuma
+  constexpr int MpolPreferred = 1;
+  constexpr unsigned long MaxNumaNodes = sizeof(unsigned long) * CHAR_BIT;
+  unsigned Cpu = 0;
+  unsigned Node = 0;
+  if (::syscall(SYS_getcpu, &Cpu, &Node, nullptr) != 0 ||
+      Node >= MaxNumaNodes) {
+    return;
+  }
+  unsigned long NodeMask = 1UL << Node;
+  // The kernel reads maxnode - 1 bits of the mask
+  if (::syscall(SYS_mbind, Addr, Len, MpolPreferred, &NodeMask,
+                MaxNumaNodes + 1, 0) != 0) {
+    ZEN_LOG_DEBUG("failed to mbind(%p, %zu) to numa node %u due to '%s'",
+                  Addr, Len, Node, std::strerror(errno));
+  }
+#endif
+}
+
+bool mapFile(FileMapInfo *Info, const char *Filename, bool Writable) {
+  int Fd = ::open(Filename, O_RDONLY);
   if (Fd < 0) {
     ZEN_LOG_ERROR("failed to open file '%s' due to '%s'", Filename,
                   std::strerror(errno));
@@ -63,8 +110,8 @@ bool mapFile(FileMapInfo *Info, const char *Filename) {
     return false;
   }
 
-  void *Ptr = platform::mmap(nullptr, Stat.st_size, PROT_READ | PROT_WRITE,
-                             MAP_PRIVATE, Fd, 0);
+  int Prot = Writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+  void *Ptr = platform::mmap(nullptr, Stat.st_size, Prot, MAP_PRIVATE, Fd, 0);
   if (!Ptr) {
     return false;
   }
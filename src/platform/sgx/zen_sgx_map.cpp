@@ -39,7 +39,13 @@ void mprotect(void *Addr, size_t Len, int Prot) {
   }
 }
 
-bool mapFile(FileMapInfo *Info, const char *Filename) {
+void adviseHugePages(void *Addr, size_t Len) {}
+
+void bindLocalNumaNode(void *Addr, size_t Len) {}
+
+void discardPages(void *Addr, size_t Len) {}
+
+bool mapFile(FileMapInfo *Info, const char *Filename, bool Writable) {
   ocall_print_string("unsupport mapFile in SGX");
   return false;
 }
@@ -0,0 +1,99 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "runtime/block_profile.h"
+
+#include "common/enums.h"
+#include "runtime/module.h"
+#include "runtime/runtime.h"
+#include "utils/wasm.h"
+
+#include <string>
+
+namespace zen::runtime {
+
+using common::Opcode;
+
+static std::string getFuncName(const Module &Mod, uint32_t FuncIdx) {
+  const FuncEntry &Func =
+      Mod.getInternalFunction(FuncIdx - Mod.getNumImportFunctions());
+  if (Func.Name == common::WASM_SYMBOL_NULL) {
+    return "$f" + std::to_string(FuncIdx);
+  }
+  // keep one name per field
+  std::string Name = Mod.getRuntime()->dumpSymbolString(Func.Name);
+  for (char &C : Name) {
+    if (C == ' ' || C == '\t' || C == '\n') {
+      C = '_';
+    }
+  }
+  return Name;
+}
+
+bool writeBlockProfile(const Module &Mod, FILE *Out) {
+  const uint64_t *Counters = Mod.getBlockCounters();
+  const uint8_t *Bytecode = Mod.getWASMBytecode();
+  uint64_t OpcodeCounts[256] = {0};
+
+  uint32_t NumImportFunctions = Mod.getNumImportFunctions();
+  uint32_t NumTotalFunctions = Mod.getNumTotalFunctions();
+  for (uint32_t I = NumImportFunctions; I < NumTotalFunctions; ++I) {
+    const CodeEntry *Entry = Mod.getCodeEntry(I);
+    // never called with RuntimeConfig::EnableLazyValidation
+    if (Entry->MaxBlockDepth == 0) {
+      continue;
+    }
+    const uint8_t *Ip = Entry->CodePtr;
+    const uint8_t *IpEnd = Ip + Entry->CodeSize;
+    std::string FuncName;
+    // count of the block containing Ip
+    uint64_t Count = 0;
+    bool IsLeader = true;
+    while (Ip < IpEnd) {
+      if (IsLeader) {
+        Count = Counters[Ip - Bytecode];
+        if (Count > 0) {
+          if (FuncName.empty()) {
+            FuncName = getFuncName(Mod, I);
+          }
+          std::fprintf(Out, "block %u %s 0x%lx %lu\n", I, FuncName.c_str(),
+                       static_cast<unsigned long>(Ip - Bytecode),
+                       static_cast<unsigned long>(Count));
+        }
+      }
+      uint8_t Op = *Ip;
+      OpcodeCounts[Op] += Count;
+      Ip = utils::skipInstruction(Ip, IpEnd);
+      switch (Op) {
+      case Opcode::LOOP:
+      case Opcode::IF:
+      case Opcode::ELSE:
+      case Opcode::END:
+      case Opcode::BR_IF:
+        IsLeader = true;
+        break;
+      case Opcode::BR:
+      case Opcode::BR_TABLE:
+      case Opcode::RETURN:
+      case Opcode::UNREACHABLE:
+        // dead code until the next else or end
+        Count = 0;
+        IsLeader = false;
+        break;
+      default:
+        IsLeader = false;
+        break;
+      }
+    }
+  }
+
+  for (uint32_t Op = 0; Op < 256; ++Op) {
+    if (OpcodeCounts[Op] > 0) {
+      std::fprintf(Out, "opcode %s %lu\n", utils::getOpcodeString(Op),
+                   static_cast<unsigned long>(OpcodeCounts[Op]));
+    }
+  }
+  return !std::ferror(Out);
+}
+
+} // namespace zen::runtime
@@ -0,0 +1,34 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_BLOCK_PROFILE_H
+#define ZEN_RUNTIME_BLOCK_PROFILE_H
+
+#include "common/defines.h"
+
+#include <cstdio>
+
+namespace zen::runtime {
+
+class Module;
+
+/// Write the basic block execution counts collected by the interpreter and
+/// JIT code of a module built with ZEN_ENABLE_BLOCK_COUNTERS, as lines of
+///
+///   block <func idx> <func name> <byte code offset> <count>
+///
+/// for every executed block, ordered by offset in the module binary, followed
+/// by the dynamic count of every executed opcode, derived from the counts of
+/// the blocks containing it
+///
+///   opcode <name> <count>
+///
+/// Blocks start at the function entry and after every loop, if, else, end and
+/// br_if instruction. Counts are not synchronized between threads running the
+/// same module, and a trap in the middle of a block still counts the rest of
+/// its opcodes.
+bool writeBlockProfile(const Module &Mod, FILE *Out);
+
+} // namespace zen::runtime
+
+#endif // ZEN_RUNTIME_BLOCK_PROFILE_H
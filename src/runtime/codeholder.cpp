@@ -5,6 +5,7 @@
 #include "common/errors.h"
 #include "platform/map.h"
 #include "runtime/module.h"
+#include "runtime/runtime.h"
 
 namespace zen::runtime {
 
@@ -17,7 +18,10 @@ CodeHolderUniquePtr CodeHolder::newFileCodeHolder(Runtime &RT,
 
   FileMapInfo MapInfo = {.Addr = nullptr, .Length = size_t(-1)};
 
-  if (!mapFile(&MapInfo, Filename.c_str())) {
+  // The module keeps its code and data segments as views into the mapping,
+  // only the interpreter rewrites some opcodes in place while loading
+  bool Writable = RT.getConfig().Mode == RunMode::InterpMode;
+  if (!mapFile(&MapInfo, Filename.c_str(), Writable)) {
     if (MapInfo.Length == 0) {
       // Empty File
       throw getError(ErrorCode::UnexpectedEnd);
@@ -42,6 +46,15 @@ CodeHolderUniquePtr CodeHolder::newFileCodeHolder(Runtime &RT,
 
 CodeHolderUniquePtr
 CodeHolder::newRawDataCodeHolder(Runtime &RT, const void *Data, size_t Size) {
+  void *DataCopy;
+  CodeHolderUniquePtr RawData = newRawBufferCodeHolder(RT, Size, DataCopy);
+  std::memcpy(DataCopy, Data, Size);
+  return RawData;
+}
+
+CodeHolderUniquePtr CodeHolder::newRawBufferCodeHolder(Runtime &RT,
+                                                       size_t Size,
+                                                       void *&Buffer) {
   if (Size > PresetMaxModuleSize) {
     throw getError(ErrorCode::ModuleSizeTooLarge);
   }
@@ -51,11 +64,10 @@ CodeHolder::newRawDataCodeHolder(Runtime &RT, const void *Data, size_t Size) {
 
   CodeHolderUniquePtr RawData(new (Buf) CodeHolder(RT, HolderKind::kRawData));
 
-  void *DataCopy = RT.allocate(Size);
-  ZEN_ASSERT(DataCopy);
-  std::memcpy(DataCopy, Data, Size);
+  Buffer = RT.allocate(Size);
+  ZEN_ASSERT(Buffer);
 
-  RawData->Data = DataCopy;
+  RawData->Data = Buffer;
   RawData->Size = Size;
 
   return RawData;
@@ -22,6 +22,11 @@ public:
   static CodeHolderUniquePtr newRawDataCodeHolder(Runtime &RT, const void *Data,
                                                   size_t Size);
 
+  /// Allocate an uninitialized buffer of `Size` bytes, returned in `Buffer`
+  /// to be filled by the caller, e.g. ModuleStream
+  static CodeHolderUniquePtr newRawBufferCodeHolder(Runtime &RT, size_t Size,
+                                                    void *&Buffer);
+
   HolderKind getKind() const { return Kind; }
 
   const void *getData() const { return Data; }
@@ -14,6 +14,11 @@ struct RuntimeConfig {
   common::RunMode Mode = common::RunMode::SinglepassMode;
   // Disable mmap to allocate wasm memory
   bool DisableWasmMemoryMap = false;
+  // Back mmaped wasm memory and JIT code with transparent huge pages
+  bool EnableHugePages = false;
+  // Prefer the NUMA node of the allocating thread for mmaped wasm memory and
+  // JIT code
+  bool EnableNumaLocalMemory = false;
   // Enable benchmark
   bool EnableBenchmark = false;
 #ifdef ZEN_ENABLE_BUILTIN_WASI
@@ -22,8 +27,19 @@ struct RuntimeConfig {
 #endif
   // Open statistics(compilation time/execution time)
   bool EnableStatistics = false;
+  // Count cpu cycles/instructions/misses of the statistics phases by
+  // perf_event_open(linux only, needs EnableStatistics)
+  bool EnableHardwareCounters = false;
+  // Poll Instance::interrupt requests at function entries and loop headers
+  bool EnableInterruption = false;
   // Enable cpu instruction tracer hook
   bool EnableGdbTracingHook = false;
+  // Number of threads validating the function bodies of a module while
+  // loading it, 0 or 1 validates them on the loading thread
+  uint32_t NumLoaderThreads = 0;
+  // Only check the encoding of function bodies while loading, and type check
+  // each of them on its first call(interpreter only)
+  bool EnableLazyValidation = false;
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
   // Disable greedy register allocation of multipass JIT
   bool DisableMultipassGreedyRA = false;
@@ -44,6 +60,10 @@ struct RuntimeConfig {
       DisableMultipassMultithread = true;
     }
 #endif // ZEN_ENABLE_MULTIPASS_JIT
+    if (EnableLazyValidation && Mode != common::RunMode::InterpMode) {
+      ZEN_LOG_WARN("lazy validation disabled, only supported by interpreter");
+      EnableLazyValidation = false;
+    }
 
     switch (Mode) {
 #ifndef ZEN_ENABLE_SINGLEPASS_JIT
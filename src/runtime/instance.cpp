@@ -10,6 +10,7 @@
 #include "entrypoint/entrypoint.h"
 #include "runtime/config.h"
 #include <algorithm>
+#include <cstring>
 
 namespace zen::runtime {
 
@@ -43,10 +44,11 @@ void Module::InstanceLayout::compute() {
   TableInstancesSize = ZEN_ALIGN(sizeof(TableInstance) * NumTables, Alignment);
   TableElemsSize = 0;
   for (size_t I = 0; I < Mod.NumImportTables; ++I) {
-    TableElemsSize += Mod.ImportTableTable[I].InitSize * sizeof(uint32_t);
+    TableElemsSize += Mod.ImportTableTable[I].InitSize * sizeof(TableElement);
   }
   for (size_t I = 0; I < Mod.NumInternalTables; ++I) {
-    TableElemsSize += Mod.InternalTableTable[I].InitSize * sizeof(uint32_t);
+    TableElemsSize +=
+        Mod.InternalTableTable[I].InitSize * sizeof(TableElement);
   }
   TableElemsSize = ZEN_ALIGN(TableElemsSize, Alignment);
   // at least malloc one memory instance after Instance object
@@ -71,12 +73,10 @@ void Module::InstanceLayout::compute() {
 
 #ifdef ZEN_ENABLE_JIT
   FuncPtrsSize = ZEN_ALIGN(NumFunctions * sizeof(uintptr_t), Alignment);
-  FuncTypeIndexesSize = ZEN_ALIGN(NumFunctions * sizeof(uint32_t), Alignment);
-  TotalSize += FuncPtrsSize + FuncTypeIndexesSize;
+  TotalSize += FuncPtrsSize;
 
   FuncPtrsBaseOffset =
       TableElemBaseOffset + TableElemsSize + MemoryInstancesSize;
-  FuncTypeIndexesBaseOffset = FuncPtrsBaseOffset + FuncPtrsSize;
 
   StackBoundaryOffset = offsetof(Instance, JITStackBoundary);
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
@@ -87,6 +87,7 @@ void Module::InstanceLayout::compute() {
 
   ExceptionOffset = offsetof(Instance, Err.ErrCode);
   GasOffset = offsetof(Instance, Gas);
+  InterruptFlagOffset = offsetof(Instance, InterruptFlag);
 
 #ifdef ZEN_ENABLE_DWASM
   StackCostOffset = offsetof(Instance, StackCost);
@@ -124,11 +125,9 @@ InstanceUniquePtr Instance::newInstance(Isolation &Iso, const Module &Mod,
 #ifdef ZEN_ENABLE_JIT
   Inst->JITFuncPtrs = reinterpret_cast<uintptr_t *>((uintptr_t)Inst->Memories +
                                                     Layout.MemoryInstancesSize);
-  Inst->FuncTypeIdxs = reinterpret_cast<uint32_t *>(
-      (uintptr_t)Inst->JITFuncPtrs + Layout.FuncPtrsSize);
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
-  Inst->Traces = reinterpret_cast<int32_t *>((uintptr_t)Inst->FuncTypeIdxs +
-                                             Layout.FuncTypeIndexesSize);
+  Inst->Traces = reinterpret_cast<int32_t *>((uintptr_t)Inst->JITFuncPtrs +
+                                             Layout.FuncPtrsSize);
 #endif // ZEN_ENABLE_DUMP_CALL_STACK
 
 #endif // ZEN_ENABLE_JIT
@@ -174,6 +173,27 @@ Instance::~Instance() {
 #endif
 }
 
+// ==================== Table Accessing Methods ====================
+
+void Instance::setTableElement(TableInstance &Table, uint32_t ElemIdx,
+                               uint32_t FuncIdx) {
+  ZEN_ASSERT(ElemIdx < Table.CurSize);
+  TableElement &Elem = Table.Elements[ElemIdx];
+  Elem.FuncIdx = FuncIdx;
+  if (FuncIdx == -1u) {
+    Elem.TypeIdx = -1u;
+    Elem.JITCodePtr = nullptr;
+    return;
+  }
+  ZEN_ASSERT(FuncIdx < NumTotalFunctions);
+  Elem.TypeIdx = Functions[FuncIdx].FuncType->SmallestTypeIdx;
+#ifdef ZEN_ENABLE_JIT
+  Elem.JITCodePtr = reinterpret_cast<const uint8_t *>(JITFuncPtrs[FuncIdx]);
+#else
+  Elem.JITCodePtr = nullptr;
+#endif
+}
+
 // ==================== Memory Accessing Methods ====================
 
 WasmMemoryAllocator *Instance::getWasmMemoryAllocator() {
@@ -247,6 +267,58 @@ bool Instance::growLinearMemory(uint32_t MemIdx, uint32_t GrowPagesDelta) {
   return true;
 }
 
+bool Instance::copyLinearMemory(uint32_t DestOffset, uint32_t SrcOffset,
+                                uint32_t Size) {
+  if (!hasMemory()) {
+    return false;
+  }
+  MemoryInstance &Mem = Memories[0];
+  if (uint64_t(DestOffset) + Size > Mem.MemSize ||
+      uint64_t(SrcOffset) + Size > Mem.MemSize) {
+    return false;
+  }
+  if (Size) {
+    std::memmove(Mem.MemBase + DestOffset, Mem.MemBase + SrcOffset, Size);
+  }
+  return true;
+}
+
+bool Instance::fillLinearMemory(uint32_t DestOffset, uint8_t Value,
+                                uint32_t Size) {
+  if (!hasMemory()) {
+    return false;
+  }
+  MemoryInstance &Mem = Memories[0];
+  if (uint64_t(DestOffset) + Size > Mem.MemSize) {
+    return false;
+  }
+  if (Size) {
+    std::memset(Mem.MemBase + DestOffset, Value, Size);
+  }
+  return true;
+}
+
+bool Instance::initLinearMemory(uint32_t DataIdx, uint32_t DestOffset,
+                                uint32_t SrcOffset, uint32_t Size) {
+  ZEN_ASSERT(DataIdx < DroppedDataSegs.size());
+  if (!hasMemory()) {
+    return false;
+  }
+  const DataEntry &DataSeg = *Mod->getDataEntry(DataIdx);
+  // A dropped segment behaves as an empty one
+  uint32_t SegSize = DroppedDataSegs[DataIdx] ? 0 : DataSeg.Size;
+  MemoryInstance &Mem = Memories[0];
+  if (uint64_t(SrcOffset) + Size > SegSize ||
+      uint64_t(DestOffset) + Size > Mem.MemSize) {
+    return false;
+  }
+  if (Size) {
+    std::memcpy(Mem.MemBase + DestOffset,
+                Mod->getWASMBytecode() + DataSeg.Offset + SrcOffset, Size);
+  }
+  return true;
+}
+
 void *Instance::getNativeMemoryAddr(uint32_t Offset) {
   if (Offset >= Memories[0].MemSize) {
     return nullptr;
@@ -323,6 +395,26 @@ int32_t Instance::growInstanceMemoryOnJIT(Instance *Inst,
   return -1;
 }
 
+int32_t Instance::copyInstanceMemoryOnJIT(Instance *Inst, uint32_t DestOffset,
+                                          uint32_t SrcOffset, uint32_t Size) {
+  return Inst->copyLinearMemory(DestOffset, SrcOffset, Size) ? 0 : -1;
+}
+
+int32_t Instance::fillInstanceMemoryOnJIT(Instance *Inst, uint32_t DestOffset,
+                                          uint32_t Value, uint32_t Size) {
+  return Inst->fillLinearMemory(DestOffset, uint8_t(Value), Size) ? 0 : -1;
+}
+
+int32_t Instance::initInstanceMemoryOnJIT(Instance *Inst, uint32_t DataIdx,
+                                          uint32_t DestOffset,
+                                          uint32_t SrcOffset, uint32_t Size) {
+  return Inst->initLinearMemory(DataIdx, DestOffset, SrcOffset, Size) ? 0 : -1;
+}
+
+void Instance::dropInstanceDataSegmentOnJIT(Instance *Inst, uint32_t DataIdx) {
+  Inst->dropDataSegment(DataIdx);
+}
+
 void Instance::setInstanceExceptionOnJIT(Instance *Inst,
                                          common::ErrorCode ErrCode) {
   Inst->setExecutionError(common::getError(ErrCode), 1,
@@ -347,6 +439,24 @@ void Instance::triggerInstanceExceptionOnJIT(Instance *Inst,
   throwInstanceExceptionOnJIT(Inst);
 }
 
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+void Instance::unwindHostExceptionOnJIT(Instance *Inst) {
+  auto *TLS = common::traphandler::CallThreadState::current();
+  // the JIT code is not entered through the trap handler of this instance,
+  // fall back to the cpu trap
+  if (!TLS || !TLS->handling() || TLS->instance() != Inst) {
+    throwInstanceExceptionOnJIT(Inst);
+    return;
+  }
+  // the hostapi has returned, so no native frame with destructors is left
+  // above the JIT entry. The traces have been captured by setExecutionError,
+  // and the gas register has been saved to the instance before the import
+  // call, take it with the gas charged by the hostapi
+  TLS->setGasRegisterValue(Inst->Gas);
+  TLS->jmpToMarked(SIGILL);
+}
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
 void Instance::createCallStackOnJIT(uint32_t IgnoredDepth,
                                     common::traphandler::TrapState TS) {
@@ -12,6 +12,7 @@
 #include "utils/virtual_stack.h"
 #include <queue>
 #endif
+#include <atomic>
 
 #ifdef ZEN_ENABLE_CPU_EXCEPTION
 #include <csetjmp>
@@ -36,6 +37,9 @@ class OnePassCodeGen;
 
 namespace runtime {
 
+class StateJournal;
+template <typename Sig> class TypedFunction;
+
 enum FunctionKind {
   ByteCode = 0,
   Jit,
@@ -88,10 +92,22 @@ struct FunctionInstance final {
   }
 };
 
+/// A table slot keeps the canonical type and the code of its function next to
+/// the function index, so that call_indirect checks and calls with a single
+/// entry load
+struct TableElement final {
+  // -1 if uninitialized
+  uint32_t FuncIdx;
+  // TypeEntry::SmallestTypeIdx of the function, -1 if uninitialized
+  uint32_t TypeIdx;
+  // nullptr in the interpreter
+  const uint8_t *JITCodePtr;
+};
+
 struct TableInstance final {
   uint32_t CurSize;
   uint32_t MaxSize;
-  uint32_t *Elements;
+  TableElement *Elements;
 };
 
 struct MemoryInstance final {
@@ -136,6 +152,17 @@ public:
     return Functions + FuncIdx;
   }
 
+  /// Check the signature of a function once against R(Args...), e.g.
+  /// TypedFunction<int32_t(int32_t, double)>, for repeated typed calls. On
+  /// mismatch the error is set on the instance. Defined in
+  /// runtime/typed_function.h.
+  template <typename R, typename... Args>
+  bool getTypedFunction(uint32_t FuncIdx, TypedFunction<R(Args...)> &Func);
+
+  template <typename R, typename... Args>
+  bool getTypedFunction(const std::string &Name,
+                        TypedFunction<R(Args...)> &Func);
+
   // ==================== Table Accessing Methods ====================
 
   TableInstance *getTableInst(uint32_t TableIdx) {
@@ -143,6 +170,11 @@ public:
     return Tables + TableIdx;
   }
 
+  /// Every table mutation goes through here to keep the element in sync
+  /// \param FuncIdx -1 to clear the element
+  void setTableElement(TableInstance &Table, uint32_t ElemIdx,
+                       uint32_t FuncIdx);
+
   // ==================== Memory Accessing Methods ====================
 
   bool hasMemory() const { return NumTotalMemories > 0; }
@@ -159,6 +191,22 @@ public:
 
   bool growLinearMemory(uint32_t MemIdx, uint32_t GrowPagesDelta);
 
+  // Bulk memory operations on the default memory, shared by the interpreter
+  // and the JIT. Each returns false without touching the memory if any byte of
+  // the ranges is out of bounds, the copies go through libc memmove/memset
+  bool copyLinearMemory(uint32_t DestOffset, uint32_t SrcOffset,
+                        uint32_t Size);
+
+  bool fillLinearMemory(uint32_t DestOffset, uint8_t Value, uint32_t Size);
+
+  bool initLinearMemory(uint32_t DataIdx, uint32_t DestOffset,
+                        uint32_t SrcOffset, uint32_t Size);
+
+  void dropDataSegment(uint32_t DataIdx) {
+    ZEN_ASSERT(DataIdx < DroppedDataSegs.size());
+    DroppedDataSegs[DataIdx] = true;
+  }
+
   void *reallocLinearMemory(void *Ptr, uint32_t OldSize, uint32_t NewSize) {
     return reallocate(Ptr, OldSize, NewSize);
   }
@@ -224,6 +272,16 @@ public:
   static int32_t growInstanceMemoryOnJIT(Instance *Inst,
                                          uint32_t GrowPagesDelta);
 
+  // 0 on success, -1 on out of bounds
+  static int32_t copyInstanceMemoryOnJIT(Instance *Inst, uint32_t DestOffset,
+                                         uint32_t SrcOffset, uint32_t Size);
+  static int32_t fillInstanceMemoryOnJIT(Instance *Inst, uint32_t DestOffset,
+                                         uint32_t Value, uint32_t Size);
+  static int32_t initInstanceMemoryOnJIT(Instance *Inst, uint32_t DataIdx,
+                                         uint32_t DestOffset,
+                                         uint32_t SrcOffset, uint32_t Size);
+  static void dropInstanceDataSegmentOnJIT(Instance *Inst, uint32_t DataIdx);
+
   void setJITStackSize(uint64_t NewStackSize) { JITStackSize = NewStackSize; }
 
   static void __attribute__((noinline))
@@ -233,6 +291,13 @@ public:
   // trigger = set + throw
   static void __attribute__((noinline))
   triggerInstanceExceptionOnJIT(Instance *Inst, ErrorCode ErrCode);
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  // called by the JIT code once an import call returned with an exception,
+  // jump back to the JIT entry of the running call without raising a cpu trap
+  // and going through the signal handler
+  static void __attribute__((noinline))
+  unwindHostExceptionOnJIT(Instance *Inst);
+#endif // ZEN_ENABLE_CPU_EXCEPTION
 
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
   void createCallStackOnJIT(uint32_t IgnoredDepth,
@@ -260,9 +325,25 @@ public:
   uint64_t getGas() const { return Gas; }
   void setGas(uint64_t NewGas) { Gas = NewGas; }
 
+  // Ask the wasm code running on this instance to stop with
+  // ErrorCode::Interrupted at its next function entry or loop iteration. Can
+  // be called from any thread, only polled with
+  // RuntimeConfig::EnableInterruption. The request stays pending until
+  // clearInterrupt, so a late deadline timer can't leak into the next call as
+  // long as the embedder clears it before calling again
+  void interrupt() { InterruptFlag.store(1, std::memory_order_relaxed); }
+  void clearInterrupt() { InterruptFlag.store(0, std::memory_order_relaxed); }
+  bool isInterruptRequested() const {
+    return InterruptFlag.load(std::memory_order_relaxed) != 0;
+  }
+
   void *getCustomData() { return CustomData; }
   void setCustomData(void *NewCustomData) { CustomData = NewCustomData; }
 
+  // storage hostapis read and write through the journal, not owned
+  StateJournal *getStateJournal() const { return Journal; }
+  void setStateJournal(StateJournal *NewJournal) { Journal = NewJournal; }
+
   // wasm instance enabled by default
   // but after call some child instance, the parent maybe not active
   // need enable it again
@@ -321,7 +402,6 @@ private:
 
 #ifdef ZEN_ENABLE_JIT
   uintptr_t *JITFuncPtrs = nullptr;
-  uint32_t *FuncTypeIdxs = nullptr;
   uint64_t JITStackSize = 0;
   uint8_t *JITStackBoundary = nullptr;
 #endif
@@ -330,6 +410,9 @@ private:
 
   uint64_t Gas = 0;
 
+  // set by interrupt(), read directly by the JIT code
+  std::atomic<uint32_t> InterruptFlag{0};
+
   // exit code set by Instance.exit(ExitCode)
   int32_t InstanceExitCode = 0;
 
@@ -353,11 +436,16 @@ private:
 
   void *CustomData = nullptr;
 
+  StateJournal *Journal = nullptr;
+
   WasmMemoryDataType MemDataKind =
       WasmMemoryDataType::WM_MEMORY_DATA_TYPE_MALLOC;
 
   bool DataSegsInited = false;
 
+  // Active segments are dropped once instantiated
+  std::vector<bool> DroppedDataSegs;
+
 #ifdef ZEN_ENABLE_VIRTUAL_STACK
   // one instance maybe called by hostapi( instanceA -> hostapi -> instanceA )
   std::queue<utils::VirtualStackInfo *> VirtualStacks;
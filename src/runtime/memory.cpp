@@ -3,6 +3,7 @@
 
 #include "runtime/memory.h"
 #include "common/enums.h"
+#include "platform/map.h"
 #include "runtime/module.h"
 #include "utils/logging.h"
 #include "utils/others.h"
@@ -36,6 +37,9 @@ static bool verifyCanUseMmapBucketByModuleDataSegments(Module *Mod) {
   }
   for (size_t I = 0; I < Mod->getNumDataSegments(); I++) {
     auto *Seg = Mod->getDataEntry(I);
+    if (Seg->Passive) {
+      continue;
+    }
     if (Seg->MemIdx != 0) {
       return false;
     }
@@ -67,6 +71,8 @@ WasmMemoryAllocator::WasmMemoryAllocator(
 #ifdef ZEN_ENABLE_CPU_EXCEPTION
     UseMmap = true;
 #endif // ZEN_ENABLE_CPU_EXCEPTION
+    UseHugePages = Options->UseHugePages;
+    UseNumaLocalMemory = Options->UseNumaLocalMemory;
     bool UseMmapBucket = UseMmap;
     // if wasm module data segments has init-expr which not use i32/i64,
     // then not use mmap
@@ -132,7 +138,7 @@ WasmMemoryAllocator::WasmMemoryAllocator(
 
         for (size_t I = 0; I < Mod->getNumDataSegments(); I++) {
           auto *Seg = Mod->getDataEntry(I);
-          if (Seg->MemIdx != 0) {
+          if (Seg->Passive || Seg->MemIdx != 0) {
             continue;
           }
           int64_t BaseOffset = 0;
@@ -231,6 +237,7 @@ WasmMemoryBucketSlice WasmMemoryAllocator::getOrCreateMmapSpace(
       if (!BucketMemAddr || (BucketMemAddr == (uint8_t *)-1)) {
         ZEN_ABORT();
       }
+      applyMmapMemoryPolicy(BucketMemAddr, MmapSize);
       MmapAddresses->insert(BucketMemAddr);
       auto *BucketFreeCount = (size_t *)::malloc(sizeof(size_t));
       if (!BucketFreeCount) {
@@ -289,6 +296,17 @@ WasmMemoryBucketSlice WasmMemoryAllocator::getOrCreateMmapSpace(
   }
 }
 
+// the policies only take effect on pages faulted in later, so apply them to
+// the whole reservation right after mmap
+void WasmMemoryAllocator::applyMmapMemoryPolicy(uint8_t *Addr, size_t Size) {
+  if (UseHugePages) {
+    platform::adviseHugePages(Addr, Size);
+  }
+  if (UseNumaLocalMemory) {
+    platform::bindLocalNumaNode(Addr, Size);
+  }
+}
+
 void WasmMemoryAllocator::mprotectReadWriteWasmMemoryData(
     const WasmMemoryData &Data, bool UnprotectBucket) {
   if (Data.Type != WasmMemoryDataType::WM_MEMORY_DATA_TYPE_BUCKET_MMAP &&
@@ -339,6 +357,7 @@ WasmMemoryData WasmMemoryAllocator::allocateNonBucketMemory(size_t MemorySize) {
     if (!MemoryData || (MemoryData == (uint8_t *)-1)) {
       ZEN_ABORT();
     }
+    applyMmapMemoryPolicy(MemoryData, MmapSize);
 
     WasmMemoryData Result = {
         .Type = WM_MEMORY_DATA_TYPE_SINGLE_MMAP,
@@ -374,6 +393,7 @@ WasmMemoryData WasmMemoryAllocator::reallocateNonBucketMemoryAndFillZerosToNew(
     if (!NewMemoryData || (NewMemoryData == (uint8_t *)-1)) {
       ZEN_ABORT();
     }
+    applyMmapMemoryPolicy(NewMemoryData, MmapSize);
 
     WasmMemoryData Result = {
         .Type = WM_MEMORY_DATA_TYPE_SINGLE_MMAP,
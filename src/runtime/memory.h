@@ -37,6 +37,10 @@ struct WasmMemoryData {
 struct WasmMemoryAllocatorOptions {
   bool UseMmap;
   uint32_t MemoryIndex;
+  // back mmaped linear memory with transparent huge pages
+  bool UseHugePages = false;
+  // prefer the numa node of the allocating thread for mmaped linear memory
+  bool UseNumaLocalMemory = false;
 };
 
 struct WasmMemoryBucketSlice {
@@ -119,6 +123,8 @@ private:
   WasmMemoryDataType DefaultMemoryType;
 
   bool UseMmap = false;
+  bool UseHugePages = false;
+  bool UseNumaLocalMemory = false;
   size_t MmapMemoryInitFileSize = 0;
   // the bucket contains init-size + grow-max-size(zeros)
   // when grow to not larger then it, just inc the size.
@@ -151,6 +157,8 @@ private:
 
   void internalFreeWasmMemory(const WasmMemoryData &Data);
 
+  void applyMmapMemoryPolicy(uint8_t *Addr, size_t Size);
+
   WasmMemoryBucketSlice getOrCreateMmapSpace(
       const uint8_t
           *BucketAllocSand, // sand to alloc bucket. eg. MemoryInstance*
@@ -4,6 +4,7 @@
 #include "runtime/module.h"
 
 #include "action/compiler.h"
+#include "action/function_loader.h"
 #include "action/module_loader.h"
 #include "common/enums.h"
 #include "common/errors.h"
@@ -138,6 +139,12 @@ Module::Module(Runtime *RT) : BaseModule(RT, ModuleType::WASM), Layout(*this) {
   MemAllocOptions.UseMmap = !RT->getConfig().DisableWasmMemoryMap;
 #endif // ZEN_ENABLE_CPU_EXCEPTION
   MemAllocOptions.MemoryIndex = 0;
+  MemAllocOptions.UseHugePages = RT->getConfig().EnableHugePages;
+  MemAllocOptions.UseNumaLocalMemory = RT->getConfig().EnableNumaLocalMemory;
+#if defined(ZEN_ENABLE_JIT) && !defined(ZEN_ENABLE_SGX)
+  JITCodeMemPool.applyMemoryPolicy(RT->getConfig().EnableHugePages,
+                                   RT->getConfig().EnableNumaLocalMemory);
+#endif
   ThreadLocalMemAllocatorMap =
       new utils::ThreadSafeMap<int64_t, WasmMemoryAllocator *>();
 }
@@ -167,6 +174,9 @@ Module::~Module() {
   destroyElemTable();
   deallocate(DataTable);
   destroyCodeTable();
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  deallocate(BlockCounters);
+#endif
 }
 
 void Module::releaseMemoryAllocatorCache() {
@@ -177,8 +187,9 @@ void Module::releaseMemoryAllocatorCache() {
   }
 }
 
-ModuleUniquePtr Module::newModule(Runtime &RT, CodeHolderUniquePtr CodeHolder,
-                                  const std::string &EntryHint) {
+ModuleUniquePtr Module::newUnloadedModule(Runtime &RT,
+                                          CodeHolderUniquePtr CodeHolder,
+                                          const std::string &EntryHint) {
   void *ObjBuf = RT.allocate(sizeof(Module));
   ZEN_ASSERT(ObjBuf);
 
@@ -189,9 +200,25 @@ ModuleUniquePtr Module::newModule(Runtime &RT, CodeHolderUniquePtr CodeHolder,
   Mod->EntryHint = EntryHint;
 #endif
 
-  action::ModuleLoader Loader(*Mod,
-                              static_cast<const Byte *>(CodeHolder->getData()),
-                              CodeHolder->getSize());
+  Mod->CodeHolder = std::move(CodeHolder);
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  // one counter per byte code byte, only block leaders are used
+  Mod->BlockCounters = static_cast<uint64_t *>(
+      Mod->allocateZeros(sizeof(uint64_t) * Mod->CodeHolder->getSize()));
+#endif
+
+  return Mod;
+}
+
+ModuleUniquePtr Module::newModule(Runtime &RT, CodeHolderUniquePtr CodeHolder,
+                                  const std::string &EntryHint) {
+  ModuleUniquePtr Mod =
+      newUnloadedModule(RT, std::move(CodeHolder), EntryHint);
+
+  action::ModuleLoader Loader(
+      *Mod, static_cast<const Byte *>(Mod->CodeHolder->getData()),
+      Mod->CodeHolder->getSize());
 
   auto &Stats = RT.getStatistics();
   auto Timer = Stats.startRecord(utils::StatisticPhase::Load);
@@ -202,8 +229,6 @@ ModuleUniquePtr Module::newModule(Runtime &RT, CodeHolderUniquePtr CodeHolder,
 
   Mod->Layout.compute();
 
-  Mod->CodeHolder = std::move(CodeHolder);
-
   if (Mod->NumInternalFunctions > 0) {
     action::performJITCompile(*Mod);
   }
@@ -251,6 +276,36 @@ CodeEntry *Module::getCodeEntry(uint32_t FuncIdx) const {
   return CodeTable + InternalFuncIdx;
 }
 
+const CodeEntry &Module::validateFunction(uint32_t FuncIdx) const {
+  CodeEntry *Entry = getCodeEntry(FuncIdx);
+  ZEN_ASSERT(Entry);
+  std::scoped_lock Lock(LazyValidationMutex);
+  // Validated functions have at least the function block
+  if (Entry->MaxBlockDepth > 0) {
+    return *Entry;
+  }
+  if (auto It = LazyValidationErrors.find(FuncIdx);
+      It != LazyValidationErrors.end()) {
+    throw It->second;
+  }
+
+  // Validation only fills the code entry of the function and, in interpreter
+  // mode, rewrites some of its opcodes
+  Module &Mod = const_cast<Module &>(*this);
+  const Byte *CodeStart = reinterpret_cast<const Byte *>(Entry->CodePtr);
+  common::ArenaMemPool Arena;
+  action::FunctionLoader Loader(Mod, CodeStart, CodeStart + Entry->CodeSize,
+                                FuncIdx, *getFunctionType(FuncIdx), *Entry,
+                                Arena);
+  try {
+    Loader.load();
+  } catch (const Error &Err) {
+    LazyValidationErrors.emplace(FuncIdx, Err);
+    throw;
+  }
+  return *Entry;
+}
+
 bool Module::getExportFunc(WASMSymbol Name, uint32_t &FuncIdx) const noexcept {
   // perhaps use a hashmap instead if there are too much export functions.
   for (uint32_t I = 0; I < NumExports; ++I) {
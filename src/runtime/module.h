@@ -10,6 +10,8 @@
 #include "runtime/object.h"
 #include "utils/safe_map.h"
 
+#include <mutex>
+
 #ifdef ZEN_ENABLE_MULTIPASS_JIT
 namespace COMPILER {
 class LazyJITCompiler;
@@ -265,6 +267,8 @@ struct DataEntry {
   uint32_t Size;
   uint32_t Offset;
   uint8_t InitExprKind;
+  // only used by memory.init, no MemIdx and InitExprVal
+  bool Passive;
   InitExpr InitExprVal;
 };
 
@@ -303,9 +307,6 @@ class Module final : public BaseModule<Module> {
     size_t FuncPtrsBaseOffset = 0;
     size_t FuncPtrsSize = 0;
 
-    size_t FuncTypeIndexesBaseOffset = 0;
-    size_t FuncTypeIndexesSize = 0;
-
     size_t StackBoundaryOffset = 0;
 #ifdef ZEN_ENABLE_DUMP_CALL_STACK
     size_t TracesSize = 0;
@@ -319,6 +320,7 @@ class Module final : public BaseModule<Module> {
 #endif
 
     uint64_t GasOffset = 0;
+    size_t InterruptFlagOffset = 0;
     size_t TotalSize = 0;
 
     void compute();
@@ -332,6 +334,7 @@ class Module final : public BaseModule<Module> {
   friend class action::FunctionLoader;
   friend class Instance;
   friend class action::Instantiator;
+  friend class ModuleStream;
 
 public:
   enum StatsFlags : uint32_t {
@@ -339,6 +342,7 @@ public:
     SF_global = 1 << 0, // Access global variables
     SF_memory = 1 << 1, // Access linear memory
     SF_table = 1 << 2,  // Access table
+    SF_gas = 1 << 3,    // Call the gas function
   };
 
   static ModuleUniquePtr newModule(Runtime &RT, CodeHolderUniquePtr CodeHolder,
@@ -380,6 +384,12 @@ public:
 
   uint32_t getNumDataSegments() const { return NumDataSegments; }
 
+  bool hasDataCount() const { return DataCount != -1u; }
+
+  uint32_t getDataCount() const { return DataCount; }
+
+  uint32_t getNumElementSegments() const { return NumElementSegments; }
+
   // ==================== Validating Methods ====================
 
   bool isValidType(uint32_t TypeIdx) const { return TypeIdx < NumTypes; }
@@ -456,11 +466,22 @@ public:
 
   CodeEntry *getCodeEntry(uint32_t FuncIdx) const;
 
+  /// Validate the body of an internal function loaded with
+  /// RuntimeConfig::EnableLazyValidation, on its first call. Thread-safe and a
+  /// no-op once validated, an invalid function throws the same error on every
+  /// call.
+  const CodeEntry &validateFunction(uint32_t FuncIdx) const;
+
   DataEntry *getDataEntry(uint32_t DataSegIdx) const {
     ZEN_ASSERT(DataSegIdx < NumDataSegments);
     return DataTable + DataSegIdx;
   }
 
+  const ElemEntry &getElemEntry(uint32_t ElemSegIdx) const {
+    ZEN_ASSERT(ElemSegIdx < NumElementSegments);
+    return ElementTable[ElemSegIdx];
+  }
+
   // ==================== Layout Methods ====================
 
   const InstanceLayout &getLayout() const { return Layout; }
@@ -469,6 +490,12 @@ public:
 
   uint32_t getGasFuncIdx() const { return GasFuncIdx; }
 
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  // execution counts of the basic blocks indexed by the byte code offset of
+  // their first instruction, see runtime/block_profile.h
+  uint64_t *getBlockCounters() const { return BlockCounters; }
+#endif
+
   WasmMemoryAllocator *getMemoryAllocator();
 
   bool checkUseSoftLinearMemoryCheck() const {
@@ -543,6 +570,11 @@ private:
 
   virtual ~Module();
 
+  // Create the module of a code holder before loading it, see ModuleStream
+  static ModuleUniquePtr newUnloadedModule(Runtime &RT,
+                                           CodeHolderUniquePtr CodeHolder,
+                                           const std::string &EntryHint);
+
   // ==================== Init Table Methods ====================
 
   template <typename EntryType>
@@ -678,10 +710,20 @@ private:
   uint32_t GlobalVarSize = 0;
   InstanceLayout Layout;
 
+  // ==================== Lazy Validation Members ====================
+
+  mutable std::mutex LazyValidationMutex;
+  // Errors of the functions failed lazy validation, thrown again on later calls
+  mutable std::unordered_map<uint32_t, common::Error> LazyValidationErrors;
+
   // ==================== Platform Feature Members ====================
 
   uint32_t GasFuncIdx = -1u;
 
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  uint64_t *BlockCounters = nullptr;
+#endif
+
   WasmMemoryAllocatorOptions MemAllocOptions;
 
   // thread_id => WasmMemoryAllocator*
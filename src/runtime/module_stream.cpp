@@ -0,0 +1,148 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "runtime/module_stream.h"
+
+#include "action/compiler.h"
+#include "action/module_loader.h"
+#include "runtime/codeholder.h"
+#include "runtime/module.h"
+#include "runtime/runtime.h"
+#include "utils/statistics.h"
+
+#include <cstring>
+
+namespace zen::runtime {
+
+using namespace common;
+
+std::unique_ptr<ModuleStream>
+ModuleStream::newModuleStream(Runtime &RT, const std::string &ModName,
+                              size_t Size) {
+  std::unique_ptr<ModuleStream> Stream(new ModuleStream(RT, Size));
+  try {
+    Stream->start(ModName);
+  } catch (const Error &NewErr) {
+    Stream->fail(NewErr);
+  }
+  return Stream;
+}
+
+ModuleStream::ModuleStream(Runtime &RT, size_t Size) : RT(RT), Size(Size) {}
+
+ModuleStream::~ModuleStream() {
+  // The name belongs to the module once registered
+  if (!Finished && Name != WASM_SYMBOL_NULL) {
+    RT.freeSymbol(Name);
+  }
+}
+
+void ModuleStream::start(const std::string &ModName) {
+  if (ModName.empty() || !Size) {
+    throw common::getError(ErrorCode::InvalidRawData);
+  }
+
+  Name = RT.newSymbol(ModName.c_str(), ModName.size());
+  if (RT.ModulePool.find(Name) != RT.ModulePool.end()) {
+    throw common::getError(ErrorCode::InvalidModuleName);
+  }
+
+  void *CodeBuffer;
+  CodeHolderUniquePtr Code =
+      CodeHolder::newRawBufferCodeHolder(RT, Size, CodeBuffer);
+  Buffer = static_cast<uint8_t *>(CodeBuffer);
+
+  Mod = Module::newUnloadedModule(RT, std::move(Code), "");
+  Loader = std::make_unique<action::ModuleLoader>(
+      *Mod, reinterpret_cast<const Byte *>(Buffer), Size);
+  Loader->setFunctionLoadedCallback(
+      [this](uint32_t FuncIdx) { onFunctionLoaded(FuncIdx); });
+  Compiler = std::make_unique<action::StreamingJITCompiler>(*Mod);
+}
+
+bool ModuleStream::feed(const void *Data, size_t DataSize) noexcept {
+  if (!Err.isEmpty()) {
+    return false;
+  }
+  ZEN_ASSERT(!Finished);
+
+  if (DataSize > Size - NumReceivedBytes) {
+    fail(common::getError(ErrorCode::ModuleSizeTooLarge));
+    return false;
+  }
+  if (DataSize > 0) {
+    std::memcpy(Buffer + NumReceivedBytes, Data, DataSize);
+    NumReceivedBytes += DataSize;
+  }
+
+  auto &Stats = RT.getStatistics();
+  try {
+    auto Timer = Stats.startRecord(utils::StatisticPhase::Load);
+    Loader->loadAvailable(NumReceivedBytes);
+    Stats.stopRecord(Timer);
+  } catch (const Error &NewErr) {
+    fail(NewErr);
+    return false;
+  }
+  return true;
+}
+
+MayBe<Module *> ModuleStream::finish() noexcept {
+  if (!Err.isEmpty()) {
+    return Err;
+  }
+  ZEN_ASSERT(!Finished);
+
+  if (NumReceivedBytes != Size) {
+    fail(common::getError(ErrorCode::UnexpectedEnd));
+    return Err;
+  }
+
+  auto &Stats = RT.getStatistics();
+  try {
+    auto Timer = Stats.startRecord(utils::StatisticPhase::Load);
+    Loader->finishLoad();
+    Stats.stopRecord(Timer);
+
+    if (!LayoutComputed) {
+      Mod->Layout.compute();
+      LayoutComputed = true;
+    }
+    Compiler->finish();
+
+    Mod->getMemoryAllocator();
+
+    // The same name may have been loaded meanwhile
+    if (RT.ModulePool.find(Name) != RT.ModulePool.end()) {
+      throw common::getError(ErrorCode::InvalidModuleName);
+    }
+  } catch (const Error &NewErr) {
+    fail(NewErr);
+    return Err;
+  }
+
+  Compiler.reset();
+  Loader.reset();
+  Finished = true;
+  return RT.addModule(Name, std::move(Mod));
+}
+
+void ModuleStream::onFunctionLoaded(uint32_t FuncIdx) {
+  // The layout only depends on the sections before the code section
+  if (!LayoutComputed) {
+    Mod->Layout.compute();
+    LayoutComputed = true;
+  }
+  Compiler->compileFunction(FuncIdx);
+}
+
+void ModuleStream::fail(const Error &NewErr) {
+  RT.getStatistics().clearAllTimers();
+  Err = NewErr;
+  // Stop the background compilation before releasing the module
+  Compiler.reset();
+  Loader.reset();
+  Mod.reset();
+}
+
+} // namespace zen::runtime
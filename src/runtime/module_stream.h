@@ -0,0 +1,86 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_MODULE_STREAM_H
+#define ZEN_RUNTIME_MODULE_STREAM_H
+
+#include "common/const_string_pool.h"
+#include "common/defines.h"
+#include "common/errors.h"
+#include "runtime/destroyer.h"
+
+#include <memory>
+#include <string>
+
+namespace zen {
+
+namespace action {
+class ModuleLoader;
+class StreamingJITCompiler;
+} // namespace action
+
+namespace runtime {
+
+class Module;
+class Runtime;
+
+/// Loads a module whose bytes arrive in chunks, e.g. from the network or a
+/// slow disk. The sections and function bodies are validated as soon as they
+/// are complete, and in multipass eager multithread mode every function is
+/// compiled in the JIT thread pool as soon as its body has been validated, so
+/// that most of the load and compile time is hidden behind the transfer. The
+/// other modes compile the module in finish().
+///
+/// The whole module size must be known up front since the loaded code points
+/// into the buffer receiving the chunks.
+class ModuleStream final {
+public:
+  /// \param ModName must not be loaded yet
+  static std::unique_ptr<ModuleStream>
+  newModuleStream(Runtime &RT, const std::string &ModName, size_t Size);
+
+  /// Deleting an unfinished stream abandons the module
+  ~ModuleStream();
+
+  NONCOPYABLE(ModuleStream);
+
+  /// Append the next chunk and load the sections and function bodies it
+  /// completes
+  /// \return false on error, which is kept by the stream, see getError
+  bool feed(const void *Data, size_t Size) noexcept;
+
+  /// Load the module once all its bytes have been fed, wait for its
+  /// compilation and register it in the runtime like Runtime::loadModule
+  common::MayBe<Module *> finish() noexcept;
+
+  const common::Error &getError() const { return Err; }
+
+  size_t getNumReceivedBytes() const { return NumReceivedBytes; }
+
+private:
+  ModuleStream(Runtime &RT, size_t Size);
+
+  void start(const std::string &ModName);
+
+  void onFunctionLoaded(uint32_t FuncIdx);
+
+  void fail(const common::Error &NewErr);
+
+  Runtime &RT;
+  const size_t Size;
+  size_t NumReceivedBytes = 0;
+  WASMSymbol Name = common::WASM_SYMBOL_NULL;
+  uint8_t *Buffer = nullptr;
+  bool LayoutComputed = false;
+  bool Finished = false;
+  // Destroyed in reverse order, so the compiler and the loader go first
+  ModuleUniquePtr Mod;
+  std::unique_ptr<action::ModuleLoader> Loader;
+  std::unique_ptr<action::StreamingJITCompiler> Compiler;
+  common::Error Err = common::ErrorCode::NoError;
+};
+
+} // namespace runtime
+} // namespace zen
+
+#endif // ZEN_RUNTIME_MODULE_STREAM_H
@@ -0,0 +1,336 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "runtime/profiler.h"
+#include "action/interpreter.h"
+#include "runtime/instance.h"
+#include "runtime/module.h"
+#include "runtime/runtime.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <sys/time.h>
+#include <ucontext.h>
+
+namespace zen::runtime {
+
+using action::InterpFrame;
+using action::InterpreterExecContext;
+
+static thread_local ProfiledCall *CurrentCall = nullptr;
+
+static std::atomic<SamplingProfiler *> ActiveProfiler{nullptr};
+// signal handlers which may still use the profiler being stopped
+static std::atomic<uint32_t> NumRunningHandlers{0};
+
+ProfiledCall::ProfiledCall(Instance &Inst, uint32_t FuncIdx,
+                           InterpreterExecContext *InterpCtx)
+    : Inst(&Inst), FuncIdx(FuncIdx), InterpCtx(InterpCtx),
+      StackBase(__builtin_frame_address(0)), Prev(CurrentCall) {
+  // the handler on this thread must see a fully constructed call
+  std::atomic_signal_fence(std::memory_order_seq_cst);
+  CurrentCall = this;
+}
+
+ProfiledCall::~ProfiledCall() {
+  ZEN_ASSERT(CurrentCall == this);
+  CurrentCall = Prev;
+}
+
+ProfiledCall *ProfiledCall::current() { return CurrentCall; }
+
+void ProfiledCall::setCurrent(ProfiledCall *Call) { CurrentCall = Call; }
+
+std::unique_ptr<SamplingProfiler> SamplingProfiler::start(Runtime &RT,
+                                                          uint32_t IntervalUs) {
+  if (IntervalUs == 0) {
+    return nullptr;
+  }
+  std::unique_ptr<SamplingProfiler> Profiler(new SamplingProfiler(RT));
+  SamplingProfiler *Expected = nullptr;
+  if (!ActiveProfiler.compare_exchange_strong(Expected, Profiler.get())) {
+    ZEN_LOG_ERROR("another sampling profiler is running");
+    return nullptr;
+  }
+  Profiler->Registered = true;
+
+  struct sigaction Action = {};
+  Action.sa_sigaction = &SamplingProfiler::handleSignal;
+  Action.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&Action.sa_mask);
+  if (sigaction(SIGPROF, &Action, &Profiler->PrevAction) != 0) {
+    ZEN_LOG_ERROR("failed to install the SIGPROF handler");
+    return nullptr;
+  }
+  Profiler->ActionInstalled = true;
+
+  struct itimerval Timer;
+  Timer.it_interval.tv_sec = IntervalUs / 1000000;
+  Timer.it_interval.tv_usec = IntervalUs % 1000000;
+  Timer.it_value = Timer.it_interval;
+  if (setitimer(ITIMER_PROF, &Timer, nullptr) != 0) {
+    ZEN_LOG_ERROR("failed to start the profiling timer");
+    return nullptr;
+  }
+
+  RT.setProfiler(Profiler.get());
+  Profiler->Drainer = std::thread(&SamplingProfiler::drainLoop, Profiler.get());
+  return Profiler;
+}
+
+SamplingProfiler::SamplingProfiler(Runtime &RT)
+    : RT(RT), Slots(new Sample[NumSampleSlots]) {
+  for (uint32_t I = 0; I < NumSampleSlots; ++I) {
+    Slots[I].Seq.store(I, std::memory_order_relaxed);
+  }
+}
+
+SamplingProfiler::~SamplingProfiler() {
+  if (!Registered) {
+    // the signal state belongs to another profiler
+    return;
+  }
+  if (ActionInstalled) {
+    struct itimerval Timer = {};
+    setitimer(ITIMER_PROF, &Timer, nullptr);
+    sigaction(SIGPROF, &PrevAction, nullptr);
+  }
+  ActiveProfiler.store(nullptr);
+  while (NumRunningHandlers.load() != 0) {
+    std::this_thread::yield();
+  }
+
+  {
+    std::lock_guard<std::mutex> Lock(Mtx);
+    Stopping = true;
+  }
+  StopCond.notify_all();
+  if (Drainer.joinable()) {
+    Drainer.join();
+  }
+  if (RT.getProfiler() == this) {
+    RT.setProfiler(nullptr);
+  }
+}
+
+void SamplingProfiler::handleSignal(int Signum, siginfo_t *SigInfo,
+                                    void *Context) {
+  int SavedErrno = errno;
+  NumRunningHandlers.fetch_add(1);
+  SamplingProfiler *Profiler = ActiveProfiler.load();
+  if (Profiler) {
+    Profiler->takeSample(Context);
+  }
+  NumRunningHandlers.fetch_sub(1);
+  errno = SavedErrno;
+}
+
+SamplingProfiler::Sample *SamplingProfiler::claimSlot(uint64_t &Pos) {
+  Pos = WritePos.load(std::memory_order_relaxed);
+  while (true) {
+    Sample &Slot = Slots[Pos % NumSampleSlots];
+    uint64_t Seq = Slot.Seq.load(std::memory_order_acquire);
+    if (Seq == Pos) {
+      if (WritePos.compare_exchange_weak(Pos, Pos + 1,
+                                         std::memory_order_relaxed)) {
+        return &Slot;
+      }
+    } else if (Seq < Pos) {
+      // not drained yet
+      return nullptr;
+    } else {
+      Pos = WritePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+// Runs in the signal handler, must be async-signal-safe
+void SamplingProfiler::takeSample(void *Context) {
+  ProfiledCall *Call = ProfiledCall::current();
+  if (!Call || Call->Inst->getRuntime() != &RT) {
+    return;
+  }
+  uint64_t Pos;
+  Sample *Slot = claimSlot(Pos);
+  if (!Slot) {
+    NumDroppedSamples.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  Instance *Inst = Call->Inst;
+  uint32_t Depth = 0;
+  bool Truncated = false;
+  auto PushFrame = [&](uint32_t FuncIdx) {
+    if (Depth == MaxSampleDepth) {
+      Truncated = true;
+      return false;
+    }
+    Slot->Frames[Depth++] = FuncIdx;
+    return true;
+  };
+
+  if (Call->InterpCtx) {
+    FunctionInstance *Funcs = Inst->getFunctionInst(0);
+    InterpFrame *Frame = Call->InterpCtx->getCurFrame();
+    while (Frame && PushFrame(uint32_t(Frame->FuncInst - Funcs))) {
+      Frame = Frame->PrevFrame;
+    }
+  }
+#if defined(ZEN_ENABLE_JIT) && defined(ZEN_ENABLE_DUMP_CALL_STACK)
+  else {
+    auto *UCtx = static_cast<ucontext_t *>(Context);
+#ifdef ZEN_BUILD_TARGET_X86_64
+#ifdef ZEN_BUILD_PLATFORM_DARWIN
+    auto *FrameAddr = (uintptr_t *)((UCtx->uc_mcontext)->__ss.__rbp);
+    auto *SP = (uintptr_t *)((UCtx->uc_mcontext)->__ss.__rsp);
+    void *PC = (void *)((UCtx->uc_mcontext)->__ss.__rip);
+#else
+    auto *FrameAddr = (uintptr_t *)((UCtx->uc_mcontext).gregs[REG_RBP]);
+    auto *SP = (uintptr_t *)((UCtx->uc_mcontext).gregs[REG_RSP]);
+    void *PC = (void *)((UCtx->uc_mcontext).gregs[REG_RIP]);
+#endif // ZEN_BUILD_PLATFORM_DARWIN
+#else
+#ifdef ZEN_BUILD_PLATFORM_DARWIN
+    auto *FrameAddr = (uintptr_t *)((UCtx->uc_mcontext)->__ss.__fp);
+    auto *SP = (uintptr_t *)((UCtx->uc_mcontext)->__ss.__sp);
+    void *PC = (void *)((UCtx->uc_mcontext)->__ss.__pc);
+#else
+    auto *FrameAddr = (uintptr_t *)((UCtx->uc_mcontext).regs[29]);
+    auto *SP = (uintptr_t *)((UCtx->uc_mcontext).sp);
+    void *PC = (void *)((UCtx->uc_mcontext).pc);
+#endif // ZEN_BUILD_PLATFORM_DARWIN
+#endif // ZEN_BUILD_TARGET_X86_64
+
+    const Module *Mod = Inst->getModule();
+    auto *JITCode = static_cast<uint8_t *>(Mod->getJITCode());
+    uint8_t *JITCodeEnd = JITCode + Mod->getJITCodeSize();
+    auto InJITCode = [JITCode, JITCodeEnd](void *Addr) {
+      return Addr >= JITCode && Addr < JITCodeEnd;
+    };
+
+    bool InHostCode = !InJITCode(PC);
+    if (!InHostCode) {
+      PushFrame(Inst->getFuncIndexByAddrOnJIT(PC));
+    }
+    // only frames between the interrupted one and the call entry are readable
+    auto *StackBase = static_cast<uintptr_t *>(Call->StackBase);
+    while (FrameAddr >= SP && FrameAddr < StackBase &&
+           (uintptr_t(FrameAddr) & (sizeof(uintptr_t) - 1)) == 0) {
+      void *RetAddr = reinterpret_cast<void *>(FrameAddr[1]);
+      if (InJITCode(RetAddr)) {
+        if (Depth == 0 && InHostCode) {
+          PushFrame(HostFrame);
+        }
+        if (!PushFrame(Inst->getFuncIndexByAddrOnJIT(RetAddr))) {
+          break;
+        }
+      }
+      auto *NextFrameAddr = reinterpret_cast<uintptr_t *>(FrameAddr[0]);
+      if (NextFrameAddr <= FrameAddr) {
+        break;
+      }
+      FrameAddr = NextFrameAddr;
+    }
+  }
+#endif // ZEN_ENABLE_JIT && ZEN_ENABLE_DUMP_CALL_STACK
+
+  // no frame known, at least the entry function is running
+  if (Depth == 0) {
+    PushFrame(Call->FuncIdx);
+  }
+  Slot->Mod = Inst->getModule();
+  Slot->Depth = Depth;
+  Slot->Truncated = Truncated;
+  Slot->Seq.store(Pos + 1, std::memory_order_release);
+}
+
+// flamegraph.pl splits frames by ';' and the count by the last space
+static void appendFrameName(std::string &Stack, const char *Name) {
+  if (!Name) {
+    Stack += "[unnamed]";
+    return;
+  }
+  for (const char *C = Name; *C; ++C) {
+    Stack += (*C == ';' || *C == ' ' || *C == '\n') ? '_' : *C;
+  }
+}
+
+std::string SamplingProfiler::getFuncName(const Module &Mod,
+                                          uint32_t FuncIdx) const {
+  using common::WASM_SYMBOL_NULL;
+  if (FuncIdx == HostFrame) {
+    return "[host]";
+  }
+  if (FuncIdx >= Mod.getNumTotalFunctions()) {
+    return "[unknown]";
+  }
+  std::string Name;
+  uint32_t NumImportFunctions = Mod.getNumImportFunctions();
+  if (FuncIdx < NumImportFunctions) {
+    const auto &ImportFunc = Mod.getImportFunction(FuncIdx);
+    appendFrameName(Name, RT.dumpSymbolString(ImportFunc.ModuleName));
+    Name += '.';
+    appendFrameName(Name, RT.dumpSymbolString(ImportFunc.FieldName));
+    return Name;
+  }
+  WASMSymbol FuncName =
+      Mod.getInternalFunction(FuncIdx - NumImportFunctions).Name;
+  if (FuncName != WASM_SYMBOL_NULL) {
+    appendFrameName(Name, RT.dumpSymbolString(FuncName));
+    return Name;
+  }
+  return "$f" + std::to_string(FuncIdx);
+}
+
+void SamplingProfiler::drain() {
+  std::lock_guard<std::mutex> Lock(Mtx);
+  while (true) {
+    Sample &Slot = Slots[ReadPos % NumSampleSlots];
+    if (Slot.Seq.load(std::memory_order_acquire) != ReadPos + 1) {
+      break;
+    }
+    std::string Stack;
+    WASMSymbol ModName = Slot.Mod->getName();
+    if (ModName != common::WASM_SYMBOL_NULL) {
+      appendFrameName(Stack, RT.dumpSymbolString(ModName));
+    } else {
+      Stack = "[module]";
+    }
+    if (Slot.Truncated) {
+      Stack += ";[truncated]";
+    }
+    for (uint32_t I = Slot.Depth; I-- > 0;) {
+      Stack += ';';
+      Stack += getFuncName(*Slot.Mod, Slot.Frames[I]);
+    }
+    FoldedStacks[Stack]++;
+    NumSamples.fetch_add(1, std::memory_order_relaxed);
+    Slot.Seq.store(ReadPos + NumSampleSlots, std::memory_order_release);
+    ++ReadPos;
+  }
+}
+
+void SamplingProfiler::drainLoop() {
+  // the buffer holds 4s of samples at a 1ms interval
+  constexpr auto DrainInterval = std::chrono::milliseconds(100);
+  std::unique_lock<std::mutex> Lock(Mtx);
+  while (!StopCond.wait_for(Lock, DrainInterval, [this] { return Stopping; })) {
+    Lock.unlock();
+    drain();
+    Lock.lock();
+  }
+}
+
+bool SamplingProfiler::writeFoldedStacks(FILE *Out) {
+  drain();
+  std::lock_guard<std::mutex> Lock(Mtx);
+  for (const auto &[Stack, Count] : FoldedStacks) {
+    if (std::fprintf(Out, "%s %" PRIu64 "\n", Stack.c_str(), Count) < 0) {
+      return false;
+    }
+  }
+  return std::fflush(Out) == 0;
+}
+
+} // namespace zen::runtime
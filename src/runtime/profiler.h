@@ -0,0 +1,142 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_PROFILER_H
+#define ZEN_RUNTIME_PROFILER_H
+
+#include "common/defines.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace zen {
+
+namespace action {
+class InterpreterExecContext;
+} // namespace action
+
+namespace runtime {
+
+class Instance;
+class Module;
+class Runtime;
+
+/// The wasm call executing on the current thread, registered for the whole
+/// call so that the SIGPROF handler of SamplingProfiler can attribute the
+/// sample. Calls nest when host functions call back into wasm.
+class ProfiledCall {
+public:
+  ProfiledCall(Instance &Inst, uint32_t FuncIdx,
+               action::InterpreterExecContext *InterpCtx = nullptr);
+
+  ~ProfiledCall();
+
+  NONCOPYABLE(ProfiledCall);
+
+  static ProfiledCall *current();
+
+  // used to move the calls of a suspended resumable call between threads
+  static void setCurrent(ProfiledCall *Call);
+
+  ProfiledCall *getPrev() const { return Prev; }
+
+  void setPrev(ProfiledCall *NewPrev) { Prev = NewPrev; }
+
+private:
+  friend class SamplingProfiler;
+
+  Instance *Inst;
+  uint32_t FuncIdx;
+  // nullptr in JIT mode
+  action::InterpreterExecContext *InterpCtx;
+  // upper bound of the JIT frames of the call
+  void *StackBase;
+  ProfiledCall *Prev;
+};
+
+/// Samples the wasm call stacks of the threads running code of one runtime
+/// every IntervalUs of process cpu time(ITIMER_PROF), and folds them into
+/// `module;caller;callee count` lines accepted by flamegraph.pl. Interpreter
+/// stacks are complete, JIT stacks are walked through frame pointers with
+/// ZEN_ENABLE_DUMP_CALL_STACK and only show the entry function otherwise.
+/// Only one profiler may run per process since SIGPROF is process-wide, and it
+/// must be deleted before its runtime.
+class SamplingProfiler {
+public:
+  static constexpr uint32_t MaxSampleDepth = 32;
+  // frame of a sample taken outside JIT code while running a host function
+  static constexpr uint32_t HostFrame = -2u;
+
+  static std::unique_ptr<SamplingProfiler> start(Runtime &RT,
+                                                 uint32_t IntervalUs);
+
+  ~SamplingProfiler();
+
+  NONCOPYABLE(SamplingProfiler);
+
+  /// Fold the pending samples, must be called before a profiled module is
+  /// deleted(done by Runtime::unloadModule)
+  void drain();
+
+  bool writeFoldedStacks(FILE *Out);
+
+  uint64_t getNumSamples() const { return NumSamples; }
+
+  // samples lost because the buffer was full
+  uint64_t getNumDroppedSamples() const { return NumDroppedSamples; }
+
+private:
+  struct Sample {
+    std::atomic<uint64_t> Seq;
+    const Module *Mod;
+    uint32_t Depth;
+    bool Truncated;
+    // innermost first
+    uint32_t Frames[MaxSampleDepth];
+  };
+
+  static constexpr uint32_t NumSampleSlots = 4096;
+
+  SamplingProfiler(Runtime &RT);
+
+  static void handleSignal(int Signum, siginfo_t *SigInfo, void *Context);
+
+  void takeSample(void *Context);
+
+  Sample *claimSlot(uint64_t &Pos);
+
+  std::string getFuncName(const Module &Mod, uint32_t FuncIdx) const;
+
+  void drainLoop();
+
+  Runtime &RT;
+  // owns SIGPROF, false if another profiler was running
+  bool Registered = false;
+  bool ActionInstalled = false;
+  struct sigaction PrevAction;
+
+  std::unique_ptr<Sample[]> Slots;
+  std::atomic<uint64_t> WritePos{0};
+  // only moved by drain under Mtx
+  uint64_t ReadPos = 0;
+  std::atomic<uint64_t> NumDroppedSamples{0};
+  std::atomic<uint64_t> NumSamples{0};
+
+  std::mutex Mtx;
+  std::condition_variable StopCond;
+  bool Stopping = false;
+  std::map<std::string, uint64_t> FoldedStacks;
+  std::thread Drainer;
+};
+
+} // namespace runtime
+} // namespace zen
+
+#endif // ZEN_RUNTIME_PROFILER_H
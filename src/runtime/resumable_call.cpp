@@ -0,0 +1,169 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "runtime/resumable_call.h"
+#include "runtime/instance.h"
+#include "runtime/runtime.h"
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+#include "runtime/profiler.h"
+#endif
+
+namespace zen::runtime {
+
+using common::TypedValue;
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+using common::traphandler::CallThreadState;
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+static thread_local ResumableCall *CurrentCall = nullptr;
+
+std::unique_ptr<ResumableCall>
+ResumableCall::newResumableCall(Instance &Inst, uint32_t FuncIdx,
+                                const std::vector<TypedValue> &Args) {
+  std::unique_ptr<ResumableCall> Call(new ResumableCall(Inst, FuncIdx, Args));
+  if (!Inst.getRuntime()->prepareWasmCall(Inst, FuncIdx, Call->Args,
+                                          Call->Results)) {
+    return nullptr;
+  }
+  Call->CalleeSp = Call->StackInfo.initSwitchFrame(&ResumableCall::run,
+                                                   Call.get());
+  return Call;
+}
+
+ResumableCall::ResumableCall(Instance &Inst, uint32_t FuncIdx,
+                             const std::vector<TypedValue> &Args)
+    : Inst(&Inst), FuncIdx(FuncIdx), Args(Args),
+      StackInfo(&Inst, FuncIdx, &this->Args, &Results) {}
+
+ResumableCall::~ResumableCall() {
+  ZEN_ASSERT(CurStatus != Status::Running);
+#if defined(ZEN_ENABLE_STACK_CHECK_CPU) and defined(ZEN_ENABLE_VIRTUAL_STACK)
+  if (CurStatus == Status::Suspended) {
+    Inst->popVirtualStack();
+  }
+#endif
+}
+
+ResumableCall *ResumableCall::current() { return CurrentCall; }
+
+void ResumableCall::run(void *Arg) {
+  auto *Call = static_cast<ResumableCall *>(Arg);
+  Instance &Inst = *Call->Inst;
+#if defined(ZEN_ENABLE_STACK_CHECK_CPU) and defined(ZEN_ENABLE_VIRTUAL_STACK)
+  Inst.pushVirtualStack(&Call->StackInfo);
+#endif
+  Inst.getRuntime()->callWasmFunctionOnPhysStack(Inst, Call->FuncIdx,
+                                                 Call->Args, Call->Results);
+#if defined(ZEN_ENABLE_STACK_CHECK_CPU) and defined(ZEN_ENABLE_VIRTUAL_STACK)
+  Inst.popVirtualStack();
+#endif
+  Call->CurStatus = Status::Finished;
+  switchWasmVirtualStack(&Call->CalleeSp, Call->CallerSp);
+  ZEN_UNREACHABLE();
+}
+
+ResumableCall::Status ResumableCall::resume() {
+  ZEN_ASSERT(CurStatus == Status::NotStarted ||
+             CurStatus == Status::Suspended);
+  Runtime *RT = Inst->getRuntime();
+  utils::Statistics &Stats = RT->getStatistics();
+  auto Timer = Stats.startRecord(utils::StatisticPhase::Execution);
+
+  if (CurStatus == Status::NotStarted) {
+    Inst->protectMemoryAgain();
+  }
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  CallerTLS = CallThreadState::current();
+  if (TopTLS) {
+    attachTrapStates();
+  }
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  CallerProfiled = ProfiledCall::current();
+  if (TopProfiled) {
+    attachProfiledCalls();
+  }
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+
+  CurStatus = Status::Running;
+  PrevCall = CurrentCall;
+  CurrentCall = this;
+  switchWasmVirtualStack(&CallerSp, CalleeSp);
+  CurrentCall = PrevCall;
+
+  Stats.stopRecord(Timer);
+
+  if (CurStatus == Status::Finished && !RT->finishWasmCall(*Inst)) {
+    CurStatus = Status::Failed;
+  }
+  return CurStatus;
+}
+
+void ResumableCall::suspend() {
+  ZEN_ASSERT(CurStatus == Status::Running && CurrentCall == this);
+  CurStatus = Status::Suspended;
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  detachTrapStates();
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  detachProfiledCalls();
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+  // no thread-local access from here on, the call may be resumed on another
+  // thread
+  switchWasmVirtualStack(&CalleeSp, CallerSp);
+}
+
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+void ResumableCall::detachTrapStates() {
+  CallThreadState *Top = CallThreadState::current();
+  if (Top == CallerTLS) {
+    TopTLS = BottomTLS = nullptr;
+    return;
+  }
+  CallThreadState *Bottom = Top;
+  while (Bottom->parent() != CallerTLS) {
+    Bottom = Bottom->parent();
+    ZEN_ASSERT(Bottom);
+  }
+  TopTLS = Top;
+  BottomTLS = Bottom;
+  // give the thread back its own state, as if the call had returned
+  CallThreadState::setCurrent(CallerTLS);
+  if (CallerTLS) {
+    CallerTLS->restartHandler();
+  }
+}
+
+void ResumableCall::attachTrapStates() {
+  BottomTLS->setParent(CallerTLS);
+  if (CallerTLS) {
+    CallerTLS->stopHandler();
+  }
+  CallThreadState::setCurrent(TopTLS);
+}
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+void ResumableCall::detachProfiledCalls() {
+  ProfiledCall *Top = ProfiledCall::current();
+  if (Top == CallerProfiled) {
+    TopProfiled = BottomProfiled = nullptr;
+    return;
+  }
+  ProfiledCall *Bottom = Top;
+  while (Bottom->getPrev() != CallerProfiled) {
+    Bottom = Bottom->getPrev();
+    ZEN_ASSERT(Bottom);
+  }
+  TopProfiled = Top;
+  BottomProfiled = Bottom;
+  ProfiledCall::setCurrent(CallerProfiled);
+}
+
+void ResumableCall::attachProfiledCalls() {
+  BottomProfiled->setPrev(CallerProfiled);
+  ProfiledCall::setCurrent(TopProfiled);
+}
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+
+} // namespace zen::runtime
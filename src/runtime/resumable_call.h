@@ -0,0 +1,108 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_RESUMABLE_CALL_H
+#define ZEN_RUNTIME_RESUMABLE_CALL_H
+
+#include "common/defines.h"
+#include "common/traphandler.h"
+#include "common/type.h"
+#include "utils/virtual_stack.h"
+
+#include <memory>
+#include <vector>
+
+namespace zen::runtime {
+
+class Instance;
+class ProfiledCall;
+
+/// A wasm function call running on its own virtual stack, which the host
+/// functions it calls may suspend, e.g. to wait for an asynchronous storage
+/// read. resume() then continues the call from the suspended host function,
+/// possibly on another thread, so that many calls can be multiplexed over a
+/// few threads.
+///
+/// A call must not be resumed concurrently, and its instance must not run
+/// anything else while it is suspended. Host functions must not keep
+/// thread-local addresses across a suspension.
+class ResumableCall final {
+public:
+  enum class Status { NotStarted, Running, Suspended, Finished, Failed };
+
+  /// \return nullptr if the function or the arguments are invalid, the error
+  /// is set on the instance
+  static std::unique_ptr<ResumableCall>
+  newResumableCall(Instance &Inst, uint32_t FuncIdx,
+                   const std::vector<common::TypedValue> &Args);
+
+  /// Deleting a suspended call abandons it, the instance should not be used
+  /// anymore since its host functions never returned
+  ~ResumableCall();
+
+  NONCOPYABLE(ResumableCall);
+
+  /// Run the call until it finishes, fails(the error is set on the instance)
+  /// or is suspended again
+  Status resume();
+
+  /// Suspend the call until the next resume(), only for the host functions
+  /// called by it
+  void suspend();
+
+  /// \return the call running on the current thread, nullptr if none
+  static ResumableCall *current();
+
+  Status getStatus() const { return CurStatus; }
+
+  Instance *getInstance() const { return Inst; }
+
+  /// Valid once finished
+  const std::vector<common::TypedValue> &getResults() const { return Results; }
+
+private:
+  ResumableCall(Instance &Inst, uint32_t FuncIdx,
+                const std::vector<common::TypedValue> &Args);
+
+  static void run(void *Arg);
+
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  void detachTrapStates();
+  void attachTrapStates();
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  void detachProfiledCalls();
+  void attachProfiledCalls();
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+
+  Instance *Inst;
+  uint32_t FuncIdx;
+  std::vector<common::TypedValue> Args;
+  std::vector<common::TypedValue> Results;
+  utils::VirtualStackInfo StackInfo;
+  Status CurStatus = Status::NotStarted;
+  // the call which was running on the thread when this one was resumed
+  ResumableCall *PrevCall = nullptr;
+  void *CallerSp = nullptr;
+  void *CalleeSp = nullptr;
+
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  // the trap handler state of the thread calling resume(), and the states
+  // created inside the call which are taken off the thread while suspended
+  common::traphandler::CallThreadState *CallerTLS = nullptr;
+  common::traphandler::CallThreadState *TopTLS = nullptr;
+  common::traphandler::CallThreadState *BottomTLS = nullptr;
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  // same as the trap handler states, for the sampled wasm calls
+  ProfiledCall *CallerProfiled = nullptr;
+  ProfiledCall *TopProfiled = nullptr;
+  ProfiledCall *BottomProfiled = nullptr;
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+};
+
+} // namespace zen::runtime
+
+#endif // ZEN_RUNTIME_RESUMABLE_CALL_H
@@ -22,6 +22,9 @@
 #ifdef ZEN_ENABLE_VIRTUAL_STACK
 #include "utils/virtual_stack.h"
 #endif
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+#include "runtime/profiler.h"
+#endif
 #include <unistd.h>
 
 namespace zen::runtime {
@@ -30,6 +33,9 @@ using namespace common;
 using namespace utils;
 
 void Runtime::cleanRuntime() {
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  ZEN_ASSERT(!Profiler && "sampling profiler must be stopped first");
+#endif
 
   Isolations.clear();
 
@@ -196,6 +202,10 @@ Module *Runtime::loadModule(WASMSymbol Name, CodeHolderUniquePtr CodeHolder,
       Module::newModule(*this, std::move(CodeHolder), EntryHint);
   // All errors in Module::newModule are thrown as exceptions, so the return
   // value must be valid when the following line is executed
+  return addModule(Name, std::move(Mod));
+}
+
+Module *Runtime::addModule(WASMSymbol Name, ModuleUniquePtr Mod) {
   ZEN_ASSERT(Mod);
   auto *ModulePtr = Mod.get();
   ModulePtr->setName(Name);
@@ -211,6 +221,12 @@ Module *Runtime::loadModule(WASMSymbol Name, CodeHolderUniquePtr CodeHolder,
 }
 
 bool Runtime::unloadModule(const Module *Mod) noexcept {
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  // the pending samples still refer to the module
+  if (Profiler) {
+    Profiler->drain();
+  }
+#endif
   WASMSymbol Name = Mod->getName();
   return ModulePool.erase(Name) != 0;
 }
@@ -393,9 +409,7 @@ void Runtime::callWasmFunctionOnPhysStack(
   }
 }
 
-bool Runtime::callWasmFunction(Instance &Inst, uint32_t FuncIdx,
-                               const std::vector<TypedValue> &Args,
-                               std::vector<TypedValue> &Results) {
+static bool checkNotInHostAPI(Instance &Inst) {
 #ifdef ZEN_ENABLE_DWASM
   // dwasm disabled hostapi to call wasm function
   // hostapi prolog in dwasm will mark the WasmInstance's in hostapi flag
@@ -404,10 +418,19 @@ bool Runtime::callWasmFunction(Instance &Inst, uint32_t FuncIdx,
   if (Inst.inHostAPI()) {
     ZEN_LOG_ERROR("hostapi can't call wasm function in DWASM spec\n");
     Inst.setExecutionError(
-        common::getError(ErrorCode::DWasmInvalidHostApiCallWasm), 1);
+        common::getError(common::ErrorCode::DWasmInvalidHostApiCallWasm), 1);
     return false;
   }
 #endif
+  return true;
+}
+
+bool Runtime::prepareWasmCall(Instance &Inst, uint32_t FuncIdx,
+                              const std::vector<TypedValue> &Args,
+                              std::vector<TypedValue> &Results) {
+  if (!checkNotInHostAPI(Inst)) {
+    return false;
+  }
 
   // Check if the function arguments match the expected types
   FunctionInstance *Func = Inst.getFunctionInst(FuncIdx);
@@ -437,6 +460,34 @@ bool Runtime::callWasmFunction(Instance &Inst, uint32_t FuncIdx,
   for (uint32_t I = 0; I < NumReturns; ++I) {
     Results[I].Type = Func->ReturnTypes[I];
   }
+  return true;
+}
+
+bool Runtime::finishWasmCall(Instance &Inst) {
+  const Error &Err = Inst.getError();
+  ErrorCode ErrCode = Err.getCode();
+  if (ErrCode != ErrorCode::NoError) {
+    if (ErrCode == ErrorCode::InstanceExit) {
+      Inst.clearError();
+    } else {
+#ifdef ZEN_ENABLE_DUMP_CALL_STACK
+      if (Config.Mode == RunMode::SinglepassMode ||
+          Config.Mode == RunMode::MultipassMode) {
+        Inst.dumpCallStackOnJIT();
+      }
+#endif
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Runtime::callWasmFunction(Instance &Inst, uint32_t FuncIdx,
+                               const std::vector<TypedValue> &Args,
+                               std::vector<TypedValue> &Results) {
+  if (!prepareWasmCall(Inst, FuncIdx, Args, Results)) {
+    return false;
+  }
 
   auto Timer = Stats.startRecord(utils::StatisticPhase::Execution);
 
@@ -451,33 +502,104 @@ bool Runtime::callWasmFunction(Instance &Inst, uint32_t FuncIdx,
 
   Stats.stopRecord(Timer);
 
-  const Error &Err = Inst.getError();
-  ErrorCode ErrCode = Err.getCode();
-  if (ErrCode != ErrorCode::NoError) {
-    if (ErrCode == ErrorCode::InstanceExit) {
-      Inst.clearError();
-    } else {
-#ifdef ZEN_ENABLE_DUMP_CALL_STACK
-      if (Config.Mode == RunMode::SinglepassMode ||
-          Config.Mode == RunMode::MultipassMode) {
-        Inst.dumpCallStackOnJIT();
+  return finishWasmCall(Inst);
+}
+
+// Consecutive calls of the same instance are common, mprotect it once for them
+void Runtime::protectMemoryForCall(Instance &Inst, Instance *&LastInst) {
+  if (&Inst != LastInst) {
+    Inst.protectMemory();
+    LastInst = &Inst;
+  }
+}
+
+size_t Runtime::callWasmFunctions(WasmCall *Calls, size_t NumCalls) {
+  // validate all calls first, the failed ones are skipped by the executors
+  // below through their Err
+  for (size_t I = 0; I < NumCalls; ++I) {
+    WasmCall &Call = Calls[I];
+    ZEN_ASSERT(Call.Inst && Call.Inst->getRuntime() == this);
+    Call.Inst->clearError();
+    Call.Results.clear();
+    if (!prepareWasmCall(*Call.Inst, Call.FuncIdx, Call.Args, Call.Results)) {
+      Call.Err = Call.Inst->getError();
+      continue;
+    }
+    Call.Err = ErrorCode::NoError;
+  }
+
+  auto Timer = Stats.startRecord(utils::StatisticPhase::Execution);
+
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+  // each call needs its own virtual stack, only the validation and the timer
+  // are shared
+  Instance *LastInst = nullptr;
+  for (size_t I = 0; I < NumCalls; ++I) {
+    WasmCall &Call = Calls[I];
+    if (!Call.succeeded()) {
+      continue;
+    }
+    Call.Inst->clearError();
+    protectMemoryForCall(*Call.Inst, LastInst);
+    VirtualStackInfo StackInfo(Call.Inst, Call.FuncIdx, &Call.Args,
+                               &Call.Results);
+    StackInfo.runInVirtualStack(&callWasmFuncFromVirtualStack);
+    finishWasmCall(*Call.Inst);
+    Call.Err = Call.Inst->getError();
+  }
+#else
+  if (getConfig().Mode == RunMode::InterpMode) {
+    RuntimeObjectUniquePtr<action::InterpStack> Stack =
+        action::InterpStack::newInterpStack(*this, PresetReservedStackSize);
+    Instance *LastInst = nullptr;
+    for (size_t I = 0; I < NumCalls; ++I) {
+      WasmCall &Call = Calls[I];
+      if (!Call.succeeded()) {
+        continue;
       }
-#endif
-      return false;
+      Call.Inst->clearError();
+      protectMemoryForCall(*Call.Inst, LastInst);
+      callWasmFunctionInInterpMode(*Call.Inst, Call.FuncIdx, Call.Args,
+                                   Call.Results, Stack.get());
+      finishWasmCall(*Call.Inst);
+      Call.Err = Call.Inst->getError();
     }
+  } else {
+#ifdef ZEN_ENABLE_JIT
+    callWasmFunctionsInJITMode(Calls, NumCalls);
+#else
+    ZEN_UNREACHABLE();
+#endif
   }
+#endif // ZEN_ENABLE_VIRTUAL_STACK
 
-  return true;
+  Stats.stopRecord(Timer);
+
+  size_t NumSucceeded = 0;
+  for (size_t I = 0; I < NumCalls; ++I) {
+    NumSucceeded += Calls[I].succeeded();
+  }
+  return NumSucceeded;
 }
 
 void Runtime::callWasmFunctionInInterpMode(Instance &Inst, uint32_t FuncIdx,
                                            const std::vector<TypedValue> &Args,
-                                           std::vector<TypedValue> &Results) {
+                                           std::vector<TypedValue> &Results,
+                                           action::InterpStack *Stack) {
   using namespace action;
-  RuntimeObjectUniquePtr<InterpStack> Stack =
-      InterpStack::newInterpStack(*this, PresetReservedStackSize);
-  InterpreterExecContext Context(&Inst, Stack.get());
+  RuntimeObjectUniquePtr<InterpStack> OwnedStack;
+  if (Stack) {
+    // a trap may leave the previous call's frames on the stack
+    Stack->Top = Stack->Bottom;
+  } else {
+    OwnedStack = InterpStack::newInterpStack(*this, PresetReservedStackSize);
+    Stack = OwnedStack.get();
+  }
+  InterpreterExecContext Context(&Inst, Stack);
   uint8_t *Bottom = Stack->top();
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  ProfiledCall Profiled(Inst, FuncIdx, &Context);
+#endif
 
   for (const TypedValue &Arg : Args) {
     const UntypedValue &Val = Arg.Value;
@@ -505,11 +627,12 @@ void Runtime::callWasmFunctionInInterpMode(Instance &Inst, uint32_t FuncIdx,
 
   BaseInterpreter Interpreter(Context);
   FunctionInstance *Func = Inst.getFunctionInst(FuncIdx);
-  InterpFrame *Frame = Context.allocFrame(Func, (uint32_t *)Bottom);
-  ZEN_ASSERT(Frame != nullptr);
 
   Inst.getRuntime()->startCPUTracing();
   try {
+    // May throw the error of a lazily validated function
+    InterpFrame *Frame = Context.allocFrame(Func, (uint32_t *)Bottom);
+    ZEN_ASSERT(Frame != nullptr);
     Interpreter.interpret();
   } catch (const Error &Err) {
     Inst.getRuntime()->endCPUTracing();
@@ -548,114 +671,204 @@ void Runtime::callWasmFunctionInInterpMode(Instance &Inst, uint32_t FuncIdx,
 }
 
 #ifdef ZEN_ENABLE_JIT
-void Runtime::callWasmFunctionInJITMode(Instance &Inst, uint32_t FuncIdx,
-                                        const std::vector<TypedValue> &Args,
-                                        std::vector<TypedValue> &Results) {
+static GenericFunctionPointer getJITEntry(Instance &Inst, uint32_t FuncIdx) {
   FunctionInstance *Func = Inst.getFunctionInst(FuncIdx);
-  Inst.setJITStackSize(PresetReservedStackSize);
   bool IsImport = FuncIdx < Inst.getModule()->getNumImportFunctions();
-  auto FuncPtr =
-      GenericFunctionPointer(IsImport ? Func->CodePtr : Func->JITCodePtr);
-
-#ifdef ZEN_ENABLE_CPU_EXCEPTION
-  jmp_buf JmpBuf;
-  common::traphandler::CallThreadState TLS(&Inst, &JmpBuf,
-                                           __builtin_frame_address(0), nullptr);
-
-  // longjmp with asan(in gcc-9) not works well, it affects the asan stack
-  // malloc. so use wrapper func to recover the stack
-  auto CallWasmFnWrapper = [&]() {
-    int JmpSignum = ::setjmp(JmpBuf);
-    if (JmpSignum == 0) {
-      TLS.restartHandler();
-
-#endif // ZEN_ENABLE_CPU_EXCEPTION
-
-      entrypoint::callNativeGeneral(&Inst, FuncPtr, Args, Results,
-                                    this->getMemAllocator());
+  return GenericFunctionPointer(IsImport ? Func->CodePtr : Func->JITCodePtr);
+}
 
 #ifdef ZEN_ENABLE_CPU_EXCEPTION
-    } else { // When cpu-exception
-      // NoError means not need capture trap state
-      ErrorCode CapturedTapErrCode = ErrorCode::NoError;
-      switch (JmpSignum) {
-      case SIGFPE: {
-        // divide by zero signal
-        CapturedTapErrCode = ErrorCode::IntegerDivByZero;
-        break;
-      }
-      case SIGSEGV:
-      case SIGBUS: {
-        // out of bounds signal
-        CapturedTapErrCode = ErrorCode::OutOfBoundsMemory;
+using common::traphandler::CallThreadState;
+
+// Record the cpu exception caught by TLS as the execution error of Inst
+static void handleJITTrap(Instance &Inst, CallThreadState &TLS, int JmpSignum,
+                          common::RunMode Mode) {
+  using common::ErrorCode;
+  // NoError means not need capture trap state
+  ErrorCode CapturedTapErrCode = ErrorCode::NoError;
+  switch (JmpSignum) {
+  case SIGFPE: {
+    // divide by zero signal
+    CapturedTapErrCode = ErrorCode::IntegerDivByZero;
+    break;
+  }
+  case SIGSEGV:
+  case SIGBUS: {
+    // out of bounds signal
+    CapturedTapErrCode = ErrorCode::OutOfBoundsMemory;
 #ifdef ZEN_ENABLE_STACK_CHECK_CPU
-        // when the accessed address in virtual stack, raise CallStackExhausted
-        auto *FaultingAddress =
-            static_cast<uint8_t *>(TLS.getTrapState().FaultingAddress);
+    // when the accessed address in virtual stack, raise CallStackExhausted
+    auto *FaultingAddress =
+        static_cast<uint8_t *>(TLS.getTrapState().FaultingAddress);
 #ifdef ZEN_ENABLE_VIRTUAL_STACK
-        auto *VirtualStack = Inst.currentVirtualStack();
-        if (FaultingAddress != nullptr && VirtualStack) {
-          if (FaultingAddress >= VirtualStack->AllInfo &&
-              FaultingAddress < VirtualStack->StackMemoryTop) {
-            CapturedTapErrCode = ErrorCode::CallStackExhausted;
-          }
-        }
+    auto *VirtualStack = Inst.currentVirtualStack();
+    if (FaultingAddress != nullptr && VirtualStack) {
+      if (FaultingAddress >= VirtualStack->AllInfo &&
+          FaultingAddress < VirtualStack->StackMemoryTop) {
+        CapturedTapErrCode = ErrorCode::CallStackExhausted;
+      }
+    }
 #else
 
 #ifdef ZEN_BUILD_PLATFORM_DARWIN
-        // on darwin get stack info
-        void *StackAddr = pthread_get_stackaddr_np(pthread_self());
-        size_t StackSize = pthread_get_stacksize_np(pthread_self());
+    // on darwin get stack info
+    void *StackAddr = pthread_get_stackaddr_np(pthread_self());
+    size_t StackSize = pthread_get_stacksize_np(pthread_self());
 #else
-        // on linux get stack info
-        pthread_attr_t Attrs;
-        pthread_getattr_np(pthread_self(), &Attrs);
+    // on linux get stack info
+    pthread_attr_t Attrs;
+    pthread_getattr_np(pthread_self(), &Attrs);
 
-        void *StackAddr;
-        size_t StackSize;
-        pthread_attr_getstack(&Attrs, &StackAddr, &StackSize);
+    void *StackAddr;
+    size_t StackSize;
+    pthread_attr_getstack(&Attrs, &StackAddr, &StackSize);
 #endif
 
-        size_t GuardSize =
-            common::StackGuardSize; // stack overflow guard, when overflow not
-                                    // in dwasm, not greater then StackGuardSize
-                                    // bytes
-        if ((uintptr_t)FaultingAddress >= (uintptr_t)StackAddr - GuardSize &&
-            (uintptr_t)FaultingAddress < ((uintptr_t)StackAddr + StackSize)) {
-          CapturedTapErrCode = ErrorCode::CallStackExhausted;
-        }
+    size_t GuardSize =
+        common::StackGuardSize; // stack overflow guard, when overflow not
+                                // in dwasm, not greater then StackGuardSize
+                                // bytes
+    if ((uintptr_t)FaultingAddress >= (uintptr_t)StackAddr - GuardSize &&
+        (uintptr_t)FaultingAddress < ((uintptr_t)StackAddr + StackSize)) {
+      CapturedTapErrCode = ErrorCode::CallStackExhausted;
+    }
 #ifndef ZEN_BUILD_PLATFORM_DARWIN
-        pthread_attr_destroy(&Attrs);
+    pthread_attr_destroy(&Attrs);
 #endif // ZEN_BUILD_PLATFORM_DARWIN
 
 #endif // ZEN_ENABLE_VIRTUAL_STACK
 
 #endif // ZEN_ENABLE_STACK_CHECK_CPU
-        break;
-      }
-      default: {
-        // SIGILL not process here. the traces set by Instance::setException
-        break;
-      }
-      }
-      if (Inst.getError().getCode() == ErrorCode::GasLimitExceeded) {
-        Inst.setGas(0);
-      } else if (Config.Mode == RunMode::SinglepassMode) {
-        // restore gas left from register when trap in singlepass JIT mode
-        Inst.setGas(TLS.getGasRegisterValue());
-      }
-      if (CapturedTapErrCode != ErrorCode::NoError) {
-        const auto &TrapState = TLS.getTrapState();
-        Inst.setExecutionError(common::getError(CapturedTapErrCode),
-                               TrapState.NumIgnoredFrames, TrapState);
-      }
+    break;
+  }
+  default: {
+    // SIGILL not process here. the traces set by Instance::setException
+    break;
+  }
+  }
+  if (Inst.getError().getCode() == ErrorCode::GasLimitExceeded) {
+    Inst.setGas(0);
+  } else if (Mode == common::RunMode::SinglepassMode) {
+    // restore gas left from register when trap in singlepass JIT mode
+    Inst.setGas(TLS.getGasRegisterValue());
+  }
+  if (CapturedTapErrCode != ErrorCode::NoError) {
+    const auto &TrapState = TLS.getTrapState();
+    Inst.setExecutionError(common::getError(CapturedTapErrCode),
+                           TrapState.NumIgnoredFrames, TrapState);
+  }
+}
+
+// longjmp with asan(in gcc-9) not works well, it affects the asan stack
+// malloc. so setjmp in a dedicated frame to recover the stack
+template <typename CallFn>
+static void callJITFunctionWithTrap(Instance &Inst, CallThreadState &TLS,
+                                    jmp_buf &JmpBuf, common::RunMode Mode,
+                                    CallFn &&Call) {
+  int JmpSignum = ::setjmp(JmpBuf);
+  if (JmpSignum == 0) {
+    TLS.restartHandler();
+    Call();
+  } else { // When cpu-exception
+    handleJITTrap(Inst, TLS, JmpSignum, Mode);
+  }
+}
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+void Runtime::callWasmFunctionInJITMode(Instance &Inst, uint32_t FuncIdx,
+                                        const std::vector<TypedValue> &Args,
+                                        std::vector<TypedValue> &Results) {
+  Inst.setJITStackSize(PresetReservedStackSize);
+  GenericFunctionPointer FuncPtr = getJITEntry(Inst, FuncIdx);
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  ProfiledCall Profiled(Inst, FuncIdx);
+#endif
+
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  jmp_buf JmpBuf;
+  CallThreadState TLS(&Inst, &JmpBuf, __builtin_frame_address(0), nullptr);
+  callJITFunctionWithTrap(Inst, TLS, JmpBuf, Config.Mode, [&] {
+    entrypoint::callNativeGeneral(&Inst, FuncPtr, Args, Results,
+                                  getMemAllocator());
+  });
+#else
+  entrypoint::callNativeGeneral(&Inst, FuncPtr, Args, Results,
+                                getMemAllocator());
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+}
+
+void Runtime::callWasmFunctionsInJITMode(WasmCall *Calls, size_t NumCalls) {
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  // one trap handler state for the whole batch, only rebound to the instance
+  // of each call and re-armed by setjmp
+  jmp_buf JmpBuf;
+  CallThreadState TLS(nullptr, &JmpBuf, __builtin_frame_address(0), nullptr);
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+  Instance *LastInst = nullptr;
+  for (size_t I = 0; I < NumCalls; ++I) {
+    WasmCall &Call = Calls[I];
+    if (!Call.succeeded()) {
+      continue;
     }
-  };
-  CallWasmFnWrapper();
+    Instance &Inst = *Call.Inst;
+    Inst.clearError();
+    protectMemoryForCall(Inst, LastInst);
+    Inst.setJITStackSize(PresetReservedStackSize);
+    GenericFunctionPointer FuncPtr = getJITEntry(Inst, Call.FuncIdx);
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+    ProfiledCall Profiled(Inst, Call.FuncIdx);
+#endif
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+    TLS.setInstance(&Inst);
+    callJITFunctionWithTrap(Inst, TLS, JmpBuf, Config.Mode, [&] {
+      entrypoint::callNativeGeneral(&Inst, FuncPtr, Call.Args, Call.Results,
+                                    getMemAllocator());
+    });
+#else
+    entrypoint::callNativeGeneral(&Inst, FuncPtr, Call.Args, Call.Results,
+                                  getMemAllocator());
 #endif // ZEN_ENABLE_CPU_EXCEPTION
+    finishWasmCall(Inst);
+    Call.Err = Inst.getError();
+  }
 }
 #endif // ZEN_ENABLE_JIT
 
+bool Runtime::callWasmFunctionDirect(Instance &Inst, uint32_t FuncIdx,
+                                     uint64_t *ArgvNative,
+                                     uint32_t NumStackArgs,
+                                     TypedValue *Result) {
+#ifdef ZEN_ENABLE_JIT
+  ZEN_ASSERT(supportsDirectCall());
+  if (!checkNotInHostAPI(Inst)) {
+    return false;
+  }
+
+  auto Timer = Stats.startRecord(utils::StatisticPhase::Execution);
+
+  Inst.protectMemory();
+  Inst.setJITStackSize(PresetReservedStackSize);
+  GenericFunctionPointer FuncPtr = getJITEntry(Inst, FuncIdx);
+#ifdef ZEN_ENABLE_CPU_EXCEPTION
+  jmp_buf JmpBuf;
+  CallThreadState TLS(&Inst, &JmpBuf, __builtin_frame_address(0), nullptr);
+  callJITFunctionWithTrap(Inst, TLS, JmpBuf, Config.Mode, [&] {
+    entrypoint::callNativeArgv(&Inst, FuncPtr, ArgvNative, NumStackArgs,
+                               Result);
+  });
+#else
+  entrypoint::callNativeArgv(&Inst, FuncPtr, ArgvNative, NumStackArgs, Result);
+#endif // ZEN_ENABLE_CPU_EXCEPTION
+
+  Stats.stopRecord(Timer);
+
+  return finishWasmCall(Inst);
+#else
+  ZEN_UNREACHABLE();
+#endif // ZEN_ENABLE_JIT
+}
+
 void Runtime::startCPUTracing() {
   if (!Config.EnableGdbTracingHook) {
     return;
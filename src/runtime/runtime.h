@@ -19,6 +19,10 @@
 #include <utility>
 #include <vector>
 
+namespace zen::action {
+class InterpStack;
+} // namespace zen::action
+
 namespace zen::runtime {
 
 class HostModule;
@@ -26,6 +30,9 @@ class Module;
 class Instance;
 class Runtime;
 class Isolation;
+class ResumableCall;
+class ModuleStream;
+class SamplingProfiler;
 
 typedef struct VNMIEnvInternal_ {
   VNMIEnv _env;
@@ -37,6 +44,21 @@ typedef struct VNMIEnvInternal_ {
 #define MERGE_HOST_MODULE(RT, OriginMod, Namespace, ModName)                   \
   RT->mergeHostModule(OriginMod, Namespace::m_##ModName##_desc)
 
+/// One call of a batch executed by Runtime::callWasmFunctions. The function
+/// index must be resolved beforehand, e.g. by Module::getExportFunc, so that
+/// a batch calling the same export many times looks the name up only once.
+struct WasmCall {
+  Instance *Inst = nullptr;
+  uint32_t FuncIdx = 0;
+  std::vector<common::TypedValue> Args;
+  std::vector<common::TypedValue> Results;
+  common::Error Err = common::ErrorCode::NoError;
+
+  bool succeeded() const {
+    return Err.getCode() == common::ErrorCode::NoError;
+  }
+};
+
 // Only some of the methods of the Runtime class are thread-safe
 
 class Runtime final {
@@ -47,6 +69,9 @@ class Runtime final {
   using TypedValue = common::TypedValue;
   using RunMode = common::RunMode;
 
+  friend class ResumableCall;
+  friend class ModuleStream;
+
 public:
   Runtime(const Runtime &Other) = delete;
   Runtime &operator=(const Runtime &Other) = delete;
@@ -157,6 +182,32 @@ public:
                         const std::vector<TypedValue> &Args,
                         std::vector<TypedValue> &Results);
 
+  /// Execute the calls back to back on the current thread. The execution
+  /// timer, the interpreter stack and the trap handler state are set up once
+  /// for the whole batch instead of once per call. A failing call doesn't
+  /// stop the batch, its error is stored in WasmCall::Err(and also left on
+  /// its instance as for callWasmFunction).
+  /// \return the number of successful calls
+  size_t callWasmFunctions(WasmCall *Calls, size_t NumCalls);
+
+  /// Whether callWasmFunctionDirect is available, i.e. JIT mode without
+  /// virtual stacks
+  bool supportsDirectCall() const {
+#if defined(ZEN_ENABLE_JIT) && !defined(ZEN_ENABLE_VIRTUAL_STACK)
+    return Config.Mode != RunMode::InterpMode;
+#else
+    return false;
+#endif
+  }
+
+  /// Call a function whose signature has been checked by the caller with an
+  /// argv already laid out for entrypoint::callNativeArgv, see TypedFunction
+  /// \param Result receives the return value with its type preset, null if
+  /// the function returns nothing
+  bool callWasmFunctionDirect(Instance &Inst, uint32_t FuncIdx,
+                              uint64_t *ArgvNative, uint32_t NumStackArgs,
+                              TypedValue *Result);
+
 #ifdef ZEN_ENABLE_BUILTIN_WASI
   /// \warning not thread-safe
   void setWASIArgs(const std::string &wasm_name,
@@ -280,6 +331,13 @@ public:
 
   utils::Statistics &getStatistics() { return Stats; }
 
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  SamplingProfiler *getProfiler() const { return Profiler; }
+
+  /// \warning not thread-safe, only used by SamplingProfiler
+  void setProfiler(SamplingProfiler *NewProfiler) { Profiler = NewProfiler; }
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+
   void startCPUTracing();
 
   void endCPUTracing();
@@ -291,7 +349,8 @@ public:
   /* **************** [End] Runtime Tool Methods  **************** */
 private:
   Runtime(const RuntimeConfig &Configuration)
-      : Config(Configuration), Stats(Config.EnableStatistics) {}
+      : Config(Configuration),
+        Stats(Config.EnableStatistics, Config.EnableHardwareCounters) {}
 
   bool initRuntime() { return SymbolPool.initPool(); }
 
@@ -300,14 +359,30 @@ private:
   Module *loadModule(WASMSymbol ModName, CodeHolderUniquePtr CodeHolder,
                      const std::string &EntryHint = "");
 
+  Module *addModule(WASMSymbol ModName, ModuleUniquePtr Mod);
+
+  bool prepareWasmCall(Instance &Inst, uint32_t FuncIdx,
+                       const std::vector<TypedValue> &Args,
+                       std::vector<TypedValue> &Results);
+
+  bool finishWasmCall(Instance &Inst);
+
+  /// Protect the memory of Inst right before its call in a batch, skipped
+  /// when LastInst(the instance of the previous call) is the same
+  static void protectMemoryForCall(Instance &Inst, Instance *&LastInst);
+
+  /// \param Stack reused interpreter stack, allocate a new one if null
   void callWasmFunctionInInterpMode(Instance &Inst, uint32_t FuncIdx,
                                     const std::vector<TypedValue> &Args,
-                                    std::vector<common::TypedValue> &Results);
+                                    std::vector<common::TypedValue> &Results,
+                                    action::InterpStack *Stack = nullptr);
 
 #ifdef ZEN_ENABLE_JIT
   void callWasmFunctionInJITMode(Instance &Inst, uint32_t FuncIdx,
                                  const std::vector<TypedValue> &Args,
                                  std::vector<common::TypedValue> &Results);
+
+  void callWasmFunctionsInJITMode(WasmCall *Calls, size_t NumCalls);
 #endif
 
   common::Mutex Mtx;
@@ -347,6 +422,10 @@ private:
   RuntimeConfig Config;
 
   utils::Statistics Stats;
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  SamplingProfiler *Profiler = nullptr;
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
 };
 
 } // namespace zen::runtime
@@ -0,0 +1,245 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "runtime/state_journal.h"
+#include "common/defines.h"
+#include <algorithm>
+#include <cstring>
+
+namespace zen::runtime {
+
+StateJournal::StateJournal(StateBackend &Backend) : Backend(Backend) {
+  Index.assign(64, 0);
+}
+
+uint64_t StateJournal::hash(const uint8_t *Key, uint32_t KeyLen) {
+  // FNV-1a over 8-byte words, keys are short and mostly hashes themselves
+  uint64_t H = 0xcbf29ce484222325ULL ^ KeyLen;
+  uint32_t I = 0;
+  for (; I + 8 <= KeyLen; I += 8) {
+    uint64_t Word;
+    std::memcpy(&Word, Key + I, sizeof(Word));
+    H = (H ^ Word) * 0x100000001b3ULL;
+  }
+  for (; I < KeyLen; ++I) {
+    H = (H ^ Key[I]) * 0x100000001b3ULL;
+  }
+  H ^= H >> 32;
+  return H;
+}
+
+uint32_t StateJournal::lookup(const uint8_t *Key, uint32_t KeyLen) {
+  uint64_t H = hash(Key, KeyLen);
+  size_t Mask = Index.size() - 1;
+  for (size_t I = H & Mask; Index[I] != 0; I = (I + 1) & Mask) {
+    const Entry &E = Entries[Index[I] - 1];
+    if (E.Hash == H && E.KeyLen == KeyLen &&
+        std::memcmp(Arena.data() + E.KeyOffset, Key, KeyLen) == 0) {
+      return Index[I] - 1;
+    }
+  }
+
+  // Miss, fill the read cache from the backend
+  LoadBuffer.clear();
+  bool Exists = Backend.load(Key, KeyLen, LoadBuffer);
+  Entry E;
+  E.Hash = H;
+  E.KeyLen = KeyLen;
+  E.KeyOffset = appendBytes(Key, KeyLen);
+  E.ValueLen = Exists ? LoadBuffer.size() : 0;
+  E.ValueOffset = appendBytes(
+      reinterpret_cast<const uint8_t *>(LoadBuffer.data()), E.ValueLen);
+  E.Exists = Exists;
+  E.Dirty = false;
+  LiveBytes += KeyLen + E.ValueLen;
+  uint32_t EntryIdx = Entries.size();
+  Entries.push_back(E);
+  insertIndex(EntryIdx);
+  return EntryIdx;
+}
+
+bool StateJournal::get(const uint8_t *Key, uint32_t KeyLen,
+                       const uint8_t *&Value, uint32_t &ValueLen) {
+  const Entry &E = Entries[lookup(Key, KeyLen)];
+  if (!E.Exists) {
+    return false;
+  }
+  Value = reinterpret_cast<const uint8_t *>(Arena.data()) + E.ValueOffset;
+  ValueLen = E.ValueLen;
+  return true;
+}
+
+void StateJournal::set(const uint8_t *Key, uint32_t KeyLen,
+                       const uint8_t *Value, uint32_t ValueLen) {
+  const uint8_t *Base = reinterpret_cast<const uint8_t *>(Arena.data());
+  if (Value >= Base && Value < Base + Arena.size()) {
+    // Value is returned by get, and the lookup may move the arena
+    size_t ValueOffset = Value - Base;
+    uint32_t EntryIdx = lookup(Key, KeyLen);
+    Value = reinterpret_cast<const uint8_t *>(Arena.data()) + ValueOffset;
+    update(EntryIdx, Value, ValueLen, true);
+    return;
+  }
+  update(lookup(Key, KeyLen), Value, ValueLen, true);
+}
+
+void StateJournal::remove(const uint8_t *Key, uint32_t KeyLen) {
+  uint32_t EntryIdx = lookup(Key, KeyLen);
+  if (Entries[EntryIdx].Exists) {
+    update(EntryIdx, nullptr, 0, false);
+  }
+}
+
+void StateJournal::update(uint32_t EntryIdx, const uint8_t *Value,
+                          uint32_t ValueLen, bool Exists) {
+  Entry &E = Entries[EntryIdx];
+  Journal.push_back({EntryIdx, E.ValueOffset, E.ValueLen, E.Exists, E.Dirty});
+  if (!E.Dirty) {
+    E.Dirty = true;
+    DirtyEntries.push_back(EntryIdx);
+  }
+  // The old value is still referenced by the journal, so never overwrite it
+  // in place
+  E.ValueOffset = appendBytes(Value, ValueLen);
+  LiveBytes = LiveBytes - E.ValueLen + ValueLen;
+  E.ValueLen = ValueLen;
+  E.Exists = Exists;
+}
+
+uint32_t StateJournal::checkpoint() {
+  Checkpoints.push_back(Journal.size());
+  return Checkpoints.size() - 1;
+}
+
+void StateJournal::revert(uint32_t Id) {
+  ZEN_ASSERT(Id < Checkpoints.size());
+  revertTo(Checkpoints[Id]);
+  Checkpoints.resize(Id);
+}
+
+void StateJournal::release(uint32_t Id) {
+  ZEN_ASSERT(Id < Checkpoints.size());
+  Checkpoints.resize(Id);
+}
+
+void StateJournal::discard() {
+  revertTo(0);
+  Checkpoints.clear();
+}
+
+void StateJournal::revertTo(size_t JournalSize) {
+  ZEN_ASSERT(JournalSize <= Journal.size());
+  while (Journal.size() > JournalSize) {
+    const JournalEntry &JE = Journal.back();
+    Entry &E = Entries[JE.EntryIdx];
+    LiveBytes = LiveBytes - E.ValueLen + JE.PrevValueLen;
+    E.ValueOffset = JE.PrevValueOffset;
+    E.ValueLen = JE.PrevValueLen;
+    E.Exists = JE.PrevExists;
+    if (!JE.PrevDirty) {
+      // The first write of an entry since the last commit is also the one
+      // that added it to the dirty list, so they are undone in the same
+      // LIFO order
+      ZEN_ASSERT(DirtyEntries.back() == JE.EntryIdx);
+      DirtyEntries.pop_back();
+      E.Dirty = false;
+    }
+    Journal.pop_back();
+  }
+}
+
+void StateJournal::commit() {
+  if (!DirtyEntries.empty()) {
+    WriteBatch.clear();
+    WriteBatch.reserve(DirtyEntries.size());
+    const uint8_t *Base = reinterpret_cast<const uint8_t *>(Arena.data());
+    for (uint32_t EntryIdx : DirtyEntries) {
+      Entry &E = Entries[EntryIdx];
+      WriteBatch.push_back({Base + E.KeyOffset, E.KeyLen,
+                            E.Exists ? Base + E.ValueOffset : nullptr,
+                            E.ValueLen});
+      E.Dirty = false;
+    }
+    Backend.commit(WriteBatch.data(), WriteBatch.size());
+    DirtyEntries.clear();
+  }
+  Journal.clear();
+  Checkpoints.clear();
+  compactArena();
+}
+
+void StateJournal::clearCache() {
+  ZEN_ASSERT(Journal.empty() && DirtyEntries.empty());
+  Arena.clear();
+  Entries.clear();
+  LiveBytes = 0;
+  std::fill(Index.begin(), Index.end(), 0);
+}
+
+uint32_t StateJournal::appendBytes(const uint8_t *Data, uint32_t Size) {
+  ZEN_ASSERT(Arena.size() + Size <= UINT32_MAX);
+  uint32_t Offset = Arena.size();
+  if (Size == 0) {
+    return Offset;
+  }
+  const char *Src = reinterpret_cast<const char *>(Data);
+  if (Src >= Arena.data() && Src < Arena.data() + Arena.size()) {
+    // Data is in the arena, which the append can move
+    size_t SrcOffset = Src - Arena.data();
+    Arena.resize(Offset + Size);
+    std::memmove(&Arena[Offset], Arena.data() + SrcOffset, Size);
+  } else {
+    Arena.append(Src, Size);
+  }
+  return Offset;
+}
+
+void StateJournal::insertIndex(uint32_t EntryIdx) {
+  // keep the load factor under 1/2, entries are never erased
+  if (Entries.size() * 2 > Index.size()) {
+    growIndex();
+    return;
+  }
+  size_t Mask = Index.size() - 1;
+  size_t I = Entries[EntryIdx].Hash & Mask;
+  while (Index[I] != 0) {
+    I = (I + 1) & Mask;
+  }
+  Index[I] = EntryIdx + 1;
+}
+
+void StateJournal::growIndex() {
+  size_t Capacity = Index.size();
+  while (Entries.size() * 2 > Capacity) {
+    Capacity <<= 1;
+  }
+  Index.assign(Capacity, 0);
+  size_t Mask = Capacity - 1;
+  for (uint32_t EntryIdx = 0; EntryIdx < Entries.size(); ++EntryIdx) {
+    size_t I = Entries[EntryIdx].Hash & Mask;
+    while (Index[I] != 0) {
+      I = (I + 1) & Mask;
+    }
+    Index[I] = EntryIdx + 1;
+  }
+}
+
+void StateJournal::compactArena() {
+  ZEN_ASSERT(Journal.empty());
+  if (Arena.size() <= LiveBytes * 2) {
+    return;
+  }
+  std::string NewArena;
+  NewArena.reserve(LiveBytes);
+  for (Entry &E : Entries) {
+    uint32_t KeyOffset = NewArena.size();
+    NewArena.append(Arena, E.KeyOffset, E.KeyLen);
+    uint32_t ValueOffset = NewArena.size();
+    NewArena.append(Arena, E.ValueOffset, E.ValueLen);
+    E.KeyOffset = KeyOffset;
+    E.ValueOffset = ValueOffset;
+  }
+  Arena.swap(NewArena);
+}
+
+} // namespace zen::runtime
@@ -0,0 +1,146 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_STATE_JOURNAL_H
+#define ZEN_RUNTIME_STATE_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zen::runtime {
+
+/// A key written since the last commit, Value is null if the key was deleted
+struct StateWrite {
+  const uint8_t *Key;
+  uint32_t KeyLen;
+  const uint8_t *Value;
+  uint32_t ValueLen;
+};
+
+/// Embedder-supplied persistent storage behind the state journal
+class StateBackend {
+public:
+  virtual ~StateBackend() = default;
+
+  /// \return false if the key does not exist
+  virtual bool load(const uint8_t *Key, uint32_t KeyLen,
+                    std::string &Value) = 0;
+
+  /// Batched commit hook, called once per StateJournal::commit with all the
+  /// keys changed since the previous commit
+  virtual void commit(const StateWrite *Writes, size_t NumWrites) = 0;
+};
+
+/// Transactional key-value layer in front of a StateBackend.
+///
+/// Every key touched(read or written) gets one entry whose key and current
+/// value live in a single byte arena, entries are found through an
+/// open-addressing index, so the entries double as the read cache. Writes
+/// only record the previous value of the entry in the journal, a checkpoint
+/// is a journal position, so both revert and commit cost O(changes).
+class StateJournal {
+public:
+  explicit StateJournal(StateBackend &Backend);
+
+  StateJournal(const StateJournal &Other) = delete;
+  StateJournal &operator=(const StateJournal &Other) = delete;
+
+  /// \return false if the key does not exist, otherwise Value and ValueLen
+  /// point to the current value which stays valid until the next call
+  bool get(const uint8_t *Key, uint32_t KeyLen, const uint8_t *&Value,
+           uint32_t &ValueLen);
+
+  void set(const uint8_t *Key, uint32_t KeyLen, const uint8_t *Value,
+           uint32_t ValueLen);
+
+  void remove(const uint8_t *Key, uint32_t KeyLen);
+
+  /// Open a nested checkpoint
+  /// \return the id of the checkpoint, ids are the nesting depth
+  uint32_t checkpoint();
+
+  /// Undo all the writes since checkpoint Id, and close it together with all
+  /// the checkpoints nested in it
+  void revert(uint32_t Id);
+
+  /// Close checkpoint Id(and the nested ones), keeping its writes as part of
+  /// the enclosing checkpoint
+  void release(uint32_t Id);
+
+  /// Close all the checkpoints and flush the changed keys to the backend in
+  /// one batch. Committed values stay in the read cache.
+  void commit();
+
+  /// Undo all the writes since the last commit
+  void discard();
+
+  /// Drop the read cache, only allowed when nothing is pending
+  void clearCache();
+
+  uint32_t getNumCheckpoints() const { return Checkpoints.size(); }
+
+  size_t getNumDirtyKeys() const { return DirtyEntries.size(); }
+
+  size_t getNumCachedKeys() const { return Entries.size(); }
+
+private:
+  struct Entry {
+    uint64_t Hash;
+    uint32_t KeyOffset;
+    uint32_t KeyLen;
+    uint32_t ValueOffset;
+    uint32_t ValueLen;
+    bool Exists;
+    // written since the last commit
+    bool Dirty;
+  };
+
+  struct JournalEntry {
+    uint32_t EntryIdx;
+    uint32_t PrevValueOffset;
+    uint32_t PrevValueLen;
+    bool PrevExists;
+    bool PrevDirty;
+  };
+
+  static uint64_t hash(const uint8_t *Key, uint32_t KeyLen);
+
+  /// \return the entry of the key, loading it from the backend on miss
+  uint32_t lookup(const uint8_t *Key, uint32_t KeyLen);
+
+  void update(uint32_t EntryIdx, const uint8_t *Value, uint32_t ValueLen,
+              bool Exists);
+
+  void revertTo(size_t JournalSize);
+
+  uint32_t appendBytes(const uint8_t *Data, uint32_t Size);
+
+  void insertIndex(uint32_t EntryIdx);
+
+  void growIndex();
+
+  /// Drop the dead values left in the arena by overwritten keys
+  void compactArena();
+
+  StateBackend &Backend;
+
+  std::string Arena;
+  std::vector<Entry> Entries;
+  // entry index + 1, 0 means empty
+  std::vector<uint32_t> Index;
+  std::vector<uint32_t> DirtyEntries;
+  std::vector<JournalEntry> Journal;
+  // journal size when each checkpoint is opened
+  std::vector<size_t> Checkpoints;
+  // bytes of the arena referenced by the entries, the rest is dead values
+  size_t LiveBytes = 0;
+
+  std::string LoadBuffer;
+  std::vector<StateWrite> WriteBatch;
+};
+
+} // namespace zen::runtime
+
+#endif // ZEN_RUNTIME_STATE_JOURNAL_H
@@ -0,0 +1,230 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_RUNTIME_TYPED_FUNCTION_H
+#define ZEN_RUNTIME_TYPED_FUNCTION_H
+
+#include "common/errors.h"
+#include "common/type.h"
+#include "entrypoint/entrypoint.h"
+#include "runtime/instance.h"
+#include "runtime/runtime.h"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace zen::runtime {
+
+namespace detail {
+
+template <typename T>
+constexpr bool IsWASMValueType =
+    std::is_same<T, int32_t>::value || std::is_same<T, uint32_t>::value ||
+    std::is_same<T, int64_t>::value || std::is_same<T, uint64_t>::value ||
+    std::is_same<T, float>::value || std::is_same<T, double>::value;
+
+// Native argv of callNative for NumArgs arguments, filled in the same way as
+// entrypoint::callNativeGeneral. With the argument types known statically all
+// the slot indices fold to constants.
+template <size_t NumArgs> class NativeArgv {
+public:
+  explicit NativeArgv(Instance *Inst) {
+    Ints()[NumIntArgs++] = uint64_t(uintptr_t(Inst));
+  }
+
+  void push(int32_t V) { pushInt(&V, sizeof(V)); }
+  void push(uint32_t V) { pushInt(&V, sizeof(V)); }
+  void push(int64_t V) { pushInt(&V, sizeof(V)); }
+  void push(uint64_t V) { pushInt(&V, sizeof(V)); }
+  void push(float V) { pushFloat(&V, sizeof(V)); }
+  void push(double V) { pushFloat(&V, sizeof(V)); }
+
+  uint64_t *data() { return Buf; }
+  uint32_t getNumStackArgs() const { return NumStackArgs; }
+
+private:
+  static constexpr uint32_t NumFloatCells = entrypoint::MaxFloatRegs * 2;
+
+  uint64_t *Ints() { return Buf + NumFloatCells; }
+  uint64_t *Stacks() { return Ints() + entrypoint::MaxIntRegs; }
+
+  void pushInt(const void *V, size_t Size) {
+    if (NumIntArgs < entrypoint::MaxIntRegs) {
+      std::memcpy(Ints() + NumIntArgs++, V, Size);
+    } else {
+      std::memcpy(Stacks() + NumStackArgs++, V, Size);
+    }
+  }
+
+  void pushFloat(const void *V, size_t Size) {
+    if (NumFpArgs < entrypoint::MaxFloatRegs) {
+      std::memcpy(Buf + 2 * NumFpArgs++, V, Size);
+    } else {
+      std::memcpy(Stacks() + NumStackArgs++, V, Size);
+    }
+  }
+
+  uint64_t Buf[NumFloatCells + entrypoint::MaxIntRegs + NumArgs] = {0};
+  uint32_t NumIntArgs = 0;
+  uint32_t NumFpArgs = 0;
+  uint32_t NumStackArgs = 0;
+};
+
+template <typename T> common::TypedValue toTypedValue(T V) {
+  common::TypedValue Value;
+  Value.Type = common::getWASMTypeFromType<T>();
+  if constexpr (std::is_same<T, float>::value) {
+    Value.Value.F32 = V;
+  } else if constexpr (std::is_same<T, double>::value) {
+    Value.Value.F64 = V;
+  } else if constexpr (sizeof(T) == sizeof(int32_t)) {
+    Value.Value.I32 = static_cast<int32_t>(V);
+  } else {
+    Value.Value.I64 = static_cast<int64_t>(V);
+  }
+  return Value;
+}
+
+template <typename R> R getTypedResult(const common::TypedValue &Result) {
+  if constexpr (std::is_same<R, float>::value) {
+    return Result.Value.F32;
+  } else if constexpr (std::is_same<R, double>::value) {
+    return Result.Value.F64;
+  } else if constexpr (sizeof(R) == sizeof(int32_t)) {
+    return static_cast<R>(Result.Value.I32);
+  } else {
+    return static_cast<R>(Result.Value.I64);
+  }
+}
+
+} // namespace detail
+
+template <typename Sig> class TypedFunction;
+
+/// A function of an instance whose signature has been checked once against
+/// R(Args...), obtained from Instance::getTypedFunction. In JIT mode a call
+/// lays the arguments out on the native stack and enters the JIT code
+/// directly, without the TypedValue vectors and per-argument type dispatch
+/// of Runtime::callWasmFunction. Calls report errors as callWasmFunction
+/// does: false is returned and the error is left on the instance.
+template <typename R, typename... Args> class TypedFunction<R(Args...)> {
+  static_assert(std::is_void<R>::value || detail::IsWASMValueType<R>,
+                "unsupported result type");
+  static_assert((detail::IsWASMValueType<Args> && ...),
+                "unsupported argument type");
+
+public:
+  TypedFunction() = default;
+
+  Instance *getInstance() const { return Inst; }
+  uint32_t getFuncIdx() const { return FuncIdx; }
+
+  /// Only for functions returning a value
+  template <typename T = R>
+  std::enable_if_t<!std::is_void<T>::value, bool> call(T &Result,
+                                                       Args... As) const {
+    common::TypedValue Ret;
+    Ret.Type = common::getWASMTypeFromType<R>();
+    if (!invoke(&Ret, As...)) {
+      return false;
+    }
+    Result = detail::getTypedResult<R>(Ret);
+    return true;
+  }
+
+  /// Only for functions returning nothing
+  template <typename T = R>
+  std::enable_if_t<std::is_void<T>::value, bool> call(Args... As) const {
+    return invoke(nullptr, As...);
+  }
+
+private:
+  friend class Instance;
+
+  TypedFunction(Instance *Inst, uint32_t FuncIdx, bool Direct)
+      : Inst(Inst), FuncIdx(FuncIdx), Direct(Direct) {}
+
+  bool invoke(common::TypedValue *Result, Args... As) const {
+    Runtime *RT = Inst->getRuntime();
+    if (Direct) {
+      detail::NativeArgv<sizeof...(Args)> Argv(Inst);
+      (Argv.push(As), ...);
+      return RT->callWasmFunctionDirect(*Inst, FuncIdx, Argv.data(),
+                                        Argv.getNumStackArgs(), Result);
+    }
+
+    // interpreter and virtual stacks go through the generic path
+    std::vector<common::TypedValue> ArgValues{detail::toTypedValue(As)...};
+    std::vector<common::TypedValue> Results;
+    if (!RT->callWasmFunction(*Inst, FuncIdx, ArgValues, Results)) {
+      return false;
+    }
+    if (Result) {
+      *Result = Results[0];
+    }
+    return true;
+  }
+
+  Instance *Inst = nullptr;
+  uint32_t FuncIdx = 0;
+  bool Direct = false;
+};
+
+template <typename R, typename... Args>
+bool Instance::getTypedFunction(const std::string &Name,
+                                TypedFunction<R(Args...)> &Func) {
+  uint32_t FuncIdx;
+  if (!Mod->getExportFunc(Name, FuncIdx)) {
+    setError(common::getErrorWithExtraMessage(
+        common::ErrorCode::CannotFindFunction, '"' + Name + '"'));
+    ZEN_LOG_ERROR("cannot find function '%s'", Name.c_str());
+    return false;
+  }
+  return getTypedFunction(FuncIdx, Func);
+}
+
+template <typename R, typename... Args>
+bool Instance::getTypedFunction(uint32_t FuncIdx,
+                                TypedFunction<R(Args...)> &Func) {
+  using common::getWASMTypeFromType;
+  if (FuncIdx >= NumTotalFunctions) {
+    setError(common::getErrorWithExtraMessage(ErrorCode::CannotFindFunction,
+                                              std::to_string(FuncIdx)));
+    ZEN_LOG_ERROR("cannot find function %u", FuncIdx);
+    return false;
+  }
+  FunctionInstance &FuncInst = Functions[FuncIdx];
+  const WASMType ParamTypes[] = {getWASMTypeFromType<Args>()...,
+                                 WASMType::VOID};
+  if (FuncInst.NumParams != sizeof...(Args)) {
+    setError(common::getError(ErrorCode::UnexpectedNumArgs));
+    ZEN_LOG_ERROR("unexpected number of arguments for function %u", FuncIdx);
+    return false;
+  }
+  for (uint32_t I = 0; I < FuncInst.NumParams; ++I) {
+    if (FuncInst.getLocalType(I) != ParamTypes[I]) {
+      setError(common::getError(ErrorCode::UnexpectedArgType));
+      ZEN_LOG_ERROR("unexpected argument type for function %u", FuncIdx);
+      return false;
+    }
+  }
+  bool ResultMatched = std::is_void<R>::value
+                           ? FuncInst.NumReturns == 0
+                           : FuncInst.NumReturns == 1 &&
+                                 FuncInst.ReturnTypes[0] ==
+                                     getWASMTypeFromType<R>();
+  if (!ResultMatched) {
+    setError(common::getError(ErrorCode::UnexpectedFuncType));
+    ZEN_LOG_ERROR("unexpected result type for function %u", FuncIdx);
+    return false;
+  }
+  Func = TypedFunction<R(Args...)>(this, FuncIdx,
+                                   getRuntime()->supportsDirectCall());
+  return true;
+}
+
+} // namespace zen::runtime
+
+#endif // ZEN_RUNTIME_TYPED_FUNCTION_H
@@ -300,30 +300,32 @@ private:
     bindLabel(ChkOk);
   }
 
-  void emitTableGet(uint32_t TblIdx, Operand Elem, A64::GP ResRegNum) {
-    // place table[TblIdx] to ScopedTempReg1
+  // place the address of table[TblIdx].elements[Elem] into ScopedTempReg1
+  void emitTableElemAddress(uint32_t TblIdx, Operand Elem) {
     emitGetTableAddress<ScopedTempReg1, ScopedTempReg0, ScopedTempReg2>(TblIdx,
                                                                         Elem);
     auto AddrReg = Layout.getScopedTempReg<A64::I64, ScopedTempReg1>();
     // reuse addrReg(ScopedTempReg1) to load element start addr
     _ ldr(AddrReg, asmjit::a64::ptr(AddrReg, TableBaseOffset));
-    auto ResReg = A64Reg::getRegRef<A64::I32>(ResRegNum);
-    constexpr uint32_t Shift = 2;
-    // load table[TblIdx].functions[Elem] into register
+    // the elements are too large for a scaled index in loads
+    ZEN_STATIC_ASSERT(sizeof(TableElement) == 16);
+    constexpr uint32_t Shift = 4;
     if (Elem.isReg()) {
-      _ ldr(ResReg, asmjit::a64::ptr(AddrReg, Elem.getRegRef<A64::I32>(),
-                                     asmjit::a64::lsl(Shift)));
-    } else if (Elem.isMem()) {
-      // Elem  is on stack, load it and save to ScopedTempReg0
-      auto ElemRegNum = Layout.getScopedTemp<A64::I32, ScopedTempReg0>();
-      auto ElemReg = A64Reg::getRegRef<A64::I32>(ElemRegNum);
+      _ add(AddrReg, AddrReg, Elem.getRegRef<A64::I32>(),
+            asmjit::a64::uxtw(Shift));
+      return;
+    }
+    // Elem is on stack or an immediate, load it into ScopedTempReg0
+    auto ElemRegNum = Layout.getScopedTemp<A64::I32, ScopedTempReg0>();
+    if (Elem.isMem()) {
       loadRegFromMem<A64::I32>(ElemRegNum, Elem.getMem<A64::I32>());
-      _ ldr(ResReg,
-            asmjit::a64::ptr(AddrReg, ElemReg, asmjit::a64::lsl(Shift)));
     } else if (Elem.isImm()) {
-      auto Offset = Elem.getImm() * sizeof(uint32_t);
-      loadRegFromMem<A64::I32>(ResRegNum, asmjit::a64::ptr(AddrReg, Offset));
+      movImm<A64::I32>(ElemRegNum, Elem.getImm());
+    } else {
+      ZEN_ABORT();
     }
+    _ add(AddrReg, AddrReg, A64Reg::getRegRef<A64::I32>(ElemRegNum),
+          asmjit::a64::uxtw(Shift));
   }
 
   void emitRuntimeError(ErrorCode Id) { _ b(getExceptLabel(Id)); };
@@ -945,6 +947,14 @@ public:
 
   void branchLTU(uint32_t LabelIdx) { _ b_lo(asmjit::Label(LabelIdx)); }
 
+  // branch to label if the instance has been asked to interrupt
+  void branchIfInterrupted(uint32_t LabelIdx) {
+    auto FlagReg = Layout.getScopedTempReg<A64::I32, ScopedTempReg0>();
+    _ ldr(FlagReg,
+          asmjit::a64::ptr(ABI.getModuleInstReg(), InterruptFlagOffset));
+    _ cbnz(FlagReg, asmjit::Label(LabelIdx));
+  }
+
   // branch to label if cond is false
   void branchFalse(Operand Cond, uint32_t LabelIdx) {
     ZEN_ASSERT(Cond.getType() == WASMType::I32 ||
@@ -1092,35 +1102,30 @@ public:
         [this, NumHostAPIs, TypeIdx, Callee, TblIdx]() {
           saveGasVal();
 
-          auto FuncIdxReg = Layout.getScopedTemp<A64::I32, ScopedTempReg0>();
-          emitTableGet(TblIdx, Callee, FuncIdxReg);
-          auto FuncIdx = A64Reg::getRegRef<A64::I32>(FuncIdxReg);
-          auto InstReg = ABI.getModuleInstReg();
-          uint32_t CheckFuncType = createLabel();
-          bool Exchanged;
-          cmp<A64::I32, ScopedTempReg2, ScopedTempReg2>(
-              Operand(WASMType::I32, FuncIdxReg, Operand::FLAG_NONE),
-              Operand(WASMType::I32, -1), Exchanged);
-          jmpcc<CompareOperator::CO_NE, true>(CheckFuncType);
-          emitRuntimeError(ErrorCode::UninitializedElement);
-
-          bindLabel(CheckFuncType);
-          auto TypeIdxs = Layout.getScopedTempReg<A64::I64, ScopedTempReg2>();
-          asmjit::a64::Mem TypeIdxsAddr(InstReg, FunctionTypesOffset);
-          _ ldr(TypeIdxs, TypeIdxsAddr);
-
-          asmjit::a64::Mem TypeIdxAddr(TypeIdxs, FuncIdx, asmjit::a64::lsl(2));
+          emitTableElemAddress(TblIdx, Callee);
+          auto ElemAddr = Layout.getScopedTempReg<A64::I64, ScopedTempReg1>();
           auto ActualTypeIdx =
               Layout.getScopedTempReg<A64::I32, ScopedTempReg2>();
-          _ ldr(ActualTypeIdx, TypeIdxAddr);
+          _ ldr(ActualTypeIdx,
+                asmjit::a64::ptr(ElemAddr, TableElemTypeIdxOffset));
 
+          // uninitialized elements never match, tell them apart only then
           uint32_t CheckSucc = createLabel();
           _ cmp(ActualTypeIdx, TypeIdx);
           jmpcc<CompareOperator::CO_EQ, true>(CheckSucc);
+          _ cmn(ActualTypeIdx, 1);
+          _ b_eq(getExceptLabel(ErrorCode::UninitializedElement));
           emitRuntimeError(ErrorCode::IndirectCallTypeMismatch);
           bindLabel(CheckSucc);
 
+          // load the code first, the dwasm check below reuses ScopedTempReg1
+          auto FuncPtr = ABI.getCallTargetReg();
+          _ ldr(FuncPtr, asmjit::a64::ptr(ElemAddr, TableElemCodeOffset));
+
 #ifdef ZEN_ENABLE_DWASM
+          auto FuncIdx = Layout.getScopedTempReg<A64::I32, ScopedTempReg2>();
+          _ ldr(FuncIdx, asmjit::a64::ptr(ElemAddr, TableElemFuncIdxOffset));
+
           // check FuncIdx < import_funcs_count (is_import)
           // if is_import, update WasmInstance::is_host_api
           auto UpdateFlagLabel = createLabel();
@@ -1146,16 +1151,6 @@ public:
 
           bindLabel(EndUpdateFlagLabel);
 #endif
-
-          auto FuncPtrs = Layout.getScopedTempReg<A64::I64, ScopedTempReg2>();
-          asmjit::a64::Mem FuncPtrsAddr(InstReg, FunctionPointersOffset);
-          _ ldr(FuncPtrs, FuncPtrsAddr);
-
-          auto FuncPtr = ABI.getCallTargetReg();
-          constexpr uint32_t Shift = sizeof(void *) == 4 ? 2 : 3;
-          asmjit::a64::Mem FuncPtrAddr(FuncPtrs, FuncIdx,
-                                       asmjit::a64::lsl(Shift));
-          _ ldr(FuncPtr, FuncPtrAddr);
         },
         // generate call
         [&]() { _ blr(ABI.getCallTargetReg()); },
@@ -1198,6 +1193,38 @@ public:
 
   // in alphabetical order
 
+  // data drop
+  void handleDataDropImpl(uint32_t DataIdx) {
+    static TypeEntry SigBuf = {
+        .NumParams = 1,
+        .NumParamCells = 1,
+        .NumReturns = 0,
+        .NumReturnCells = 0,
+        .ReturnTypes = {},
+        {
+            .ParamTypesVec = {WASMType::I32},
+        },
+        .SmallestTypeIdx = uint32_t(-1),
+    };
+    Operand DataIdxOp(WASMType::I32, int32_t(DataIdx));
+    emitMemoryKernelCall(&SigBuf, {DataIdxOp},
+                         uintptr_t(Instance::dropInstanceDataSegmentOnJIT),
+                         false);
+  }
+
+  // memory copy
+  void handleMemoryCopyImpl(Operand DestOffset, Operand SrcOffset,
+                            Operand Size) {
+    emitMemoryKernelCall(&MemoryKernelSig, {DestOffset, SrcOffset, Size},
+                         uintptr_t(Instance::copyInstanceMemoryOnJIT), true);
+  }
+
+  // memory fill
+  void handleMemoryFillImpl(Operand DestOffset, Operand Value, Operand Size) {
+    emitMemoryKernelCall(&MemoryKernelSig, {DestOffset, Value, Size},
+                         uintptr_t(Instance::fillInstanceMemoryOnJIT), true);
+  }
+
   // memory grow
   Operand handleMemoryGrowImpl(Operand Op) {
     static TypeEntry SigBuf = {
@@ -1232,6 +1259,26 @@ public:
         ArgInfo, Args, [] {}, GenCall, [] {});
   }
 
+  // memory init
+  void handleMemoryInitImpl(uint32_t DataIdx, Operand DestOffset,
+                            Operand SrcOffset, Operand Size) {
+    static TypeEntry SigBuf = {
+        .NumParams = 4,
+        .NumParamCells = 4,
+        .NumReturns = 0,
+        .NumReturnCells = 0,
+        .ReturnTypes = {},
+        {
+            .ParamTypesVec = {WASMType::I32, WASMType::I32, WASMType::I32,
+                              WASMType::I32},
+        },
+        .SmallestTypeIdx = uint32_t(-1),
+    };
+    Operand DataIdxOp(WASMType::I32, int32_t(DataIdx));
+    emitMemoryKernelCall(&SigBuf, {DataIdxOp, DestOffset, SrcOffset, Size},
+                         uintptr_t(Instance::initInstanceMemoryOnJIT), true);
+  }
+
   // memory size
   Operand handleMemorySizeImpl() {
     // convert bytes to pages
@@ -1284,6 +1331,18 @@ public:
     _ str(ABI.getGasReg(), GasPtr);
   }
 
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  void incrementCounter(uint64_t *Counter) {
+    auto AddrRegNum = Layout.getScopedTemp<A64::I64, ScopedTempReg0>();
+    movImm<A64::I64>(AddrRegNum, uintptr_t(Counter));
+    auto AddrReg = A64Reg::getRegRef<A64::I64>(AddrRegNum);
+    auto CountReg = Layout.getScopedTempReg<A64::I64, ScopedTempReg1>();
+    _ ldr(CountReg, asmjit::a64::ptr(AddrReg));
+    _ add(CountReg, CountReg, 1);
+    _ str(CountReg, asmjit::a64::ptr(AddrReg));
+  }
+#endif
+
   template <A64::Type Ty, BinaryOperator Opr>
   void handleBinaryOpWithOverflowFlags(const A64::RegNum ResRegNum,
                                        const A64::RegNum LHSRegNum,
@@ -1512,6 +1571,36 @@ public:
   }
 
 private:
+  // (i32, i32, i32) of memory.copy and memory.fill, the kernels return 0 or -1
+  // in w0 which is checked by emitMemoryKernelCall rather than copied out
+  static inline TypeEntry MemoryKernelSig = {
+      .NumParams = 3,
+      .NumParamCells = 3,
+      .NumReturns = 0,
+      .NumReturnCells = 0,
+      .ReturnTypes = {},
+      {
+          .ParamTypesVec = {WASMType::I32, WASMType::I32, WASMType::I32},
+      },
+      .SmallestTypeIdx = uint32_t(-1),
+  };
+
+  // call a bulk memory kernel of Instance, which neither touches the gas nor
+  // moves the memory, and trap on out of bounds if CheckBounds
+  void emitMemoryKernelCall(TypeEntry *Sig, const std::vector<Operand> &Args,
+                            uintptr_t Target, bool CheckBounds) {
+    ArgumentInfo ArgInfo(Sig);
+    auto GenCall = [this, Target, CheckBounds] {
+      callAbsolute(Target);
+      if (CheckBounds) {
+        _ cbnz(ABI.getRetReg<A64::I32>(),
+               getExceptLabel(ErrorCode::OutOfBoundsMemory));
+      }
+    };
+    emitCall(
+        ArgInfo, Args, [] {}, GenCall, [] {});
+  }
+
   template <WASMType Type>
   Operand selectWithIf(Operand Cond, Operand LHS, Operand RHS) {
     auto Ret = getTempOperand(Type);
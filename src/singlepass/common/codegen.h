@@ -13,6 +13,9 @@
 
 #include "singlepass/common/definitions.h"
 
+#include <limits>
+#include <type_traits>
+
 namespace zen::singlepass {
 
 template <typename ConcreteArgumentInfo, typename ConcreteArgumentInfoAttrs>
@@ -194,14 +197,18 @@ public:
   static constexpr uint32_t TablesOffset = offsetof(Instance, Tables);
   static constexpr uint32_t TableSizeOffset = offsetof(TableInstance, CurSize);
   static constexpr uint32_t TableBaseOffset = offsetof(TableInstance, Elements);
-  static constexpr uint32_t FunctionTypesOffset =
-      offsetof(Instance, FuncTypeIdxs);
-  static constexpr uint32_t FunctionPointersOffset =
-      offsetof(Instance, JITFuncPtrs);
+  static constexpr uint32_t TableElemFuncIdxOffset =
+      offsetof(TableElement, FuncIdx);
+  static constexpr uint32_t TableElemTypeIdxOffset =
+      offsetof(TableElement, TypeIdx);
+  static constexpr uint32_t TableElemCodeOffset =
+      offsetof(TableElement, JITCodePtr);
   static constexpr uint32_t ExceptionOffset = offsetof(Instance, Err.ErrCode);
   static constexpr uint32_t StackBoundaryOffset =
       offsetof(Instance, JITStackBoundary);
   static constexpr uint32_t GasLeftOffset = offsetof(Instance, Gas);
+  static constexpr uint32_t InterruptFlagOffset =
+      offsetof(Instance, InterruptFlag);
 #ifdef ZEN_ENABLE_DWASM
   static constexpr uint32_t InHostApiOffset = offsetof(Instance, InHostAPI);
   static constexpr uint32_t InHostApiSize = sizeof(Instance::InHostAPI);
@@ -257,7 +264,8 @@ public:
 
   OnePassCodeGen(asmjit::CodeHolder *Code, OnePassDataLayout &Layout,
                  CodePatcher &Patcher, JITCompilerContext *Ctx)
-      : ASM(Code), Layout(Layout), Patcher(Patcher), ABI(Layout.getABI()),
+      : Stack(common::ArenaMemPoolAllocator<BlockInfo>(Ctx->MemPool)),
+        ASM(Code), Layout(Layout), Patcher(Patcher), ABI(Layout.getABI()),
         Ctx(Ctx) {
     Stack.reserve(16);
   }
@@ -280,6 +288,11 @@ public:
     // Save parameters in reg to stack
     saveParamReg(Type->NumParams);
 
+    // Move the hottest locals from stack to their registers
+    loadLocalReg();
+
+    checkInterrupt();
+
     ZEN_ASSERT(Stack.size() == 0);
 
     WASMType RetType = Type->getReturnType();
@@ -327,7 +340,9 @@ public:
       self().setException();
 #ifdef ZEN_ENABLE_CPU_EXCEPTION
       mov<I64>(ABI.template getParamRegNum<I64, 0>(), ABI.getModuleInst());
-      self().callAbsolute(uintptr_t(Instance::throwInstanceExceptionOnJIT));
+      // triggerInstanceExceptionOnJIT never returns, so only the import calls
+      // get here, after the hostapi has returned
+      self().callAbsolute(uintptr_t(Instance::unwindHostExceptionOnJIT));
 #else
       if (Layout.getNumReturns() > 0) {
         self().emitEpilog(getReturnRegOperand(Layout.getReturnType(0)));
@@ -402,6 +417,8 @@ public:
     auto Res = (Type == WASMType::VOID) ? Operand() : getTempStackOperand(Type);
     Stack.push_back(BlockInfo(CtrlBlockKind::LOOP, Res, Label, Estack));
     bindLabel(Label);
+    // every back edge goes through the loop header
+    checkInterrupt();
   }
 
   void handleIf(Operand Op, WASMType Type, uint32_t Estack) {
@@ -554,6 +571,21 @@ public:
     return self().handleMemoryGrowImpl(Op);
   }
 
+  void handleMemoryCopy(Operand DestOffset, Operand SrcOffset, Operand Size) {
+    self().handleMemoryCopyImpl(DestOffset, SrcOffset, Size);
+  }
+
+  void handleMemoryFill(Operand DestOffset, Operand Value, Operand Size) {
+    self().handleMemoryFillImpl(DestOffset, Value, Size);
+  }
+
+  void handleMemoryInit(uint32_t DataIdx, Operand DestOffset, Operand SrcOffset,
+                        Operand Size) {
+    self().handleMemoryInitImpl(DataIdx, DestOffset, SrcOffset, Size);
+  }
+
+  void handleDataDrop(uint32_t DataIdx) { self().handleDataDropImpl(DataIdx); }
+
   // ==================== Numeric Instruction Handlers ====================
 
   template <WASMType Ty>
@@ -564,6 +596,13 @@ public:
   // compare operator
   template <WASMType Type, CompareOperator Opr>
   Operand handleCompareOp(Operand LHS, Operand RHS) {
+    if constexpr (isWASMTypeInteger<Type>()) {
+      if (LHS.isImm() && (Opr == CompareOperator::CO_EQZ || RHS.isImm())) {
+        int32_t RHSImm = (Opr == CompareOperator::CO_EQZ) ? 0 : RHS.getImm();
+        return handleConst<WASMType::I32>(
+            foldIntCompareOp<Type, Opr>(LHS.getImm(), RHSImm));
+      }
+    }
     return self().template handleCompareOpImpl<Type, Opr>(LHS, RHS);
   }
 
@@ -603,16 +642,28 @@ public:
 
   template <WASMType Type, BinaryOperator Opr>
   Operand handleBinaryOp(Operand LHS, Operand RHS) {
+    typename WASMTypeAttr<Type>::Type Folded;
+    if (foldBinaryOp<Type, Opr>(LHS, RHS, Folded)) {
+      return handleConst<Type>(Folded);
+    }
     return self().template handleBinaryOpImpl<Type, Opr>(LHS, RHS);
   }
 
   template <WASMType Type, BinaryOperator Opr>
   Operand handleIDiv(Operand LHS, Operand RHS) {
+    typename WASMTypeAttr<Type>::Type Folded;
+    if (foldBinaryOp<Type, Opr>(LHS, RHS, Folded)) {
+      return handleConst<Type>(Folded);
+    }
     return self().template handleIDivOpImpl<Type, Opr>(LHS, RHS);
   }
 
   template <WASMType Type, BinaryOperator Opr>
   Operand handleShift(Operand LHS, Operand RHS) {
+    typename WASMTypeAttr<Type>::Type Folded;
+    if (foldBinaryOp<Type, Opr>(LHS, RHS, Folded)) {
+      return handleConst<Type>(Folded);
+    }
     return self().template handleShiftOpImpl<Type, Opr>(LHS, RHS);
   }
 
@@ -671,6 +722,140 @@ public:
     return Ret;
   }
 
+  // ==================== Constant Folding Methods ====================
+
+  // fold integer binary operator when both operands are immediates, return
+  // false when the result is not a plain value (division by zero, overflow)
+  // so that the instruction is emitted and traps at runtime
+  template <WASMType Type, BinaryOperator Opr>
+  static bool foldBinaryOp(Operand LHS, Operand RHS,
+                           typename WASMTypeAttr<Type>::Type &Result) {
+    if constexpr (isWASMTypeInteger<Type>()) {
+      if (LHS.isImm() && RHS.isImm()) {
+        return foldIntBinaryOp<Type, Opr>(LHS.getImm(), RHS.getImm(),
+                                          Result);
+      }
+    }
+    return false;
+  }
+
+  // i64 immediates are sign-extended from 32 bits
+  template <WASMType Type, BinaryOperator Opr>
+  static bool foldIntBinaryOp(int32_t LHSImm, int32_t RHSImm,
+                              typename WASMTypeAttr<Type>::Type &Result) {
+    using SType = typename WASMTypeAttr<Type>::Type;
+    using UType = std::make_unsigned_t<SType>;
+    constexpr uint32_t NumBits = sizeof(SType) * 8;
+    const SType LHS = LHSImm;
+    const SType RHS = RHSImm;
+    const UType ULHS = static_cast<UType>(LHS);
+    const UType URHS = static_cast<UType>(RHS);
+    const uint32_t Count = URHS & (NumBits - 1);
+    UType Val = 0;
+    switch (Opr) {
+    case BinaryOperator::BO_ADD:
+      Val = ULHS + URHS;
+      break;
+    case BinaryOperator::BO_SUB:
+      Val = ULHS - URHS;
+      break;
+    case BinaryOperator::BO_MUL:
+      Val = ULHS * URHS;
+      break;
+    case BinaryOperator::BO_AND:
+      Val = ULHS & URHS;
+      break;
+    case BinaryOperator::BO_OR:
+      Val = ULHS | URHS;
+      break;
+    case BinaryOperator::BO_XOR:
+      Val = ULHS ^ URHS;
+      break;
+    case BinaryOperator::BO_SHL:
+      Val = ULHS << Count;
+      break;
+    case BinaryOperator::BO_SHR_S:
+      Val = static_cast<UType>(LHS >> Count);
+      break;
+    case BinaryOperator::BO_SHR_U:
+      Val = ULHS >> Count;
+      break;
+    case BinaryOperator::BO_ROTL:
+      Val = Count ? (ULHS << Count) | (ULHS >> (NumBits - Count)) : ULHS;
+      break;
+    case BinaryOperator::BO_ROTR:
+      Val = Count ? (ULHS >> Count) | (ULHS << (NumBits - Count)) : ULHS;
+      break;
+    case BinaryOperator::BO_DIV_S:
+      if (RHS == 0 ||
+          (LHS == std::numeric_limits<SType>::min() && RHS == -1)) {
+        return false;
+      }
+      Val = static_cast<UType>(LHS / RHS);
+      break;
+    case BinaryOperator::BO_DIV_U:
+      if (URHS == 0) {
+        return false;
+      }
+      Val = ULHS / URHS;
+      break;
+    case BinaryOperator::BO_REM_S:
+      if (RHS == 0) {
+        return false;
+      }
+      // INT_MIN % -1 is 0 in wasm but overflows in C++
+      Val = (RHS == -1) ? 0 : static_cast<UType>(LHS % RHS);
+      break;
+    case BinaryOperator::BO_REM_U:
+      if (URHS == 0) {
+        return false;
+      }
+      Val = ULHS % URHS;
+      break;
+    default:
+      return false;
+    }
+    Result = static_cast<SType>(Val);
+    return true;
+  }
+
+  template <WASMType Type, CompareOperator Opr>
+  static int32_t foldIntCompareOp(int32_t LHSImm, int32_t RHSImm) {
+    using SType = typename WASMTypeAttr<Type>::Type;
+    using UType = std::make_unsigned_t<SType>;
+    const SType LHS = LHSImm;
+    const SType RHS = RHSImm;
+    const UType ULHS = static_cast<UType>(LHS);
+    const UType URHS = static_cast<UType>(RHS);
+    switch (Opr) {
+    case CompareOperator::CO_EQZ:
+      return LHS == 0;
+    case CompareOperator::CO_EQ:
+      return LHS == RHS;
+    case CompareOperator::CO_NE:
+      return LHS != RHS;
+    case CompareOperator::CO_LT_S:
+      return LHS < RHS;
+    case CompareOperator::CO_LT_U:
+      return ULHS < URHS;
+    case CompareOperator::CO_GT_S:
+      return LHS > RHS;
+    case CompareOperator::CO_GT_U:
+      return ULHS > URHS;
+    case CompareOperator::CO_LE_S:
+      return LHS <= RHS;
+    case CompareOperator::CO_LE_U:
+      return ULHS <= URHS;
+    case CompareOperator::CO_GE_S:
+      return LHS >= RHS;
+    case CompareOperator::CO_GE_U:
+      return ULHS >= URHS;
+    default:
+      ZEN_ABORT();
+      return 0;
+    }
+  }
+
   // ==================== Platform Feature Methods ====================
 
   void handleGasCall(Operand Delta) {
@@ -678,6 +863,17 @@ public:
     self().branchLTU(getExceptLabel(ErrorCode::GasLimitExceeded).id());
   }
 
+  void checkInterrupt() {
+    if (Ctx->UseInterruptCheck) {
+      self().branchIfInterrupted(
+          getExceptLabel(ErrorCode::Interrupted).id());
+    }
+  }
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  void handleBlockCount(uint64_t *Counter) { self().incrementCounter(Counter); }
+#endif
+
   template <bool Sign, WASMType Type, BinaryOperator Opr>
   Operand handleCheckedArithmetic(Operand LHS, Operand RHS) {
     return self().template checkedArithmetic<Sign, Type, Opr>(LHS, RHS);
@@ -979,7 +1175,8 @@ protected:
   }
 
   // Use vector because branch may refer random parent block
-  typedef std::vector<BlockInfo> BlockStack;
+  typedef std::vector<BlockInfo, common::ArenaMemPoolAllocator<BlockInfo>>
+      BlockStack;
   BlockStack Stack; // manage nested block
   Assembler ASM;
   OnePassDataLayout &Layout;
@@ -1040,6 +1237,36 @@ private:
     Layout.clearParamInReg();
   }
 
+  // load locals picked by the layout to their registers, their stack slots
+  // hold the initial value once params are saved and locals zeroed
+  void loadLocalReg() {
+    for (const auto &[LocalIdx, Reg] : Layout.getLocalRegs()) {
+      auto Info = Layout.getLocalInfo(LocalIdx);
+      Mem Addr(ABI.getFrameBaseReg(), Info.getOffset());
+      switch (Info.getType()) {
+      case WASMType::I32:
+        Layout.template clearAvailReg<I64>((GP)Reg);
+        self().template loadRegFromMem<I32>(Reg, Addr);
+        break;
+      case WASMType::I64:
+        Layout.template clearAvailReg<I64>((GP)Reg);
+        self().template loadRegFromMem<I64>(Reg, Addr);
+        break;
+      case WASMType::F32:
+        Layout.template clearAvailReg<F64>((FP)Reg);
+        self().template loadRegFromMem<F32>(Reg, Addr);
+        break;
+      case WASMType::F64:
+        Layout.template clearAvailReg<F64>((FP)Reg);
+        self().template loadRegFromMem<F64>(Reg, Addr);
+        break;
+      default:
+        ZEN_ABORT();
+      }
+      Layout.setLocalInRegister(LocalIdx, Reg);
+    }
+  }
+
   // save/restore tempoorary registers for call
   template <DataType Type, bool Save>
   void saveRestoreTempReg(uint32_t Mask, uint32_t &StackOffset) {
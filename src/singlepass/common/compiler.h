@@ -46,12 +46,20 @@ public:
 
   bool compile(asmjit::CodeHolder *Code) {
     ZEN_ASSERT(Code != nullptr);
+    // declared before the codegen and the visitor, so the pool is reset once
+    // everything allocated from it has died, also when the compilation throws
+    MemPoolResetGuard ResetGuard{Ctx->MemPool};
     CodeGenImpl CodeGen(Layout, Patcher, Code, Ctx);
     action::WASMByteCodeVisitor<CodeGenImpl> Visitor(CodeGen, Ctx);
     return Visitor.compile();
   }
 
 private:
+  struct MemPoolResetGuard {
+    ~MemPoolResetGuard() { Pool.reset(); }
+    common::ArenaMemPool &Pool;
+  };
+
   ABIType ABI;
   DataLayout Layout;
   CodePatcher Patcher;
@@ -13,6 +13,8 @@
 // ============================================================================
 
 #include "singlepass/common/definitions.h"
+#include "utils/wasm.h"
+#include <utility>
 #include <vector>
 
 // ============================================================================
@@ -136,12 +138,19 @@ public:
     int32_t getOffset() const { return Offset; }
     bool inReg() const { return Reg != ABI::InvalidParamReg; }
     void setClearReg() { Reg = ABI::InvalidParamReg; }
+    void setReg(uint32_t R) {
+      ZEN_ASSERT(R < (1 << 4));
+      Reg = R;
+    }
   }; // LocalInfo
 
 protected:
   JITCompilerContext *Ctx;       // JIT compile context containing current WASM
                                  // function been jit'ed
   std::vector<LocalInfo> Locals; // all locals in the function
+  std::vector<std::pair<uint32_t, uint32_t>>
+      LocalRegs;                 // local index and register of the locals
+                                 //   kept in register after params saved
   uint32_t GpPresSavedArea;      // callee-saved int register backup
   uint32_t FpPresSavedArea;      // callee-saved fp register backup
   int32_t StackUsed;             // total used stack, include above and temp
@@ -168,6 +177,7 @@ public:
     ZEN_ASSERT(Locals.size() ==
                Ctx->FuncType->NumParams + Ctx->Func->NumLocals);
     Locals.clear();
+    LocalRegs.clear();
   }
 
 public:
@@ -197,6 +207,71 @@ public:
     ZEN_ASSERT(Locals[LocalIdx].inReg());
     Locals[LocalIdx].setClearReg();
   }
+
+  const std::vector<std::pair<uint32_t, uint32_t>> &getLocalRegs() const {
+    return LocalRegs;
+  }
+
+  void setLocalInRegister(uint32_t LocalIdx, uint32_t Reg) {
+    ZEN_ASSERT(LocalIdx < Locals.size());
+    ZEN_ASSERT(!Locals[LocalIdx].inReg());
+    Locals[LocalIdx].setReg(Reg);
+  }
+
+protected:
+  // count the uses of each local in the function body, each use weighted by
+  // 8^loop_depth. return the calls weighted the same way, registers holding
+  // locals are saved and restored around every call
+  uint64_t countLocalUses(std::vector<uint64_t> &Uses) const {
+    using common::Opcode;
+    Uses.assign(Locals.size(), 0);
+    uint64_t Calls = 0;
+    uint32_t LoopDepth = 0;
+    std::vector<bool> IsLoop; // enclosing blocks, true for loop
+    const uint8_t *Ip = Ctx->Func->CodePtr;
+    const uint8_t *IpEnd = Ip + Ctx->Func->CodeSize;
+    while (Ip < IpEnd) {
+      uint64_t Weight = uint64_t(1) << (3 * std::min(LoopDepth, 8u));
+      uint8_t Op = *Ip;
+      switch (Op) {
+      case Opcode::BLOCK:
+      case Opcode::IF:
+        IsLoop.push_back(false);
+        break;
+      case Opcode::LOOP:
+        IsLoop.push_back(true);
+        ++LoopDepth;
+        break;
+      case Opcode::END:
+        // the last end closes the function body
+        if (!IsLoop.empty()) {
+          LoopDepth -= IsLoop.back();
+          IsLoop.pop_back();
+        }
+        break;
+      case Opcode::GET_LOCAL:
+      case Opcode::SET_LOCAL:
+      case Opcode::TEE_LOCAL: {
+        uint32_t LocalIdx;
+        utils::readSafeLEBNumber(Ip + 1, LocalIdx);
+        if (LocalIdx < Uses.size()) {
+          Uses[LocalIdx] += Weight;
+        }
+        break;
+      }
+      case Opcode::CALL:
+      case Opcode::CALL_INDIRECT:
+      case Opcode::MEMORY_GROW:
+      case Opcode::MISC_PREFIX:
+        Calls += Weight;
+        break;
+      default:
+        break;
+      }
+      Ip = utils::skipInstruction(Ip, IpEnd);
+    }
+    return Calls;
+  }
 };
 
 } // namespace zen::singlepass
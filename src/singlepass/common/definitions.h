@@ -6,6 +6,7 @@
 
 #include "common/defines.h"
 #include "common/errors.h"
+#include "common/mem_pool.h"
 #include "common/operators.h"
 #include "common/type.h"
 #include "runtime/instance.h"
@@ -36,15 +37,20 @@ using runtime::CodeEntry;
 using runtime::Instance;
 using runtime::MemoryInstance;
 using runtime::Module;
+using runtime::TableElement;
 using runtime::TableInstance;
 using runtime::TypeEntry;
 
 struct JITCompilerContext {
   Module *Mod = nullptr;
   bool UseSoftMemCheck = true;
+  // poll Instance::interrupt at function entries and loop headers
+  bool UseInterruptCheck = false;
   CodeEntry *Func = nullptr;
   TypeEntry *FuncType = nullptr;
   uint32_t InternalFuncIdx = -1; // exclude imported functions
+  // per function data of the visitor and codegen, reset between functions
+  common::ArenaMemPool MemPool;
 
   runtime::Module &getWasmMod() { return *Mod; }
 
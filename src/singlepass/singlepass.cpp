@@ -7,6 +7,7 @@
 #include "platform/map.h"
 #include "runtime/memory.h"
 #include "runtime/module.h"
+#include "runtime/runtime.h"
 #include "singlepass/common/compiler.h"
 #include "utils/statistics.h"
 
@@ -45,6 +46,8 @@ void JITCompiler::compile(Module *Mod) {
   JITCompilerContext Ctx = {
       .Mod = Mod,
       .UseSoftMemCheck = Mod->checkUseSoftLinearMemoryCheck(),
+      .UseInterruptCheck =
+          Mod->getRuntime()->getConfig().EnableInterruption,
   };
   Compiler.initModule(&Ctx);
 
@@ -184,14 +184,14 @@ public:
   // temp register, can be used to keep data in a longer range across
   // multiple byte code handling and must be allocated and released when
   // it's pop'ed from eval stack explicitly
-  // matches with wasmer single-pass compiler convention
-  // TODO: xmm8-xmm15 should also be used?
+  // matches with wasmer single-pass compiler convention, plus xmm11-xmm15
+  // which no one else uses
 
   // temporary integer register
   constexpr static uint32_t NumTempGpRegs = 6;
 
   // temporary floating point register
-  constexpr static uint32_t NumTempFpRegs = 8;
+  constexpr static uint32_t NumTempFpRegs = 13;
 
 #define TEMP_GP_REG_LIST                                                       \
   X64::RSI, X64::RDI, X64::R8, X64::R9, X64::R10, X64::R11
@@ -202,11 +202,13 @@ public:
 
 #define TEMP_FP_REG_LIST                                                       \
   X64::XMM3, X64::XMM4, X64::XMM5, X64::XMM6, X64::XMM7, X64::XMM8, X64::XMM9, \
-      X64::XMM10
+      X64::XMM10, X64::XMM11, X64::XMM12, X64::XMM13, X64::XMM14, X64::XMM15
 
 #define TEMP_FP_REG_MASK                                                       \
   ((1 << X64::XMM3) | (1 << X64::XMM4) | (1 << X64::XMM5) | (1 << X64::XMM6) | \
-   (1 << X64::XMM7) | (1 << X64::XMM8) | (1 << X64::XMM9) | (1 << X64::XMM10))
+   (1 << X64::XMM7) | (1 << X64::XMM8) | (1 << X64::XMM9) |                    \
+   (1 << X64::XMM10) | (1 << X64::XMM11) | (1 << X64::XMM12) |                 \
+   (1 << X64::XMM13) | (1 << X64::XMM14) | (1 << X64::XMM15))
 
   // get temporary integer register number with constant index
   template <uint32_t Index> static constexpr X64::GP getTempIntRegNum() {
@@ -292,6 +294,40 @@ public:
     auto Reg = getTempRegNum<Ty>(Index);
     return X64Reg::getRegRef<Ty>(Reg);
   }
+
+public:
+  // local register, temp register taken out of the pool for the whole
+  // function to hold one of its hottest locals. taken from the top of the
+  // pool as temp registers are handed out from the bottom, and saved around
+  // calls like any other temp register in use.
+  // xmm15 can't hold a local, 0xF means not in register for LocalInfo
+
+  // local integer register
+  constexpr static uint32_t NumLocalGpRegs = 2;
+
+  // local floating point register
+  constexpr static uint32_t NumLocalFpRegs = 4;
+
+#define LOCAL_GP_REG_LIST X64::R11, X64::R10
+
+#define LOCAL_FP_REG_LIST X64::XMM14, X64::XMM13, X64::XMM12, X64::XMM11
+
+  // get local integer register number with variable index
+  static X64::GP getLocalIntRegNum(uint32_t Index) {
+    static const X64::GP LocalGpRegs[NumLocalGpRegs] = {LOCAL_GP_REG_LIST};
+    ZEN_ASSERT(Index < NumLocalGpRegs);
+    return LocalGpRegs[Index];
+  }
+
+  // get local floating point register number with variable index
+  static X64::FP getLocalFloatRegNum(uint32_t Index) {
+    static const X64::FP LocalFpRegs[NumLocalFpRegs] = {LOCAL_FP_REG_LIST};
+    ZEN_ASSERT(Index < NumLocalFpRegs);
+    return LocalFpRegs[Index];
+  }
+
+#undef LOCAL_GP_REG_LIST
+#undef LOCAL_FP_REG_LIST
 };
 
 } // namespace zen::singlepass
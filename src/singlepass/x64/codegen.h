@@ -256,27 +256,24 @@ private:
     _ jbe(getExceptLabel(ErrorCode::UndefinedElement));
   }
 
-  void emitTableGet(uint32_t TblIdx, Operand Elem, X64::GP ResRegNum) {
-    // place table[tbl_idx] to ScopedTempReg1
+  // place the offset of table[tbl_idx].elements[elem] from the table element
+  // base into ScopedTempReg0
+  void emitTableElemOffset(uint32_t TblIdx, Operand Elem) {
     emitTableSize<ScopedTempReg0>(TblIdx, Elem);
-    auto InstReg = ABI.getModuleInstReg();
-    auto ResReg = X64Reg::getRegRef<X64::I32>(ResRegNum);
-    constexpr uint32_t Shift = 2;
-    uint32_t BaseOffset = Ctx->Mod->getLayout().TableElemBaseOffset;
-    // load table[tbl_idx].functions[elem] into register
+    auto OffsetReg = Layout.getScopedTempReg<X64::I32, ScopedTempReg0>();
     if (Elem.isReg()) {
-      // elem is in reg, reuse this reg
-      _ mov(ResReg, asmjit::x86::ptr(InstReg, Elem.getRegRef<X64::I32>(), Shift,
-                                     BaseOffset));
+      _ mov(OffsetReg, Elem.getRegRef<X64::I32>());
     } else if (Elem.isMem()) {
-      // elem  is on stack, load it and save to ScopedTempReg0
-      auto ElemReg = Layout.getScopedTempReg<X64::I32, ScopedTempReg0>();
-      _ mov(ElemReg, Elem.getMem<X64::I32>());
-      _ mov(ResReg, asmjit::x86::ptr(InstReg, ElemReg, Shift, BaseOffset));
+      _ mov(OffsetReg, Elem.getMem<X64::I32>());
     } else if (Elem.isImm()) {
-      _ mov(ResReg, asmjit::x86::Mem(InstReg, Elem.getImm() * sizeof(uint32_t) +
-                                                  BaseOffset));
+      _ mov(OffsetReg, Elem.getImm());
+    } else {
+      ZEN_ABORT();
     }
+    // the 32-bit mov above zero-extends, and the elements are too large for a
+    // scaled index
+    ZEN_STATIC_ASSERT(sizeof(TableElement) == 16);
+    _ shl(Layout.getScopedTempReg<X64::I64, ScopedTempReg0>(), 4);
   }
 
 public:
@@ -1072,6 +1069,13 @@ public:
 
   void branchLTU(uint32_t LabelIdx) { _ jb(asmjit::Label(LabelIdx)); }
 
+  // branch to label if the instance has been asked to interrupt
+  void branchIfInterrupted(uint32_t LabelIdx) {
+    _ cmp(asmjit::x86::dword_ptr(ABI.getModuleInstReg(), InterruptFlagOffset),
+          0);
+    _ jne(asmjit::Label(LabelIdx));
+  }
+
   // branch to label if cond is false
   void branchFalse(Operand Cond, uint32_t LabelIdx) {
     ZEN_ASSERT(Cond.getType() == WASMType::I32 ||
@@ -1212,27 +1216,31 @@ public:
         [this, NumHostAPIs, TypeIdx, Callee, TblIdx]() {
           saveGasVal();
 
-          auto FuncIdxReg = Layout.getScopedTemp<X64::I32, ScopedTempReg0>();
-
-          auto FuncIdx = X64Reg::getRegRef<X64::I32>(FuncIdxReg);
-
-          emitTableGet(TblIdx, Callee, FuncIdxReg);
+          emitTableElemOffset(TblIdx, Callee);
 
           auto InstReg = ABI.getModuleInstReg();
-
-          _ cmp(FuncIdx, -1);
-          _ je(getExceptLabel(ErrorCode::UninitializedElement));
-
-          constexpr uint32_t Shift0 = 2;
-          auto IndexesBaseOffset =
-              Ctx->Mod->getLayout().FuncTypeIndexesBaseOffset;
-          asmjit::x86::Mem TypeIdxAddr(InstReg, FuncIdx, Shift0,
-                                       IndexesBaseOffset, sizeof(TypeIdx));
-
+          auto ElemOffset = Layout.getScopedTempReg<X64::I64, ScopedTempReg0>();
+          uint32_t BaseOffset = Ctx->Mod->getLayout().TableElemBaseOffset;
+
+          // uninitialized elements never match, tell them apart only then
+          asmjit::x86::Mem TypeIdxAddr(InstReg, ElemOffset, 0,
+                                       BaseOffset + TableElemTypeIdxOffset,
+                                       sizeof(uint32_t));
+          auto TypeMatched = createLabel();
           _ cmp(TypeIdxAddr, TypeIdx);
-          _ jne(getExceptLabel(ErrorCode::IndirectCallTypeMismatch));
+          je(TypeMatched);
+          _ cmp(TypeIdxAddr, -1);
+          _ je(getExceptLabel(ErrorCode::UninitializedElement));
+          _ jmp(getExceptLabel(ErrorCode::IndirectCallTypeMismatch));
+          bindLabel(TypeMatched);
 
 #ifdef ZEN_ENABLE_DWASM
+          auto FuncIdx = Layout.getScopedTempReg<X64::I32, ScopedTempReg1>();
+          _ mov(FuncIdx,
+                asmjit::x86::Mem(InstReg, ElemOffset, 0,
+                                 BaseOffset + TableElemFuncIdxOffset,
+                                 sizeof(uint32_t)));
+
           // check func_idx < import_funcs_count (is_import)
           // if is_import, update WasmInstance::is_host_api
           auto UpdateFlagLabel = createLabel();
@@ -1251,10 +1259,8 @@ public:
 #endif
 
           auto FuncPtr = ABI.getCallTargetReg();
-          constexpr uint32_t Shift = sizeof(void *) == 4 ? 2 : 3;
-          asmjit::x86::Mem FuncPtrAddr(
-              InstReg, FuncIdx, Shift,
-              Ctx->Mod->getLayout().FuncPtrsBaseOffset);
+          asmjit::x86::Mem FuncPtrAddr(InstReg, ElemOffset, 0,
+                                       BaseOffset + TableElemCodeOffset);
 
           _ mov(FuncPtr, FuncPtrAddr);
         },
@@ -1301,6 +1307,38 @@ public:
 
   // in alphabetical order
 
+  // data drop
+  void handleDataDropImpl(uint32_t DataIdx) {
+    static TypeEntry SigBuf = {
+        .NumParams = 1,
+        .NumParamCells = 1,
+        .NumReturns = 0,
+        .NumReturnCells = 0,
+        .ReturnTypes = {},
+        {
+            .ParamTypesVec = {WASMType::I32},
+        },
+        .SmallestTypeIdx = uint32_t(-1),
+    };
+    Operand DataIdxOp(WASMType::I32, int32_t(DataIdx));
+    emitMemoryKernelCall(&SigBuf, {DataIdxOp},
+                         uintptr_t(Instance::dropInstanceDataSegmentOnJIT),
+                         false);
+  }
+
+  // memory copy
+  void handleMemoryCopyImpl(Operand DestOffset, Operand SrcOffset,
+                            Operand Size) {
+    emitMemoryKernelCall(&MemoryKernelSig, {DestOffset, SrcOffset, Size},
+                         uintptr_t(Instance::copyInstanceMemoryOnJIT), true);
+  }
+
+  // memory fill
+  void handleMemoryFillImpl(Operand DestOffset, Operand Value, Operand Size) {
+    emitMemoryKernelCall(&MemoryKernelSig, {DestOffset, Value, Size},
+                         uintptr_t(Instance::fillInstanceMemoryOnJIT), true);
+  }
+
   // memory grow
   Operand handleMemoryGrowImpl(Operand Op) {
     static TypeEntry SigBuf = {
@@ -1341,6 +1379,26 @@ public:
         [] {});
   }
 
+  // memory init
+  void handleMemoryInitImpl(uint32_t DataIdx, Operand DestOffset,
+                            Operand SrcOffset, Operand Size) {
+    static TypeEntry SigBuf = {
+        .NumParams = 4,
+        .NumParamCells = 4,
+        .NumReturns = 0,
+        .NumReturnCells = 0,
+        .ReturnTypes = {},
+        {
+            .ParamTypesVec = {WASMType::I32, WASMType::I32, WASMType::I32,
+                              WASMType::I32},
+        },
+        .SmallestTypeIdx = uint32_t(-1),
+    };
+    Operand DataIdxOp(WASMType::I32, int32_t(DataIdx));
+    emitMemoryKernelCall(&SigBuf, {DataIdxOp, DestOffset, SrcOffset, Size},
+                         uintptr_t(Instance::initInstanceMemoryOnJIT), true);
+  }
+
   // memory size
   Operand handleMemorySizeImpl() {
     Operand Ret = getTempOperand(WASMType::I32);
@@ -1379,6 +1437,37 @@ public:
   }
 
 private:
+  // (i32, i32, i32) of memory.copy and memory.fill, the kernels return 0 or -1
+  // in eax which is checked by emitMemoryKernelCall rather than copied out
+  static inline TypeEntry MemoryKernelSig = {
+      .NumParams = 3,
+      .NumParamCells = 3,
+      .NumReturns = 0,
+      .NumReturnCells = 0,
+      .ReturnTypes = {},
+      {
+          .ParamTypesVec = {WASMType::I32, WASMType::I32, WASMType::I32},
+      },
+      .SmallestTypeIdx = uint32_t(-1),
+  };
+
+  // call a bulk memory kernel of Instance, which neither touches the gas nor
+  // moves the memory, and trap on out of bounds if CheckBounds
+  void emitMemoryKernelCall(TypeEntry *Sig, const std::vector<Operand> &Args,
+                            uintptr_t Target, bool CheckBounds) {
+    X64ArgumentInfo ArgInfo(Sig);
+    emitCall(
+        ArgInfo, Args, [] {},
+        [this, Target, CheckBounds]() {
+          _ call(Target);
+          if (CheckBounds) {
+            _ test(ABI.getRetReg<X64::I32>(), ABI.getRetReg<X64::I32>());
+            _ jne(getExceptLabel(ErrorCode::OutOfBoundsMemory));
+          }
+        },
+        [] {});
+  }
+
   // select, return value in type
   // test   cond
   // mov    rhs, res
@@ -1861,6 +1950,15 @@ public:
                                                                Delta);
   }
 
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  // only emitted at block leaders, where the flags are dead
+  void incrementCounter(uint64_t *Counter) {
+    auto AddrReg = Layout.getScopedTempReg<X64::I64, ScopedTempReg0>();
+    _ mov(AddrReg, uintptr_t(Counter));
+    _ add(asmjit::x86::qword_ptr(AddrReg), 1);
+  }
+#endif
+
   template <bool Sign, WASMType Type, BinaryOperator Opr>
   Operand checkedArithmetic(Operand LHS, Operand RHS) {
     constexpr auto X64Type = getX64TypeFromWASMType<Type>();
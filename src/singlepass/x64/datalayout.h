@@ -77,6 +77,35 @@ private:
     Locals.push_back(LocalInfo(Type, -StkSize));
   }
 
+  // pick the locals to keep in local registers, the ones whose weighted uses
+  // pay most for the load at entry and the save and restore around calls
+  void allocLocalRegs() {
+    std::vector<uint64_t> Uses;
+    uint64_t Calls = countLocalUses(Uses);
+    std::vector<uint32_t> Candidates;
+    for (uint32_t I = 0; I < Locals.size(); ++I) {
+      WASMType Type = Locals[I].getType();
+      if (Type != WASMType::V128 && Uses[I] > 1 + 2 * Calls) {
+        Candidates.push_back(I);
+      }
+    }
+    std::stable_sort(
+        Candidates.begin(), Candidates.end(),
+        [&Uses](uint32_t L, uint32_t R) { return Uses[L] > Uses[R]; });
+
+    uint32_t NumGp = 0;
+    uint32_t NumFp = 0;
+    for (uint32_t I : Candidates) {
+      if (getWASMTypeKind(Locals[I].getType()) == WASMTypeKind::INTEGER) {
+        if (NumGp < X64OnePassABI::NumLocalGpRegs) {
+          LocalRegs.emplace_back(I, X64OnePassABI::getLocalIntRegNum(NumGp++));
+        }
+      } else if (NumFp < X64OnePassABI::NumLocalFpRegs) {
+        LocalRegs.emplace_back(I, X64OnePassABI::getLocalFloatRegNum(NumFp++));
+      }
+    }
+  }
+
 public:
   void initFunction(JITCompilerContext *Ctx) {
     auto *FuncType = Ctx->FuncType;
@@ -144,6 +173,9 @@ public:
     if (FuncType->NumParams) {
       ParamInRegister = true;
     }
+
+    ZEN_ASSERT(LocalRegs.empty());
+    allocLocalRegs();
   }
 
   void finalizeFunction() {
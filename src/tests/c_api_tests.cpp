@@ -4,7 +4,15 @@
 #include "zetaengine-c.h"
 #include "zetaengine.h"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <gtest/gtest.h>
+#include <iterator>
+#include <map>
+#include <sys/stat.h>
+#include <thread>
 
 namespace zen::test {
 
@@ -21,6 +29,12 @@ static ZenRuntimeConfig RuntimeConfig = {
     .DisableWASI = true,
     .EnableStatistics = false,
     .EnableGdbTracingHook = false,
+    .EnableHugePages = false,
+    .EnableNumaLocalMemory = false,
+    .EnableInterruption = false,
+    .EnableHardwareCounters = false,
+    .NumLoaderThreads = 0,
+    .EnableLazyValidation = false,
 };
 
 static void envPrintStr(ZenInstanceRef Instance, uint32_t Offset) {
@@ -118,6 +132,252 @@ TEST(C_API, LoadError) {
   ZenDeleteRuntime(Runtime);
 }
 
+// (func $f0 (export "outer") (param i32) (result i32)
+//   (call $f1 (local.get 0)))
+// (func $f1 (param i32) (result i32) sum of 1..n in a loop)
+static uint8_t NestedLoopWASM[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x03, 0x03, 0x02, 0x00, 0x00, 0x07, 0x09, 0x01,
+    0x05, 0x6f, 0x75, 0x74, 0x65, 0x72, 0x00, 0x00, 0x0a, 0x22, 0x02, 0x06,
+    0x00, 0x20, 0x00, 0x10, 0x01, 0x0b, 0x19, 0x01, 0x01, 0x7f, 0x03, 0x40,
+    0x20, 0x01, 0x20, 0x00, 0x6a, 0x21, 0x01, 0x20, 0x00, 0x41, 0x01, 0x6b,
+    0x22, 0x00, 0x0d, 0x00, 0x0b, 0x20, 0x01, 0x0b,
+};
+
+TEST(C_API, ModuleStream) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+
+  // Every split of the sections and function bodies must load
+  for (uint32_t ChunkSize = 1; ChunkSize <= 8; ++ChunkSize) {
+    ZenModuleStreamRef Stream =
+        ZenCreateModuleStream(Runtime, "stream", sizeof(NestedLoopWASM));
+    ASSERT_NE(Stream, nullptr);
+    for (uint32_t Offset = 0; Offset < sizeof(NestedLoopWASM);
+         Offset += ChunkSize) {
+      uint32_t Size =
+          std::min<uint32_t>(ChunkSize, sizeof(NestedLoopWASM) - Offset);
+      ASSERT_TRUE(ZenFeedModuleStream(Stream, NestedLoopWASM + Offset, Size,
+                                      ErrBuf, ErrBufSize))
+          << ErrBuf;
+    }
+    ZenModuleRef Module = ZenFinishModuleStream(Stream, ErrBuf, ErrBufSize);
+    ZenDeleteModuleStream(Stream);
+    ASSERT_NE(Module, nullptr) << ErrBuf;
+
+    ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+    ZenInstanceRef Instance =
+        ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+    ASSERT_NE(Instance, nullptr);
+    const char *Args[] = {"10"};
+    ZenValue Results[1];
+    uint32_t NumResults = 0;
+    EXPECT_TRUE(ZenCallWasmFuncByName(Runtime, Instance, "outer", Args, 1,
+                                      Results, &NumResults));
+    EXPECT_EQ(Results[0].Value.I32, 55);
+    EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+    EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+    EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  }
+
+  // Truncated module
+  ZenModuleStreamRef Stream =
+      ZenCreateModuleStream(Runtime, "stream", sizeof(NestedLoopWASM));
+  EXPECT_TRUE(ZenFeedModuleStream(Stream, NestedLoopWASM,
+                                  sizeof(NestedLoopWASM) - 1, ErrBuf,
+                                  ErrBufSize));
+  EXPECT_EQ(ZenFinishModuleStream(Stream, ErrBuf, ErrBufSize), nullptr);
+  EXPECT_STREQ(ErrBuf, "load error: unexpected end");
+  ZenDeleteModuleStream(Stream);
+
+  // Invalid byte code is reported by the chunk completing the function
+  static uint8_t InvalidBuffer[sizeof(NestedLoopWASM)];
+  std::memcpy(InvalidBuffer, NestedLoopWASM, sizeof(NestedLoopWASM));
+  InvalidBuffer[sizeof(NestedLoopWASM) - 3] = 0xff;
+  Stream = ZenCreateModuleStream(Runtime, "stream", sizeof(InvalidBuffer));
+  EXPECT_TRUE(ZenFeedModuleStream(Stream, InvalidBuffer, 40, ErrBuf,
+                                  ErrBufSize));
+  EXPECT_FALSE(ZenFeedModuleStream(Stream, InvalidBuffer + 40,
+                                   sizeof(InvalidBuffer) - 40, ErrBuf,
+                                   ErrBufSize));
+  EXPECT_EQ(ZenFinishModuleStream(Stream, ErrBuf, ErrBufSize), nullptr);
+  ZenDeleteModuleStream(Stream);
+
+  ZenDeleteRuntime(Runtime);
+}
+
+TEST(C_API, ParallelValidation) {
+  ZenRuntimeConfig Config = RuntimeConfig;
+  Config.NumLoaderThreads = 4;
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&Config);
+  ASSERT_NE(Runtime, nullptr);
+  ZenRuntimeRef SerialRuntime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(SerialRuntime, nullptr);
+
+  // three functions of type [] -> [], the second adds without operands and
+  // the third has an invalid opcode
+  static uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01,
+      0x60, 0x00, 0x00, 0x03, 0x04, 0x03, 0x00, 0x00, 0x00, 0x0a, 0x0c,
+      0x03, 0x02, 0x00, 0x0b, 0x03, 0x00, 0x6a, 0x0b, 0x03, 0x00, 0xff,
+      0x0b,
+  };
+  char ErrBuf[128] = {0};
+  char SerialErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  // the first invalid function is reported, as in serial loading
+  EXPECT_EQ(ZenLoadModuleFromBuffer(Runtime, "invalid", WASMBuffer,
+                                    sizeof(WASMBuffer), ErrBuf, ErrBufSize),
+            nullptr);
+  EXPECT_EQ(ZenLoadModuleFromBuffer(SerialRuntime, "invalid", WASMBuffer,
+                                    sizeof(WASMBuffer), SerialErrBuf,
+                                    ErrBufSize),
+            nullptr);
+  EXPECT_STRNE(ErrBuf, "");
+  EXPECT_STREQ(ErrBuf, SerialErrBuf);
+
+  // i32.add -> nop, unknown -> nop
+  WASMBuffer[28] = 0x01;
+  WASMBuffer[32] = 0x01;
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "valid", WASMBuffer, sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+  EXPECT_NE(Module, nullptr);
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+
+  ZenDeleteRuntime(SerialRuntime);
+  ZenDeleteRuntime(Runtime);
+}
+
+TEST(C_API, LazyValidation) {
+  ZenRuntimeConfig Config = RuntimeConfig;
+  Config.Mode = ZenModeInterp;
+  ZenRuntimeRef StrictRuntime = ZenCreateRuntime(&Config);
+  ASSERT_NE(StrictRuntime, nullptr);
+  Config.EnableLazyValidation = true;
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&Config);
+  ASSERT_NE(Runtime, nullptr);
+
+  // (func (export "ok") (result i32) (drop (i64.const 5)) (i32.const 7))
+  // (func (export "bad") i32.add)
+  static const uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x02,
+      0x60, 0x00, 0x01, 0x7f, 0x60, 0x00, 0x00, 0x03, 0x03, 0x02, 0x00,
+      0x01, 0x07, 0x0c, 0x02, 0x02, 0x6f, 0x6b, 0x00, 0x00, 0x03, 0x62,
+      0x61, 0x64, 0x00, 0x01, 0x0a, 0x0d, 0x02, 0x07, 0x00, 0x42, 0x05,
+      0x1a, 0x41, 0x07, 0x0b, 0x03, 0x00, 0x6a, 0x0b,
+  };
+  char LoadErrBuf[128] = {0};
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  EXPECT_EQ(ZenLoadModuleFromBuffer(StrictRuntime, "lazy", WASMBuffer,
+                                    sizeof(WASMBuffer), LoadErrBuf,
+                                    ErrBufSize),
+            nullptr);
+
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "lazy", WASMBuffer, sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByName(Runtime, Instance, "ok", nullptr, 0,
+                                    Results, &NumResults));
+  EXPECT_EQ(Results[0].Value.I32, 7);
+
+  // the invalid function fails on every call with the error of strict loading
+  for (int I = 0; I < 2; ++I) {
+    EXPECT_FALSE(ZenCallWasmFuncByName(Runtime, Instance, "bad", nullptr, 0,
+                                       Results, &NumResults));
+    EXPECT_TRUE(ZenGetInstanceError(Instance, ErrBuf, ErrBufSize));
+    EXPECT_STREQ(ErrBuf, LoadErrBuf);
+    ZenClearInstanceError(Instance);
+  }
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+
+  // malformed bodies are still rejected at load with the error of strict
+  // loading: i32.add -> unknown opcode
+  uint8_t MalformedBuffer[sizeof(WASMBuffer)];
+  std::memcpy(MalformedBuffer, WASMBuffer, sizeof(WASMBuffer));
+  MalformedBuffer[50] = 0x06;
+  EXPECT_EQ(ZenLoadModuleFromBuffer(StrictRuntime, "malformed", MalformedBuffer,
+                                    sizeof(MalformedBuffer), LoadErrBuf,
+                                    ErrBufSize),
+            nullptr);
+  EXPECT_EQ(ZenLoadModuleFromBuffer(Runtime, "malformed", MalformedBuffer,
+                                    sizeof(MalformedBuffer), ErrBuf,
+                                    ErrBufSize),
+            nullptr);
+  EXPECT_STREQ(ErrBuf, LoadErrBuf);
+
+  ZenDeleteRuntime(Runtime);
+  ZenDeleteRuntime(StrictRuntime);
+}
+
+TEST(C_API, LoadReadOnlyFile) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  // (func (export "f") (param i64) (result i32)
+  //   (drop (local.get 0)) (i32.const 7))
+  static const uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x06,
+      0x01, 0x60, 0x01, 0x7e, 0x01, 0x7f, 0x03, 0x02, 0x01, 0x00,
+      0x07, 0x05, 0x01, 0x01, 0x66, 0x00, 0x00, 0x0a, 0x09, 0x01,
+      0x07, 0x00, 0x20, 0x00, 0x1a, 0x41, 0x07, 0x0b,
+  };
+  const char *WASMFile = "c_api_read_only.wasm";
+  FILE *File = std::fopen(WASMFile, "wb");
+  ASSERT_NE(File, nullptr);
+  ASSERT_EQ(std::fwrite(WASMBuffer, 1, sizeof(WASMBuffer), File),
+            sizeof(WASMBuffer));
+  std::fclose(File);
+  ASSERT_EQ(::chmod(WASMFile, S_IRUSR), 0);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module =
+      ZenLoadModuleFromFile(Runtime, WASMFile, ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Arg;
+  Arg.Type = ZenTypeI64;
+  Arg.Value.I64 = 1;
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, 0, &Arg, 1, Results,
+                                   &NumResults));
+  EXPECT_EQ(Results[0].Value.I32, 7);
+
+  // loading never writes through to the file
+  uint8_t FileBuffer[sizeof(WASMBuffer)];
+  File = std::fopen(WASMFile, "rb");
+  ASSERT_NE(File, nullptr);
+  EXPECT_EQ(std::fread(FileBuffer, 1, sizeof(FileBuffer), File),
+            sizeof(FileBuffer));
+  std::fclose(File);
+  std::remove(WASMFile);
+  EXPECT_EQ(std::memcmp(FileBuffer, WASMBuffer, sizeof(WASMBuffer)), 0);
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+
 TEST(C_API, Trap) {
   ZenEnableLogging();
   ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
@@ -163,6 +423,824 @@ TEST(C_API, Trap) {
   ZenDeleteRuntime(Runtime);
 }
 
+#ifdef ZEN_ENABLE_SINGLEPASS_JIT
+TEST(C_API, SinglepassConstantFolding) {
+  // Function #I applies Cases[I].Op to two constants and returns the result,
+  // singlepass folds it at compile time and the interpreter evaluates it
+  static const uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x09, 0x02, 0x60,
+      0x00, 0x01, 0x7f, 0x60, 0x00, 0x01, 0x7e, 0x03, 0x25, 0x24, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00,
+      0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+      0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0xcf,
+      0x01, 0x24, 0x02, 0x66, 0x30, 0x00, 0x00, 0x02, 0x66, 0x31, 0x00, 0x01,
+      0x02, 0x66, 0x32, 0x00, 0x02, 0x02, 0x66, 0x33, 0x00, 0x03, 0x02, 0x66,
+      0x34, 0x00, 0x04, 0x02, 0x66, 0x35, 0x00, 0x05, 0x02, 0x66, 0x36, 0x00,
+      0x06, 0x02, 0x66, 0x37, 0x00, 0x07, 0x02, 0x66, 0x38, 0x00, 0x08, 0x02,
+      0x66, 0x39, 0x00, 0x09, 0x03, 0x66, 0x31, 0x30, 0x00, 0x0a, 0x03, 0x66,
+      0x31, 0x31, 0x00, 0x0b, 0x03, 0x66, 0x31, 0x32, 0x00, 0x0c, 0x03, 0x66,
+      0x31, 0x33, 0x00, 0x0d, 0x03, 0x66, 0x31, 0x34, 0x00, 0x0e, 0x03, 0x66,
+      0x31, 0x35, 0x00, 0x0f, 0x03, 0x66, 0x31, 0x36, 0x00, 0x10, 0x03, 0x66,
+      0x31, 0x37, 0x00, 0x11, 0x03, 0x66, 0x31, 0x38, 0x00, 0x12, 0x03, 0x66,
+      0x31, 0x39, 0x00, 0x13, 0x03, 0x66, 0x32, 0x30, 0x00, 0x14, 0x03, 0x66,
+      0x32, 0x31, 0x00, 0x15, 0x03, 0x66, 0x32, 0x32, 0x00, 0x16, 0x03, 0x66,
+      0x32, 0x33, 0x00, 0x17, 0x03, 0x66, 0x32, 0x34, 0x00, 0x18, 0x03, 0x66,
+      0x32, 0x35, 0x00, 0x19, 0x03, 0x66, 0x32, 0x36, 0x00, 0x1a, 0x03, 0x66,
+      0x32, 0x37, 0x00, 0x1b, 0x03, 0x66, 0x32, 0x38, 0x00, 0x1c, 0x03, 0x66,
+      0x32, 0x39, 0x00, 0x1d, 0x03, 0x66, 0x33, 0x30, 0x00, 0x1e, 0x03, 0x66,
+      0x33, 0x31, 0x00, 0x1f, 0x03, 0x66, 0x33, 0x32, 0x00, 0x20, 0x03, 0x66,
+      0x33, 0x33, 0x00, 0x21, 0x03, 0x66, 0x33, 0x34, 0x00, 0x22, 0x03, 0x66,
+      0x33, 0x35, 0x00, 0x23, 0x0a, 0xeb, 0x02, 0x24, 0x0b, 0x00, 0x41, 0x80,
+      0x80, 0x80, 0x80, 0x78, 0x41, 0x7f, 0x6d, 0x0b, 0x0b, 0x00, 0x41, 0x80,
+      0x80, 0x80, 0x80, 0x78, 0x41, 0x7f, 0x6f, 0x0b, 0x07, 0x00, 0x41, 0x07,
+      0x41, 0x00, 0x6d, 0x0b, 0x07, 0x00, 0x41, 0x07, 0x41, 0x00, 0x6e, 0x0b,
+      0x07, 0x00, 0x41, 0x07, 0x41, 0x00, 0x6f, 0x0b, 0x07, 0x00, 0x41, 0x07,
+      0x41, 0x00, 0x70, 0x0b, 0x10, 0x00, 0x42, 0x80, 0x80, 0x80, 0x80, 0x80,
+      0x80, 0x80, 0x80, 0x80, 0x7f, 0x42, 0x7f, 0x7f, 0x0b, 0x10, 0x00, 0x42,
+      0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x7f, 0x42, 0x7f,
+      0x81, 0x0b, 0x0b, 0x00, 0x42, 0x80, 0x80, 0x80, 0x80, 0x78, 0x42, 0x7f,
+      0x7f, 0x0b, 0x0b, 0x00, 0x42, 0x80, 0x80, 0x80, 0x80, 0x78, 0x42, 0x7f,
+      0x81, 0x0b, 0x07, 0x00, 0x42, 0x07, 0x42, 0x00, 0x7f, 0x0b, 0x07, 0x00,
+      0x42, 0x07, 0x42, 0x00, 0x82, 0x0b, 0x07, 0x00, 0x41, 0x01, 0x41, 0x20,
+      0x74, 0x0b, 0x07, 0x00, 0x41, 0x01, 0x41, 0x21, 0x74, 0x0b, 0x0b, 0x00,
+      0x41, 0x80, 0x80, 0x80, 0x80, 0x78, 0x41, 0x3f, 0x75, 0x0b, 0x07, 0x00,
+      0x41, 0x7f, 0x41, 0x7f, 0x76, 0x0b, 0x0b, 0x00, 0x41, 0x81, 0x80, 0x80,
+      0x80, 0x78, 0x41, 0x20, 0x77, 0x0b, 0x07, 0x00, 0x41, 0x01, 0x41, 0x61,
+      0x78, 0x0b, 0x08, 0x00, 0x42, 0x01, 0x42, 0xc0, 0x00, 0x86, 0x0b, 0x07,
+      0x00, 0x42, 0x01, 0x42, 0x28, 0x86, 0x0b, 0x0c, 0x00, 0x42, 0x80, 0x80,
+      0x80, 0x80, 0x78, 0x42, 0xdf, 0x00, 0x87, 0x0b, 0x07, 0x00, 0x42, 0x7f,
+      0x42, 0x7f, 0x88, 0x0b, 0x0c, 0x00, 0x42, 0x80, 0x80, 0x80, 0x80, 0x78,
+      0x42, 0xc0, 0x00, 0x89, 0x0b, 0x08, 0x00, 0x42, 0x01, 0x42, 0xc1, 0x00,
+      0x8a, 0x0b, 0x0f, 0x00, 0x42, 0xff, 0xff, 0xff, 0xff, 0x07, 0x42, 0xff,
+      0xff, 0xff, 0xff, 0x07, 0x7e, 0x0b, 0x0b, 0x00, 0x42, 0xff, 0xff, 0xff,
+      0xff, 0x07, 0x42, 0x01, 0x7c, 0x0b, 0x0b, 0x00, 0x42, 0x80, 0x80, 0x80,
+      0x80, 0x78, 0x42, 0x01, 0x7d, 0x0b, 0x07, 0x00, 0x42, 0x7f, 0x42, 0x02,
+      0x80, 0x0b, 0x07, 0x00, 0x42, 0x7f, 0x42, 0x07, 0x82, 0x0b, 0x07, 0x00,
+      0x41, 0x7f, 0x41, 0x01, 0x49, 0x0b, 0x07, 0x00, 0x41, 0x7f, 0x41, 0x01,
+      0x4a, 0x0b, 0x05, 0x00, 0x41, 0x00, 0x45, 0x0b, 0x07, 0x00, 0x42, 0x7f,
+      0x42, 0x01, 0x54, 0x0b, 0x07, 0x00, 0x42, 0x7f, 0x42, 0x01, 0x53, 0x0b,
+      0x0f, 0x00, 0x42, 0x80, 0x80, 0x80, 0x80, 0x78, 0x42, 0xff, 0xff, 0xff,
+      0xff, 0x07, 0x5a, 0x0b, 0x05, 0x00, 0x42, 0x00, 0x50, 0x0b,
+  };
+  static const struct {
+    const char *Op;
+    // Sign-extended for i32 results
+    int64_t Expected;
+    const char *Trap;
+  } Cases[] = {
+      {"i32.div_s -2147483648 -1", 0, "integer overflow"},
+      {"i32.rem_s -2147483648 -1", 0, nullptr},
+      {"i32.div_s 7 0", 0, "integer divide by zero"},
+      {"i32.div_u 7 0", 0, "integer divide by zero"},
+      {"i32.rem_s 7 0", 0, "integer divide by zero"},
+      {"i32.rem_u 7 0", 0, "integer divide by zero"},
+      {"i64.div_s INT64_MIN -1", 0, "integer overflow"},
+      {"i64.rem_s INT64_MIN -1", 0, nullptr},
+      {"i64.div_s -2147483648 -1", 2147483648LL, nullptr},
+      {"i64.rem_s -2147483648 -1", 0, nullptr},
+      {"i64.div_s 7 0", 0, "integer divide by zero"},
+      {"i64.rem_u 7 0", 0, "integer divide by zero"},
+      {"i32.shl 1 32", 1, nullptr},
+      {"i32.shl 1 33", 2, nullptr},
+      {"i32.shr_s -2147483648 63", -1, nullptr},
+      {"i32.shr_u -1 -1", 1, nullptr},
+      {"i32.rotl -2147483647 32", -2147483647, nullptr},
+      {"i32.rotr 1 -31", INT32_MIN, nullptr},
+      {"i64.shl 1 64", 1, nullptr},
+      {"i64.shl 1 40", 1099511627776LL, nullptr},
+      {"i64.shr_s -2147483648 95", -1, nullptr},
+      {"i64.shr_u -1 -1", 1, nullptr},
+      {"i64.rotl -2147483648 64", INT32_MIN, nullptr},
+      {"i64.rotr 1 65", INT64_MIN, nullptr},
+      {"i64.mul 2147483647 2147483647", 4611686014132420609LL, nullptr},
+      {"i64.add 2147483647 1", 2147483648LL, nullptr},
+      {"i64.sub -2147483648 1", -2147483649LL, nullptr},
+      {"i64.div_u -1 2", INT64_MAX, nullptr},
+      {"i64.rem_u -1 7", 1, nullptr},
+      {"i32.lt_u -1 1", 0, nullptr},
+      {"i32.gt_s -1 1", 0, nullptr},
+      {"i32.eqz 0", 1, nullptr},
+      {"i64.lt_u -1 1", 0, nullptr},
+      {"i64.lt_s -1 1", 1, nullptr},
+      {"i64.ge_u -2147483648 2147483647", 1, nullptr},
+      {"i64.eqz 0", 1, nullptr},
+  };
+
+  ZenRuntimeConfig Config = RuntimeConfig;
+  Config.Mode = ZenModeInterp;
+  ZenRuntimeRef Runtimes[] = {ZenCreateRuntime(&RuntimeConfig),
+                              ZenCreateRuntime(&Config)};
+  ZenModuleRef Modules[2];
+  ZenIsolationRef Isolations[2];
+  ZenInstanceRef Instances[2];
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  for (int M = 0; M < 2; ++M) {
+    ASSERT_NE(Runtimes[M], nullptr);
+    Modules[M] =
+        ZenLoadModuleFromBuffer(Runtimes[M], "fold", WASMBuffer,
+                                sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+    ASSERT_NE(Modules[M], nullptr);
+    Isolations[M] = ZenCreateIsolation(Runtimes[M]);
+    Instances[M] =
+        ZenCreateInstance(Isolations[M], Modules[M], ErrBuf, ErrBufSize);
+    ASSERT_NE(Instances[M], nullptr);
+  }
+
+  for (uint32_t I = 0; I < std::size(Cases); ++I) {
+    SCOPED_TRACE(Cases[I].Op);
+    std::string Outcomes[2];
+    for (int M = 0; M < 2; ++M) {
+      ZenValue Results[1];
+      uint32_t NumResults = 0;
+      if (ZenCallWasmFuncByIdx(Runtimes[M], Instances[M], I, nullptr, 0,
+                               Results, &NumResults)) {
+        ASSERT_EQ(NumResults, 1u);
+        int64_t Result = Results[0].Type == ZenTypeI64 ? Results[0].Value.I64
+                                                       : Results[0].Value.I32;
+        Outcomes[M] = std::to_string(Result);
+      } else {
+        EXPECT_TRUE(ZenGetInstanceError(Instances[M], ErrBuf, ErrBufSize));
+        Outcomes[M] = ErrBuf;
+        ZenClearInstanceError(Instances[M]);
+      }
+    }
+    EXPECT_EQ(Outcomes[0], Outcomes[1]);
+    EXPECT_EQ(Outcomes[0], Cases[I].Trap ? std::string("execution error: ") +
+                                               Cases[I].Trap
+                                         : std::to_string(Cases[I].Expected));
+  }
+
+  for (int M = 0; M < 2; ++M) {
+    EXPECT_TRUE(ZenDeleteInstance(Isolations[M], Instances[M]));
+    EXPECT_TRUE(ZenDeleteIsolation(Runtimes[M], Isolations[M]));
+    EXPECT_TRUE(ZenDeleteModule(Runtimes[M], Modules[M]));
+    ZenDeleteRuntime(Runtimes[M]);
+  }
+}
+#endif // ZEN_ENABLE_SINGLEPASS_JIT
+
+static uint32_t NumRaiseFrameDestroyed = 0;
+
+static void envRaise(ZenInstanceRef Instance, int32_t Abort) {
+  // the frame of the host function must be destroyed normally when raising
+  struct FrameObject {
+    ~FrameObject() { ++NumRaiseFrameDestroyed; }
+  } Object;
+  if (Abort != 0) {
+    ZenSetInstanceExceptionByHostapi(Instance, ZenGetErrCodeEnvAbort());
+  }
+}
+
+TEST(C_API, HostException) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  ZenType ArgTypesI32[] = {ZenTypeI32};
+  ZenHostFuncDesc HostFuncDescs[] = {
+      {
+          .Name = "raise",
+          .NumArgs = 1,
+          .ArgTypes = ArgTypesI32,
+          .NumReturns = 0,
+          .RetTypes = NULL,
+          .Ptr = (void *)envRaise,
+      },
+  };
+  ZenHostModuleDescRef HostModuleDesc =
+      ZenCreateHostModuleDesc(Runtime, "env", HostFuncDescs, 1);
+  ZenHostModuleRef HostModule = ZenLoadHostModule(Runtime, HostModuleDesc);
+  ASSERT_NE(HostModule, nullptr);
+
+  // (import "env" "raise" (func $raise (param i32)))
+  // (func (export "run") (param i32) (result i32)
+  //   (call $raise (local.get 0)) (i32.const 7))
+  static uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x0a, 0x02, 0x60,
+      0x01, 0x7f, 0x00, 0x60, 0x01, 0x7f, 0x01, 0x7f, 0x02, 0x0d, 0x01, 0x03,
+      0x65, 0x6e, 0x76, 0x05, 0x72, 0x61, 0x69, 0x73, 0x65, 0x00, 0x00, 0x03,
+      0x02, 0x01, 0x01, 0x07, 0x07, 0x01, 0x03, 0x72, 0x75, 0x6e, 0x00, 0x01,
+      0x0a, 0x0a, 0x01, 0x08, 0x00, 0x20, 0x00, 0x10, 0x00, 0x41, 0x07, 0x0b,
+  };
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "test", WASMBuffer, sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t FuncIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "run", &FuncIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Args[1] = {{.Type = ZenTypeI32, .Value = {.I32 = 0}}};
+  ZenValue Results[1];
+  uint32_t NumOutResults = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, Args, 1,
+                                   Results, &NumOutResults));
+  EXPECT_EQ(NumOutResults, 1);
+  EXPECT_EQ(Results[0].Value.I32, 7);
+
+  Args[0].Value.I32 = 1;
+  EXPECT_FALSE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, Args, 1,
+                                    Results, &NumOutResults));
+  EXPECT_TRUE(ZenGetInstanceError(Instance, ErrBuf, ErrBufSize));
+  EXPECT_STREQ(ErrBuf, "execution error: env.abort");
+  EXPECT_EQ(NumRaiseFrameDestroyed, 2u);
+
+  // the instance is still usable after the exception
+  ZenClearInstanceError(Instance);
+  Args[0].Value.I32 = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, Args, 1,
+                                   Results, &NumOutResults));
+  EXPECT_EQ(Results[0].Value.I32, 7);
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  EXPECT_TRUE(ZenDeleteHostModule(Runtime, HostModule));
+  ZenDeleteHostModuleDesc(Runtime, HostModuleDesc);
+  ZenDeleteRuntime(Runtime);
+}
+
+// (func (export "add") (param i32 i32) (result i32)
+//   (i32.add (local.get 0) (local.get 1)))
+// (func (export "div") (param i32 i32) (result i32)
+//   (i32.div_u (local.get 0) (local.get 1)))
+static uint8_t AddDivWASM[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x07, 0x01, 0x60,
+    0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x03, 0x03, 0x02, 0x00, 0x00, 0x07, 0x0d,
+    0x02, 0x03, 0x61, 0x64, 0x64, 0x00, 0x00, 0x03, 0x64, 0x69, 0x76, 0x00,
+    0x01, 0x0a, 0x11, 0x02, 0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6a, 0x0b,
+    0x07, 0x00, 0x20, 0x00, 0x20, 0x01, 0x6e, 0x0b,
+};
+
+TEST(C_API, BatchCall) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  EXPECT_NE(Runtime, nullptr);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "test", AddDivWASM, sizeof(AddDivWASM), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t AddIdx = 0, DivIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "add", &AddIdx));
+  ASSERT_TRUE(ZenGetExportFunc(Module, "div", &DivIdx));
+
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  constexpr uint32_t NumCalls = 8;
+  ZenValue Args[NumCalls][2];
+  ZenValue Results[NumCalls][1];
+  ZenWasmCall Calls[NumCalls];
+  for (uint32_t I = 0; I < NumCalls; ++I) {
+    Args[I][0].Type = Args[I][1].Type = ZenTypeI32;
+    Args[I][0].Value.I32 = 100;
+    Args[I][1].Value.I32 = I;
+    Calls[I] = {
+        .Instance = Instance,
+        .FuncIdx = I % 2 ? AddIdx : DivIdx,
+        .InArgs = Args[I],
+        .NumInArgs = 2,
+        .OutResults = Results[I],
+        .NumOutResults = 0,
+        .Success = false,
+    };
+  }
+  // the trap of 100 / 0 must not affect the following calls
+  EXPECT_EQ(ZenCallWasmFuncsByIdx(Runtime, Calls, NumCalls), NumCalls - 1);
+  EXPECT_FALSE(Calls[0].Success);
+  for (uint32_t I = 1; I < NumCalls; ++I) {
+    EXPECT_TRUE(Calls[I].Success);
+    EXPECT_EQ(Calls[I].NumOutResults, 1);
+    EXPECT_EQ(Results[I][0].Value.I32, I % 2 ? 100 + I : 100 / I);
+  }
+
+  // a trap in the last call is left on the instance
+  Args[0][1].Value.I32 = 0;
+  Calls[0].FuncIdx = DivIdx;
+  EXPECT_EQ(ZenCallWasmFuncsByIdx(Runtime, Calls + 1, 1), 1);
+  EXPECT_EQ(ZenCallWasmFuncsByIdx(Runtime, Calls, 1), 0);
+  EXPECT_TRUE(ZenGetInstanceError(Instance, ErrBuf, ErrBufSize));
+  EXPECT_STREQ(ErrBuf, "execution error: integer divide by zero");
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+
+// (type $i2i (func (param i32) (result i32)))
+// (type $v2i (func (result i32)))
+// (type $i2i_dup (func (param i32) (result i32)))
+// (table 3 funcref)
+// (elem (i32.const 0) $inc $answer)
+// (func $inc (type $i2i) (i32.add (local.get 0) (i32.const 1)))
+// (func $answer (type $v2i) (i32.const 42))
+// (func (export "call") (param i32 i32) (result i32)
+//   (call_indirect (type $i2i_dup) (local.get 1) (local.get 0)))
+static uint8_t CallIndirectWASM[] = {
+    0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x15, 0x04, 0x60,
+    0x01, 0x7f, 0x01, 0x7f, 0x60, 0x00, 0x01, 0x7f, 0x60, 0x01, 0x7f, 0x01,
+    0x7f, 0x60, 0x02, 0x7f, 0x7f, 0x01, 0x7f, 0x03, 0x04, 0x03, 0x00, 0x01,
+    0x03, 0x04, 0x04, 0x01, 0x70, 0x00, 0x03, 0x07, 0x08, 0x01, 0x04, 0x63,
+    0x61, 0x6c, 0x6c, 0x00, 0x02, 0x09, 0x08, 0x01, 0x00, 0x41, 0x00, 0x0b,
+    0x02, 0x00, 0x01, 0x0a, 0x18, 0x03, 0x07, 0x00, 0x20, 0x00, 0x41, 0x01,
+    0x6a, 0x0b, 0x04, 0x00, 0x41, 0x2a, 0x0b, 0x09, 0x00, 0x20, 0x01, 0x20,
+    0x00, 0x11, 0x02, 0x00, 0x0b,
+};
+
+TEST(C_API, CallIndirect) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  EXPECT_NE(Runtime, nullptr);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module =
+      ZenLoadModuleFromBuffer(Runtime, "test", CallIndirectWASM,
+                              sizeof(CallIndirectWASM), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t CallIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "call", &CallIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Args[2];
+  Args[0].Type = Args[1].Type = ZenTypeI32;
+  Args[1].Value.I32 = 5;
+  ZenValue Results[1];
+  uint32_t NumOutResults;
+
+  // the types of the table element and the call site only match structurally
+  Args[0].Value.I32 = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, CallIdx, Args, 2,
+                                   Results, &NumOutResults));
+  EXPECT_EQ(NumOutResults, 1);
+  EXPECT_EQ(Results[0].Value.I32, 6);
+
+  const char *Errors[] = {
+      "execution error: indirect call type mismatch",
+      "execution error: uninitialized element",
+      "execution error: undefined element",
+  };
+  for (uint32_t I = 0; I < 3; ++I) {
+    Args[0].Value.I32 = I + 1;
+    EXPECT_FALSE(ZenCallWasmFuncByIdx(Runtime, Instance, CallIdx, Args, 2,
+                                      Results, &NumOutResults));
+    EXPECT_TRUE(ZenGetInstanceError(Instance, ErrBuf, ErrBufSize));
+    EXPECT_STREQ(ErrBuf, Errors[I]);
+    ZenClearInstanceError(Instance);
+  }
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+
+TEST(CXX_API, TypedFunction) {
+  runtime::RuntimeConfig Config;
+  Config.Mode = static_cast<RunMode>(RuntimeConfig.Mode);
+  Config.DisableWASI = true;
+  auto RT = runtime::Runtime::newRuntime(Config);
+  ASSERT_NE(RT, nullptr);
+  auto ModOrErr = RT->loadModule("test", AddDivWASM, sizeof(AddDivWASM));
+  ASSERT_TRUE(ModOrErr);
+  runtime::Isolation *Iso = RT->createManagedIsolation();
+  auto InstOrErr = Iso->createInstance(**ModOrErr);
+  ASSERT_TRUE(InstOrErr);
+  runtime::Instance *Inst = *InstOrErr;
+
+  runtime::TypedFunction<int32_t(int32_t, int32_t)> Add;
+  ASSERT_TRUE(Inst->getTypedFunction("add", Add));
+  int32_t Sum = 0;
+  EXPECT_TRUE(Add.call(Sum, 40, 2));
+  EXPECT_EQ(Sum, 42);
+
+  runtime::TypedFunction<uint32_t(uint32_t, uint32_t)> Div;
+  ASSERT_TRUE(Inst->getTypedFunction("div", Div));
+  uint32_t Quot = 0;
+  EXPECT_TRUE(Div.call(Quot, 0xfffffffe, 2));
+  EXPECT_EQ(Quot, 0x7fffffffu);
+  EXPECT_FALSE(Div.call(Quot, 1, 0));
+  EXPECT_EQ(Inst->getError().getCode(), ErrorCode::IntegerDivByZero);
+  Inst->clearError();
+
+  runtime::TypedFunction<int64_t(int32_t, int32_t)> WrongResult;
+  EXPECT_FALSE(Inst->getTypedFunction("add", WrongResult));
+  EXPECT_EQ(Inst->getError().getCode(), ErrorCode::UnexpectedFuncType);
+  runtime::TypedFunction<int32_t(int32_t)> WrongNumArgs;
+  EXPECT_FALSE(Inst->getTypedFunction("add", WrongNumArgs));
+  EXPECT_EQ(Inst->getError().getCode(), ErrorCode::UnexpectedNumArgs);
+  runtime::TypedFunction<int32_t(int32_t, float)> WrongArg;
+  EXPECT_FALSE(Inst->getTypedFunction("add", WrongArg));
+  EXPECT_EQ(Inst->getError().getCode(), ErrorCode::UnexpectedArgType);
+  runtime::TypedFunction<void()> Missing;
+  EXPECT_FALSE(Inst->getTypedFunction("sub", Missing));
+  EXPECT_EQ(Inst->getError().getCode(), ErrorCode::CannotFindFunction);
+  Inst->clearError();
+
+  EXPECT_TRUE(Iso->deleteInstance(Inst));
+  EXPECT_TRUE(RT->deleteManagedIsolation(Iso));
+}
+
+TEST(C_API, Interrupt) {
+  ZenRuntimeConfig Config = RuntimeConfig;
+  Config.EnableInterruption = true;
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&Config);
+  ASSERT_NE(Runtime, nullptr);
+
+  // (func (export "spin") (loop (br 0)))
+  static uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x04, 0x01,
+      0x60, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0x07, 0x08, 0x01, 0x04,
+      0x73, 0x70, 0x69, 0x6e, 0x00, 0x00, 0x0a, 0x09, 0x01, 0x07, 0x00,
+      0x03, 0x40, 0x0c, 0x00, 0x0b, 0x0b,
+  };
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "test", WASMBuffer, sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t FuncIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "spin", &FuncIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  std::thread Timer([Instance] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ZenInterruptInstance(Instance);
+  });
+  uint32_t NumResults = 0;
+  EXPECT_FALSE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, nullptr, 0,
+                                    nullptr, &NumResults));
+  Timer.join();
+  EXPECT_TRUE(ZenGetInstanceError(Instance, ErrBuf, ErrBufSize));
+  EXPECT_STREQ(ErrBuf, "execution error: execution interrupted");
+
+  // a pending request stops the next call right away
+  ZenClearInstanceError(Instance);
+  EXPECT_FALSE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, nullptr, 0,
+                                    nullptr, &NumResults));
+  ZenClearInstanceInterrupt(Instance);
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+
+TEST(C_API, Statistics) {
+  ZenRuntimeConfig Config = RuntimeConfig;
+  ZenPhaseStatistics Stats;
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&Config);
+  ASSERT_NE(Runtime, nullptr);
+  EXPECT_FALSE(ZenGetPhaseStatistics(Runtime, ZenPhaseExecution, &Stats));
+  ZenDeleteRuntime(Runtime);
+
+  Config.EnableStatistics = true;
+  Config.EnableHardwareCounters = true;
+  Runtime = ZenCreateRuntime(&Config);
+  ASSERT_NE(Runtime, nullptr);
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "test", AddDivWASM, sizeof(AddDivWASM), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t AddIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "add", &AddIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Args[2];
+  Args[0].Type = Args[1].Type = ZenTypeI32;
+  Args[0].Value.I32 = Args[1].Value.I32 = 1;
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  for (uint32_t I = 0; I < 3; ++I) {
+    EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, AddIdx, Args, 2,
+                                     Results, &NumResults));
+  }
+  // the counters may be unavailable on this machine, only the records count
+  ASSERT_TRUE(ZenGetPhaseStatistics(Runtime, ZenPhaseLoad, &Stats));
+  EXPECT_EQ(Stats.NumRecords, 1);
+  ASSERT_TRUE(ZenGetPhaseStatistics(Runtime, ZenPhaseExecution, &Stats));
+  EXPECT_EQ(Stats.NumRecords, 3);
+  EXPECT_GE(Stats.TimeCost, 0);
+  EXPECT_FALSE(
+      ZenGetPhaseStatistics(Runtime, static_cast<ZenStatisticPhase>(9), &Stats));
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+TEST(C_API, Profiler) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "prof", NestedLoopWASM, sizeof(NestedLoopWASM), ErrBuf,
+      ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t FuncIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "outer", &FuncIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenProfilerRef Profiler = ZenStartProfiler(Runtime, 1000);
+  ASSERT_NE(Profiler, nullptr);
+  // only one profiler per process
+  EXPECT_EQ(ZenStartProfiler(Runtime, 1000), nullptr);
+  ZenValue Arg;
+  Arg.Type = ZenTypeI32;
+  Arg.Value.I32 = 1000000;
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  // run for at least 100ms of cpu time, so the 1ms timer takes samples
+  std::clock_t Start = std::clock();
+  do {
+    ASSERT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, &Arg, 1,
+                                     Results, &NumResults));
+  } while (std::clock() - Start < CLOCKS_PER_SEC / 10);
+  const char *ProfileFile = "c_api_profile.folded";
+  ASSERT_TRUE(ZenWriteProfile(Profiler, ProfileFile));
+  ZenStopProfiler(Profiler);
+
+  FILE *File = std::fopen(ProfileFile, "r");
+  ASSERT_NE(File, nullptr);
+  char Line[256];
+  bool FoundEntry = false;
+  bool FoundNested = false;
+  while (std::fgets(Line, sizeof(Line), File)) {
+    FoundEntry |= std::strncmp(Line, "prof;$f0", 8) == 0;
+    FoundNested |= std::strncmp(Line, "prof;$f0;$f1 ", 13) == 0;
+  }
+  std::fclose(File);
+  std::remove(ProfileFile);
+  EXPECT_TRUE(FoundEntry);
+  // JIT stacks are only walked with ZEN_ENABLE_DUMP_CALL_STACK, otherwise
+  // only the entry function is reported
+#if defined(ZEN_ENABLE_SINGLEPASS_JIT) && !defined(ZEN_ENABLE_DUMP_CALL_STACK)
+  (void)FoundNested;
+#else
+  EXPECT_TRUE(FoundNested);
+#endif
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+TEST(C_API, BlockProfile) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "blocks", NestedLoopWASM, sizeof(NestedLoopWASM), ErrBuf,
+      ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t FuncIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "outer", &FuncIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  ZenValue Arg;
+  Arg.Type = ZenTypeI32;
+  Arg.Value.I32 = 10;
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  EXPECT_TRUE(ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, &Arg, 1,
+                                   Results, &NumResults));
+  EXPECT_EQ(Results[0].Value.I32, 55);
+  const char *ProfileFile = "c_api_block_profile.txt";
+  ASSERT_TRUE(ZenWriteBlockProfile(Module, ProfileFile));
+
+  FILE *File = std::fopen(ProfileFile, "r");
+  ASSERT_NE(File, nullptr);
+  std::map<uint32_t, std::vector<unsigned long>> BlockCounts;
+  std::map<std::string, unsigned long> OpcodeCounts;
+  char Line[256];
+  while (std::fgets(Line, sizeof(Line), File)) {
+    uint32_t Func;
+    char Name[64];
+    unsigned long Offset, Count;
+    if (std::sscanf(Line, "block %u %63s %lx %lu", &Func, Name, &Offset,
+                    &Count) == 4) {
+      BlockCounts[Func].push_back(Count);
+    } else if (std::sscanf(Line, "opcode %63s %lu", Name, &Count) == 2) {
+      OpcodeCounts[Name] = Count;
+    }
+  }
+  std::fclose(File);
+  std::remove(ProfileFile);
+
+  // entry, loop body, after br_if and after the loop
+  std::vector<unsigned long> ExpectedCounts = {1, 10, 1, 1};
+  EXPECT_EQ(BlockCounts[0], std::vector<unsigned long>{1});
+  EXPECT_EQ(BlockCounts[1], ExpectedCounts);
+  EXPECT_EQ(OpcodeCounts["loop"], 1u);
+  EXPECT_EQ(OpcodeCounts["i32_add"], 10u);
+  EXPECT_EQ(OpcodeCounts["br_if"], 10u);
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  ZenDeleteRuntime(Runtime);
+}
+#endif // ZEN_ENABLE_BLOCK_COUNTERS
+
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+static int32_t PendingValue = 0;
+
+static int32_t envWait(ZenInstanceRef Instance) {
+  EXPECT_TRUE(ZenSuspendCurrentCall());
+  return PendingValue;
+}
+
+TEST(C_API, ResumableCall) {
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&RuntimeConfig);
+  ASSERT_NE(Runtime, nullptr);
+
+  ZenType RetTypesI32[] = {ZenTypeI32};
+  ZenHostFuncDesc HostFuncDescs[] = {
+      {
+          .Name = "wait",
+          .NumArgs = 0,
+          .ArgTypes = NULL,
+          .NumReturns = 1,
+          .RetTypes = RetTypesI32,
+          .Ptr = (void *)envWait,
+      },
+  };
+  ZenHostModuleDescRef HostModuleDesc =
+      ZenCreateHostModuleDesc(Runtime, "env", HostFuncDescs, 1);
+  ZenHostModuleRef HostModule = ZenLoadHostModule(Runtime, HostModuleDesc);
+  ASSERT_NE(HostModule, nullptr);
+
+  // (import "env" "wait" (func $wait (result i32)))
+  // (func (export "run") (result i32) (i32.add (call $wait) (call $wait)))
+  static uint8_t WASMBuffer[] = {
+      0x00, 0x61, 0x73, 0x6d, 0x01, 0x00, 0x00, 0x00, 0x01, 0x05, 0x01,
+      0x60, 0x00, 0x01, 0x7f, 0x02, 0x0c, 0x01, 0x03, 0x65, 0x6e, 0x76,
+      0x04, 0x77, 0x61, 0x69, 0x74, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00,
+      0x07, 0x07, 0x01, 0x03, 0x72, 0x75, 0x6e, 0x00, 0x01, 0x0a, 0x09,
+      0x01, 0x07, 0x00, 0x10, 0x00, 0x10, 0x00, 0x6a, 0x0b,
+  };
+  char ErrBuf[128] = {0};
+  const uint32_t ErrBufSize = sizeof(ErrBuf);
+  ZenModuleRef Module = ZenLoadModuleFromBuffer(
+      Runtime, "test", WASMBuffer, sizeof(WASMBuffer), ErrBuf, ErrBufSize);
+  ASSERT_NE(Module, nullptr);
+  uint32_t FuncIdx = 0;
+  ASSERT_TRUE(ZenGetExportFunc(Module, "run", &FuncIdx));
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, ErrBufSize);
+  ASSERT_NE(Instance, nullptr);
+
+  EXPECT_FALSE(ZenSuspendCurrentCall());
+
+  ZenResumableCallRef Call =
+      ZenCreateResumableCall(Instance, FuncIdx, nullptr, 0);
+  ASSERT_NE(Call, nullptr);
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  EXPECT_EQ(ZenResumeCall(Call, Results, &NumResults), ZenCallSuspended);
+  PendingValue = 40;
+  // the first wait returns on another thread
+  std::thread([&] {
+    EXPECT_EQ(ZenResumeCall(Call, Results, &NumResults), ZenCallSuspended);
+  }).join();
+  PendingValue = 2;
+  EXPECT_EQ(ZenResumeCall(Call, Results, &NumResults), ZenCallFinished);
+  EXPECT_EQ(NumResults, 1);
+  EXPECT_EQ(Results[0].Value.I32, 42);
+  ZenDeleteResumableCall(Call);
+
+  // wrong number of arguments
+  ZenValue Arg = {.Type = ZenTypeI32, .Value = {.I32 = 0}};
+  EXPECT_EQ(ZenCreateResumableCall(Instance, FuncIdx, &Arg, 1), nullptr);
+
+  EXPECT_TRUE(ZenDeleteInstance(Isolation, Instance));
+  EXPECT_TRUE(ZenDeleteIsolation(Runtime, Isolation));
+  EXPECT_TRUE(ZenDeleteModule(Runtime, Module));
+  EXPECT_TRUE(ZenDeleteHostModule(Runtime, HostModule));
+  ZenDeleteHostModuleDesc(Runtime, HostModuleDesc);
+  ZenDeleteRuntime(Runtime);
+}
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+
+struct TestStateStore {
+  std::map<std::string, std::string> Data;
+  uint32_t NumCommits = 0;
+};
+
+static bool testStateLoad(void *Ctx, const uint8_t *Key, uint32_t KeyLen,
+                          const uint8_t **Value, uint32_t *ValueLen) {
+  auto *Store = static_cast<TestStateStore *>(Ctx);
+  auto It = Store->Data.find(std::string((const char *)Key, KeyLen));
+  if (It == Store->Data.end()) {
+    return false;
+  }
+  *Value = reinterpret_cast<const uint8_t *>(It->second.data());
+  *ValueLen = It->second.size();
+  return true;
+}
+
+static void testStateCommit(void *Ctx, const ZenStateWrite *Writes,
+                            uint32_t NumWrites) {
+  auto *Store = static_cast<TestStateStore *>(Ctx);
+  ++Store->NumCommits;
+  for (uint32_t I = 0; I < NumWrites; ++I) {
+    std::string Key((const char *)Writes[I].Key, Writes[I].KeyLen);
+    if (Writes[I].Value) {
+      Store->Data[Key].assign((const char *)Writes[I].Value,
+                              Writes[I].ValueLen);
+    } else {
+      Store->Data.erase(Key);
+    }
+  }
+}
+
+static std::string getState(ZenStateJournalRef Journal, const char *Key) {
+  const uint8_t *Value = nullptr;
+  uint32_t ValueLen = 0;
+  if (!ZenStateJournalGet(Journal, (const uint8_t *)Key, strlen(Key), &Value,
+                          &ValueLen)) {
+    return "<none>";
+  }
+  return std::string((const char *)Value, ValueLen);
+}
+
+static void setState(ZenStateJournalRef Journal, const char *Key,
+                     const char *Value) {
+  ZenStateJournalSet(Journal, (const uint8_t *)Key, strlen(Key),
+                     (const uint8_t *)Value, strlen(Value));
+}
+
+TEST(C_API, StateJournal) {
+  TestStateStore Store;
+  Store.Data["a"] = "1";
+  ZenStateBackend Backend = {&Store, testStateLoad, testStateCommit};
+  ZenStateJournalRef Journal = ZenCreateStateJournal(&Backend);
+
+  EXPECT_EQ(getState(Journal, "a"), "1");
+  setState(Journal, "b", "2");
+  uint32_t Outer = ZenStateJournalCheckpoint(Journal);
+  setState(Journal, "a", "10");
+  uint32_t Inner = ZenStateJournalCheckpoint(Journal);
+  ZenStateJournalDelete(Journal, (const uint8_t *)"b", 1);
+  setState(Journal, "c", "3");
+  EXPECT_EQ(getState(Journal, "b"), "<none>");
+  ZenStateJournalRevert(Journal, Inner);
+  EXPECT_EQ(getState(Journal, "b"), "2");
+  EXPECT_EQ(getState(Journal, "c"), "<none>");
+  EXPECT_EQ(getState(Journal, "a"), "10");
+  ZenStateJournalRelease(Journal, Outer);
+
+  // nothing reaches the backend before commit
+  EXPECT_EQ(Store.NumCommits, 0u);
+  EXPECT_EQ(Store.Data.count("b"), 0u);
+  ZenStateJournalCommit(Journal);
+  EXPECT_EQ(Store.NumCommits, 1u);
+  EXPECT_EQ(Store.Data["a"], "10");
+  EXPECT_EQ(Store.Data["b"], "2");
+  EXPECT_EQ(Store.Data.count("c"), 0u);
+
+  setState(Journal, "a", "100");
+  ZenStateJournalDiscard(Journal);
+  EXPECT_EQ(getState(Journal, "a"), "10");
+  ZenStateJournalCommit(Journal);
+  EXPECT_EQ(Store.NumCommits, 1u);
+
+  ZenDeleteStateJournal(Journal);
+}
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,182 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// Throughput of the native hash kernels behind the crypto hostapis, and
+// optionally of an in-wasm implementation exported by a module as
+// `hash(input_ptr: i32, input_len: i32, result_ptr: i32)`, for example one
+// compiled from the Solidity/C library a contract would otherwise link.
+
+#include "utils/crypto.h"
+#include "zetaengine-c.h"
+
+#include <CLI/CLI.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+using HashFn = void (*)(const uint8_t *, size_t, uint8_t[32]);
+
+struct HashDesc {
+  const char *Name;
+  HashFn Fn;
+};
+
+const HashDesc Hashes[] = {
+    {"sha256", zen::utils::sha256},
+    {"sha256-generic", zen::utils::sha256Generic},
+    {"keccak256", zen::utils::keccak256},
+    {"sm3", zen::utils::sm3},
+};
+
+template <typename Func> double timeIt(uint32_t NumIters, Func &&F) {
+  auto Start = std::chrono::steady_clock::now();
+  for (uint32_t I = 0; I < NumIters; ++I) {
+    F();
+  }
+  std::chrono::duration<double> Elapsed =
+      std::chrono::steady_clock::now() - Start;
+  return Elapsed.count();
+}
+
+void report(const char *Name, uint32_t InputSize, uint32_t NumIters,
+            double Seconds) {
+  std::printf("%-24s %10.1f ns/op %10.1f MB/s\n", Name,
+              Seconds * 1e9 / NumIters,
+              double(InputSize) * NumIters / Seconds / 1e6);
+}
+
+int runWasm(const std::string &WasmFile, const std::string &FuncName,
+            ZenRunMode Mode, HashFn Expected, const std::vector<uint8_t> &Input,
+            uint32_t InputOffset, uint32_t NumIters) {
+  ZenRuntimeConfig Config = {};
+  Config.Mode = Mode;
+  Config.DisableWASI = true;
+  ZenRuntimeRef Runtime = ZenCreateRuntime(&Config);
+  char ErrBuf[256] = {0};
+  ZenModuleRef Module =
+      ZenLoadModuleFromFile(Runtime, WasmFile.c_str(), ErrBuf, sizeof(ErrBuf));
+  if (!Module) {
+    std::fprintf(stderr, "failed to load %s: %s\n", WasmFile.c_str(), ErrBuf);
+    return 1;
+  }
+  uint32_t FuncIdx = 0;
+  if (!ZenGetExportFunc(Module, FuncName.c_str(), &FuncIdx)) {
+    std::fprintf(stderr, "function %s not exported\n", FuncName.c_str());
+    return 1;
+  }
+  ZenIsolationRef Isolation = ZenCreateIsolation(Runtime);
+  ZenInstanceRef Instance =
+      ZenCreateInstance(Isolation, Module, ErrBuf, sizeof(ErrBuf));
+  if (!Instance) {
+    std::fprintf(stderr, "failed to instantiate: %s\n", ErrBuf);
+    return 1;
+  }
+  uint32_t InputSize = Input.size();
+  uint32_t ResultOffset = InputOffset + InputSize;
+  if (!ZenValidateAppMemAddr(Instance, InputOffset, InputSize + 32)) {
+    std::fprintf(stderr, "input does not fit in the linear memory\n");
+    return 1;
+  }
+  if (InputSize) {
+    std::memcpy(ZenGetHostMemAddr(Instance, InputOffset), Input.data(),
+                InputSize);
+  }
+
+  ZenValue Args[3];
+  Args[0].Type = Args[1].Type = Args[2].Type = ZenTypeI32;
+  Args[0].Value.I32 = InputOffset;
+  Args[1].Value.I32 = InputSize;
+  Args[2].Value.I32 = ResultOffset;
+  ZenValue Results[1];
+  uint32_t NumResults = 0;
+  bool Ok = true;
+  double Seconds = timeIt(NumIters, [&] {
+    Ok &= ZenCallWasmFuncByIdx(Runtime, Instance, FuncIdx, Args, 3, Results,
+                               &NumResults);
+  });
+  if (!Ok) {
+    ZenGetInstanceError(Instance, ErrBuf, sizeof(ErrBuf));
+    std::fprintf(stderr, "wasm hash failed: %s\n", ErrBuf);
+    return 1;
+  }
+  report("wasm", InputSize, NumIters, Seconds);
+
+  uint8_t Digest[32];
+  Expected(Input.data(), InputSize, Digest);
+  if (std::memcmp(ZenGetHostMemAddr(Instance, ResultOffset), Digest, 32)) {
+    std::fprintf(stderr, "wasm digest differs from the native one\n");
+    return 1;
+  }
+
+  ZenDeleteInstance(Isolation, Instance);
+  ZenDeleteIsolation(Runtime, Isolation);
+  ZenDeleteModule(Runtime, Module);
+  ZenDeleteRuntime(Runtime);
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  CLI::App App{"Crypto hostapi benchmark"};
+  uint32_t InputSize = 64;
+  uint32_t NumIters = 100000;
+  std::string WasmFile;
+  std::string FuncName = "hash";
+  std::string WasmHash = "keccak256";
+  std::string Mode = "singlepass";
+  uint32_t InputOffset = 65536;
+  App.add_option("--size", InputSize, "Input size in bytes");
+  App.add_option("--iters", NumIters, "Number of iterations");
+  App.add_option("--wasm", WasmFile, "Module with an in-wasm hash function");
+  App.add_option("--func", FuncName, "Exported hash function of the module");
+  App.add_option("--wasm-hash", WasmHash,
+                 "Algorithm implemented by the module, to check its digest");
+  App.add_option("-m,--mode", Mode, "interpreter/singlepass/multipass");
+  App.add_option("--input-offset", InputOffset,
+                 "Linear memory offset the input is copied to");
+  CLI11_PARSE(App, argc, argv);
+
+  std::vector<uint8_t> Input(InputSize);
+  for (uint32_t I = 0; I < InputSize; ++I) {
+    Input[I] = uint8_t(I * 131 + 7);
+  }
+
+  std::printf("sha256 kernel: %s, input: %u bytes, %u iterations\n",
+              zen::utils::getSha256ImplName(), InputSize, NumIters);
+  HashFn Expected = nullptr;
+  for (const HashDesc &Hash : Hashes) {
+    uint8_t Digest[32];
+    double Seconds = timeIt(
+        NumIters, [&] { Hash.Fn(Input.data(), Input.size(), Digest); });
+    report(Hash.Name, InputSize, NumIters, Seconds);
+    if (WasmHash == Hash.Name) {
+      Expected = Hash.Fn;
+    }
+  }
+
+  if (WasmFile.empty()) {
+    return 0;
+  }
+  if (!Expected) {
+    std::fprintf(stderr, "unknown hash %s\n", WasmHash.c_str());
+    return 1;
+  }
+  ZenRunMode RunMode = ZenModeUnknown;
+  if (Mode == "interpreter") {
+    RunMode = ZenModeInterp;
+  } else if (Mode == "singlepass") {
+    RunMode = ZenModeSinglepass;
+  } else if (Mode == "multipass") {
+    RunMode = ZenModeMultipass;
+  } else {
+    std::fprintf(stderr, "unknown mode %s\n", Mode.c_str());
+    return 1;
+  }
+  return runWasm(WasmFile, FuncName, RunMode, Expected, Input, InputOffset,
+                 NumIters);
+}
@@ -0,0 +1,97 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "utils/crypto.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace zen::test {
+
+using namespace zen;
+using namespace utils;
+
+static std::string toHex(const uint8_t *Data, size_t Size) {
+  static const char *Digits = "0123456789abcdef";
+  std::string Hex;
+  for (size_t I = 0; I < Size; ++I) {
+    Hex.push_back(Digits[Data[I] >> 4]);
+    Hex.push_back(Digits[Data[I] & 0xf]);
+  }
+  return Hex;
+}
+
+static std::vector<uint8_t> fromHex(const std::string &Hex) {
+  std::vector<uint8_t> Data;
+  for (size_t I = 0; I + 1 < Hex.size(); I += 2) {
+    Data.push_back(std::stoi(Hex.substr(I, 2), nullptr, 16));
+  }
+  return Data;
+}
+
+using HashFn = void (*)(const uint8_t *, size_t, uint8_t[32]);
+
+static std::string hashHex(HashFn Fn, const std::string &Input) {
+  uint8_t Digest[32];
+  Fn(reinterpret_cast<const uint8_t *>(Input.data()), Input.size(), Digest);
+  return toHex(Digest, 32);
+}
+
+TEST(Crypto, Sha256) {
+  EXPECT_EQ(hashHex(sha256, "abc"),
+            "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+  EXPECT_EQ(hashHex(sha256, std::string(200, 'a')),
+            "c2a908d98f5df987ade41b5fce213067efbcc21ef2240212a41e54b5e7c28ae5");
+  // The dispatched kernel must agree with the portable one on every tail
+  // length
+  std::string Input;
+  for (int I = 0; I < 300; ++I) {
+    EXPECT_EQ(hashHex(sha256, Input), hashHex(sha256Generic, Input));
+    Input.push_back(char(I * 7));
+  }
+}
+
+TEST(Crypto, Keccak256) {
+  EXPECT_EQ(hashHex(keccak256, ""),
+            "c5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470");
+  EXPECT_EQ(hashHex(keccak256, "abc"),
+            "4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45");
+  EXPECT_EQ(hashHex(keccak256, std::string(200, 'a')),
+            "96ea54061def936c4be90b518992fdc6f12f535068a256229aca54267b4d084d");
+}
+
+TEST(Crypto, Sm3) {
+  EXPECT_EQ(hashHex(sm3, "abc"),
+            "66c7f0f462eeedd9d1f2d46bdc10e4e24167c4875cf2f7a2297da02b8f4ba8e0");
+  EXPECT_EQ(hashHex(sm3, std::string(200, 'a')),
+            "a8da99c801bbd65ec00992ed5cbef851f275e98da9fb2d4f5be184f81473d5dd");
+}
+
+TEST(Crypto, Secp256k1Recover) {
+  // Signed by the private key 1, whose public key is the generator
+  std::vector<uint8_t> Hash = fromHex(
+      "589eef8f9cb88da57f00931f7eda04183ff8952ea35d12a2fe1b129395b03a4c");
+  std::vector<uint8_t> R = fromHex(
+      "f973a0b87062c389d125d8199e803b832b6ac6bf7867a4f6cd87506060fc4c58");
+  std::vector<uint8_t> S = fromHex(
+      "73fbadfe634beec1e0eca6f405e8bf03602a144282a864f86045f9cc0a9fa404");
+  uint8_t PubKey[64];
+  ASSERT_TRUE(secp256k1Recover(Hash.data(), R.data(), S.data(), 1, PubKey));
+  EXPECT_EQ(toHex(PubKey, 64),
+            "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798"
+            "483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8");
+
+  // The other parity recovers another key
+  ASSERT_TRUE(secp256k1Recover(Hash.data(), R.data(), S.data(), 0, PubKey));
+  EXPECT_NE(toHex(PubKey, 64).substr(0, 64),
+            "79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798");
+
+  std::vector<uint8_t> Zero(32, 0);
+  EXPECT_FALSE(
+      secp256k1Recover(Hash.data(), Zero.data(), S.data(), 1, PubKey));
+  EXPECT_FALSE(
+      secp256k1Recover(Hash.data(), R.data(), Zero.data(), 1, PubKey));
+}
+
+} // namespace zen::test
@@ -0,0 +1,168 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "host/evmabimock/evm_storage.h"
+
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace zen::test {
+
+using namespace zen::host;
+
+static Bytes32 makeBytes32(uint32_t N) {
+  Bytes32 B{};
+  std::memcpy(B.data() + 28, &N, sizeof(N));
+  return B;
+}
+
+// Find NumKeys keys probing from Slot in Table
+static std::vector<Bytes32> findKeysWithHome(const Bytes32Table &Table,
+                                             size_t Slot, size_t NumKeys,
+                                             uint32_t &Next) {
+  std::vector<Bytes32> Keys;
+  while (Keys.size() < NumKeys) {
+    Bytes32 Key = makeBytes32(Next++);
+    if (Table.getHomeSlot(Key) == Slot) {
+      Keys.push_back(Key);
+    }
+  }
+  return Keys;
+}
+
+TEST(Bytes32Table, EraseShiftsWrappedCluster) {
+  Bytes32Table Table(16);
+  ASSERT_EQ(Table.capacity(), 16u);
+  size_t Last = Table.capacity() - 1;
+
+  // A, B and C all start from the last slot and wrap to slots 0 and 1, D
+  // starts from slot 0 and is pushed to slot 2
+  uint32_t Next = 1;
+  std::vector<Bytes32> Keys = findKeysWithHome(Table, Last, 3, Next);
+  Keys.push_back(findKeysWithHome(Table, 0, 1, Next)[0]);
+  for (size_t I = 0; I < Keys.size(); ++I) {
+    bool Inserted;
+    Table.findOrInsert(Keys[I], Inserted) = makeBytes32(100 + I);
+    ASSERT_TRUE(Inserted);
+  }
+
+  // Erasing the head of the cluster must shift every key back across the
+  // wrap point, none of them may become unreachable
+  EXPECT_TRUE(Table.erase(Keys[0]));
+  EXPECT_EQ(Table.size(), 3u);
+  EXPECT_EQ(Table.find(Keys[0]), nullptr);
+  for (size_t I = 1; I < Keys.size(); ++I) {
+    const Bytes32 *Value = Table.find(Keys[I]);
+    ASSERT_NE(Value, nullptr);
+    EXPECT_EQ(*Value, makeBytes32(100 + I));
+  }
+
+  // Erase from the middle of the remaining cluster, after the wrap
+  EXPECT_TRUE(Table.erase(Keys[2]));
+  EXPECT_FALSE(Table.erase(Keys[2]));
+  EXPECT_EQ(Table.size(), 2u);
+  EXPECT_NE(Table.find(Keys[1]), nullptr);
+  EXPECT_NE(Table.find(Keys[3]), nullptr);
+  EXPECT_EQ(*Table.find(Keys[3]), makeBytes32(103));
+}
+
+TEST(Bytes32Table, GrowKeepsLiveEntries) {
+  Bytes32Table Table(16);
+  constexpr uint32_t NumKeys = 1000;
+  for (uint32_t I = 0; I < NumKeys; ++I) {
+    bool Inserted;
+    Table.findOrInsert(makeBytes32(I), Inserted) = makeBytes32(I * 7);
+    ASSERT_TRUE(Inserted);
+    // Erase every third key while growing, so the rehash sees holes
+    if (I % 3 == 0) {
+      ASSERT_TRUE(Table.erase(makeBytes32(I)));
+    }
+  }
+  EXPECT_GT(Table.capacity(), 16u);
+  EXPECT_LE(Table.size() * 4, Table.capacity() * 3);
+
+  size_t NumLive = 0;
+  for (uint32_t I = 0; I < NumKeys; ++I) {
+    const Bytes32 *Value = Table.find(makeBytes32(I));
+    if (I % 3 == 0) {
+      EXPECT_EQ(Value, nullptr);
+      continue;
+    }
+    ASSERT_NE(Value, nullptr);
+    EXPECT_EQ(*Value, makeBytes32(I * 7));
+    ++NumLive;
+  }
+  EXPECT_EQ(Table.size(), NumLive);
+
+  bool Inserted;
+  Table.findOrInsert(makeBytes32(1), Inserted);
+  EXPECT_FALSE(Inserted);
+}
+
+static Bytes32 loadSlot(JournaledEVMStorage &Storage, uint32_t Key) {
+  Bytes32 Value;
+  Storage.load(makeBytes32(Key), Value);
+  return Value;
+}
+
+TEST(JournaledEVMStorage, NestedCheckpointRevert) {
+  InMemoryEVMStorage Backend;
+  JournaledEVMStorage Storage(Backend);
+  Storage.store(makeBytes32(1), makeBytes32(10));
+  Storage.commit();
+
+  uint32_t Outer = Storage.checkpoint();
+  Storage.store(makeBytes32(1), makeBytes32(11));
+  Storage.store(makeBytes32(2), makeBytes32(20));
+
+  uint32_t Inner = Storage.checkpoint();
+  Storage.store(makeBytes32(1), makeBytes32(12));
+  Storage.store(makeBytes32(3), makeBytes32(30));
+  EXPECT_EQ(loadSlot(Storage, 1), makeBytes32(12));
+
+  Storage.revert(Inner);
+  EXPECT_EQ(loadSlot(Storage, 1), makeBytes32(11));
+  EXPECT_EQ(loadSlot(Storage, 2), makeBytes32(20));
+  EXPECT_EQ(loadSlot(Storage, 3), Bytes32{});
+
+  Storage.revert(Outer);
+  EXPECT_EQ(loadSlot(Storage, 1), makeBytes32(10));
+  EXPECT_EQ(loadSlot(Storage, 2), Bytes32{});
+  EXPECT_EQ(Storage.getNumDirtySlots(), 0u);
+
+  // Nothing reverted reached the backend
+  EXPECT_EQ(Backend.getTable().size(), 1u);
+  EXPECT_EQ(*Backend.getTable().find(makeBytes32(1)), makeBytes32(10));
+}
+
+TEST(JournaledEVMStorage, NestedCheckpointCommit) {
+  InMemoryEVMStorage Backend;
+  JournaledEVMStorage Storage(Backend);
+
+  Storage.checkpoint();
+  Storage.store(makeBytes32(1), makeBytes32(11));
+  uint32_t Inner = Storage.checkpoint();
+  Storage.store(makeBytes32(1), makeBytes32(12));
+  Storage.store(makeBytes32(2), makeBytes32(20));
+  Storage.revert(Inner);
+  Storage.checkpoint();
+  Storage.store(makeBytes32(3), makeBytes32(30));
+
+  // Commit keeps the writes of all the open checkpoints but the reverted one
+  Storage.commit();
+  EXPECT_EQ(Storage.getNumDirtySlots(), 0u);
+  const Bytes32Table &Table = Backend.getTable();
+  EXPECT_EQ(Table.size(), 2u);
+  EXPECT_EQ(*Table.find(makeBytes32(1)), makeBytes32(11));
+  EXPECT_EQ(Table.find(makeBytes32(2)), nullptr);
+  EXPECT_EQ(*Table.find(makeBytes32(3)), makeBytes32(30));
+  EXPECT_EQ(loadSlot(Storage, 1), makeBytes32(11));
+
+  // Checkpoints don't survive the commit
+  Storage.store(makeBytes32(1), makeBytes32(13));
+  Storage.revert(Storage.checkpoint());
+  EXPECT_EQ(loadSlot(Storage, 1), makeBytes32(13));
+}
+
+} // namespace zen::test
@@ -2,8 +2,15 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "common/mem_pool.h"
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+#include "utils/virtual_stack.h"
+#endif // ZEN_ENABLE_VIRTUAL_STACK
 
+#include <algorithm>
+#include <condition_variable>
 #include <gtest/gtest.h>
+#include <mutex>
+#include <thread>
 
 namespace zen::test {
 
@@ -38,6 +45,77 @@ TEST(Mempool, CodeMemPool) {
   EXPECT_DEATH(Pool.allocate(CodeMemPool::MaxCodeSize), "");
 }
 
+TEST(Mempool, CodeMemPoolWithMemoryPolicy) {
+  CodeMemPool Pool;
+  // huge pages and numa binding are hints, they must not change the layout
+  Pool.applyMemoryPolicy(true, true);
+  auto *Start = Pool.getMemStart();
+
+  auto *Ptr = static_cast<uint8_t *>(Pool.allocate(10));
+  EXPECT_EQ(Ptr, Start);
+  EXPECT_EQ(Pool.getMemPageEnd(), Start + 4096);
+  Ptr[0] = 0xc3;
+  EXPECT_EQ(Ptr[0], 0xc3);
+}
+
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+TEST(Mempool, StackMemPool) {
+  constexpr size_t PageSize = utils::StackMemPool::PageSize;
+  utils::StackMemPool Pool(PageSize * 4, PageSize, PageSize);
+
+  std::vector<void *> Stacks;
+  for (size_t I = 0; I < utils::StackMemPool::THREAD_CACHE_SIZE + 2; ++I) {
+    auto *Ptr = static_cast<uint8_t *>(Pool.allocate(true));
+    Ptr[PageSize * 4 - 1] = 1;
+    Stacks.push_back(Ptr);
+  }
+  for (void *Ptr : Stacks) {
+    Pool.deallocate(Ptr);
+  }
+  // reused from the thread cache, then from the shared free list
+  for (size_t I = 0; I < Stacks.size(); ++I) {
+    void *Ptr = Pool.allocate(true);
+    EXPECT_NE(std::find(Stacks.begin(), Stacks.end(), Ptr), Stacks.end());
+  }
+  for (void *Ptr : Stacks) {
+    Pool.deallocate(Ptr);
+  }
+
+  // a stack cached by an idle thread is taken when the pool runs out
+  std::mutex Mtx;
+  std::condition_variable CV;
+  bool Cached = false;
+  bool Done = false;
+  void *IdleStack = nullptr;
+  std::thread Idle([&] {
+    IdleStack = Pool.allocate(true);
+    Pool.deallocate(IdleStack);
+    std::unique_lock<std::mutex> Lock(Mtx);
+    Cached = true;
+    CV.notify_all();
+    CV.wait(Lock, [&] { return Done; });
+  });
+  {
+    std::unique_lock<std::mutex> Lock(Mtx);
+    CV.wait(Lock, [&] { return Cached; });
+  }
+  std::vector<void *> All;
+  for (size_t I = 0; I < utils::StackMemPool::MAX_STACK_ITEM_NUM; ++I) {
+    All.push_back(Pool.allocate(true));
+  }
+  EXPECT_NE(std::find(All.begin(), All.end(), IdleStack), All.end());
+  for (void *Ptr : All) {
+    Pool.deallocate(Ptr);
+  }
+  {
+    std::unique_lock<std::mutex> Lock(Mtx);
+    Done = true;
+    CV.notify_all();
+  }
+  Idle.join();
+}
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,375 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// Load, compile, instantiation and execution times of a corpus of modules in
+// every run mode, written as JSON so that two builds can be compared with
+// tools/bench_compare.py. Each entry of the corpus is a module file, a
+// directory of modules, or FILE:FUNC to call FUNC instead of --function(or
+// the main function of the module when neither is given).
+
+#include "utils/logging.h"
+#include "utils/others.h"
+#include "utils/statistics.h"
+#include "zetaengine.h"
+
+#ifdef ZEN_ENABLE_BUILTIN_WASI
+#include "host/wasi/wasi.h"
+#endif
+
+#ifdef ZEN_ENABLE_BUILTIN_ENV
+#include "host/env/env.h"
+#endif
+
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <dirent.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+
+using namespace zen::common;
+using namespace zen::runtime;
+using zen::utils::StatisticPhase;
+
+enum BenchPhase : uint32_t { Load, Compile, Instantiate, Execute, NumPhases };
+
+const char *const PhaseNames[NumPhases] = {"load", "compile", "instantiate",
+                                           "execute"};
+
+struct BenchEntry {
+  std::string Path;
+  std::string FuncName;
+};
+
+struct BenchResult {
+  const BenchEntry *Entry;
+  const char *Mode;
+  std::string Error;
+  std::vector<double> Samples[NumPhases];
+};
+
+struct BenchOptions {
+  std::vector<std::string> Args;
+  uint64_t GasLimit = UINT64_MAX;
+  uint32_t NumWarmups = 2;
+  uint32_t NumIters = 10;
+};
+
+bool isDirectory(const std::string &Path) {
+  struct stat Stat;
+  return ::stat(Path.c_str(), &Stat) == 0 && S_ISDIR(Stat.st_mode);
+}
+
+bool endsWith(const std::string &Str, const std::string &Suffix) {
+  return Str.size() >= Suffix.size() &&
+         Str.compare(Str.size() - Suffix.size(), Suffix.size(), Suffix) == 0;
+}
+
+// expand directories to the modules inside, sorted to keep the report stable
+bool collectEntries(const std::vector<std::string> &Corpus,
+                    const std::string &DefaultFunc,
+                    std::vector<BenchEntry> &Entries) {
+  for (const std::string &Item : Corpus) {
+    std::string Path = Item;
+    std::string FuncName = DefaultFunc;
+    size_t Colon = Item.rfind(':');
+    if (Colon != std::string::npos && !isDirectory(Item)) {
+      Path = Item.substr(0, Colon);
+      FuncName = Item.substr(Colon + 1);
+    }
+    if (!isDirectory(Path)) {
+      Entries.push_back({Path, FuncName});
+      continue;
+    }
+    DIR *Dir = ::opendir(Path.c_str());
+    if (!Dir) {
+      ZEN_LOG_ERROR("failed to open directory %s", Path.c_str());
+      return false;
+    }
+    std::vector<std::string> Files;
+    while (struct dirent *Ent = ::readdir(Dir)) {
+      std::string Name = Ent->d_name;
+      if (endsWith(Name, ".wasm")) {
+        Files.push_back(Path + "/" + Name);
+      }
+    }
+    ::closedir(Dir);
+    std::sort(Files.begin(), Files.end());
+    for (const std::string &File : Files) {
+      Entries.push_back({File, FuncName});
+    }
+  }
+  return true;
+}
+
+std::unique_ptr<Runtime> createRuntime(RunMode Mode) {
+  RuntimeConfig Config;
+  Config.Mode = Mode;
+  // the phase times are taken from the statistics records
+  Config.EnableStatistics = true;
+  std::unique_ptr<Runtime> RT = Runtime::newRuntime(Config);
+  if (!RT) {
+    return nullptr;
+  }
+#ifdef ZEN_ENABLE_BUILTIN_WASI
+  if (!LOAD_HOST_MODULE(RT, zen::host, wasi_snapshot_preview1)) {
+    return nullptr;
+  }
+#endif
+#ifdef ZEN_ENABLE_BUILTIN_ENV
+  if (!LOAD_HOST_MODULE(RT, zen::host, env)) {
+    return nullptr;
+  }
+#endif
+  return RT;
+}
+
+// one full load/instantiate/call/unload cycle, the times are added to Result
+// unless it is a warm-up
+bool runOnce(Runtime &RT, const BenchEntry &Entry,
+             const std::vector<uint8_t> &Code, const BenchOptions &Opts,
+             uint32_t Iter, bool Record, BenchResult &Result) {
+  zen::utils::Statistics &Stats = RT.getStatistics();
+  Stats.takeRecords();
+
+  // a new name for every iteration, to bypass the module cache
+  std::string ModName = Entry.Path + "#" + std::to_string(Iter);
+  MayBe<Module *> ModRet =
+      RT.loadModule(ModName, Code.data(), Code.size(), Entry.FuncName);
+  if (!ModRet) {
+    Result.Error = ModRet.getError().getFormattedMessage(false);
+    return false;
+  }
+  Module *Mod = *ModRet;
+
+  bool Ok = true;
+  {
+    IsolationUniquePtr Iso = RT.createUnmanagedIsolation();
+    MayBe<Instance *> InstRet = Iso->createInstance(*Mod, Opts.GasLimit);
+    if (!InstRet) {
+      Result.Error = InstRet.getError().getFormattedMessage(false);
+      Ok = false;
+    } else {
+      Instance *Inst = *InstRet;
+      std::vector<TypedValue> Results;
+      bool CallRet =
+          Entry.FuncName.empty()
+              ? RT.callWasmMain(*Inst, Results)
+              : RT.callWasmFunction(*Inst, Entry.FuncName, Opts.Args, Results);
+      if (!CallRet) {
+        Result.Error = Inst->getError().getFormattedMessage(false);
+        Ok = false;
+      }
+      Iso->deleteInstance(Inst);
+    }
+  }
+  RT.unloadModule(Mod);
+  if (!Ok || !Record) {
+    Stats.takeRecords();
+    return Ok;
+  }
+
+  double Times[NumPhases] = {0};
+  for (const auto &Record : Stats.takeRecords()) {
+    float TimeCost = Record.TimeCost;
+    switch (Record.Phase) {
+    case StatisticPhase::Load:
+      Times[Load] += TimeCost;
+      break;
+    case StatisticPhase::JITCompilation:
+    case StatisticPhase::JITLazyPrecompilation:
+      Times[Compile] += TimeCost;
+      break;
+    case StatisticPhase::JITLazyFgCompilation:
+      // compiled on request while executing
+      Times[Compile] += TimeCost;
+      Times[Execute] -= TimeCost;
+      break;
+    case StatisticPhase::Instantiation:
+      Times[Instantiate] += TimeCost;
+      break;
+    case StatisticPhase::Execution:
+      Times[Execute] += TimeCost;
+      break;
+    default:
+      break;
+    }
+  }
+  for (uint32_t I = 0; I < NumPhases; ++I) {
+    Result.Samples[I].push_back(Times[I]);
+  }
+  return true;
+}
+
+void runEntry(Runtime &RT, const BenchEntry &Entry, const BenchOptions &Opts,
+              BenchResult &Result) {
+  std::vector<uint8_t> Code;
+  if (!zen::utils::readBinaryFile(Entry.Path, Code)) {
+    Result.Error = "failed to read " + Entry.Path;
+    return;
+  }
+  uint32_t NumRuns = Opts.NumWarmups + Opts.NumIters;
+  for (uint32_t I = 0; I < NumRuns; ++I) {
+    if (!runOnce(RT, Entry, Code, Opts, I, I >= Opts.NumWarmups, Result)) {
+      for (std::vector<double> &Samples : Result.Samples) {
+        Samples.clear();
+      }
+      return;
+    }
+  }
+}
+
+// nearest-rank percentile of sorted samples
+double percentile(const std::vector<double> &Sorted, double P) {
+  size_t Rank = size_t(std::ceil(P / 100 * Sorted.size()));
+  return Sorted[std::max<size_t>(Rank, 1) - 1];
+}
+
+void writeString(FILE *Out, const std::string &Str) {
+  std::fputc('"', Out);
+  for (char C : Str) {
+    if (C == '"' || C == '\\') {
+      std::fprintf(Out, "\\%c", C);
+    } else if (uint8_t(C) < 0x20) {
+      std::fprintf(Out, "\\u%04x", C);
+    } else {
+      std::fputc(C, Out);
+    }
+  }
+  std::fputc('"', Out);
+}
+
+void writeReport(FILE *Out, const BenchOptions &Opts,
+                 const std::vector<BenchResult> &Results) {
+  std::fprintf(Out, "{\n  \"warmups\": %u,\n  \"iterations\": %u,\n",
+               Opts.NumWarmups, Opts.NumIters);
+  std::fprintf(Out, "  \"unit\": \"ms\",\n  \"results\": [");
+  for (size_t I = 0; I < Results.size(); ++I) {
+    const BenchResult &Result = Results[I];
+    std::fprintf(Out, "%s\n    {\"module\": ", I ? "," : "");
+    writeString(Out, Result.Entry->Path);
+    std::fprintf(Out, ", \"function\": ");
+    writeString(Out, Result.Entry->FuncName);
+    std::fprintf(Out, ", \"mode\": \"%s\"", Result.Mode);
+    if (!Result.Error.empty()) {
+      std::fprintf(Out, ", \"error\": ");
+      writeString(Out, Result.Error);
+      std::fprintf(Out, "}");
+      continue;
+    }
+    std::fprintf(Out, ",\n     \"phases\": {");
+    for (uint32_t P = 0; P < NumPhases; ++P) {
+      std::vector<double> Sorted = Result.Samples[P];
+      std::sort(Sorted.begin(), Sorted.end());
+      double Sum = 0;
+      for (double V : Sorted) {
+        Sum += V;
+      }
+      std::fprintf(Out,
+                   "%s\n       \"%s\": {\"min\": %.4f, \"p50\": %.4f, "
+                   "\"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f, "
+                   "\"mean\": %.4f}",
+                   P ? "," : "", PhaseNames[P], Sorted.front(),
+                   percentile(Sorted, 50), percentile(Sorted, 90),
+                   percentile(Sorted, 99), Sorted.back(),
+                   Sum / Sorted.size());
+    }
+    std::fprintf(Out, "\n     }}");
+  }
+  std::fprintf(Out, "\n  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  CLI::App App{"Wasm load/compile/instantiate/execute benchmark"};
+  std::vector<std::string> Corpus;
+  std::vector<std::string> ModeNames;
+  std::string FuncName;
+  std::string OutputFile;
+  BenchOptions Opts;
+  App.add_option("CORPUS", Corpus, "Module files, directories or FILE:FUNC")
+      ->required();
+  App.add_option("-m,--mode", ModeNames,
+                 "interpreter/singlepass/multipass(default all built ones)");
+  App.add_option("-f,--function", FuncName, "Function to call");
+  App.add_option("--args", Opts.Args, "Arguments of the function");
+  App.add_option("--gas-limit", Opts.GasLimit, "Gas limit");
+  App.add_option("--warmup", Opts.NumWarmups, "Discarded runs per module");
+  App.add_option("--iters", Opts.NumIters, "Measured runs per module");
+  App.add_option("-o,--output", OutputFile, "JSON report file(default stdout)");
+  CLI11_PARSE(App, argc, argv);
+
+  zen::setGlobalLogger(zen::utils::createConsoleLogger(
+      "wasm_bench_logger", zen::utils::LoggerLevel::Error));
+
+  if (Opts.NumIters == 0) {
+    std::fprintf(stderr, "--iters must be positive\n");
+    return 1;
+  }
+  if (ModeNames.empty()) {
+    ModeNames.push_back("interpreter");
+#ifdef ZEN_ENABLE_SINGLEPASS_JIT
+    ModeNames.push_back("singlepass");
+#endif
+#ifdef ZEN_ENABLE_MULTIPASS_JIT
+    ModeNames.push_back("multipass");
+#endif
+  }
+  std::vector<std::pair<const char *, RunMode>> Modes;
+  for (const std::string &Name : ModeNames) {
+    if (Name == "interpreter") {
+      Modes.emplace_back("interpreter", RunMode::InterpMode);
+    } else if (Name == "singlepass") {
+      Modes.emplace_back("singlepass", RunMode::SinglepassMode);
+    } else if (Name == "multipass") {
+      Modes.emplace_back("multipass", RunMode::MultipassMode);
+    } else {
+      std::fprintf(stderr, "unknown mode %s\n", Name.c_str());
+      return 1;
+    }
+  }
+
+  std::vector<BenchEntry> Entries;
+  if (!collectEntries(Corpus, FuncName, Entries)) {
+    return 1;
+  }
+
+  bool Failed = false;
+  std::vector<BenchResult> Results;
+  Results.reserve(Entries.size() * Modes.size());
+  for (const auto &[ModeName, Mode] : Modes) {
+    std::unique_ptr<Runtime> RT = createRuntime(Mode);
+    if (!RT) {
+      std::fprintf(stderr, "failed to create %s runtime\n", ModeName);
+      return 1;
+    }
+    for (const BenchEntry &Entry : Entries) {
+      Results.push_back({&Entry, ModeName, "", {}});
+      runEntry(*RT, Entry, Opts, Results.back());
+      if (!Results.back().Error.empty()) {
+        Failed = true;
+        std::fprintf(stderr, "%s(%s): %s\n", Entry.Path.c_str(), ModeName,
+                     Results.back().Error.c_str());
+      }
+    }
+  }
+
+  FILE *Out = stdout;
+  if (!OutputFile.empty()) {
+    Out = std::fopen(OutputFile.c_str(), "w");
+    if (!Out) {
+      std::fprintf(stderr, "failed to open %s\n", OutputFile.c_str());
+      return 1;
+    }
+  }
+  writeReport(Out, Opts, Results);
+  if (Out != stdout) {
+    std::fclose(Out);
+  }
+  return Failed ? 1 : 0;
+}
@@ -0,0 +1,425 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "utils/crypto.h"
+#include <cstring>
+
+// cpuid is not allowed inside SGX enclaves
+#if defined(ZEN_BUILD_TARGET_X86_64) && !defined(ZEN_ENABLE_SGX)
+#define ZEN_CRYPTO_USE_SHA_NI
+#endif
+
+#ifdef ZEN_CRYPTO_USE_SHA_NI
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace zen::utils {
+
+namespace {
+
+inline uint32_t rotl32(uint32_t X, uint32_t N) {
+  return (X << N) | (X >> ((32 - N) & 31));
+}
+
+inline uint32_t rotr32(uint32_t X, uint32_t N) {
+  return (X >> N) | (X << ((32 - N) & 31));
+}
+
+inline uint64_t rotl64(uint64_t X, uint32_t N) {
+  return (X << N) | (X >> ((64 - N) & 63));
+}
+
+inline uint32_t loadBE32(const uint8_t *P) {
+  return (uint32_t(P[0]) << 24) | (uint32_t(P[1]) << 16) |
+         (uint32_t(P[2]) << 8) | uint32_t(P[3]);
+}
+
+inline void storeBE32(uint8_t *P, uint32_t V) {
+  P[0] = uint8_t(V >> 24);
+  P[1] = uint8_t(V >> 16);
+  P[2] = uint8_t(V >> 8);
+  P[3] = uint8_t(V);
+}
+
+inline uint64_t loadLE64(const uint8_t *P) {
+  uint64_t V = 0;
+  for (int I = 7; I >= 0; --I) {
+    V = (V << 8) | P[I];
+  }
+  return V;
+}
+
+inline void storeLE64(uint8_t *P, uint64_t V) {
+  for (int I = 0; I < 8; ++I) {
+    P[I] = uint8_t(V >> (8 * I));
+  }
+}
+
+using CompressFn = void (*)(uint32_t State[8], const uint8_t *Blocks,
+                            size_t NumBlocks);
+
+// Merkle-Damgard driver shared by SHA-256 and SM3(64-byte blocks, big-endian
+// bit length in the padding)
+void mdHash(CompressFn Compress, uint32_t State[8], const uint8_t *Data,
+            size_t Size, uint8_t Digest[32]) {
+  size_t NumBlocks = Size / 64;
+  if (NumBlocks) {
+    Compress(State, Data, NumBlocks);
+  }
+  size_t Tail = Size % 64;
+  uint8_t Last[128] = {0};
+  if (Tail) {
+    std::memcpy(Last, Data + NumBlocks * 64, Tail);
+  }
+  Last[Tail] = 0x80;
+  size_t LastSize = Tail < 56 ? 64 : 128;
+  uint64_t BitLen = uint64_t(Size) << 3;
+  storeBE32(Last + LastSize - 8, uint32_t(BitLen >> 32));
+  storeBE32(Last + LastSize - 4, uint32_t(BitLen));
+  Compress(State, Last, LastSize / 64);
+  for (int I = 0; I < 8; ++I) {
+    storeBE32(Digest + 4 * I, State[I]);
+  }
+}
+
+// ==================== SHA-256 ====================
+
+alignas(16) const uint32_t Sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+const uint32_t Sha256Init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+void sha256CompressGeneric(uint32_t State[8], const uint8_t *Blocks,
+                           size_t NumBlocks) {
+  for (; NumBlocks; --NumBlocks, Blocks += 64) {
+    uint32_t W[64];
+    for (int I = 0; I < 16; ++I) {
+      W[I] = loadBE32(Blocks + 4 * I);
+    }
+    for (int I = 16; I < 64; ++I) {
+      uint32_t S0 =
+          rotr32(W[I - 15], 7) ^ rotr32(W[I - 15], 18) ^ (W[I - 15] >> 3);
+      uint32_t S1 =
+          rotr32(W[I - 2], 17) ^ rotr32(W[I - 2], 19) ^ (W[I - 2] >> 10);
+      W[I] = W[I - 16] + S0 + W[I - 7] + S1;
+    }
+    uint32_t A = State[0], B = State[1], C = State[2], D = State[3];
+    uint32_t E = State[4], F = State[5], G = State[6], H = State[7];
+    for (int I = 0; I < 64; ++I) {
+      uint32_t S1 = rotr32(E, 6) ^ rotr32(E, 11) ^ rotr32(E, 25);
+      uint32_t Ch = (E & F) ^ (~E & G);
+      uint32_t T1 = H + S1 + Ch + Sha256K[I] + W[I];
+      uint32_t S0 = rotr32(A, 2) ^ rotr32(A, 13) ^ rotr32(A, 22);
+      uint32_t Maj = (A & B) ^ (A & C) ^ (B & C);
+      uint32_t T2 = S0 + Maj;
+      H = G;
+      G = F;
+      F = E;
+      E = D + T1;
+      D = C;
+      C = B;
+      B = A;
+      A = T1 + T2;
+    }
+    State[0] += A;
+    State[1] += B;
+    State[2] += C;
+    State[3] += D;
+    State[4] += E;
+    State[5] += F;
+    State[6] += G;
+    State[7] += H;
+  }
+}
+
+#ifdef ZEN_CRYPTO_USE_SHA_NI
+
+// 4 rounds per group, W[I] holds message words 4I..4I+3 and lives in
+// Msg[I % 4]. The schedule of the later groups is computed in flight by
+// sha256msg1/sha256msg2.
+#define SHA256_NI_GROUP(I)                                                     \
+  do {                                                                         \
+    Tmp = _mm_add_epi32(Msg[(I) % 4],                                          \
+                        _mm_load_si128((const __m128i *)&Sha256K[4 * (I)]));   \
+    State1 = _mm_sha256rnds2_epu32(State1, State0, Tmp);                       \
+    if ((I) >= 3 && (I) <= 14) {                                              \
+      __m128i Prev = _mm_alignr_epi8(Msg[(I) % 4], Msg[((I) + 3) % 4], 4);     \
+      Msg[((I) + 1) % 4] = _mm_add_epi32(Msg[((I) + 1) % 4], Prev);            \
+      Msg[((I) + 1) % 4] =                                                     \
+          _mm_sha256msg2_epu32(Msg[((I) + 1) % 4], Msg[(I) % 4]);              \
+    }                                                                          \
+    Tmp = _mm_shuffle_epi32(Tmp, 0x0E);                                        \
+    State0 = _mm_sha256rnds2_epu32(State0, State1, Tmp);                       \
+    if ((I) >= 1 && (I) <= 12) {                                              \
+      Msg[((I) + 3) % 4] =                                                     \
+          _mm_sha256msg1_epu32(Msg[((I) + 3) % 4], Msg[(I) % 4]);              \
+    }                                                                          \
+  } while (0)
+
+__attribute__((target("sha,sse4.1,ssse3"))) void
+sha256CompressShaNi(uint32_t State[8], const uint8_t *Blocks,
+                    size_t NumBlocks) {
+  const __m128i ByteSwap =
+      _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+  // The instructions take the state as ABEF/CDGH
+  __m128i Tmp = _mm_loadu_si128((const __m128i *)&State[0]);
+  __m128i State1 = _mm_loadu_si128((const __m128i *)&State[4]);
+  Tmp = _mm_shuffle_epi32(Tmp, 0xB1);
+  State1 = _mm_shuffle_epi32(State1, 0x1B);
+  __m128i State0 = _mm_alignr_epi8(Tmp, State1, 8);
+  State1 = _mm_blend_epi16(State1, Tmp, 0xF0);
+
+  for (; NumBlocks; --NumBlocks, Blocks += 64) {
+    __m128i SavedState0 = State0;
+    __m128i SavedState1 = State1;
+    __m128i Msg[4];
+    for (int I = 0; I < 4; ++I) {
+      Msg[I] = _mm_shuffle_epi8(
+          _mm_loadu_si128((const __m128i *)(Blocks + 16 * I)), ByteSwap);
+    }
+    SHA256_NI_GROUP(0);
+    SHA256_NI_GROUP(1);
+    SHA256_NI_GROUP(2);
+    SHA256_NI_GROUP(3);
+    SHA256_NI_GROUP(4);
+    SHA256_NI_GROUP(5);
+    SHA256_NI_GROUP(6);
+    SHA256_NI_GROUP(7);
+    SHA256_NI_GROUP(8);
+    SHA256_NI_GROUP(9);
+    SHA256_NI_GROUP(10);
+    SHA256_NI_GROUP(11);
+    SHA256_NI_GROUP(12);
+    SHA256_NI_GROUP(13);
+    SHA256_NI_GROUP(14);
+    SHA256_NI_GROUP(15);
+    State0 = _mm_add_epi32(State0, SavedState0);
+    State1 = _mm_add_epi32(State1, SavedState1);
+  }
+
+  Tmp = _mm_shuffle_epi32(State0, 0x1B);
+  State1 = _mm_shuffle_epi32(State1, 0xB1);
+  State0 = _mm_blend_epi16(Tmp, State1, 0xF0);
+  State1 = _mm_alignr_epi8(State1, Tmp, 8);
+  _mm_storeu_si128((__m128i *)&State[0], State0);
+  _mm_storeu_si128((__m128i *)&State[4], State1);
+}
+
+#undef SHA256_NI_GROUP
+
+bool hasShaNi() {
+  unsigned Eax, Ebx, Ecx, Edx;
+  if (!__get_cpuid(1, &Eax, &Ebx, &Ecx, &Edx)) {
+    return false;
+  }
+  bool HasSsse3 = Ecx & (1u << 9);
+  bool HasSse41 = Ecx & (1u << 19);
+  if (!__get_cpuid_count(7, 0, &Eax, &Ebx, &Ecx, &Edx)) {
+    return false;
+  }
+  bool HasSha = Ebx & (1u << 29);
+  return HasSsse3 && HasSse41 && HasSha;
+}
+
+#endif // ZEN_CRYPTO_USE_SHA_NI
+
+struct Sha256Impl {
+  CompressFn Compress;
+  const char *Name;
+};
+
+const Sha256Impl &getSha256Impl() {
+  static const Sha256Impl Impl = []() -> Sha256Impl {
+#ifdef ZEN_CRYPTO_USE_SHA_NI
+    if (hasShaNi()) {
+      return {sha256CompressShaNi, "sha-ni"};
+    }
+#endif
+    return {sha256CompressGeneric, "generic"};
+  }();
+  return Impl;
+}
+
+// ==================== Keccak ====================
+
+const uint64_t KeccakRoundConstants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL,
+    0x8000000080008000ULL, 0x000000000000808bULL, 0x0000000080000001ULL,
+    0x8000000080008081ULL, 0x8000000000008009ULL, 0x000000000000008aULL,
+    0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL,
+    0x8000000000008003ULL, 0x8000000000008002ULL, 0x8000000000000080ULL,
+    0x000000000000800aULL, 0x800000008000000aULL, 0x8000000080008081ULL,
+    0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL,
+};
+
+const uint8_t KeccakRho[24] = {1,  3,  6,  10, 15, 21, 28, 36,
+                               45, 55, 2,  14, 27, 41, 56, 8,
+                               25, 43, 62, 18, 39, 61, 20, 44};
+
+const uint8_t KeccakPi[24] = {10, 7,  11, 17, 18, 3,  5,  16,
+                              8,  21, 24, 4,  15, 23, 19, 13,
+                              12, 2,  20, 14, 22, 9,  6,  1};
+
+// The 25 lanes stay in registers once the fixed-count loops are unrolled,
+// which beats any SIMD layout for a single message
+void keccakF1600(uint64_t A[25]) {
+  for (int Round = 0; Round < 24; ++Round) {
+    uint64_t C[5];
+#pragma GCC unroll 5
+    for (int X = 0; X < 5; ++X) {
+      C[X] = A[X] ^ A[X + 5] ^ A[X + 10] ^ A[X + 15] ^ A[X + 20];
+    }
+#pragma GCC unroll 5
+    for (int X = 0; X < 5; ++X) {
+      uint64_t D = C[(X + 4) % 5] ^ rotl64(C[(X + 1) % 5], 1);
+#pragma GCC unroll 5
+      for (int Y = 0; Y < 25; Y += 5) {
+        A[Y + X] ^= D;
+      }
+    }
+    uint64_t Cur = A[1];
+#pragma GCC unroll 24
+    for (int I = 0; I < 24; ++I) {
+      int J = KeccakPi[I];
+      uint64_t Next = A[J];
+      A[J] = rotl64(Cur, KeccakRho[I]);
+      Cur = Next;
+    }
+#pragma GCC unroll 5
+    for (int Y = 0; Y < 25; Y += 5) {
+      uint64_t Row[5];
+#pragma GCC unroll 5
+      for (int X = 0; X < 5; ++X) {
+        Row[X] = A[Y + X];
+      }
+#pragma GCC unroll 5
+      for (int X = 0; X < 5; ++X) {
+        A[Y + X] = Row[X] ^ (~Row[(X + 1) % 5] & Row[(X + 2) % 5]);
+      }
+    }
+    A[0] ^= KeccakRoundConstants[Round];
+  }
+}
+
+// ==================== SM3 ====================
+
+const uint32_t Sm3Init[8] = {
+    0x7380166f, 0x4914b2b9, 0x172442d7, 0xda8a0600,
+    0xa96f30bc, 0x163138aa, 0xe38dee4d, 0xb0fb0e4e,
+};
+
+inline uint32_t sm3P0(uint32_t X) { return X ^ rotl32(X, 9) ^ rotl32(X, 17); }
+
+inline uint32_t sm3P1(uint32_t X) { return X ^ rotl32(X, 15) ^ rotl32(X, 23); }
+
+void sm3Compress(uint32_t State[8], const uint8_t *Blocks, size_t NumBlocks) {
+  for (; NumBlocks; --NumBlocks, Blocks += 64) {
+    uint32_t W[68];
+    for (int I = 0; I < 16; ++I) {
+      W[I] = loadBE32(Blocks + 4 * I);
+    }
+    for (int I = 16; I < 68; ++I) {
+      W[I] = sm3P1(W[I - 16] ^ W[I - 9] ^ rotl32(W[I - 3], 15)) ^
+             rotl32(W[I - 13], 7) ^ W[I - 6];
+    }
+    uint32_t A = State[0], B = State[1], C = State[2], D = State[3];
+    uint32_t E = State[4], F = State[5], G = State[6], H = State[7];
+    for (int J = 0; J < 64; ++J) {
+      uint32_t T = J < 16 ? 0x79cc4519 : 0x7a879d8a;
+      uint32_t A12 = rotl32(A, 12);
+      uint32_t SS1 = rotl32(A12 + E + rotl32(T, J % 32), 7);
+      uint32_t SS2 = SS1 ^ A12;
+      uint32_t FF, GG;
+      if (J < 16) {
+        FF = A ^ B ^ C;
+        GG = E ^ F ^ G;
+      } else {
+        FF = (A & B) | (A & C) | (B & C);
+        GG = (E & F) | (~E & G);
+      }
+      uint32_t TT1 = FF + D + SS2 + (W[J] ^ W[J + 4]);
+      uint32_t TT2 = GG + H + SS1 + W[J];
+      D = C;
+      C = rotl32(B, 9);
+      B = A;
+      A = TT1;
+      H = G;
+      G = rotl32(F, 19);
+      F = E;
+      E = sm3P0(TT2);
+    }
+    State[0] ^= A;
+    State[1] ^= B;
+    State[2] ^= C;
+    State[3] ^= D;
+    State[4] ^= E;
+    State[5] ^= F;
+    State[6] ^= G;
+    State[7] ^= H;
+  }
+}
+
+} // namespace
+
+void sha256(const uint8_t *Data, size_t Size, uint8_t Digest[32]) {
+  uint32_t State[8];
+  std::memcpy(State, Sha256Init, sizeof(State));
+  mdHash(getSha256Impl().Compress, State, Data, Size, Digest);
+}
+
+void sha256Generic(const uint8_t *Data, size_t Size, uint8_t Digest[32]) {
+  uint32_t State[8];
+  std::memcpy(State, Sha256Init, sizeof(State));
+  mdHash(sha256CompressGeneric, State, Data, Size, Digest);
+}
+
+const char *getSha256ImplName() { return getSha256Impl().Name; }
+
+void keccak256(const uint8_t *Data, size_t Size, uint8_t Digest[32]) {
+  constexpr size_t Rate = 136;
+  uint64_t A[25] = {0};
+  for (; Size >= Rate; Size -= Rate, Data += Rate) {
+    for (size_t I = 0; I < Rate / 8; ++I) {
+      A[I] ^= loadLE64(Data + 8 * I);
+    }
+    keccakF1600(A);
+  }
+  uint8_t Last[Rate] = {0};
+  if (Size) {
+    std::memcpy(Last, Data, Size);
+  }
+  Last[Size] ^= 0x01;
+  Last[Rate - 1] ^= 0x80;
+  for (size_t I = 0; I < Rate / 8; ++I) {
+    A[I] ^= loadLE64(Last + 8 * I);
+  }
+  keccakF1600(A);
+  for (int I = 0; I < 4; ++I) {
+    storeLE64(Digest + 8 * I, A[I]);
+  }
+}
+
+void sm3(const uint8_t *Data, size_t Size, uint8_t Digest[32]) {
+  uint32_t State[8];
+  std::memcpy(State, Sm3Init, sizeof(State));
+  mdHash(sm3Compress, State, Data, Size, Digest);
+}
+
+} // namespace zen::utils
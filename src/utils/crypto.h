@@ -0,0 +1,39 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef ZEN_UTILS_CRYPTO_H
+#define ZEN_UTILS_CRYPTO_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zen::utils {
+
+// Native hash primitives backing the crypto hostapis. The SHA-256 kernel is
+// selected once at runtime according to the cpu features(SHA-NI on x86-64).
+
+void sha256(const uint8_t *Data, size_t Size, uint8_t Digest[32]);
+
+/// Keccak-256 as used by Ethereum(original 0x01 padding, not SHA3-256)
+void keccak256(const uint8_t *Data, size_t Size, uint8_t Digest[32]);
+
+void sm3(const uint8_t *Data, size_t Size, uint8_t Digest[32]);
+
+/// Recover the secp256k1 public key which produced the signature (R, S) of
+/// Hash, all big-endian.
+/// \param RecId 0/1 for the parity of the y coordinate of the signature
+/// point, 2/3 if its x coordinate overflowed the curve order
+/// \param PubKey output uncompressed public key x || y without the 0x04 prefix
+/// \return false if the signature is invalid
+bool secp256k1Recover(const uint8_t Hash[32], const uint8_t R[32],
+                      const uint8_t S[32], uint8_t RecId, uint8_t PubKey[64]);
+
+/// \return the name of the SHA-256 kernel selected for this cpu
+const char *getSha256ImplName();
+
+/// Portable SHA-256, used as fallback and baseline of benchmarks
+void sha256Generic(const uint8_t *Data, size_t Size, uint8_t Digest[32]);
+
+} // namespace zen::utils
+
+#endif // ZEN_UTILS_CRYPTO_H
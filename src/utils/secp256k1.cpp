@@ -0,0 +1,359 @@
+// Copyright (C) 2024-2025 the DTVM authors. All Rights Reserved.
+// SPDX-License-Identifier: Apache-2.0
+
+// Public key recovery on secp256k1. Recovery only handles public data, so
+// the arithmetic is variable time.
+
+#include "utils/crypto.h"
+#include <cstring>
+
+namespace zen::utils {
+
+namespace {
+
+using uint128_t = unsigned __int128;
+
+// 256-bit integer, little-endian 64-bit limbs
+struct U256 {
+  uint64_t W[4];
+};
+
+U256 loadBE256(const uint8_t *P) {
+  U256 R;
+  for (int I = 0; I < 4; ++I) {
+    uint64_t V = 0;
+    for (int J = 0; J < 8; ++J) {
+      V = (V << 8) | P[8 * (3 - I) + J];
+    }
+    R.W[I] = V;
+  }
+  return R;
+}
+
+void storeBE256(uint8_t *P, const U256 &A) {
+  for (int I = 0; I < 4; ++I) {
+    uint64_t V = A.W[I];
+    for (int J = 7; J >= 0; --J) {
+      P[8 * (3 - I) + J] = uint8_t(V);
+      V >>= 8;
+    }
+  }
+}
+
+bool isZero(const U256 &A) { return (A.W[0] | A.W[1] | A.W[2] | A.W[3]) == 0; }
+
+bool isEqual(const U256 &A, const U256 &B) {
+  return std::memcmp(A.W, B.W, sizeof(A.W)) == 0;
+}
+
+// \return true if A < B
+bool isLess(const U256 &A, const U256 &B) {
+  for (int I = 3; I >= 0; --I) {
+    if (A.W[I] != B.W[I]) {
+      return A.W[I] < B.W[I];
+    }
+  }
+  return false;
+}
+
+// \return the carry
+uint64_t addWithCarry(U256 &R, const U256 &A, const U256 &B) {
+  uint128_t Carry = 0;
+  for (int I = 0; I < 4; ++I) {
+    Carry += uint128_t(A.W[I]) + B.W[I];
+    R.W[I] = uint64_t(Carry);
+    Carry >>= 64;
+  }
+  return uint64_t(Carry);
+}
+
+// \return the borrow
+uint64_t subWithBorrow(U256 &R, const U256 &A, const U256 &B) {
+  uint64_t Borrow = 0;
+  for (int I = 0; I < 4; ++I) {
+    uint128_t Diff = uint128_t(A.W[I]) - B.W[I] - Borrow;
+    R.W[I] = uint64_t(Diff);
+    Borrow = uint64_t(Diff >> 64) & 1;
+  }
+  return Borrow;
+}
+
+// Montgomery arithmetic modulo an odd 256-bit M, with R = 2^256
+class MontField {
+public:
+  explicit MontField(const U256 &M) : M(M) {
+    // -M^-1 mod 2^64 by Newton iteration
+    uint64_t Inv = 1;
+    for (int I = 0; I < 6; ++I) {
+      Inv *= 2 - M.W[0] * Inv;
+    }
+    MInv = -Inv;
+    // R mod M = 2^256 - M, then R^2 mod M by 256 doublings
+    U256 Zero = {{0, 0, 0, 0}};
+    subWithBorrow(One, Zero, M);
+    R2 = One;
+    for (int I = 0; I < 256; ++I) {
+      R2 = this->add(R2, R2);
+    }
+  }
+
+  const U256 &getModulus() const { return M; }
+
+  const U256 &one() const { return One; }
+
+  U256 add(const U256 &A, const U256 &B) const {
+    U256 R;
+    uint64_t Carry = addWithCarry(R, A, B);
+    if (Carry || !isLess(R, M)) {
+      subWithBorrow(R, R, M);
+    }
+    return R;
+  }
+
+  U256 sub(const U256 &A, const U256 &B) const {
+    U256 R;
+    if (subWithBorrow(R, A, B)) {
+      addWithCarry(R, R, M);
+    }
+    return R;
+  }
+
+  U256 neg(const U256 &A) const {
+    U256 Zero = {{0, 0, 0, 0}};
+    return sub(Zero, A);
+  }
+
+  U256 mul(const U256 &A, const U256 &B) const {
+    // CIOS Montgomery multiplication
+    uint64_t T[6] = {0};
+    for (int I = 0; I < 4; ++I) {
+      uint128_t Carry = 0;
+      for (int J = 0; J < 4; ++J) {
+        Carry += uint128_t(A.W[J]) * B.W[I] + T[J];
+        T[J] = uint64_t(Carry);
+        Carry >>= 64;
+      }
+      Carry += T[4];
+      T[4] = uint64_t(Carry);
+      T[5] = uint64_t(Carry >> 64);
+
+      uint64_t Q = T[0] * MInv;
+      Carry = uint128_t(Q) * M.W[0] + T[0];
+      Carry >>= 64;
+      for (int J = 1; J < 4; ++J) {
+        Carry += uint128_t(Q) * M.W[J] + T[J];
+        T[J - 1] = uint64_t(Carry);
+        Carry >>= 64;
+      }
+      Carry += T[4];
+      T[3] = uint64_t(Carry);
+      T[4] = T[5] + uint64_t(Carry >> 64);
+    }
+    U256 R = {{T[0], T[1], T[2], T[3]}};
+    if (T[4] || !isLess(R, M)) {
+      subWithBorrow(R, R, M);
+    }
+    return R;
+  }
+
+  U256 sqr(const U256 &A) const { return mul(A, A); }
+
+  U256 toMont(const U256 &A) const { return mul(A, R2); }
+
+  U256 fromMont(const U256 &A) const {
+    U256 Unit = {{1, 0, 0, 0}};
+    return mul(A, Unit);
+  }
+
+  // A^E with A in Montgomery form and E a plain integer
+  U256 pow(const U256 &A, const U256 &E) const {
+    U256 R = One;
+    for (int I = 255; I >= 0; --I) {
+      R = sqr(R);
+      if ((E.W[I / 64] >> (I % 64)) & 1) {
+        R = mul(R, A);
+      }
+    }
+    return R;
+  }
+
+  // Fermat inversion, M is prime
+  U256 inv(const U256 &A) const {
+    U256 Two = {{2, 0, 0, 0}};
+    U256 E;
+    subWithBorrow(E, M, Two);
+    return pow(A, E);
+  }
+
+private:
+  U256 M;
+  uint64_t MInv;
+  U256 One;
+  U256 R2;
+};
+
+// p = 2^256 - 2^32 - 977
+const U256 CurveP = {{0xfffffffefffffc2fULL, 0xffffffffffffffffULL,
+                      0xffffffffffffffffULL, 0xffffffffffffffffULL}};
+const U256 CurveN = {{0xbfd25e8cd0364141ULL, 0xbaaedce6af48a03bULL,
+                      0xfffffffffffffffeULL, 0xffffffffffffffffULL}};
+const U256 CurveGx = {{0x59f2815b16f81798ULL, 0x029bfcdb2dce28d9ULL,
+                       0x55a06295ce870b07ULL, 0x79be667ef9dcbbacULL}};
+const U256 CurveGy = {{0x9c47d08ffb10d4b8ULL, 0xfd17b448a6855419ULL,
+                       0x5da4fbfc0e1108a8ULL, 0x483ada7726a3c465ULL}};
+
+const MontField &getFieldP() {
+  static const MontField Field(CurveP);
+  return Field;
+}
+
+const MontField &getFieldN() {
+  static const MontField Field(CurveN);
+  return Field;
+}
+
+// Jacobian point with coordinates in Montgomery form, Z == 0 is infinity
+struct Point {
+  U256 X, Y, Z;
+};
+
+bool isInfinity(const Point &P) { return isZero(P.Z); }
+
+Point pointDouble(const MontField &F, const Point &P) {
+  if (isInfinity(P) || isZero(P.Y)) {
+    return {F.one(), F.one(), {{0, 0, 0, 0}}};
+  }
+  // dbl-2009-l, a = 0
+  U256 A = F.sqr(P.X);
+  U256 B = F.sqr(P.Y);
+  U256 C = F.sqr(B);
+  U256 D = F.sub(F.sub(F.sqr(F.add(P.X, B)), A), C);
+  D = F.add(D, D);
+  U256 E = F.add(F.add(A, A), A);
+  U256 FF = F.sqr(E);
+  Point R;
+  R.X = F.sub(FF, F.add(D, D));
+  U256 C8 = F.add(C, C);
+  C8 = F.add(C8, C8);
+  C8 = F.add(C8, C8);
+  R.Y = F.sub(F.mul(E, F.sub(D, R.X)), C8);
+  U256 YZ = F.mul(P.Y, P.Z);
+  R.Z = F.add(YZ, YZ);
+  return R;
+}
+
+Point pointAdd(const MontField &F, const Point &P, const Point &Q) {
+  if (isInfinity(P)) {
+    return Q;
+  }
+  if (isInfinity(Q)) {
+    return P;
+  }
+  // add-2007-bl
+  U256 Z1Z1 = F.sqr(P.Z);
+  U256 Z2Z2 = F.sqr(Q.Z);
+  U256 U1 = F.mul(P.X, Z2Z2);
+  U256 U2 = F.mul(Q.X, Z1Z1);
+  U256 S1 = F.mul(F.mul(P.Y, Q.Z), Z2Z2);
+  U256 S2 = F.mul(F.mul(Q.Y, P.Z), Z1Z1);
+  U256 H = F.sub(U2, U1);
+  U256 Rr = F.sub(S2, S1);
+  if (isZero(H)) {
+    if (isZero(Rr)) {
+      return pointDouble(F, P);
+    }
+    return {F.one(), F.one(), {{0, 0, 0, 0}}};
+  }
+  U256 HH = F.sqr(H);
+  U256 HHH = F.mul(H, HH);
+  U256 V = F.mul(U1, HH);
+  Point R;
+  R.X = F.sub(F.sub(F.sqr(Rr), HHH), F.add(V, V));
+  R.Y = F.sub(F.mul(Rr, F.sub(V, R.X)), F.mul(S1, HHH));
+  R.Z = F.mul(F.mul(P.Z, Q.Z), H);
+  return R;
+}
+
+// U1 * G + U2 * Q by Shamir's trick
+Point doubleScalarMul(const MontField &F, const Point &G, const U256 &U1,
+                      const Point &Q, const U256 &U2) {
+  Point GQ = pointAdd(F, G, Q);
+  Point R = {F.one(), F.one(), {{0, 0, 0, 0}}};
+  for (int I = 255; I >= 0; --I) {
+    R = pointDouble(F, R);
+    bool B1 = (U1.W[I / 64] >> (I % 64)) & 1;
+    bool B2 = (U2.W[I / 64] >> (I % 64)) & 1;
+    if (B1 && B2) {
+      R = pointAdd(F, R, GQ);
+    } else if (B1) {
+      R = pointAdd(F, R, G);
+    } else if (B2) {
+      R = pointAdd(F, R, Q);
+    }
+  }
+  return R;
+}
+
+} // namespace
+
+bool secp256k1Recover(const uint8_t Hash[32], const uint8_t R[32],
+                      const uint8_t S[32], uint8_t RecId, uint8_t PubKey[64]) {
+  if (RecId > 3) {
+    return false;
+  }
+  const MontField &FP = getFieldP();
+  const MontField &FN = getFieldN();
+
+  U256 Rv = loadBE256(R);
+  U256 Sv = loadBE256(S);
+  if (isZero(Rv) || !isLess(Rv, CurveN) || isZero(Sv) ||
+      !isLess(Sv, CurveN)) {
+    return false;
+  }
+  U256 Z = loadBE256(Hash);
+  if (!isLess(Z, CurveN)) {
+    subWithBorrow(Z, Z, CurveN);
+  }
+
+  // Lift x = r(+ n) to the curve point with the requested y parity
+  U256 X = Rv;
+  if (RecId & 2) {
+    if (addWithCarry(X, Rv, CurveN) || !isLess(X, CurveP)) {
+      return false;
+    }
+  }
+  U256 XM = FP.toMont(X);
+  U256 Seven = FP.toMont({{7, 0, 0, 0}});
+  U256 Alpha = FP.add(FP.mul(FP.sqr(XM), XM), Seven);
+  // p = 3 mod 4, so sqrt(a) = a^((p + 1) / 4)
+  U256 SqrtExp = {{0xffffffffbfffff0cULL, 0xffffffffffffffffULL,
+                   0xffffffffffffffffULL, 0x3fffffffffffffffULL}};
+  U256 YM = FP.pow(Alpha, SqrtExp);
+  if (!isEqual(FP.sqr(YM), Alpha)) {
+    return false;
+  }
+  if ((FP.fromMont(YM).W[0] & 1) != (RecId & 1)) {
+    YM = FP.neg(YM);
+  }
+
+  // Q = r^-1 * (s * R - z * G)
+  U256 RInv = FN.inv(FN.toMont(Rv));
+  U256 U1 = FN.fromMont(FN.mul(FN.neg(FN.toMont(Z)), RInv));
+  U256 U2 = FN.fromMont(FN.mul(FN.toMont(Sv), RInv));
+  Point G = {FP.toMont(CurveGx), FP.toMont(CurveGy), FP.one()};
+  Point RPoint = {XM, YM, FP.one()};
+  Point Q = doubleScalarMul(FP, G, U1, RPoint, U2);
+  if (isInfinity(Q)) {
+    return false;
+  }
+
+  U256 ZInv = FP.inv(Q.Z);
+  U256 ZInv2 = FP.sqr(ZInv);
+  U256 QX = FP.fromMont(FP.mul(Q.X, ZInv2));
+  U256 QY = FP.fromMont(FP.mul(Q.Y, FP.mul(ZInv2, ZInv)));
+  storeBE256(PubKey, QX);
+  storeBE256(PubKey + 32, QY);
+  return true;
+}
+
+} // namespace zen::utils
@@ -3,19 +3,148 @@
 
 #include "utils/statistics.h"
 #include "utils/logging.h"
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
 #include <cstdio>
 #include <ratio>
 
+#ifdef ZEN_BUILD_PLATFORM_LINUX
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace zen::utils {
 
-Statistics::StatisticTimer Statistics::startRecord(StatisticPhase Phase) {
+namespace {
+
+constexpr uint32_t NumPerfCounters =
+    common::to_underlying(PerfCounter::NumPerfCounters);
+
+// The counters of the current thread, opened on first use as one perf event
+// group so that they are scheduled together and read with a single syscall. A
+// counter the kernel or the cpu refuses(e.g. perf_event_paranoid, virtual
+// machines, too many events for the PMU) reads as zero.
+class PerfCounterGroup {
+public:
+  static const PerfCounterGroup *current() {
+    static thread_local PerfCounterGroup Group;
+    return Group.Available ? &Group : nullptr;
+  }
+
+  // The times are those the group was enabled and actually counting, they
+  // differ when the kernel multiplexes the PMU between groups
+  void read(PerfCounterValues &Values, uint64_t &TimeEnabled,
+            uint64_t &TimeRunning) const {
+    Values.fill(0);
+    TimeEnabled = 0;
+    TimeRunning = 0;
+#ifdef ZEN_BUILD_PLATFORM_LINUX
+    // layout of PERF_FORMAT_GROUP with both total times
+    struct {
+      uint64_t NumEvents;
+      uint64_t TimeEnabled;
+      uint64_t TimeRunning;
+      uint64_t Values[NumPerfCounters];
+    } Data;
+    ssize_t Size = ::read(LeaderFd, &Data, sizeof(Data));
+    if (Size < ssize_t(3 * sizeof(uint64_t)) ||
+        size_t(Size) < (3 + Data.NumEvents) * sizeof(uint64_t)) {
+      return;
+    }
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      if (Slots[I] >= 0 && uint64_t(Slots[I]) < Data.NumEvents) {
+        Values[I] = Data.Values[Slots[I]];
+      }
+    }
+    TimeEnabled = Data.TimeEnabled;
+    TimeRunning = Data.TimeRunning;
+#endif
+  }
+
+private:
+  PerfCounterGroup() {
+    Fds.fill(-1);
+    Slots.fill(-1);
+#ifdef ZEN_BUILD_PLATFORM_LINUX
+    static constexpr std::pair<uint32_t, uint64_t> Events[] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_ITLB |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    };
+    static_assert(std::size(Events) == NumPerfCounters);
+    int32_t NumEvents = 0;
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      perf_event_attr Attr = {};
+      Attr.size = sizeof(Attr);
+      Attr.type = Events[I].first;
+      Attr.config = Events[I].second;
+      Attr.exclude_kernel = 1;
+      Attr.exclude_hv = 1;
+      Attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                         PERF_FORMAT_TOTAL_TIME_RUNNING;
+      // the calling thread on any cpu, the first counter opened leads the
+      // group and the following ones join it
+      Fds[I] = int(::syscall(SYS_perf_event_open, &Attr, 0, -1, LeaderFd, 0));
+      if (Fds[I] >= 0) {
+        if (LeaderFd < 0) {
+          LeaderFd = Fds[I];
+        }
+        // the group is read in the order the counters joined it
+        Slots[I] = NumEvents++;
+        Available = true;
+      }
+    }
+#endif
+    static std::atomic_flag Warned = ATOMIC_FLAG_INIT;
+    if (!Available && !Warned.test_and_set()) {
+      ZEN_LOG_WARN("hardware performance counters are not available");
+    }
+  }
+
+  ~PerfCounterGroup() {
+#ifdef ZEN_BUILD_PLATFORM_LINUX
+    for (int Fd : Fds) {
+      if (Fd >= 0) {
+        ::close(Fd);
+      }
+    }
+#endif
+  }
+
+  std::array<int, NumPerfCounters> Fds;
+  // Position of each counter in the group read, -1 if not opened
+  std::array<int32_t, NumPerfCounters> Slots;
+  int LeaderFd = -1;
+  bool Available = false;
+};
+
+} // namespace
+
+Statistics::StatisticTimer Statistics::startRecord(StatisticPhase Phase,
+                                                   uint32_t FuncIdx) {
   if (!Enabled) {
     return -1u;
   }
 
+  TimerInfo Info{Phase, FuncIdx, {}, nullptr, {}, 0, 0};
+  if (EnableCounters) {
+    const PerfCounterGroup *Group = PerfCounterGroup::current();
+    Info.CounterGroup = Group;
+    if (Group) {
+      Group->read(Info.StartCounters, Info.StartTimeEnabled,
+                  Info.StartTimeRunning);
+    }
+  }
   common::LockGuard<common::Mutex> Lock(Mtx);
   auto Timer = TimerCounter++;
-  Timers[Timer] = {Phase, common::SteadyClock::now()};
+  Info.Start = common::SteadyClock::now();
+  Timers[Timer] = Info;
   return Timer;
 }
 
@@ -24,14 +153,45 @@ void Statistics::stopRecord(StatisticTimer Timer) {
     return;
   }
 
+  auto End = common::SteadyClock::now();
+  PerfCounterValues EndCounters{};
+  uint64_t EndTimeEnabled = 0;
+  uint64_t EndTimeRunning = 0;
+  const PerfCounterGroup *Group = nullptr;
+  if (EnableCounters) {
+    Group = PerfCounterGroup::current();
+    if (Group) {
+      Group->read(EndCounters, EndTimeEnabled, EndTimeRunning);
+    }
+  }
+
   ZEN_ASSERT(Timers.find(Timer) != Timers.end());
   common::LockGuard<common::Mutex> Lock(Mtx);
-  auto End = common::SteadyClock::now();
-  auto Start = Timers[Timer].second;
+  const TimerInfo &Info = Timers[Timer];
   float TimeCost =
-      common::chrono::duration<float, std::milli>(End - Start).count();
-  auto Phase = Timers[Timer].first;
-  Records.emplace_back(Phase, TimeCost);
+      common::chrono::duration<float, std::milli>(End - Info.Start).count();
+  StatisticRecord Record{Info.Phase, TimeCost, Info.FuncIdx, {}};
+  // counters of another thread can't be subtracted
+  if (Group && Group == Info.CounterGroup) {
+    uint64_t TimeEnabled = EndTimeEnabled - Info.StartTimeEnabled;
+    uint64_t TimeRunning = EndTimeRunning - Info.StartTimeRunning;
+    // the group only counted for part of the interval, extrapolate the counts
+    // to the whole of it like perf-stat does
+    double Scale = 1;
+    if (TimeRunning < TimeEnabled) {
+      Scale = TimeRunning ? double(TimeEnabled) / TimeRunning : 0;
+      static std::atomic_flag Warned = ATOMIC_FLAG_INIT;
+      if (!Warned.test_and_set()) {
+        ZEN_LOG_WARN("hardware performance counters are multiplexed, the "
+                     "counts are scaled estimates");
+      }
+    }
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      uint64_t Count = EndCounters[I] - Info.StartCounters[I];
+      Record.Counters[I] = Scale == 1 ? Count : uint64_t(Count * Scale);
+    }
+  }
+  Records.push_back(Record);
   Timers.erase(Timer);
 }
 
@@ -54,6 +214,29 @@ void Statistics::clearAllTimers() {
   Timers.clear();
 }
 
+std::vector<Statistics::StatisticRecord> Statistics::takeRecords() {
+  common::LockGuard<common::Mutex> Lock(Mtx);
+  std::vector<StatisticRecord> Taken;
+  Taken.swap(Records);
+  return Taken;
+}
+
+Statistics::PhaseSummary Statistics::summarize(StatisticPhase Phase) {
+  common::LockGuard<common::Mutex> Lock(Mtx);
+  PhaseSummary Summary;
+  for (const StatisticRecord &Record : Records) {
+    if (Record.Phase != Phase) {
+      continue;
+    }
+    Summary.NumRecords++;
+    Summary.TimeCost += Record.TimeCost;
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      Summary.Counters[I] += Record.Counters[I];
+    }
+  }
+  return Summary;
+}
+
 void Statistics::report() const {
   if (!Enabled) {
     return;
@@ -71,12 +254,16 @@ void Statistics::report() const {
 
   uint32_t NumPhaseRecords[NumStatPhases] = {0};
   float TimePhaseCosts[NumStatPhases] = {0};
+  PerfCounterValues PhaseCounters[NumStatPhases] = {};
 
-  for (const auto &[Phase, TimeCost] : Records) {
-    auto PhaseVal = to_underlying(Phase);
+  for (const StatisticRecord &Record : Records) {
+    auto PhaseVal = to_underlying(Record.Phase);
     ZEN_ASSERT(PhaseVal < NumStatPhases);
     NumPhaseRecords[PhaseVal]++;
-    TimePhaseCosts[PhaseVal] += TimeCost;
+    TimePhaseCosts[PhaseVal] += Record.TimeCost;
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      PhaseCounters[PhaseVal][I] += Record.Counters[I];
+    }
   }
 
   TimePhaseCosts[ExePhaseVal] -= TimePhaseCosts[JITLazyFgPhaseVal];
@@ -126,13 +313,70 @@ void Statistics::report() const {
                      StatLogPrefixs[I], NumPhaseRecords[I], AvgPhaseTimeCost,
                      TimePhaseCosts[I], PhaseTimeCostPercent);
       }
+      if (EnableCounters) {
+        reportCounters("\t", PhaseCounters[I]);
+      }
     }
   }
 
   ZEN_LOG_INFO("Total:\t\t%.3fms", TotalTimeCost);
 
+  if (EnableCounters) {
+    reportCompiledFunctions();
+  }
+
   ZEN_LOG_INFO(
       "=================  [End] ZetaEngine Statistics =================");
 }
 
+void Statistics::reportCounters(const char *Prefix,
+                                const PerfCounterValues &Counters) {
+  using common::to_underlying;
+  uint64_t Cycles = Counters[to_underlying(PerfCounter::Cycles)];
+  uint64_t Instrs = Counters[to_underlying(PerfCounter::Instructions)];
+  double IPC = Cycles ? double(Instrs) / Cycles : 0;
+  ZEN_LOG_INFO("%scycles %" PRIu64 ", instructions %" PRIu64
+               "(IPC %.2f), branch misses %" PRIu64 ", cache misses %" PRIu64
+               ", iTLB misses %" PRIu64,
+               Prefix, Cycles, Instrs, IPC,
+               Counters[to_underlying(PerfCounter::BranchMisses)],
+               Counters[to_underlying(PerfCounter::CacheMisses)],
+               Counters[to_underlying(PerfCounter::ITLBMisses)]);
+}
+
+void Statistics::reportCompiledFunctions() const {
+  constexpr uint32_t MaxReportedFuncs = 10;
+
+  std::unordered_map<uint32_t, PerfCounterValues> FuncCounters;
+  for (const StatisticRecord &Record : Records) {
+    if (Record.FuncIdx == -1u) {
+      continue;
+    }
+    PerfCounterValues &Counters = FuncCounters[Record.FuncIdx];
+    for (uint32_t I = 0; I < NumPerfCounters; ++I) {
+      Counters[I] += Record.Counters[I];
+    }
+  }
+  if (FuncCounters.empty()) {
+    return;
+  }
+
+  std::vector<std::pair<uint32_t, PerfCounterValues>> SortedFuncs(
+      FuncCounters.begin(), FuncCounters.end());
+  std::sort(SortedFuncs.begin(), SortedFuncs.end(),
+            [](const auto &LHS, const auto &RHS) {
+              constexpr auto Idx = common::to_underlying(PerfCounter::Cycles);
+              return LHS.second[Idx] > RHS.second[Idx];
+            });
+  if (SortedFuncs.size() > MaxReportedFuncs) {
+    SortedFuncs.resize(MaxReportedFuncs);
+  }
+  ZEN_LOG_INFO("Most expensive lazily compiled functions:");
+  for (const auto &[FuncIdx, Counters] : SortedFuncs) {
+    char Prefix[32];
+    std::snprintf(Prefix, sizeof(Prefix), "\tfunction %u: ", FuncIdx);
+    reportCounters(Prefix, Counters);
+  }
+}
+
 } // namespace zen::utils
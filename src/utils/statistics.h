@@ -6,6 +6,7 @@
 
 #include "common/defines.h"
 
+#include <array>
 #include <chrono>
 #include <unordered_map>
 #include <vector>
@@ -25,19 +26,50 @@ enum class StatisticPhase : uint32_t {
   NumStatisticPhases
 };
 
+// hardware events counted in user space by perf_event_open(linux only)
+enum class PerfCounter : uint32_t {
+  Cycles = 0,
+  Instructions = 1,
+  BranchMisses = 2,
+  CacheMisses = 3,
+  ITLBMisses = 4,
+  NumPerfCounters
+};
+
+typedef std::array<uint64_t,
+                   common::to_underlying(PerfCounter::NumPerfCounters)>
+    PerfCounterValues;
+
 class Statistics final {
   typedef common::SteadyClock::time_point TimePoint;
   typedef uint32_t StatisticTimer;
-  typedef std::pair<StatisticPhase, float> StatisticRecord;
 
 public:
-  Statistics(bool Enabled) : Enabled(Enabled) {}
+  struct StatisticRecord {
+    StatisticPhase Phase;
+    // in milliseconds
+    float TimeCost;
+    // the compiled internal function of the lazy compilation phases,
+    // otherwise -1u
+    uint32_t FuncIdx;
+    // all zero unless the counters are enabled and available
+    PerfCounterValues Counters;
+  };
+
+  struct PhaseSummary {
+    uint32_t NumRecords = 0;
+    float TimeCost = 0;
+    PerfCounterValues Counters{};
+  };
+
+  Statistics(bool Enabled, bool EnableCounters = false)
+      : Enabled(Enabled), EnableCounters(Enabled && EnableCounters) {}
 
   ~Statistics() { ZEN_ASSERT(Timers.empty()); }
 
   NONCOPYABLE(Statistics);
 
-  StatisticTimer startRecord(StatisticPhase Phase);
+  StatisticTimer startRecord(StatisticPhase Phase, uint32_t FuncIdx = -1u);
 
   void stopRecord(StatisticTimer Timer);
 
@@ -47,12 +79,39 @@ public:
 
   void report() const;
 
+  // Move out the records collected so far, e.g. to aggregate them per run
+  // instead of for the whole process
+  std::vector<StatisticRecord> takeRecords();
+
+  // Sum of the records of the phase collected so far
+  PhaseSummary summarize(StatisticPhase Phase);
+
+  bool isCountersEnabled() const { return EnableCounters; }
+
 private:
+  static void reportCounters(const char *Prefix,
+                             const PerfCounterValues &Counters);
+
+  void reportCompiledFunctions() const;
+
+  struct TimerInfo {
+    StatisticPhase Phase;
+    uint32_t FuncIdx;
+    TimePoint Start;
+    // the counters of the thread which started the timer, nullptr if
+    // unavailable
+    const void *CounterGroup;
+    PerfCounterValues StartCounters;
+    // to scale the counters when the kernel multiplexes them
+    uint64_t StartTimeEnabled;
+    uint64_t StartTimeRunning;
+  };
+
   const bool Enabled;
+  const bool EnableCounters;
   common::Mutex Mtx;
   StatisticTimer TimerCounter = 0;
-  typedef std::pair<StatisticPhase, TimePoint> TimerPair;
-  std::unordered_map<StatisticTimer, TimerPair> Timers;
+  std::unordered_map<StatisticTimer, TimerInfo> Timers;
   std::vector<StatisticRecord> Records;
 };
 
@@ -4,12 +4,22 @@
 #include "common/mem_pool.h"
 #include "runtime/instance.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace zen::utils {
 
 constexpr size_t StackMemorySize = 9 * 1024 * 1024; // 9MB > dwasm 8MB
 
-StackMemPool::StackMemPool(size_t ItemSize)
-    : EachStackSize(ItemSize), AvailableCount(MAX_STACK_ITEM_NUM) {
+// the top of each stack is kept resident for the common shallow calls
+constexpr size_t StackResidentSize = 256 * 1024;
+
+StackMemPool::StackMemPool(size_t ItemSize, size_t GuardSize,
+                           size_t ResidentSize)
+    : EachStackSize(ItemSize), GuardSize(GuardSize),
+      ResidentSize(ResidentSize) {
+  ZEN_ASSERT(GuardSize % PageSize == 0 && ItemSize % PageSize == 0);
+  ZEN_ASSERT(GuardSize + ResidentSize <= ItemSize);
 #ifdef ZEN_ENABLE_CPU_EXCEPTION
   int DefaultProtMode = PROT_NONE;
 #else
@@ -21,21 +31,69 @@ StackMemPool::StackMemPool(size_t ItemSize)
 
   MemEnd = MemStart;
   MemPageEnd = MemStart;
+  FreeObjects.reserve(MAX_STACK_ITEM_NUM);
 }
-StackMemPool::~StackMemPool() { platform::munmap(MemStart, MaxCodeSize); }
 
-void *StackMemPool::allocate(bool AllowReadWrite) {
-  common::UniqueLock<common::Mutex> Lock(Mutex);
+StackMemPool::~StackMemPool() {
+  // the caches of the threads still running must not flush into this pool
+  for (ThreadCache *Cache : Caches) {
+    while (Cache->take()) {
+    }
+    Cache->Pool = nullptr;
+  }
+  platform::munmap(MemStart, MaxCodeSize);
+}
+
+StackMemPool::ThreadCache::~ThreadCache() {
+  if (!Pool) {
+    return;
+  }
+  common::LockGuard<common::Mutex> Lock(Pool->Mutex);
+  auto It = std::find(Pool->Caches.begin(), Pool->Caches.end(), this);
+  ZEN_ASSERT(It != Pool->Caches.end());
+  Pool->Caches.erase(It);
+  while (void *Ptr = take()) {
+    Pool->FreeObjects.push_back(Ptr);
+  }
 #ifndef ZEN_ENABLE_SGX
-  AvailableCountCV.wait(Lock, [this]() { return AvailableCount > 0; });
+  Pool->AvailableCountCV.notify_all();
 #endif // ZEN_ENABLE_SGX
-  --AvailableCount;
+}
 
-  if (!FreeObjects.empty()) {
-    auto *Result = FreeObjects.front();
-    FreeObjects.pop();
-    return Result;
+void *StackMemPool::ThreadCache::take() {
+  for (std::atomic<void *> &Slot : Slots) {
+    if (Slot.load(std::memory_order_relaxed)) {
+      if (void *Ptr = Slot.exchange(nullptr)) {
+        return Ptr;
+      }
+    }
   }
+  return nullptr;
+}
+
+bool StackMemPool::ThreadCache::put(void *Ptr) {
+  for (std::atomic<void *> &Slot : Slots) {
+    void *Expected = nullptr;
+    if (Slot.compare_exchange_strong(Expected, Ptr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+StackMemPool::ThreadCache &StackMemPool::getThreadCache() {
+  // only one pool exists, see getVirtualStackPool
+  thread_local ThreadCache Cache;
+  if (!Cache.Pool) {
+    common::LockGuard<common::Mutex> Lock(Mutex);
+    Cache.Pool = this;
+    Caches.push_back(&Cache);
+  }
+  ZEN_ASSERT(Cache.Pool == this);
+  return Cache;
+}
+
+void *StackMemPool::carve(bool AllowReadWrite) {
   constexpr size_t Align = 16;
   uint8_t *Ptr = reinterpret_cast<uint8_t *>(
       ZEN_ALIGN(reinterpret_cast<uintptr_t>(MemEnd), Align));
@@ -57,28 +115,107 @@ void *StackMemPool::allocate(bool AllowReadWrite) {
 #endif // ZEN_ENABLE_CPU_EXCEPTION
     MemPageEnd = NewMemPageEnd;
   }
+  // the pages are committed by the kernel on first touch, only the guard
+  // needs to be set up, once for the lifetime of the stack
+  platform::mprotect(Ptr, GuardSize, PROT_NONE);
+  ++NumCarved;
   return Ptr;
 }
 
+void *StackMemPool::takeFromCaches() {
+  for (ThreadCache *Cache : Caches) {
+    if (void *Ptr = Cache->take()) {
+      return Ptr;
+    }
+  }
+  return nullptr;
+}
+
+void *StackMemPool::allocate(bool AllowReadWrite) {
+  ThreadCache &Cache = getThreadCache();
+  if (void *Ptr = Cache.take()) {
+    return Ptr;
+  }
+
+  common::UniqueLock<common::Mutex> Lock(Mutex);
+  if (!FreeObjects.empty()) {
+    void *Ptr = FreeObjects.back();
+    FreeObjects.pop_back();
+    return Ptr;
+  }
+  if (NumCarved < MAX_STACK_ITEM_NUM) {
+    return carve(AllowReadWrite);
+  }
+#ifndef ZEN_ENABLE_SGX
+  // announce the wait before looking into the caches, so that a stack cached
+  // concurrently is either seen here or pushed to the free list by its owner
+  NumWaiters.fetch_add(1);
+  void *Ptr = nullptr;
+  AvailableCountCV.wait(Lock, [this, &Ptr]() {
+    if (!FreeObjects.empty()) {
+      Ptr = FreeObjects.back();
+      FreeObjects.pop_back();
+    } else {
+      Ptr = takeFromCaches();
+    }
+    return Ptr != nullptr;
+  });
+  NumWaiters.fetch_sub(1);
+  return Ptr;
+#else
+  if (void *Ptr = takeFromCaches()) {
+    return Ptr;
+  }
+  return carve(AllowReadWrite);
+#endif // ZEN_ENABLE_SGX
+}
+
 void StackMemPool::deallocate(void *Ptr) {
   if (!Ptr) {
     return;
   }
+  // a cached stack may stay idle as long as its thread lives, so the pages of
+  // deep calls are released before caching too. Only the resident top is
+  // kept, and the madvise is cheap when the deep pages were never touched
+  discardDeepPages(Ptr);
+  ThreadCache &Cache = getThreadCache();
+  if (Cache.put(Ptr)) {
+    if (NumWaiters.load() == 0) {
+      return;
+    }
+    // a thread is waiting, hand it any stack cached here
+    Ptr = Cache.take();
+    if (!Ptr) {
+      return;
+    }
+  }
+  pushFree(Ptr);
+}
+
+void StackMemPool::pushFree(void *Ptr) {
+  common::LockGuard<common::Mutex> Lock(Mutex);
+  ZEN_ASSERT(FreeObjects.size() < NumCarved);
+  FreeObjects.push_back(Ptr);
 #ifndef ZEN_ENABLE_SGX
-  common::UniqueLock<common::Mutex> Lock(Mutex);
+  AvailableCountCV.notify_one();
 #endif // ZEN_ENABLE_SGX
-  ZEN_ASSERT(AvailableCount < MAX_STACK_ITEM_NUM);
-
-  ++AvailableCount;
+}
 
-  FreeObjects.push(Ptr);
+void StackMemPool::discardDeepPages(void *Ptr) {
+  uint8_t *Start = static_cast<uint8_t *>(Ptr) + GuardSize;
+  size_t Size = EachStackSize - GuardSize - ResidentSize;
+  Size &= ~(PageSize - 1);
+  if (Size > 0) {
+    platform::discardPages(Start, Size);
+  }
 }
 
 static StackMemPool *getVirtualStackPool() {
   // stack allocate 2 * needed size, the first part used as stack, the second
   // part used to protect read/write by cpu
   // can't be less, even not enable cpu exception
-  static StackMemPool StackPool(StackMemorySize * 2);
+  static StackMemPool StackPool(StackMemorySize * 2, StackMemorySize,
+                                StackResidentSize);
   return &StackPool;
 }
 
@@ -89,9 +226,8 @@ void VirtualStackInfo::allocate() {
   auto *MemPool = getVirtualStackPool();
   AllocatedMem = (uint8_t *)MemPool->allocate(true);
   AllInfo = AllocatedMem + StackMemorySize;
-  // [AllocatedMem, AllInfo) is disabled visiting
+  // [AllocatedMem, AllInfo) is disabled visiting(set up by the pool)
   // [AllInfo, StackMemoryTop) is available stack memory
-  platform::mprotect(AllocatedMem, StackMemorySize, PROT_NONE);
 
   // when update sp/rsp register, we need copy old frame to new frame, then
   // the new frame rsp should have enough frame to store
@@ -144,6 +280,31 @@ void VirtualStackInfo::rollbackStack() {
   ::longjmp(*ResultJmpBuf, 1);
 }
 
+void *VirtualStackInfo::initSwitchFrame(void (*Entry)(void *), void *Arg) {
+  auto *Top = reinterpret_cast<uint64_t *>(
+      reinterpret_cast<uintptr_t>(StackMemoryTop) & ~uintptr_t(15));
+  auto EnterAddr = reinterpret_cast<uint64_t>(&enterWasmVirtualStack);
+#if defined(ZEN_BUILD_TARGET_X86_64)
+  // mxcsr/x87 control word, r15, r14, r13, r12, rbx, rbp, return address
+  uint64_t *Frame = Top - 8;
+  std::memset(Frame, 0, 8 * sizeof(uint64_t));
+  Frame[0] = 0x037f00001f80; // default mxcsr and x87 control word
+  Frame[3] = reinterpret_cast<uint64_t>(Arg);   // r13
+  Frame[4] = reinterpret_cast<uint64_t>(Entry); // r12
+  Frame[7] = EnterAddr;
+#elif defined(ZEN_BUILD_TARGET_AARCH64)
+  // x19-x30, d8-d15 and fpcr, see switchWasmVirtualStack
+  uint64_t *Frame = Top - 22;
+  std::memset(Frame, 0, 22 * sizeof(uint64_t));
+  Frame[0] = reinterpret_cast<uint64_t>(Entry); // x19
+  Frame[1] = reinterpret_cast<uint64_t>(Arg);   // x20
+  Frame[11] = EnterAddr;                        // x30
+#else
+#error "unsupported target"
+#endif
+  return Frame;
+}
+
 uint8_t checkDwasmStackEnough() {
   uint8_t Stack[8 * 1024 * 1024];
   Stack[8 * 1024 * 1024 - 1] = 0;
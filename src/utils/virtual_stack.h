@@ -6,6 +6,7 @@
 
 #include "common/type.h"
 #include "platform/platform.h"
+#include <atomic>
 #include <csetjmp>
 #include <queue>
 #include <vector>
@@ -17,10 +18,18 @@ namespace zen::utils {
 using namespace common;
 using namespace runtime;
 
+/// Pool of virtual stacks carved from one reserved range. Each stack starts
+/// with a guard region which stays inaccessible, set up once when the stack
+/// is carved. Every thread keeps up to THREAD_CACHE_SIZE free stacks of its
+/// own, so short calls reuse a warm stack without taking the pool lock.
+/// Every released stack has its deep pages discarded, cached ones included,
+/// they are faulted in again lazily by the next deep call.
 class StackMemPool {
 public:
   // The maximum number of VStackItem that can be used simultaneously.
   static constexpr size_t MAX_STACK_ITEM_NUM = 100;
+  // The number of free stacks cached by each thread
+  static constexpr size_t THREAD_CACHE_SIZE = 4;
 
 #ifndef ZEN_ENABLE_OCCLUM
   static constexpr size_t MaxCodeSize = INT32_MAX;
@@ -30,23 +39,47 @@ public:
   static constexpr size_t MaxCodeSize = 640 * 1024 * 1024; // 640MB
 #endif // ZEN_ENABLE_OCCLUM
   static constexpr size_t PageSize = 4096;
-  StackMemPool(size_t ItemSize);
+  /// \param GuardSize the inaccessible size at the start of each item
+  /// \param ResidentSize the size at the end of each item which is never
+  /// discarded
+  StackMemPool(size_t ItemSize, size_t GuardSize, size_t ResidentSize);
   ~StackMemPool();
   NONCOPYABLE(StackMemPool);
   void *allocate(bool AllowReadWrite);
   void deallocate(void *Ptr);
 
 private:
+  // The slots are also taken by the threads running out of stacks, so that
+  // idle threads never hold stacks needed by others
+  struct ThreadCache {
+    StackMemPool *Pool = nullptr;
+    std::atomic<void *> Slots[THREAD_CACHE_SIZE] = {};
+    ~ThreadCache();
+    void *take();
+    bool put(void *Ptr);
+  };
+
+  ThreadCache &getThreadCache();
+  void *carve(bool AllowReadWrite);
+  void *takeFromCaches();
+  void pushFree(void *Ptr);
+  void discardDeepPages(void *Ptr);
+
   size_t EachStackSize;
+  size_t GuardSize;
+  size_t ResidentSize;
   uint8_t *MemStart;
   uint8_t *MemEnd;
   uint8_t *MemPageEnd;
-  std::queue<void *> FreeObjects;
+  size_t NumCarved = 0;
+  // LIFO to reuse the most recently used stacks first
+  std::vector<void *> FreeObjects;
+  std::vector<ThreadCache *> Caches;
+  std::atomic<uint32_t> NumWaiters{0};
   common::Mutex Mutex;
 #ifndef ZEN_ENABLE_SGX
   std::condition_variable AvailableCountCV;
 #endif // ZEN_ENABLE_SGX
-  size_t AvailableCount;
 };
 
 struct VirtualStackInfo;
@@ -97,6 +130,10 @@ struct VirtualStackInfo {
   // setjmp saved register info in stack, so need to rollback stack to origin
   // stack when setjmp
   void __attribute__((noinline)) rollbackStack();
+
+  // prepare the stack to be entered by switchWasmVirtualStack, which then
+  // calls Entry(Arg) on it, return the sp to switch to
+  void *initSwitchFrame(void (*Entry)(void *), void *Arg);
 };
 
 // utils func to check enough stack for dwasm
@@ -110,6 +147,10 @@ void *startWasmFuncStack(void *StackInfo, uint8_t *NewRsp, uint64_t *OldRspPtr,
                          zen::utils::InVirtualStackFuncPtr Func);
 void *rollbackWasmVirtualStack(void *StackInfo, uint64_t OldRsp,
                                jmp_buf *JmpBuf);
+// save the callee-saved registers and sp of the running stack to *SavedSp,
+// then continue on the stack whose state was saved at NewSp
+void switchWasmVirtualStack(void **SavedSp, void *NewSp);
+void enterWasmVirtualStack();
 }
 
 #endif // ZEN_UTILS_VIRTUAL_STACK_H
@@ -135,6 +135,9 @@ const uint8_t *skipBlockType(const uint8_t *Ip, const uint8_t *End);
 // skip current block for br, br_table, return and unreachable
 const uint8_t *skipCurrentBlock(const uint8_t *Ip, const uint8_t *End);
 
+// skip the opcode and immediates of the instruction at Ip
+const uint8_t *skipInstruction(const uint8_t *Ip, const uint8_t *End);
+
 // byte code to string for dump purpose
 const char *getWASMTypeString(common::WASMType Type);
 const char *getOpcodeString(uint8_t Opcode);
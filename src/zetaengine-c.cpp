@@ -102,6 +102,50 @@ static void setErrBuf(char *ErrBuf, uint32_t ErrBufSize, const char *Str) {
 
 static void nop() {}
 
+namespace {
+
+class CStateBackend final : public zen::runtime::StateBackend {
+public:
+  explicit CStateBackend(const ZenStateBackend &Backend) : Backend(Backend) {}
+
+  bool load(const uint8_t *Key, uint32_t KeyLen, std::string &Value) override {
+    const uint8_t *Data = nullptr;
+    uint32_t Size = 0;
+    if (!Backend.Load(Backend.Ctx, Key, KeyLen, &Data, &Size)) {
+      return false;
+    }
+    Value.assign(reinterpret_cast<const char *>(Data), Size);
+    return true;
+  }
+
+  void commit(const zen::runtime::StateWrite *Writes,
+              size_t NumWrites) override {
+    ZEN_ASSERT(NumWrites <= UINT32_MAX);
+    Backend.Commit(Backend.Ctx, reinterpret_cast<const ZenStateWrite *>(Writes),
+                   static_cast<uint32_t>(NumWrites));
+  }
+
+private:
+  ZenStateBackend Backend;
+};
+
+struct CStateJournal {
+  explicit CStateJournal(const ZenStateBackend &B)
+      : Backend(B), Journal(Backend) {}
+
+  CStateBackend Backend;
+  zen::runtime::StateJournal Journal;
+};
+
+static_assert(sizeof(ZenStateWrite) == sizeof(zen::runtime::StateWrite) &&
+                  offsetof(ZenStateWrite, Value) ==
+                      offsetof(zen::runtime::StateWrite, Value) &&
+                  offsetof(ZenStateWrite, ValueLen) ==
+                      offsetof(zen::runtime::StateWrite, ValueLen),
+              "ZenStateWrite must match zen::runtime::StateWrite");
+
+} // namespace
+
 #define DEFINE_CONVERSION_FUNCTIONS(ty, ref)                                   \
   static inline ty *unwrap(ref P) { return reinterpret_cast<ty *>(P); }        \
                                                                                \
@@ -111,10 +155,18 @@ static void nop() {}
 
 DEFINE_CONVERSION_FUNCTIONS(zen::runtime::Runtime, ZenRuntimeRef)
 DEFINE_CONVERSION_FUNCTIONS(zen::runtime::Module, ZenModuleRef)
+DEFINE_CONVERSION_FUNCTIONS(zen::runtime::ModuleStream, ZenModuleStreamRef)
 DEFINE_CONVERSION_FUNCTIONS(zen::runtime::HostModule, ZenHostModuleRef)
 DEFINE_CONVERSION_FUNCTIONS(BuiltinModuleDesc, ZenHostModuleDescRef)
 DEFINE_CONVERSION_FUNCTIONS(zen::runtime::Isolation, ZenIsolationRef)
 DEFINE_CONVERSION_FUNCTIONS(zen::runtime::Instance, ZenInstanceRef)
+DEFINE_CONVERSION_FUNCTIONS(CStateJournal, ZenStateJournalRef)
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+DEFINE_CONVERSION_FUNCTIONS(zen::runtime::ResumableCall, ZenResumableCallRef)
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+DEFINE_CONVERSION_FUNCTIONS(zen::runtime::SamplingProfiler, ZenProfilerRef)
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
 
 // ==================== Runtime ====================
 
@@ -140,6 +192,17 @@ void ZenRuntimeConfigSetWasmMemoryMap(ZenRuntimeConfigRef Config,
   Config->DisableWasmMemoryMap = !Enabled;
 }
 
+void ZenRuntimeConfigSetHugePages(ZenRuntimeConfigRef Config, bool Enabled) {
+  ZEN_ASSERT(Config);
+  Config->EnableHugePages = Enabled;
+}
+
+void ZenRuntimeConfigSetNumaLocalMemory(ZenRuntimeConfigRef Config,
+                                        bool Enabled) {
+  ZEN_ASSERT(Config);
+  Config->EnableNumaLocalMemory = Enabled;
+}
+
 ZenRuntimeRef ZenCreateRuntime(ZenRuntimeConfig *Config) {
   zen::runtime::RuntimeConfig NewConfig;
   if (Config) {
@@ -149,6 +212,12 @@ ZenRuntimeRef ZenCreateRuntime(ZenRuntimeConfig *Config) {
 #endif
     NewConfig.EnableStatistics = Config->EnableStatistics;
     NewConfig.EnableGdbTracingHook = Config->EnableGdbTracingHook;
+    NewConfig.EnableHugePages = Config->EnableHugePages;
+    NewConfig.EnableNumaLocalMemory = Config->EnableNumaLocalMemory;
+    NewConfig.EnableInterruption = Config->EnableInterruption;
+    NewConfig.EnableHardwareCounters = Config->EnableHardwareCounters;
+    NewConfig.NumLoaderThreads = Config->NumLoaderThreads;
+    NewConfig.EnableLazyValidation = Config->EnableLazyValidation;
     using ZenRunModeCPP = zen::common::RunMode;
     switch (Config->Mode) {
     case ZenModeInterp:
@@ -227,6 +296,30 @@ bool ZenCallWasmFuncByIdx(ZenRuntimeRef Runtime, ZenInstanceRef Instance,
   return Ret;
 }
 
+uint32_t ZenCallWasmFuncsByIdx(ZenRuntimeRef Runtime, ZenWasmCall Calls[],
+                               uint32_t NumCalls) {
+  ZEN_ASSERT(Runtime);
+  zen::runtime::Runtime *RT = unwrap(Runtime);
+
+  std::vector<zen::runtime::WasmCall> Batch(NumCalls);
+  for (uint32_t I = 0; I < NumCalls; ++I) {
+    const ZenWasmCall &Call = Calls[I];
+    ZEN_ASSERT(Call.Instance);
+    Batch[I].Inst = unwrap(Call.Instance);
+    Batch[I].FuncIdx = Call.FuncIdx;
+    copyArgsIn(Call.InArgs, Call.NumInArgs, Batch[I].Args);
+  }
+
+  uint32_t NumSucceeded = RT->callWasmFunctions(Batch.data(), NumCalls);
+
+  for (uint32_t I = 0; I < NumCalls; ++I) {
+    ZenWasmCall &Call = Calls[I];
+    Call.Success = Batch[I].succeeded();
+    copyResultsOut(Batch[I].Results, Call.OutResults, &Call.NumOutResults);
+  }
+  return NumSucceeded;
+}
+
 // ==================== Host Module ====================
 
 ZenHostModuleDescRef
@@ -426,6 +519,44 @@ uint32_t ZenGetNumImportFunctions(ZenModuleRef Module) {
   return Mod->getNumImportFunctions();
 }
 
+// ==================== Module Stream ====================
+
+ZenModuleStreamRef ZenCreateModuleStream(ZenRuntimeRef Runtime,
+                                         const char *ModuleName,
+                                         uint32_t CodeSize) {
+  ZEN_ASSERT(Runtime);
+  ZEN_ASSERT(ModuleName);
+  auto Stream = zen::runtime::ModuleStream::newModuleStream(
+      *unwrap(Runtime), ModuleName, CodeSize);
+  return wrap(Stream.release());
+}
+
+bool ZenFeedModuleStream(ZenModuleStreamRef Stream, const uint8_t *Data,
+                         uint32_t Size, char *ErrBuf, uint32_t ErrBufSize) {
+  ZEN_ASSERT(Stream);
+  zen::runtime::ModuleStream *ModStream = unwrap(Stream);
+  if (!ModStream->feed(Data, Size)) {
+    const std::string &ErrMsg = ModStream->getError().getFormattedMessage();
+    setErrBuf(ErrBuf, ErrBufSize, ErrMsg.c_str());
+    return false;
+  }
+  return true;
+}
+
+ZenModuleRef ZenFinishModuleStream(ZenModuleStreamRef Stream, char *ErrBuf,
+                                   uint32_t ErrBufSize) {
+  ZEN_ASSERT(Stream);
+  auto ModuleOrErr = unwrap(Stream)->finish();
+  if (!ModuleOrErr) {
+    const std::string &ErrMsg = ModuleOrErr.getError().getFormattedMessage();
+    setErrBuf(ErrBuf, ErrBufSize, ErrMsg.c_str());
+    return nullptr;
+  }
+  return wrap(*ModuleOrErr);
+}
+
+void ZenDeleteModuleStream(ZenModuleStreamRef Stream) { delete unwrap(Stream); }
+
 // ==================== Isolation ====================
 
 ZenIsolationRef ZenCreateIsolation(ZenRuntimeRef Runtime) {
@@ -558,6 +689,18 @@ void ZenSetInstanceGasLeft(ZenInstanceRef Instance, uint64_t NewGas) {
   Inst->setGas(NewGas);
 }
 
+void ZenInterruptInstance(ZenInstanceRef Instance) {
+  ZEN_ASSERT(Instance);
+  zen::runtime::Instance *Inst = unwrap(Instance);
+  Inst->interrupt();
+}
+
+void ZenClearInstanceInterrupt(ZenInstanceRef Instance) {
+  ZEN_ASSERT(Instance);
+  zen::runtime::Instance *Inst = unwrap(Instance);
+  Inst->clearInterrupt();
+}
+
 void ZenSetInstanceExceptionByHostapi(ZenInstanceRef Instance,
                                       uint32_t ErrorCode) {
   ZEN_ASSERT(Instance);
@@ -579,6 +722,9 @@ uint32_t ZenGetErrCodeGasLimitExceeded() {
 uint32_t ZenGetErrCodeOutOfBoundsMemory() {
   return (uint32_t)zen::common::ErrorCode::OutOfBoundsMemory;
 }
+uint32_t ZenGetErrCodeInterrupted() {
+  return (uint32_t)zen::common::ErrorCode::Interrupted;
+}
 
 void ZenInstanceExit(ZenInstanceRef Instance, int32_t ExitCode) {
   ZEN_ASSERT(Instance);
@@ -598,6 +744,211 @@ void ZenInstanceProtectMemoryAgain(ZenInstanceRef Instance) {
   Inst->protectMemoryAgain();
 }
 
+// ==================== State Journal ====================
+
+ZenStateJournalRef ZenCreateStateJournal(const ZenStateBackend *Backend) {
+  ZEN_ASSERT(Backend && Backend->Load && Backend->Commit);
+  return wrap(new CStateJournal(*Backend));
+}
+
+void ZenDeleteStateJournal(ZenStateJournalRef Journal) {
+  delete unwrap(Journal);
+}
+
+void ZenSetInstanceStateJournal(ZenInstanceRef Instance,
+                                ZenStateJournalRef Journal) {
+  ZEN_ASSERT(Instance);
+  zen::runtime::Instance *Inst = unwrap(Instance);
+  Inst->setStateJournal(Journal ? &unwrap(Journal)->Journal : nullptr);
+}
+
+uint32_t ZenStateJournalCheckpoint(ZenStateJournalRef Journal) {
+  ZEN_ASSERT(Journal);
+  return unwrap(Journal)->Journal.checkpoint();
+}
+
+void ZenStateJournalRevert(ZenStateJournalRef Journal, uint32_t Checkpoint) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.revert(Checkpoint);
+}
+
+void ZenStateJournalRelease(ZenStateJournalRef Journal, uint32_t Checkpoint) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.release(Checkpoint);
+}
+
+void ZenStateJournalCommit(ZenStateJournalRef Journal) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.commit();
+}
+
+void ZenStateJournalDiscard(ZenStateJournalRef Journal) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.discard();
+}
+
+bool ZenStateJournalGet(ZenStateJournalRef Journal, const uint8_t *Key,
+                        uint32_t KeyLen, const uint8_t **Value,
+                        uint32_t *ValueLen) {
+  ZEN_ASSERT(Journal && Value && ValueLen);
+  return unwrap(Journal)->Journal.get(Key, KeyLen, *Value, *ValueLen);
+}
+
+void ZenStateJournalSet(ZenStateJournalRef Journal, const uint8_t *Key,
+                        uint32_t KeyLen, const uint8_t *Value,
+                        uint32_t ValueLen) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.set(Key, KeyLen, Value, ValueLen);
+}
+
+void ZenStateJournalDelete(ZenStateJournalRef Journal, const uint8_t *Key,
+                           uint32_t KeyLen) {
+  ZEN_ASSERT(Journal);
+  unwrap(Journal)->Journal.remove(Key, KeyLen);
+}
+
+// ==================== Resumable Call ====================
+
+ZenResumableCallRef ZenCreateResumableCall(ZenInstanceRef Instance,
+                                           uint32_t FuncIdx,
+                                           const ZenValue InArgs[],
+                                           uint32_t NumInArgs) {
+  ZEN_ASSERT(Instance);
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+  std::vector<zen::common::TypedValue> Args;
+  copyArgsIn(InArgs, NumInArgs, Args);
+  auto Call = zen::runtime::ResumableCall::newResumableCall(*unwrap(Instance),
+                                                            FuncIdx, Args);
+  return wrap(Call.release());
+#else
+  return nullptr;
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+}
+
+void ZenDeleteResumableCall(ZenResumableCallRef Call) {
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+  delete unwrap(Call);
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+}
+
+ZenCallStatus ZenResumeCall(ZenResumableCallRef Call, ZenValue OutResults[],
+                            uint32_t *NumOutResults) {
+  ZEN_ASSERT(Call);
+  ZEN_ASSERT(NumOutResults);
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+  using Status = zen::runtime::ResumableCall::Status;
+  *NumOutResults = 0;
+  switch (unwrap(Call)->resume()) {
+  case Status::Finished:
+    copyResultsOut(unwrap(Call)->getResults(), OutResults, NumOutResults);
+    return ZenCallFinished;
+  case Status::Suspended:
+    return ZenCallSuspended;
+  default:
+    return ZenCallFailed;
+  }
+#else
+  ZEN_UNREACHABLE();
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+}
+
+bool ZenSuspendCurrentCall(void) {
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+  zen::runtime::ResumableCall *Call = zen::runtime::ResumableCall::current();
+  if (!Call) {
+    return false;
+  }
+  Call->suspend();
+  return true;
+#else
+  return false;
+#endif // ZEN_ENABLE_VIRTUAL_STACK
+}
+
+// ==================== Statistics ====================
+
+static_assert(ZenPhaseExecution ==
+                  zen::common::to_underlying(
+                      zen::utils::StatisticPhase::Execution) &&
+                  ZenPhaseExecution + 1 ==
+                      zen::common::to_underlying(
+                          zen::utils::StatisticPhase::NumStatisticPhases),
+              "ZenStatisticPhase must match zen::utils::StatisticPhase");
+
+bool ZenGetPhaseStatistics(ZenRuntimeRef Runtime, ZenStatisticPhase Phase,
+                           ZenPhaseStatistics *Out) {
+  ZEN_ASSERT(Runtime);
+  ZEN_ASSERT(Out);
+  zen::runtime::Runtime *RT = unwrap(Runtime);
+  if (!RT->getConfig().EnableStatistics || Phase < ZenPhaseLoad ||
+      Phase > ZenPhaseExecution) {
+    return false;
+  }
+  using zen::utils::PerfCounter;
+  auto Summary = RT->getStatistics().summarize(
+      static_cast<zen::utils::StatisticPhase>(Phase));
+  auto GetCounter = [&Summary](PerfCounter Counter) {
+    return Summary.Counters[zen::common::to_underlying(Counter)];
+  };
+  Out->NumRecords = Summary.NumRecords;
+  Out->TimeCost = Summary.TimeCost;
+  Out->Cycles = GetCounter(PerfCounter::Cycles);
+  Out->Instructions = GetCounter(PerfCounter::Instructions);
+  Out->BranchMisses = GetCounter(PerfCounter::BranchMisses);
+  Out->CacheMisses = GetCounter(PerfCounter::CacheMisses);
+  Out->ITLBMisses = GetCounter(PerfCounter::ITLBMisses);
+  return true;
+}
+
+// ==================== Profiler ====================
+
+ZenProfilerRef ZenStartProfiler(ZenRuntimeRef Runtime, uint32_t IntervalUs) {
+  ZEN_ASSERT(Runtime);
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  auto Profiler =
+      zen::runtime::SamplingProfiler::start(*unwrap(Runtime), IntervalUs);
+  return wrap(Profiler.release());
+#else
+  return nullptr;
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+}
+
+bool ZenWriteProfile(ZenProfilerRef Profiler, const char *Filename) {
+  ZEN_ASSERT(Filename);
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  ZEN_ASSERT(Profiler);
+  FILE *File = std::fopen(Filename, "w");
+  if (!File) {
+    return false;
+  }
+  bool Written = unwrap(Profiler)->writeFoldedStacks(File);
+  return std::fclose(File) == 0 && Written;
+#else
+  return false;
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+}
+
+void ZenStopProfiler(ZenProfilerRef Profiler) {
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+  delete unwrap(Profiler);
+#endif // ZEN_ENABLE_SAMPLING_PROFILER
+}
+
+bool ZenWriteBlockProfile(ZenModuleRef Module, const char *Filename) {
+  ZEN_ASSERT(Filename);
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+  ZEN_ASSERT(Module);
+  FILE *File = std::fopen(Filename, "w");
+  if (!File) {
+    return false;
+  }
+  bool Written = zen::runtime::writeBlockProfile(*unwrap(Module), File);
+  return std::fclose(File) == 0 && Written;
+#else
+  return false;
+#endif // ZEN_ENABLE_BLOCK_COUNTERS
+}
+
 // ==================== Others ====================
 
 void ZenEnableLogging() {
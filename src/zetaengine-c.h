@@ -47,6 +47,22 @@ typedef struct ZenRuntimeConfig {
   bool EnableStatistics;
   // Enable cpu instruction tracer hook
   bool EnableGdbTracingHook;
+  // Back mmaped wasm memory and JIT code with transparent huge pages
+  bool EnableHugePages;
+  // Prefer the NUMA node of the allocating thread for mmaped wasm memory and
+  // JIT code
+  bool EnableNumaLocalMemory;
+  // Poll ZenInterruptInstance requests at function entries and loop headers
+  bool EnableInterruption;
+  // Count cpu cycles/instructions/misses per statistics phase by
+  // perf_event_open(linux only, needs EnableStatistics)
+  bool EnableHardwareCounters;
+  // Number of threads validating the function bodies of a module while
+  // loading it, 0 or 1 validates them on the loading thread
+  uint32_t NumLoaderThreads;
+  // Only check the structure of function bodies while loading, and validate
+  // each of them on its first call(interpreter only)
+  bool EnableLazyValidation;
 } ZenRuntimeConfig;
 
 typedef struct ZenRuntimeConfig *ZenRuntimeConfigRef;
@@ -65,6 +81,11 @@ void ZenDeleteRuntimeConfig(ZenRuntimeConfigRef Config);
 
 void ZenRuntimeConfigSetWasmMemoryMap(ZenRuntimeConfigRef Config, bool Enabled);
 
+void ZenRuntimeConfigSetHugePages(ZenRuntimeConfigRef Config, bool Enabled);
+
+void ZenRuntimeConfigSetNumaLocalMemory(ZenRuntimeConfigRef Config,
+                                        bool Enabled);
+
 ZenRuntimeRef ZenCreateRuntime(ZenRuntimeConfig *Config);
 
 void ZenDeleteRuntime(ZenRuntimeRef Runtime);
@@ -82,6 +103,25 @@ bool ZenCallWasmFuncByIdx(ZenRuntimeRef Runtime, ZenInstanceRef Instance,
                           uint32_t NumInArgs, ZenValue OutResults[],
                           uint32_t *NumOutResults);
 
+typedef struct ZenWasmCall {
+  ZenInstanceRef Instance;
+  // Resolved once by ZenGetExportFunc
+  uint32_t FuncIdx;
+  const ZenValue *InArgs;
+  uint32_t NumInArgs;
+  // Must have room for all results of the function
+  ZenValue *OutResults;
+  uint32_t NumOutResults;
+  // Set by ZenCallWasmFuncsByIdx, the error of a failed call is left on its
+  // instance(ZenGetInstanceError) until the next call of the instance
+  bool Success;
+} ZenWasmCall;
+
+// Execute the calls back to back on the current thread, sharing the
+// execution setup among them. Returns the number of successful calls.
+uint32_t ZenCallWasmFuncsByIdx(ZenRuntimeRef Runtime, ZenWasmCall Calls[],
+                               uint32_t NumCalls);
+
 // ==================== Host Module ====================
 
 typedef struct ZenHostFuncDesc {
@@ -144,6 +184,31 @@ bool ZenGetImportFuncName(ZenModuleRef Module, uint32_t FuncIdx,
 
 uint32_t ZenGetNumImportFunctions(ZenModuleRef Module);
 
+// ==================== Module Stream ====================
+
+typedef struct ZenOpaqueModuleStream *ZenModuleStreamRef;
+
+// Load a module of CodeSize bytes passed in chunks, e.g. while it is received
+// from the network. Sections and function bodies are validated as soon as
+// they are complete, and in multipass multithread mode functions are
+// compiled in background at the same time. Errors are reported by
+// ZenFeedModuleStream or ZenFinishModuleStream.
+/// \warning not thread-safe
+ZenModuleStreamRef ZenCreateModuleStream(ZenRuntimeRef Runtime,
+                                         const char *ModuleName,
+                                         uint32_t CodeSize);
+
+bool ZenFeedModuleStream(ZenModuleStreamRef Stream, const uint8_t *Data,
+                         uint32_t Size, char *ErrBuf, uint32_t ErrBufSize);
+
+// Return the module once all its bytes have been fed, NULL on error
+/// \warning not thread-safe
+ZenModuleRef ZenFinishModuleStream(ZenModuleStreamRef Stream, char *ErrBuf,
+                                   uint32_t ErrBufSize);
+
+// Must be called after ZenFinishModuleStream, or to abandon the module
+void ZenDeleteModuleStream(ZenModuleStreamRef Stream);
+
 // ==================== Isolation ====================
 
 ZenIsolationRef ZenCreateIsolation(ZenRuntimeRef Runtime);
@@ -187,6 +252,13 @@ uint64_t ZenGetInstanceGasLeft(ZenInstanceRef Instance);
 
 void ZenSetInstanceGasLeft(ZenInstanceRef Instance, uint64_t NewGas);
 
+// Ask the running wasm code of the instance to stop with the error
+// ZenGetErrCodeInterrupted(), thread-safe. Only polled when the runtime was
+// created with EnableInterruption, and pending until cleared
+void ZenInterruptInstance(ZenInstanceRef Instance);
+
+void ZenClearInstanceInterrupt(ZenInstanceRef Instance);
+
 // param ErrorCode: zen::common::ErrorCode
 void ZenSetInstanceExceptionByHostapi(ZenInstanceRef Instance,
                                       uint32_t ErrorCode);
@@ -194,6 +266,7 @@ void ZenSetInstanceExceptionByHostapi(ZenInstanceRef Instance,
 uint32_t ZenGetErrCodeEnvAbort();
 uint32_t ZenGetErrCodeGasLimitExceeded();
 uint32_t ZenGetErrCodeOutOfBoundsMemory();
+uint32_t ZenGetErrCodeInterrupted();
 
 void ZenInstanceExit(ZenInstanceRef Instance, int32_t ExitCode);
 int32_t ZenGetInstanceExitCode(ZenInstanceRef Instance);
@@ -203,6 +276,148 @@ int32_t ZenGetInstanceExitCode(ZenInstanceRef Instance);
 // need enable it again
 void ZenInstanceProtectMemoryAgain(ZenInstanceRef Instance);
 
+// ==================== State Journal ====================
+
+// A key written since the last commit, Value is NULL if the key was deleted
+typedef struct ZenStateWrite {
+  const uint8_t *Key;
+  uint32_t KeyLen;
+  const uint8_t *Value;
+  uint32_t ValueLen;
+} ZenStateWrite;
+
+// Embedder storage behind the journal. Load returns false if the key does not
+// exist, otherwise *Value only needs to stay valid until Load returns. Commit
+// receives all the keys changed since the previous commit in one batch.
+typedef struct ZenStateBackend {
+  void *Ctx;
+  bool (*Load)(void *Ctx, const uint8_t *Key, uint32_t KeyLen,
+               const uint8_t **Value, uint32_t *ValueLen);
+  void (*Commit)(void *Ctx, const ZenStateWrite *Writes, uint32_t NumWrites);
+} ZenStateBackend;
+
+typedef struct ZenOpaqueStateJournal *ZenStateJournalRef;
+
+ZenStateJournalRef ZenCreateStateJournal(const ZenStateBackend *Backend);
+
+void ZenDeleteStateJournal(ZenStateJournalRef Journal);
+
+// The storage hostapis of the instance read and write through the journal,
+// the journal must outlive the instance or be detached by passing NULL
+void ZenSetInstanceStateJournal(ZenInstanceRef Instance,
+                                ZenStateJournalRef Journal);
+
+// Open a nested checkpoint, return its id
+uint32_t ZenStateJournalCheckpoint(ZenStateJournalRef Journal);
+
+// Undo the writes since the checkpoint and close it(and the nested ones)
+void ZenStateJournalRevert(ZenStateJournalRef Journal, uint32_t Checkpoint);
+
+// Close the checkpoint(and the nested ones) and keep its writes
+void ZenStateJournalRelease(ZenStateJournalRef Journal, uint32_t Checkpoint);
+
+// Flush all the writes to ZenStateBackend.Commit
+void ZenStateJournalCommit(ZenStateJournalRef Journal);
+
+// Undo all the writes since the last commit
+void ZenStateJournalDiscard(ZenStateJournalRef Journal);
+
+// *Value is valid until the next call on the journal
+bool ZenStateJournalGet(ZenStateJournalRef Journal, const uint8_t *Key,
+                        uint32_t KeyLen, const uint8_t **Value,
+                        uint32_t *ValueLen);
+
+void ZenStateJournalSet(ZenStateJournalRef Journal, const uint8_t *Key,
+                        uint32_t KeyLen, const uint8_t *Value,
+                        uint32_t ValueLen);
+
+void ZenStateJournalDelete(ZenStateJournalRef Journal, const uint8_t *Key,
+                           uint32_t KeyLen);
+
+// ==================== Resumable Call ====================
+
+typedef struct ZenOpaqueResumableCall *ZenResumableCallRef;
+
+typedef enum {
+  ZenCallFinished = 0,
+  ZenCallSuspended = 1,
+  ZenCallFailed = 2,
+} ZenCallStatus;
+
+// A call running on its own virtual stack, which its host functions may
+// suspend by ZenSuspendCurrentCall and which may be resumed on any thread.
+// Only available with ZEN_ENABLE_VIRTUAL_STACK, otherwise NULL is returned.
+// NULL is also returned if the function or the arguments are invalid, the
+// error is then set on the instance.
+ZenResumableCallRef ZenCreateResumableCall(ZenInstanceRef Instance,
+                                           uint32_t FuncIdx,
+                                           const ZenValue InArgs[],
+                                           uint32_t NumInArgs);
+
+// Deleting a suspended call abandons it together with its instance
+void ZenDeleteResumableCall(ZenResumableCallRef Call);
+
+// Run the call until it finishes, fails(see ZenGetInstanceError) or is
+// suspended again. The results are only written once finished.
+ZenCallStatus ZenResumeCall(ZenResumableCallRef Call, ZenValue OutResults[],
+                            uint32_t *NumOutResults);
+
+// Called by a host function to suspend the resumable call running it, returns
+// once the call is resumed, or false at once if not in a resumable call
+bool ZenSuspendCurrentCall(void);
+
+// ==================== Statistics ====================
+
+typedef enum {
+  ZenPhaseLoad = 0,
+  ZenPhaseJITCompilation = 1,
+  ZenPhaseJITLazyPrecompilation = 2,
+  ZenPhaseJITLazyFgCompilation = 3,
+  ZenPhaseJITLazyBgCompilation = 4,
+  ZenPhaseJITLazyReleaseDelay = 5,
+  ZenPhaseMemoryBucketMap = 6,
+  ZenPhaseInstantiation = 7,
+  ZenPhaseExecution = 8,
+} ZenStatisticPhase;
+
+typedef struct ZenPhaseStatistics {
+  uint32_t NumRecords;
+  // Milliseconds
+  float TimeCost;
+  // Zero unless EnableHardwareCounters and the counter is available
+  uint64_t Cycles;
+  uint64_t Instructions;
+  uint64_t BranchMisses;
+  uint64_t CacheMisses;
+  uint64_t ITLBMisses;
+} ZenPhaseStatistics;
+
+// Sum of the phase records of the runtime so far, returns false if the
+// runtime was created without EnableStatistics
+bool ZenGetPhaseStatistics(ZenRuntimeRef Runtime, ZenStatisticPhase Phase,
+                           ZenPhaseStatistics *Out);
+
+// ==================== Profiler ====================
+
+typedef struct ZenOpaqueProfiler *ZenProfilerRef;
+
+// Sample the wasm call stacks of the runtime every IntervalUs of process cpu
+// time. Only available with ZEN_ENABLE_SAMPLING_PROFILER and one profiler at
+// a time per process, otherwise NULL is returned. Must be stopped before the
+// runtime is deleted.
+ZenProfilerRef ZenStartProfiler(ZenRuntimeRef Runtime, uint32_t IntervalUs);
+
+// Write the samples so far as folded stacks(one `module;func;... count` line
+// per distinct stack) for flamegraph.pl
+bool ZenWriteProfile(ZenProfilerRef Profiler, const char *Filename);
+
+void ZenStopProfiler(ZenProfilerRef Profiler);
+
+// Write the basic block and opcode execution counts of the module, see
+// runtime/block_profile.h for the format. Only available with
+// ZEN_ENABLE_BLOCK_COUNTERS, otherwise false is returned.
+bool ZenWriteBlockProfile(ZenModuleRef Module, const char *Filename);
+
 // ==================== Others ====================
 
 // Warning: these two function can only be called for testing purpose, please
@@ -9,7 +9,19 @@
 #include "runtime/instance.h"
 #include "runtime/isolation.h"
 #include "runtime/module.h"
+#include "runtime/module_stream.h"
 #include "runtime/runtime.h"
+#ifdef ZEN_ENABLE_SAMPLING_PROFILER
+#include "runtime/profiler.h"
+#endif
+#ifdef ZEN_ENABLE_BLOCK_COUNTERS
+#include "runtime/block_profile.h"
+#endif
+#ifdef ZEN_ENABLE_VIRTUAL_STACK
+#include "runtime/resumable_call.h"
+#endif
+#include "runtime/state_journal.h"
+#include "runtime/typed_function.h"
 #include "utils/logging.h"
 #include "wni/helper.h"
 
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, "r") as f:
+        report = json.load(f)
+    results = {}
+    for result in report["results"]:
+        key = (result["module"], result["function"], result["mode"])
+        results[key] = result
+    return results
+
+
+def main():
+    """
+    Usage: ./bench_compare.py base.json new.json [--threshold 10]
+    Compare the p50 of every phase of two wasmBench reports, exit with 1 if
+    any of them is slower than the base by more than the threshold percent.
+    you can get the reports by
+    ./build/wasmBench ./bench_corpus -o base.json
+    """
+    parser = argparse.ArgumentParser()
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="allowed slowdown in percent")
+    parser.add_argument("--stat", default="p50",
+                        help="min/p50/p90/p99/max/mean")
+    args = parser.parse_args()
+
+    base = load(args.base)
+    new = load(args.new)
+    regressed = False
+    for key in sorted(base.keys() & new.keys()):
+        base_phases = base[key].get("phases")
+        new_phases = new[key].get("phases")
+        name = "%s:%s(%s)" % key
+        if base_phases is None or new_phases is None:
+            print("%s: %s" % (name, new[key].get("error", "no base result")))
+            regressed = regressed or new_phases is None
+            continue
+        for phase, base_stats in base_phases.items():
+            new_stats = new_phases.get(phase)
+            if new_stats is None:
+                print("%s %-12s missing in the new report" % (name, phase))
+                regressed = True
+                continue
+            old = base_stats[args.stat]
+            cur = new_stats[args.stat]
+            if old == 0:
+                continue
+            change = (cur - old) / old * 100
+            mark = ""
+            if change > args.threshold:
+                mark = "  REGRESSION"
+                regressed = True
+            print("%s %-12s %10.4f -> %10.4f ms %+7.2f%%%s" %
+                  (name, phase, old, cur, change, mark))
+    for key in sorted(base.keys() ^ new.keys()):
+        print("%s:%s(%s): only in one report" % key)
+    sys.exit(1 if regressed else 0)
+
+
+if __name__ == "__main__":
+    main()